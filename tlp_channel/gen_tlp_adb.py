@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+# Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+#
+# Generate tlp_adb.h, the host view of the TLP_EMU_CHANNEL firmware layouts,
+# straight from their ADB nodes instead of hand-copied mlx5_ifc structs.
+#
+#   ./gen_tlp_adb.py tlp_channel_w_log_7e18542eb.diff > tlp_adb.h
+#   ./gen_tlp_adb.py golan_fw/adabe/*.adb > tlp_adb.h
+#
+# A .diff is read as the new side of its adabe/*.adb hunks. For every node
+# in NODES this emits an mlx5_ifc_<node>_bits struct (so DEVX_SET/GET keep
+# working), a size assert, and get/set accessors that use the widest
+# naturally aligned big-endian access each field allows.
+#
+# ADB offsets are "byte.bit" with bits counted from the LSB of the dword
+# holding the byte, e.g. offset="0x0.0" size="0x1.0" is the low byte of
+# dword 0, which mlx5_ifc numbering (MSB first) calls bits 0x18-0x1f.
+
+import os
+import re
+import sys
+
+NODES = [
+    'tlp_emu_channel',                      # EAS_st.adb, CREATE/QUERY object format
+    'tlp_emu_channel_ctx',                  # gvmi_fw_context_st.adb, ICM context
+    'cmdif_ctx_special_tlp_emu_channel',    # gvmi_fw_context_st.adb, cmdif context
+    'tlp_channel_meta',                     # scratchpad_st.adb, PCI FW channel metadata
+]
+
+ATTR = re.compile(r'(\w+)="([^"]*)"')
+NODE = re.compile(r'<node\s+([^>]*)>(.*?)</node>', re.S)
+FIELD = re.compile(r'<field\s+(.*?)/>', re.S)
+
+
+def bits(spec):
+    """ADB "byte.bit" to a bit count"""
+    byte, _, bit = spec.partition('.')
+    return (int(byte, 16) if byte else 0) * 8 + (int(bit, 0) if bit else 0)
+
+
+def new_side(text):
+    """Post-image of the adabe/*.adb hunks of a git diff, one text per file"""
+    files, name, lines = {}, None, None
+    for line in text.splitlines():
+        if line.startswith('diff --git'):
+            name = line.split()[-1][2:] if line.endswith('.adb') else None
+            lines = files.setdefault(name, []) if name else None
+        elif lines is None or line.startswith(('+++', '---', 'index ')):
+            continue
+        elif line.startswith('@@'):
+            lines.append('')
+        elif line[:1] in ('+', ' '):
+            lines.append(line[1:])
+        elif line == '':
+            lines.append('')
+    return {name: '\n'.join(lines) for name, lines in files.items()}
+
+
+def read_sources(paths):
+    sources = {}
+    for path in paths:
+        with open(path) as f:
+            text = f.read()
+        if path.endswith(('.diff', '.patch')):
+            sources.update(new_side(text))
+        else:
+            sources[path] = text
+    return sources
+
+
+class Field:
+    def __init__(self, name, offset, width, subnode):
+        self.name = name
+        self.offset = offset    # mlx5_ifc bit offset, MSB first
+        self.width = width
+        self.subnode = subnode
+
+    @property
+    def reserved(self):
+        return self.name.startswith('reserved')
+
+    @property
+    def leaf(self):
+        return not self.reserved and self.subnode in (None, 'uint64')
+
+
+def parse_node(name, attrs, body, where):
+    size = bits(attrs['size'])
+    fields = []
+    for m in FIELD.finditer(body):
+        fa = dict(ATTR.findall(m.group(1)))
+        pos, width = bits(fa['offset']), bits(fa['size'])
+        if width >= 32:
+            if pos % 32:
+                sys.exit('%s: %s.%s is %d bits but not dword aligned' % (where, name, fa['name'], width))
+            offset = pos
+        else:
+            lsb = pos % 32
+            if lsb + width > 32:
+                sys.exit('%s: %s.%s crosses a dword' % (where, name, fa['name']))
+            offset = pos - lsb + 32 - lsb - width
+        fields.append(Field(fa['name'], offset, width, fa.get('subnode')))
+
+    fields.sort(key=lambda f: f.offset)
+    end = 0
+    for f in fields:
+        if f.offset < end:
+            sys.exit('%s: %s.%s overlaps the previous field' % (where, name, f.name))
+        end = f.offset + f.width
+    if end > size:
+        sys.exit('%s: %s fields run past its 0x%x byte size' % (where, name, size // 8))
+    return size, fields
+
+
+def collect(sources):
+    nodes, refs = {}, []
+    for where, text in sources.items():
+        for m in NODE.finditer(text):
+            attrs = dict(ATTR.findall(m.group(1)))
+            if attrs.get('name') in NODES:
+                nodes[attrs['name']] = (where,) + parse_node(attrs['name'], attrs, m.group(2), where)
+        # Containers referencing the nodes, their sizes must agree
+        for m in FIELD.finditer(text):
+            fa = dict(ATTR.findall(m.group(1)))
+            if fa.get('subnode') in NODES:
+                refs.append((where, fa))
+
+    missing = [n for n in NODES if n not in nodes]
+    if missing:
+        sys.exit('ADB node(s) not found: %s' % ', '.join(missing))
+    for where, fa in refs:
+        if bits(fa['size']) != nodes[fa['subnode']][1]:
+            sys.exit('%s: %s is 0x%x bytes but node %s is 0x%x' %
+                     (where, fa['name'], bits(fa['size']) // 8, fa['subnode'], nodes[fa['subnode']][1] // 8))
+    return nodes, refs
+
+
+def ctype(width):
+    for n in (8, 16, 32, 64):
+        if width <= n:
+            return 'uint%d_t' % n
+    raise ValueError(width)
+
+
+def accessor(f):
+    """(getter body, setter body) using the widest aligned access for f"""
+    t = ctype(f.width)
+    for n in (64, 32, 16, 8):
+        if f.width == n and f.offset % n == 0:
+            return ('return tlp_adb_get%d(buf, %d);' % (n, f.offset // 8),
+                    ['tlp_adb_put%d(buf, %d, v);' % (n, f.offset // 8)])
+    if f.width == 64:
+        # q_addr at a 4-byte offset: two dword accesses
+        off = f.offset // 8
+        return ('return (uint64_t)tlp_adb_get32(buf, %d) << 32 | tlp_adb_get32(buf, %d);' % (off, off + 4),
+                ['tlp_adb_put32(buf, %d, v >> 32);' % off,
+                 'tlp_adb_put32(buf, %d, (uint32_t)v);' % (off + 4)])
+    off = f.offset // 32 * 4
+    shift = 32 - f.width - f.offset % 32
+    mask = '0x%x' % ((1 << f.width) - 1)
+    shr = ' >> %d' % shift if shift else ''
+    shl = ' << %d' % shift if shift else ''
+    return ('return (%s)((tlp_adb_get32(buf, %d)%s) & %s);' % (t, off, shr, mask),
+            ['uint32_t dw = tlp_adb_get32(buf, %d) & ~((uint32_t)%s%s);' % (off, mask, shl),
+             '',
+             'tlp_adb_put32(buf, %d, dw | ((uint32_t)v & %s)%s);' % (off, mask, shl)])
+
+
+def gen_node(out, name, where, size, fields):
+    up = name.upper()
+
+    out.append('/* %s (%s), 0x%x bytes */' % (name, os.path.basename(where), size // 8))
+    out.append('struct mlx5_ifc_%s_bits {' % name)
+    pos = 0
+    members = []
+    for f in fields:
+        if f.offset > pos:
+            members.append(('reserved_at_%x' % pos, pos, f.offset - pos))
+        members.append((('reserved_at_%x' % f.offset) if f.reserved else f.name, f.offset, f.width))
+        pos = f.offset + f.width
+    if pos < size:
+        members.append(('reserved_at_%x' % pos, pos, size - pos))
+    for i, (mname, offset, width) in enumerate(members):
+        if i and offset % 32 == 0:
+            out.append('')
+        out.append('\tu8\t %s[0x%x];' % (mname, width))
+    out.append('};')
+    out.append('')
+    out.append('#define TLP_ADB_%s_SZ 0x%x' % (up, size // 8))
+    out.append('_Static_assert(sizeof(struct mlx5_ifc_%s_bits) == 0x%x, "%s does not match its ADB node");'
+               % (name, size, name))
+    for f in fields:
+        if not f.leaf and not f.reserved:
+            out.append('#define TLP_ADB_%s_%s_OFF 0x%x  // %s' % (up, f.name.upper(), f.offset // 8, f.subnode))
+    out.append('')
+
+    for f in fields:
+        if not f.leaf:
+            continue
+        get, put = accessor(f)
+        t = ctype(f.width)
+        out.append('static inline %s tlp_adb_%s_%s(const void *buf)' % (t, name, f.name))
+        out.append('{')
+        out.append('    ' + get)
+        out.append('}')
+        out.append('')
+        out.append('static inline void tlp_adb_%s_set_%s(void *buf, %s v)' % (name, f.name, t))
+        out.append('{')
+        out.extend(('    ' + line) if line else '' for line in put)
+        out.append('}')
+        out.append('')
+
+
+HEADER = '''/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - firmware layouts of the TLP emulation channel.
+ * Generated by gen_tlp_adb.py from the ADB nodes, do not edit.
+ */
+
+#ifndef TLP_ADB_H
+#define TLP_ADB_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+
+// Byte offsets; memcpy compiles to a single load/store of the given width
+static inline uint8_t tlp_adb_get8(const void *buf, unsigned int off)
+{
+    return ((const uint8_t *)buf)[off];
+}
+
+static inline void tlp_adb_put8(void *buf, unsigned int off, uint8_t val)
+{
+    ((uint8_t *)buf)[off] = val;
+}
+'''
+
+HELPER = '''
+static inline uint{n}_t tlp_adb_get{n}(const void *buf, unsigned int off)
+{{
+    uint{n}_t val;
+
+    memcpy(&val, (const uint8_t *)buf + off, sizeof(val));
+    return be{n}toh(val);
+}}
+
+static inline void tlp_adb_put{n}(void *buf, unsigned int off, uint{n}_t val)
+{{
+    val = htobe{n}(val);
+    memcpy((uint8_t *)buf + off, &val, sizeof(val));
+}}'''
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit('usage: %s <file.diff | file.adb>...' % sys.argv[0])
+    nodes, refs = collect(read_sources(sys.argv[1:]))
+
+    out = [HEADER.rstrip('\n')]
+    for n in (16, 32, 64):
+        out.append(HELPER.format(n=n))
+    out.append('')
+
+    # Fixed placements, e.g. the channel metadata inside the scratchpad
+    placed = [(where, fa) for where, fa in refs if bits(fa['offset'])]
+    for where, fa in placed:
+        area = os.path.basename(where).split('.')[0]
+        area = area[:-3] if area.endswith('_st') else area
+        out.append('#define TLP_ADB_%s_%s_OFF 0x%x' % (area.upper(), fa['name'].upper(), bits(fa['offset']) // 8))
+    if placed:
+        out.append('')
+
+    for name in NODES:
+        gen_node(out, name, *nodes[name])
+    out.append('#endif /* TLP_ADB_H */')
+    sys.stdout.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
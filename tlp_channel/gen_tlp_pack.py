@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+# Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+#
+# Generate tlp_pack.h, struct-level pack/unpack of the TLP_EMU_CHANNEL
+# command layouts, from the mlx5_ifc_*_bits definitions in mlx5_ifc.h and
+# tlp_adb.h (itself generated from the ADB nodes by gen_tlp_adb.py).
+#
+#   ./gen_tlp_pack.py mlx5_ifc.h tlp_adb.h > tlp_pack.h
+#
+# For every layout a plain C struct with one member per named field is
+# emitted. Pack assembles each aligned 64-bit word in a register and writes
+# it with one big-endian store instead of a read-modify-write per field;
+# reserved bits are always written as zero, so the buffer needs no memset.
+# Unpack reads each field with one 32-bit (64-bit for q_addr-like fields)
+# big-endian load.
+# Offsets are re-checked against mlx5_ifc.h with _Static_assert.
+
+import re
+import sys
+
+LAYOUTS = [
+    'general_obj_in_cmd_hdr',
+    'general_obj_out_cmd_hdr',
+    'tlp_emu_channel',
+]
+
+
+class Layout:
+    def __init__(self, name, union):
+        self.name = name
+        self.union = union
+        self.members = []   # (name, bit offset, bit width)
+        self.size = 0
+
+
+def tokenize(text):
+    text = re.sub(r'/\*.*?\*/', ' ', text, flags=re.S)
+    text = re.sub(r'//[^\n]*', ' ', text)
+    return re.findall(r'[A-Za-z_]\w*|0[xX][0-9a-fA-F]+|\d+|[{}\[\];]', text)
+
+
+class Parser:
+    def __init__(self, text):
+        self.toks = tokenize(text)
+        self.pos = 0
+        self.layouts = {}
+
+    def peek(self, k=0):
+        return self.toks[self.pos + k] if self.pos + k < len(self.toks) else None
+
+    def take(self, expect=None):
+        tok = self.toks[self.pos]
+        if expect and tok != expect:
+            raise SyntaxError('expected %s got %s at token %d' % (expect, tok, self.pos))
+        self.pos += 1
+        return tok
+
+    def parse(self):
+        while self.peek() is not None:
+            if self.peek() in ('struct', 'union') and self.peek(1) and \
+               self.peek(1).startswith('mlx5_ifc_') and self.peek(2) == '{':
+                union = self.take() == 'union'
+                name = self.take()[len('mlx5_ifc_'):-len('_bits')]
+                layout = Layout(name, union)
+                self.body(layout)
+                self.take(';')
+                self.layouts[name] = layout
+            else:
+                self.pos += 1
+        return self.layouts
+
+    def count(self):
+        count = 1
+        while self.peek() == '[':
+            self.take('[')
+            count *= 0 if self.peek() == ']' else int(self.take(), 0)
+            self.take(']')
+        return count
+
+    def body(self, layout):
+        self.take('{')
+        while self.peek() != '}':
+            if self.peek() == 'u8':
+                self.take()
+                name = self.take()
+                width = self.count()
+                self.take(';')
+            elif self.peek() in ('struct', 'union') and self.peek(1) == '{':
+                inner = Layout(None, self.take() == 'union')
+                self.body(inner)
+                name = self.take() if self.peek() != ';' else None
+                width = inner.size * self.count()
+                self.take(';')
+            elif self.peek() in ('struct', 'union'):
+                self.take()
+                tname = self.take()[len('mlx5_ifc_'):-len('_bits')]
+                name = self.take()
+                width = self.layouts[tname].size * self.count()
+                self.take(';')
+            else:
+                raise SyntaxError('unexpected %s in %s' % (self.peek(), layout.name))
+            offset = 0 if layout.union else layout.size
+            layout.members.append((name, offset, width))
+            layout.size = max(layout.size, width) if layout.union else layout.size + width
+        self.take('}')
+
+
+def ctype(width):
+    for bits, t in ((8, 'uint8_t'), (16, 'uint16_t'), (32, 'uint32_t'), (64, 'uint64_t')):
+        if width <= bits:
+            return t
+    raise ValueError(width)
+
+
+def fields_of(layout):
+    fields = [m for m in layout.members if m[0] and not m[0].startswith('reserved') and m[2]]
+    for name, offset, width in fields:
+        if width > 64 or (width > 32 and (width != 64 or offset % 64)) or \
+           (width <= 32 and offset // 32 != (offset + width - 1) // 32):
+            raise ValueError('%s.%s cannot be packed by whole dwords' % (layout.name, name))
+    return fields
+
+
+def gen_layout(out, layout):
+    name = layout.name
+    up = name.upper()
+    fields = fields_of(layout)
+
+    out.append('/* mlx5_ifc_%s_bits, %d bytes */' % (name, layout.size // 8))
+    out.append('#define TLP_PACK_%s_SZ %d' % (up, layout.size // 8))
+    out.append('_Static_assert(sizeof(struct mlx5_ifc_%s_bits) == 0x%x, "mlx5_ifc_%s_bits resized");'
+               % (name, layout.size, name))
+    for fname, offset, width in fields:
+        out.append('_Static_assert(__devx_bit_off(%s, %s) == 0x%x && __devx_bit_sz(%s, %s) == 0x%x,'
+                   % (name, fname, offset, name, fname, width))
+        out.append('               "mlx5_ifc_%s_bits.%s moved, regenerate tlp_pack.h");' % (name, fname))
+    out.append('')
+
+    out.append('struct tlp_pack_%s {' % name)
+    for fname, offset, width in fields:
+        out.append('    %-9s %s;' % (ctype(width), fname))
+    out.append('};')
+    out.append('')
+
+    # Group fields by the 64-bit word they live in; an odd trailing dword
+    # is stored on its own
+    words = []
+    for base in range(0, layout.size, 64):
+        wbits = min(64, layout.size - base)
+        words.append((base, wbits, [f for f in fields if base <= f[1] < base + wbits]))
+
+    out.append('static inline void tlp_pack_%s(void *buf, const struct tlp_pack_%s *v)' % (name, name))
+    out.append('{')
+    for base, wbits, wfields in words:
+        terms = []
+        for fname, offset, width in wfields:
+            shift = wbits - width - (offset - base)
+            expr = 'v->%s' % fname
+            if width not in (8, 16, 32, 64):
+                expr = '(%s & 0x%x)' % (expr, (1 << width) - 1)
+            expr = '(uint%d_t)%s' % (wbits, expr)
+            if shift:
+                expr = '(%s << %d)' % (expr, shift)
+            terms.append(expr)
+        put = 'tlp_pack_put%d(buf, %d, ' % (wbits, base // wbits)
+        out.append('    %s%s);' % (put, (' |\n' + ' ' * (4 + len(put))).join(terms or ['0'])))
+    out.append('}')
+    out.append('')
+
+    # Loads are cheap, read each dword holding a field directly rather than
+    # extracting it from a 64-bit word
+    out.append('static inline void tlp_unpack_%s(const void *buf, struct tlp_pack_%s *v)' % (name, name))
+    out.append('{')
+    for fname, offset, width in fields:
+        if width > 32:
+            out.append('    v->%s = tlp_pack_get64(buf, %d);' % (fname, offset // 64))
+            continue
+        shift = 32 - width - offset % 32
+        expr = 'tlp_pack_get32(buf, %d)' % (offset // 32)
+        if shift:
+            expr = '(%s >> %d)' % (expr, shift)
+        if width < 32:
+            expr = '%s & 0x%x' % (expr, (1 << width) - 1)
+        out.append('    v->%s = %s;' % (fname, expr))
+    out.append('}')
+    out.append('')
+
+
+HEADER = '''/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - whole-dword pack/unpack of command layouts.
+ * Generated by gen_tlp_pack.py from mlx5_ifc.h, do not edit.
+ */
+
+#ifndef TLP_PACK_H
+#define TLP_PACK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_adb.h"
+
+// memcpy compiles to a single store/load, buffers need no particular alignment
+static inline void tlp_pack_put32(void *buf, unsigned int dw, uint32_t val)
+{
+    val = htobe32(val);
+    memcpy((uint8_t *)buf + dw * 4, &val, sizeof(val));
+}
+
+static inline void tlp_pack_put64(void *buf, unsigned int qw, uint64_t val)
+{
+    val = htobe64(val);
+    memcpy((uint8_t *)buf + qw * 8, &val, sizeof(val));
+}
+
+static inline uint32_t tlp_pack_get32(const void *buf, unsigned int dw)
+{
+    uint32_t val;
+
+    memcpy(&val, (const uint8_t *)buf + dw * 4, sizeof(val));
+    return be32toh(val);
+}
+
+static inline uint64_t tlp_pack_get64(const void *buf, unsigned int qw)
+{
+    uint64_t val;
+
+    memcpy(&val, (const uint8_t *)buf + qw * 8, sizeof(val));
+    return be64toh(val);
+}
+'''
+
+
+def main():
+    text = ''
+    for path in sys.argv[1:] or ['mlx5_ifc.h', 'tlp_adb.h']:
+        with open(path) as f:
+            text += f.read()
+    layouts = Parser(text).parse()
+
+    out = [HEADER]
+    for name in LAYOUTS:
+        gen_layout(out, layouts[name])
+    out.append('#endif /* TLP_PACK_H */')
+    sys.stdout.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -1339,7 +1339,11 @@ struct mlx5_ifc_cmd_hca_cap2_bits {
 
 	u8	allowed_object_for_other_vhca_access[0x40];
 
-	u8	reserved_at_28[0x6a0];
+	u8	reserved_at_140[0x80];
+
+	u8	general_obj_types_127_64[0x40];
+
+	u8	reserved_at_200[0x5e0];
 };
 
 enum cross_vhca_object_support_bit {
@@ -2765,22 +2769,6 @@ struct mlx5_ifc_general_obj_out_cmd_hdr_bits {
 	u8	 reserved_at_60[0x20];
 };
 
-struct mlx5_ifc_tlp_emu_channel_bits {
-	u8	 reserved_at_0[0x18];
-	u8	 q_protocol_mode[0x8];
-	
-	u8	 q_mkey[0x20];
-	
-	u8	 q_size[0x20];
-	
-	u8	 reserved_at_60[0x20];
-	
-	u8	 q_addr[0x40];
-	
-	u8	 tlp_channel_stride_index[0x10];
-	u8	 reserved_at_110[0x70];
-};
-
 struct mlx5_ifc_alias_context_bits {
 	u8	 vhca_id_to_be_accessed[0x10];
 	u8	 reserved_at_10[0x10];
@@ -5,6 +5,8 @@
 #include <infiniband/verbs.h>
 #include <infiniband/mlx5dv.h>
 #include "mlx5_ifc.h"
+#include "tlp_adb.h"
+#include "tlp_mr_cache.h"
 
 #define MLX5_OBJ_TYPE_TLP_EMU_CHANNEL 0x59
 
@@ -23,17 +25,11 @@ int test_protocol_mode(struct ibv_context *ctx, struct ibv_pd *pd, uint8_t proto
     printf("\n=== Testing Protocol Mode %d ===\n", protocol_mode);
     printf("Expected result: %s\n", should_succeed ? "SUCCESS" : "FAILURE");
     
-    // Allocate test buffer
-    void *queue_buffer = aligned_alloc(64, 4096);
+    // Registered test buffer, the same one is reused for every mode
+    struct ibv_mr *mr;
+    void *queue_buffer = tlp_mr_cache_alloc(pd, 4096, IBV_ACCESS_LOCAL_WRITE, -1, &mr);
     if (!queue_buffer) {
-        fprintf(stderr, "Failed to allocate queue buffer\n");
-        return -1;
-    }
-    
-    struct ibv_mr *mr = ibv_reg_mr(pd, queue_buffer, 4096, IBV_ACCESS_LOCAL_WRITE);
-    if (!mr) {
-        fprintf(stderr, "Failed to register memory region\n");
-        free(queue_buffer);
+        fprintf(stderr, "Failed to allocate registered queue buffer\n");
         return -1;
     }
     
@@ -127,8 +123,7 @@ int test_protocol_mode(struct ibv_context *ctx, struct ibv_pd *pd, uint8_t proto
         printf("❓ Test UNCLEAR: Unexpected result\n");
     }
     
-    ibv_dereg_mr(mr);
-    free(queue_buffer);
+    tlp_mr_cache_release(queue_buffer);
     
     return test_passed ? 0 : -1;
 }
@@ -215,6 +210,7 @@ int main(int argc, char *argv[])
         printf("❌ Some tests FAILED. Check data structure mapping.\n");
     }
     
+    tlp_mr_cache_flush(pd);
     ibv_dealloc_pd(pd);
     ibv_close_device(ctx);
     
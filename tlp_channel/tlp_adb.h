@@ -0,0 +1,371 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - firmware layouts of the TLP emulation channel.
+ * Generated by gen_tlp_adb.py from the ADB nodes, do not edit.
+ */
+
+#ifndef TLP_ADB_H
+#define TLP_ADB_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+
+// Byte offsets; memcpy compiles to a single load/store of the given width
+static inline uint8_t tlp_adb_get8(const void *buf, unsigned int off)
+{
+    return ((const uint8_t *)buf)[off];
+}
+
+static inline void tlp_adb_put8(void *buf, unsigned int off, uint8_t val)
+{
+    ((uint8_t *)buf)[off] = val;
+}
+
+static inline uint16_t tlp_adb_get16(const void *buf, unsigned int off)
+{
+    uint16_t val;
+
+    memcpy(&val, (const uint8_t *)buf + off, sizeof(val));
+    return be16toh(val);
+}
+
+static inline void tlp_adb_put16(void *buf, unsigned int off, uint16_t val)
+{
+    val = htobe16(val);
+    memcpy((uint8_t *)buf + off, &val, sizeof(val));
+}
+
+static inline uint32_t tlp_adb_get32(const void *buf, unsigned int off)
+{
+    uint32_t val;
+
+    memcpy(&val, (const uint8_t *)buf + off, sizeof(val));
+    return be32toh(val);
+}
+
+static inline void tlp_adb_put32(void *buf, unsigned int off, uint32_t val)
+{
+    val = htobe32(val);
+    memcpy((uint8_t *)buf + off, &val, sizeof(val));
+}
+
+static inline uint64_t tlp_adb_get64(const void *buf, unsigned int off)
+{
+    uint64_t val;
+
+    memcpy(&val, (const uint8_t *)buf + off, sizeof(val));
+    return be64toh(val);
+}
+
+static inline void tlp_adb_put64(void *buf, unsigned int off, uint64_t val)
+{
+    val = htobe64(val);
+    memcpy((uint8_t *)buf + off, &val, sizeof(val));
+}
+
+#define TLP_ADB_SCRATCHPAD_TOP_TLP_CHANNEL_META_OFF 0xe520
+
+/* tlp_emu_channel (EAS_st.adb), 0x20 bytes */
+struct mlx5_ifc_tlp_emu_channel_bits {
+	u8	 reserved_at_0[0x18];
+	u8	 q_protocol_mode[0x8];
+
+	u8	 q_mkey[0x20];
+
+	u8	 q_size[0x20];
+
+	u8	 reserved_at_60[0x20];
+
+	u8	 q_addr[0x40];
+
+	u8	 reserved_at_c0[0x10];
+	u8	 tlp_channel_stride_index[0x10];
+
+	u8	 reserved_at_e0[0x20];
+};
+
+#define TLP_ADB_TLP_EMU_CHANNEL_SZ 0x20
+_Static_assert(sizeof(struct mlx5_ifc_tlp_emu_channel_bits) == 0x100, "tlp_emu_channel does not match its ADB node");
+
+static inline uint8_t tlp_adb_tlp_emu_channel_q_protocol_mode(const void *buf)
+{
+    return tlp_adb_get8(buf, 3);
+}
+
+static inline void tlp_adb_tlp_emu_channel_set_q_protocol_mode(void *buf, uint8_t v)
+{
+    tlp_adb_put8(buf, 3, v);
+}
+
+static inline uint32_t tlp_adb_tlp_emu_channel_q_mkey(const void *buf)
+{
+    return tlp_adb_get32(buf, 4);
+}
+
+static inline void tlp_adb_tlp_emu_channel_set_q_mkey(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 4, v);
+}
+
+static inline uint32_t tlp_adb_tlp_emu_channel_q_size(const void *buf)
+{
+    return tlp_adb_get32(buf, 8);
+}
+
+static inline void tlp_adb_tlp_emu_channel_set_q_size(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 8, v);
+}
+
+static inline uint64_t tlp_adb_tlp_emu_channel_q_addr(const void *buf)
+{
+    return tlp_adb_get64(buf, 16);
+}
+
+static inline void tlp_adb_tlp_emu_channel_set_q_addr(void *buf, uint64_t v)
+{
+    tlp_adb_put64(buf, 16, v);
+}
+
+static inline uint16_t tlp_adb_tlp_emu_channel_tlp_channel_stride_index(const void *buf)
+{
+    return tlp_adb_get16(buf, 26);
+}
+
+static inline void tlp_adb_tlp_emu_channel_set_tlp_channel_stride_index(void *buf, uint16_t v)
+{
+    tlp_adb_put16(buf, 26, v);
+}
+
+/* tlp_emu_channel_ctx (gvmi_fw_context_st.adb), 0x30 bytes */
+struct mlx5_ifc_tlp_emu_channel_ctx_bits {
+	u8	 uid_ref[0x40];
+
+	u8	 reserved_at_40[0x18];
+	u8	 q_protocol_mode[0x8];
+
+	u8	 q_mkey[0x20];
+
+	u8	 q_size[0x20];
+
+	u8	 reserved_at_a0[0x20];
+
+	u8	 q_addr[0x40];
+
+	u8	 reserved_at_100[0x10];
+	u8	 tlp_channel_stride_index[0x10];
+
+	u8	 reserved_at_120[0x18];
+	u8	 state[0x8];
+
+	u8	 reserved_at_140[0x40];
+};
+
+#define TLP_ADB_TLP_EMU_CHANNEL_CTX_SZ 0x30
+_Static_assert(sizeof(struct mlx5_ifc_tlp_emu_channel_ctx_bits) == 0x180, "tlp_emu_channel_ctx does not match its ADB node");
+#define TLP_ADB_TLP_EMU_CHANNEL_CTX_UID_REF_OFF 0x0  // uid_ref_count
+
+static inline uint8_t tlp_adb_tlp_emu_channel_ctx_q_protocol_mode(const void *buf)
+{
+    return tlp_adb_get8(buf, 11);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_q_protocol_mode(void *buf, uint8_t v)
+{
+    tlp_adb_put8(buf, 11, v);
+}
+
+static inline uint32_t tlp_adb_tlp_emu_channel_ctx_q_mkey(const void *buf)
+{
+    return tlp_adb_get32(buf, 12);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_q_mkey(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 12, v);
+}
+
+static inline uint32_t tlp_adb_tlp_emu_channel_ctx_q_size(const void *buf)
+{
+    return tlp_adb_get32(buf, 16);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_q_size(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 16, v);
+}
+
+static inline uint64_t tlp_adb_tlp_emu_channel_ctx_q_addr(const void *buf)
+{
+    return tlp_adb_get64(buf, 24);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_q_addr(void *buf, uint64_t v)
+{
+    tlp_adb_put64(buf, 24, v);
+}
+
+static inline uint16_t tlp_adb_tlp_emu_channel_ctx_tlp_channel_stride_index(const void *buf)
+{
+    return tlp_adb_get16(buf, 34);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_tlp_channel_stride_index(void *buf, uint16_t v)
+{
+    tlp_adb_put16(buf, 34, v);
+}
+
+static inline uint8_t tlp_adb_tlp_emu_channel_ctx_state(const void *buf)
+{
+    return tlp_adb_get8(buf, 39);
+}
+
+static inline void tlp_adb_tlp_emu_channel_ctx_set_state(void *buf, uint8_t v)
+{
+    tlp_adb_put8(buf, 39, v);
+}
+
+/* cmdif_ctx_special_tlp_emu_channel (gvmi_fw_context_st.adb), 0x18 bytes */
+struct mlx5_ifc_cmdif_ctx_special_tlp_emu_channel_bits {
+	u8	 tlp_channel_stride_index[0x10];
+	u8	 reserved_at_10[0x8];
+	u8	 q_protocol_mode[0x8];
+
+	u8	 q_mkey[0x20];
+
+	u8	 q_size[0x20];
+
+	u8	 q_addr[0x40];
+
+	u8	 reserved_at_a0[0x20];
+};
+
+#define TLP_ADB_CMDIF_CTX_SPECIAL_TLP_EMU_CHANNEL_SZ 0x18
+_Static_assert(sizeof(struct mlx5_ifc_cmdif_ctx_special_tlp_emu_channel_bits) == 0xc0, "cmdif_ctx_special_tlp_emu_channel does not match its ADB node");
+
+static inline uint16_t tlp_adb_cmdif_ctx_special_tlp_emu_channel_tlp_channel_stride_index(const void *buf)
+{
+    return tlp_adb_get16(buf, 0);
+}
+
+static inline void tlp_adb_cmdif_ctx_special_tlp_emu_channel_set_tlp_channel_stride_index(void *buf, uint16_t v)
+{
+    tlp_adb_put16(buf, 0, v);
+}
+
+static inline uint8_t tlp_adb_cmdif_ctx_special_tlp_emu_channel_q_protocol_mode(const void *buf)
+{
+    return tlp_adb_get8(buf, 3);
+}
+
+static inline void tlp_adb_cmdif_ctx_special_tlp_emu_channel_set_q_protocol_mode(void *buf, uint8_t v)
+{
+    tlp_adb_put8(buf, 3, v);
+}
+
+static inline uint32_t tlp_adb_cmdif_ctx_special_tlp_emu_channel_q_mkey(const void *buf)
+{
+    return tlp_adb_get32(buf, 4);
+}
+
+static inline void tlp_adb_cmdif_ctx_special_tlp_emu_channel_set_q_mkey(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 4, v);
+}
+
+static inline uint32_t tlp_adb_cmdif_ctx_special_tlp_emu_channel_q_size(const void *buf)
+{
+    return tlp_adb_get32(buf, 8);
+}
+
+static inline void tlp_adb_cmdif_ctx_special_tlp_emu_channel_set_q_size(void *buf, uint32_t v)
+{
+    tlp_adb_put32(buf, 8, v);
+}
+
+static inline uint64_t tlp_adb_cmdif_ctx_special_tlp_emu_channel_q_addr(const void *buf)
+{
+    return (uint64_t)tlp_adb_get32(buf, 12) << 32 | tlp_adb_get32(buf, 16);
+}
+
+static inline void tlp_adb_cmdif_ctx_special_tlp_emu_channel_set_q_addr(void *buf, uint64_t v)
+{
+    tlp_adb_put32(buf, 12, v >> 32);
+    tlp_adb_put32(buf, 16, (uint32_t)v);
+}
+
+/* tlp_channel_meta (scratchpad_st.adb), 0x10 bytes */
+struct mlx5_ifc_tlp_channel_meta_bits {
+	u8	 queue_physical_addr[0x40];
+
+	u8	 credit[0x10];
+	u8	 pi[0x10];
+
+	u8	 reserved_at_60[0x1e];
+	u8	 owner_bit_sw[0x1];
+	u8	 valid[0x1];
+};
+
+#define TLP_ADB_TLP_CHANNEL_META_SZ 0x10
+_Static_assert(sizeof(struct mlx5_ifc_tlp_channel_meta_bits) == 0x80, "tlp_channel_meta does not match its ADB node");
+
+static inline uint64_t tlp_adb_tlp_channel_meta_queue_physical_addr(const void *buf)
+{
+    return tlp_adb_get64(buf, 0);
+}
+
+static inline void tlp_adb_tlp_channel_meta_set_queue_physical_addr(void *buf, uint64_t v)
+{
+    tlp_adb_put64(buf, 0, v);
+}
+
+static inline uint16_t tlp_adb_tlp_channel_meta_credit(const void *buf)
+{
+    return tlp_adb_get16(buf, 8);
+}
+
+static inline void tlp_adb_tlp_channel_meta_set_credit(void *buf, uint16_t v)
+{
+    tlp_adb_put16(buf, 8, v);
+}
+
+static inline uint16_t tlp_adb_tlp_channel_meta_pi(const void *buf)
+{
+    return tlp_adb_get16(buf, 10);
+}
+
+static inline void tlp_adb_tlp_channel_meta_set_pi(void *buf, uint16_t v)
+{
+    tlp_adb_put16(buf, 10, v);
+}
+
+static inline uint8_t tlp_adb_tlp_channel_meta_owner_bit_sw(const void *buf)
+{
+    return (uint8_t)((tlp_adb_get32(buf, 12) >> 1) & 0x1);
+}
+
+static inline void tlp_adb_tlp_channel_meta_set_owner_bit_sw(void *buf, uint8_t v)
+{
+    uint32_t dw = tlp_adb_get32(buf, 12) & ~((uint32_t)0x1 << 1);
+
+    tlp_adb_put32(buf, 12, dw | ((uint32_t)v & 0x1) << 1);
+}
+
+static inline uint8_t tlp_adb_tlp_channel_meta_valid(const void *buf)
+{
+    return (uint8_t)((tlp_adb_get32(buf, 12)) & 0x1);
+}
+
+static inline void tlp_adb_tlp_channel_meta_set_valid(void *buf, uint8_t v)
+{
+    uint32_t dw = tlp_adb_get32(buf, 12) & ~((uint32_t)0x1);
+
+    tlp_adb_put32(buf, 12, dw | ((uint32_t)v & 0x1));
+}
+
+#endif /* TLP_ADB_H */
@@ -0,0 +1,380 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - emulated BAR memory backend.
+ * Each BAR is a sparse two-level page table: a directory of 2MB chunks,
+ * each an array of 512 page entries allocated when something is mapped in
+ * it. A page is unmapped, plain RAM (served with memcpy, allocated on first
+ * write) or an MMIO region whose callbacks implement the side effects.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bar.h"
+
+#define CHUNK_SHIFT     21
+#define CHUNK_PAGES     (1u << (CHUNK_SHIFT - TLP_BAR_PAGE_SHIFT))
+#define PAGE_MASK       ((uint64_t)TLP_BAR_PAGE_SIZE - 1)
+
+enum page_kind {
+    PAGE_UNMAPPED = 0,
+    PAGE_RAM,
+    PAGE_REGION,
+};
+
+struct bar_page {
+    uint8_t                         *ram;           // PAGE_RAM, NULL until first write
+    const struct tlp_bar_region_ops *ops;           // PAGE_REGION
+    void                            *arg;
+    uint64_t                        region_off;     // Offset of the page in its region
+    uint8_t                         kind;
+};
+
+struct bar {
+    uint64_t        base;
+    uint64_t        size;
+    uint32_t        nchunks;
+    struct bar_page **chunks;
+};
+
+struct tlp_bar_set {
+    struct bar      bars[TLP_BAR_MAX];
+};
+
+struct tlp_bar_set *tlp_bar_set_create(void)
+{
+    return calloc(1, sizeof(struct tlp_bar_set));
+}
+
+static void bar_free(struct bar *b)
+{
+    for (uint32_t c = 0; c < b->nchunks; c++) {
+        if (!b->chunks[c])
+            continue;
+        for (uint32_t p = 0; p < CHUNK_PAGES; p++)
+            free(b->chunks[c][p].ram);
+        free(b->chunks[c]);
+    }
+    free(b->chunks);
+    memset(b, 0, sizeof(*b));
+}
+
+void tlp_bar_set_destroy(struct tlp_bar_set *set)
+{
+    if (!set)
+        return;
+    for (int i = 0; i < TLP_BAR_MAX; i++)
+        bar_free(&set->bars[i]);
+    free(set);
+}
+
+static struct bar *bar_get(struct tlp_bar_set *set, int bar)
+{
+    if (bar < 0 || bar >= TLP_BAR_MAX || !set->bars[bar].size) {
+        fprintf(stderr, "BAR%d is not set up\n", bar);
+        return NULL;
+    }
+    return &set->bars[bar];
+}
+
+int tlp_bar_setup(struct tlp_bar_set *set, int bar, uint64_t size, uint64_t base)
+{
+    struct bar *b;
+
+    if (bar < 0 || bar >= TLP_BAR_MAX || size < TLP_BAR_PAGE_SIZE || (size & (size - 1))) {
+        fprintf(stderr, "Invalid BAR%d size 0x%lx\n", bar, size);
+        return -1;
+    }
+
+    b = &set->bars[bar];
+    bar_free(b);
+    b->nchunks = (size + (1ULL << CHUNK_SHIFT) - 1) >> CHUNK_SHIFT;
+    b->chunks = calloc(b->nchunks, sizeof(*b->chunks));
+    if (!b->chunks) {
+        b->nchunks = 0;
+        return -1;
+    }
+    b->size = size;
+    b->base = base;
+    return 0;
+}
+
+int tlp_bar_set_base(struct tlp_bar_set *set, int bar, uint64_t base)
+{
+    struct bar *b = bar_get(set, bar);
+
+    if (!b)
+        return -1;
+    b->base = base;
+    return 0;
+}
+
+static inline struct bar_page *page_lookup(const struct bar *b, uint64_t off)
+{
+    struct bar_page *chunk = b->chunks[off >> CHUNK_SHIFT];
+
+    return chunk ? &chunk[(off >> TLP_BAR_PAGE_SHIFT) & (CHUNK_PAGES - 1)] : NULL;
+}
+
+static int bar_map(struct tlp_bar_set *set, int bar, uint64_t offset, uint64_t len,
+                   int kind, const struct tlp_bar_region_ops *ops, void *arg)
+{
+    struct bar *b = bar_get(set, bar);
+
+    if (!b)
+        return -1;
+    if ((offset | len) & PAGE_MASK || !len || offset + len > b->size || offset + len < offset) {
+        fprintf(stderr, "BAR%d mapping 0x%lx+0x%lx is not page aligned or out of range\n",
+                bar, offset, len);
+        return -1;
+    }
+
+    for (uint64_t off = offset; off < offset + len; off += TLP_BAR_PAGE_SIZE) {
+        struct bar_page **chunk = &b->chunks[off >> CHUNK_SHIFT];
+        struct bar_page *p;
+
+        if (!*chunk) {
+            *chunk = calloc(CHUNK_PAGES, sizeof(**chunk));
+            if (!*chunk)
+                return -1;
+        }
+        p = &(*chunk)[(off >> TLP_BAR_PAGE_SHIFT) & (CHUNK_PAGES - 1)];
+
+        // RAM mapped over RAM keeps its content
+        if (kind != PAGE_RAM || p->kind != PAGE_RAM) {
+            free(p->ram);
+            p->ram = NULL;
+        }
+        p->kind = kind;
+        p->ops = ops;
+        p->arg = arg;
+        p->region_off = off - offset;
+    }
+    return 0;
+}
+
+int tlp_bar_map_ram(struct tlp_bar_set *set, int bar, uint64_t offset, uint64_t len)
+{
+    return bar_map(set, bar, offset, len, PAGE_RAM, NULL, NULL);
+}
+
+int tlp_bar_map_region(struct tlp_bar_set *set, int bar, uint64_t offset, uint64_t len,
+                       const struct tlp_bar_region_ops *ops, void *arg)
+{
+    return bar_map(set, bar, offset, len, PAGE_REGION, ops, arg);
+}
+
+/*
+ * Generic paths, split at page boundaries
+ */
+static void bar_read(const struct bar *b, uint64_t off, uint8_t *buf, uint32_t len)
+{
+    while (len) {
+        uint32_t n = TLP_BAR_PAGE_SIZE - (off & PAGE_MASK);
+        const struct bar_page *p = page_lookup(b, off);
+
+        if (n > len)
+            n = len;
+        if (p && p->kind == PAGE_RAM && p->ram)
+            memcpy(buf, p->ram + (off & PAGE_MASK), n);
+        else if (p && p->kind == PAGE_REGION && p->ops->read)
+            p->ops->read(p->arg, p->region_off + (off & PAGE_MASK), buf, n);
+        else
+            memset(buf, 0, n);
+        off += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+static uint8_t *page_ram(struct bar_page *p)
+{
+    if (!p->ram) {
+        p->ram = aligned_alloc(TLP_BAR_PAGE_SIZE, TLP_BAR_PAGE_SIZE);
+        if (p->ram)
+            memset(p->ram, 0, TLP_BAR_PAGE_SIZE);
+        else
+            fprintf(stderr, "Failed to allocate BAR page, write dropped\n");
+    }
+    return p->ram;
+}
+
+static void bar_write(const struct bar *b, uint64_t off, const uint8_t *buf, uint32_t len)
+{
+    while (len) {
+        uint32_t n = TLP_BAR_PAGE_SIZE - (off & PAGE_MASK);
+        struct bar_page *p = page_lookup(b, off);
+
+        if (n > len)
+            n = len;
+        if (p && p->kind == PAGE_RAM && page_ram(p))
+            memcpy(p->ram + (off & PAGE_MASK), buf, n);
+        else if (p && p->kind == PAGE_REGION && p->ops->write)
+            p->ops->write(p->arg, p->region_off + (off & PAGE_MASK), buf, n);
+        off += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+// Write only the enabled bytes, one bar_write() per contiguous run
+static void bar_write_be(const struct bar *b, uint64_t off, const uint8_t *buf, uint32_t len_dw, uint8_t be)
+{
+    uint32_t bytes = len_dw * 4, run = 0;
+    uint8_t first = be & 0xf, last = len_dw > 1 ? be >> 4 : first;
+
+    if (first == 0xf && last == 0xf) {
+        bar_write(b, off, buf, bytes);
+        return;
+    }
+    for (uint32_t i = 0; i <= bytes; i++) {
+        int on = 0;
+
+        if (i < 4)
+            on = (first >> i) & 1;
+        else if (i < bytes - 4)
+            on = 1;
+        else if (i < bytes)
+            on = (last >> (i - (bytes - 4))) & 1;
+
+        if (on) {
+            run++;
+        } else if (run) {
+            bar_write(b, off + i - run, buf + i - run, run);
+            run = 0;
+        }
+    }
+}
+
+int tlp_bar_read(struct tlp_bar_set *set, int bar, uint64_t offset, void *buf, uint32_t len)
+{
+    struct bar *b = bar_get(set, bar);
+
+    if (!b || offset + len > b->size || offset + len < offset)
+        return -1;
+    bar_read(b, offset, buf, len);
+    return 0;
+}
+
+int tlp_bar_write(struct tlp_bar_set *set, int bar, uint64_t offset, const void *buf, uint32_t len)
+{
+    struct bar *b = bar_get(set, bar);
+
+    if (!b || offset + len > b->size || offset + len < offset)
+        return -1;
+    bar_write(b, offset, buf, len);
+    return 0;
+}
+
+/*
+ * TLP path
+ */
+static inline const struct bar *bar_claim(const struct tlp_bar_set *set, uint64_t addr, uint64_t *off)
+{
+    for (int i = 0; i < TLP_BAR_MAX; i++) {
+        const struct bar *b = &set->bars[i];
+
+        // Unused BARs have size 0 and never match
+        if (addr - b->base < b->size) {
+            *off = addr - b->base;
+            return b;
+        }
+    }
+    return NULL;
+}
+
+// RAM page with the whole [off, off + len) in it, NULL for any other case.
+// Reads leave unpopulated pages to the generic path, which returns zeros.
+static inline uint8_t *ram_fast(const struct bar *b, uint64_t off, uint32_t len, int write)
+{
+    struct bar_page *p = page_lookup(b, off);
+
+    if (!p || p->kind != PAGE_RAM || (off & PAGE_MASK) + len > TLP_BAR_PAGE_SIZE)
+        return NULL;
+    return write ? page_ram(p) : p->ram;
+}
+
+static inline int full_be(uint8_t be, uint32_t bytes)
+{
+    return bytes == 4 ? (be & 0x0f) == 0x0f : be == 0xff;
+}
+
+// DW and QW sized copies stay single moves; everything else goes to the
+// library memcpy rather than an inlined string move
+static inline void ram_copy(uint8_t *dst, const uint8_t *src, uint64_t off, uint32_t bytes)
+{
+    if (bytes == 4)
+        memcpy(dst, src, 4);
+    else if (bytes == 8 && !(off & 7))
+        memcpy(dst, src, 8);
+    else
+        memcpy(dst, src, bytes);
+}
+
+uint32_t tlp_bar_serve(struct tlp_bar_set *set, const void *ring, const struct tlp_batch *batch,
+                       struct tlp_bar_io *io)
+{
+    uint32_t served = 0;
+    int retry = 0;
+
+    io->data_len = 0;
+    io->retry_from = batch->count;
+    for (uint32_t i = 0; i < batch->count; i++) {
+        uint8_t kind = batch->kind[i];
+        uint32_t bytes = batch->len_dw[i] * 4;
+        const struct bar *b;
+        uint64_t off;
+        uint8_t *ram;
+
+        if (kind != TLP_KIND_MWR && kind != TLP_KIND_MRD) {
+            io->status[i] = TLP_BAR_SKIP;
+            continue;
+        }
+        // Nothing passes a read that did not fit, writes included
+        if (retry) {
+            io->status[i] = TLP_BAR_RETRY;
+            continue;
+        }
+        b = bar_claim(set, batch->addr[i], &off);
+        if (!b || off + bytes > b->size) {
+            io->status[i] = TLP_BAR_UR;
+            continue;
+        }
+
+        if (kind == TLP_KIND_MWR) {
+            const uint8_t *payload = (const uint8_t *)ring + (size_t)batch->qe[i] * TLP_QE_SIZE +
+                                     batch->hdr_dw[i] * 4;
+
+            if (bytes > TLP_QE_SIZE - batch->hdr_dw[i] * 4u) {
+                io->status[i] = TLP_BAR_MALFORMED;
+                continue;
+            }
+            // Whole DWs inside one RAM page: one copy, a single store when aligned DW / QW
+            if (full_be(batch->be[i], bytes) && (ram = ram_fast(b, off, bytes, 1)) != NULL)
+                ram_copy(ram + (off & PAGE_MASK), payload, off, bytes);
+            else
+                bar_write_be(b, off, payload, batch->len_dw[i], batch->be[i]);
+        } else {
+            uint8_t *data = io->data + io->data_len;
+
+            if (io->data_len + bytes > io->data_cap) {
+                io->status[i] = TLP_BAR_RETRY;
+                io->retry_from = i;
+                retry = 1;
+                continue;
+            }
+            if ((ram = ram_fast(b, off, bytes, 0)) != NULL)
+                ram_copy(data, ram + (off & PAGE_MASK), off, bytes);
+            else
+                bar_read(b, off, data, bytes);
+            io->data_off[i] = io->data_len;
+            io->data_len += bytes;
+        }
+        io->status[i] = TLP_BAR_OK;
+        served++;
+    }
+    return served;
+}
@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - emulated BAR memory backend
+ */
+
+#ifndef TLP_BAR_H
+#define TLP_BAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tlp_decode.h"
+
+#define TLP_BAR_MAX             6
+#define TLP_BAR_PAGE_SHIFT      12
+#define TLP_BAR_PAGE_SIZE       (1u << TLP_BAR_PAGE_SHIFT)
+
+/*
+ * MMIO region with side effects. Offsets are relative to the region start;
+ * an access spanning pages is split at page boundaries. Reads cover whole
+ * DWs, writes only the enabled bytes (one call per contiguous run).
+ */
+struct tlp_bar_region_ops {
+    void (*read)(void *arg, uint64_t offset, void *buf, uint32_t len);
+    void (*write)(void *arg, uint64_t offset, const void *buf, uint32_t len);
+};
+
+// Per-row result of tlp_bar_serve()
+enum tlp_bar_status {
+    TLP_BAR_SKIP = 0,           // Not an MRd/MWr, left to other handlers
+    TLP_BAR_OK,
+    TLP_BAR_UR,                 // No BAR claims the address (Unsupported Request)
+    TLP_BAR_MALFORMED,          // MWr payload larger than its QE
+    TLP_BAR_RETRY,              // Not served: an MRd at or before it did not fit the read buffer
+};
+
+struct tlp_bar_set;
+
+/**
+ * BAR memory of one emulated function
+ *
+ * Every BAR has a sparse two-level page table. Unmapped pages read as zero
+ * and ignore writes; RAM pages are allocated on their first write.
+ * @return: set, NULL on failure
+ */
+struct tlp_bar_set *tlp_bar_set_create(void);
+void tlp_bar_set_destroy(struct tlp_bar_set *set);
+
+/**
+ * Size a BAR and place it on the bus
+ *
+ * @param size: Power of two, at least one page
+ * @param base: Bus address programmed by the host, may change later
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_bar_setup(struct tlp_bar_set *set, int bar, uint64_t size, uint64_t base);
+int tlp_bar_set_base(struct tlp_bar_set *set, int bar, uint64_t base);
+
+/**
+ * Back [offset, offset + len) of a BAR with plain RAM or with callbacks
+ *
+ * Offset and length must be page aligned. A later mapping replaces an
+ * earlier one page by page; ops and arg must outlive the mapping.
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_bar_map_ram(struct tlp_bar_set *set, int bar, uint64_t offset, uint64_t len);
+int tlp_bar_map_region(struct tlp_bar_set *set, int bar, uint64_t offset, uint64_t len,
+                       const struct tlp_bar_region_ops *ops, void *arg);
+
+/**
+ * Direct access by BAR offset, e.g. to seed or inspect memory
+ *
+ * Bypasses byte enables but not region callbacks.
+ * @return: 0 on success, -1 if the range is outside the BAR
+ */
+int tlp_bar_read(struct tlp_bar_set *set, int bar, uint64_t offset, void *buf, uint32_t len);
+int tlp_bar_write(struct tlp_bar_set *set, int bar, uint64_t offset, const void *buf, uint32_t len);
+
+/*
+ * Read data of the MRds in a batch, laid out back to back.
+ * Set data and data_cap before serving.
+ */
+struct tlp_bar_io {
+    uint8_t     status[TLP_BATCH_MAX];      // enum tlp_bar_status
+    uint32_t    data_off[TLP_BATCH_MAX];    // MRd row: its data in data[]
+    uint8_t     *data;
+    uint32_t    data_cap;
+    uint32_t    data_len;
+    uint32_t    retry_from;                 // First TLP_BAR_RETRY row, batch->count if none
+};
+
+/**
+ * Serve the MRd/MWr rows of a decoded batch
+ *
+ * Rows are applied in order, so a read sees every earlier write of the
+ * batch. MWr payloads are taken from the QE after the header, honoring the
+ * first/last DW byte enables; aligned 4 and 8 byte accesses to RAM pages
+ * take a single load or store. MRds return len_dw whole DWs. The first MRd
+ * that does not fit the read buffer stops the batch: it and every later
+ * MRd/MWr row are left unserved for the caller to serve again.
+ * @param ring: Queue the batch was decoded from
+ * @return: number of rows served (TLP_BAR_OK)
+ */
+uint32_t tlp_bar_serve(struct tlp_bar_set *set, const void *ring, const struct tlp_batch *batch,
+                       struct tlp_bar_io *io);
+
+#endif /* TLP_BAR_H */
@@ -0,0 +1,468 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel BAR benchmark - drives the BAR backend with MRd/MWr QEs
+ * decoded by tlp_decode_qes(). A randomized suite first checks every served
+ * access against a flat reference memory model (byte enables, page and
+ * region crossings, unmapped holes, UR, BAR rebase), then accesses/sec are
+ * timed per access shape.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "tlp_bar.h"
+#include "tlp_decode.h"
+
+#define RING_QES        1024
+#define BATCH_QES       64
+
+// Suite layout
+#define BAR0_BASE       0x2000000000ull         // 64-bit BAR, 4DW TLPs
+#define BAR0_SIZE       (16u << 20)
+#define BAR0_RAM_LEN    (8u << 20)              // Upper half unmapped
+#define BAR0_REG_OFF    (1u << 20)              // Two MMIO pages inside the RAM
+#define BAR0_REG_LEN    (2 * TLP_BAR_PAGE_SIZE)
+#define BAR2_BASE       0xe0000000ull           // 32-bit BAR, 3DW TLPs
+#define BAR2_SIZE       (64u << 10)
+#define BAR2_REG_LEN    TLP_BAR_PAGE_SIZE       // First page MMIO, rest RAM
+
+#define MAX_READ_DW     64
+
+/**
+ * Encode an MRd/MWr QE, 4DW when the address needs it
+ * @return: payload pointer inside the QE
+ */
+static uint8_t *encode_mem(uint8_t *qe, int write, uint64_t addr, uint32_t len_dw, uint8_t be, uint8_t tag)
+{
+    int four_dw = addr >> 32 != 0;
+    uint8_t fmt_type = (write ? 0x40 : 0x00) | (four_dw ? 0x20 : 0);
+
+    put_be32(qe, (uint32_t)fmt_type << 24 | (len_dw & 0x3ff));
+    put_be32(qe + 4, 0x0100u << 16 | (uint32_t)tag << 8 | be);
+    if (four_dw) {
+        put_be32(qe + 8, addr >> 32);
+        put_be32(qe + 12, (uint32_t)addr & ~3u);
+    } else {
+        put_be32(qe + 8, (uint32_t)addr & ~3u);
+    }
+    return qe + (four_dw ? 16 : 12);
+}
+
+/*
+ * MMIO region of the suite: plain storage whose callbacks count the bytes
+ * they move, so the number and size of callback calls is checked as well
+ */
+struct test_region {
+    uint8_t     mem[BAR0_REG_LEN];
+    uint64_t    read_bytes;
+    uint64_t    write_bytes;
+};
+
+static void region_read(void *arg, uint64_t offset, void *buf, uint32_t len)
+{
+    struct test_region *r = arg;
+
+    memcpy(buf, r->mem + offset, len);
+    r->read_bytes += len;
+}
+
+static void region_write(void *arg, uint64_t offset, const void *buf, uint32_t len)
+{
+    struct test_region *r = arg;
+
+    memcpy(r->mem + offset, buf, len);
+    r->write_bytes += len;
+}
+
+static const struct tlp_bar_region_ops test_region_ops = {
+    .read = region_read,
+    .write = region_write,
+};
+
+/*
+ * Reference model: one flat byte array per BAR and a page kind map,
+ * applied one byte at a time
+ */
+enum { REF_UNMAPPED, REF_RAM, REF_REGION };
+
+struct ref_bar {
+    uint64_t    base;
+    uint64_t    size;
+    uint8_t     *mem;
+    uint8_t     *kind;          // Per page
+};
+
+struct ref_model {
+    struct ref_bar  bars[2];
+    uint64_t        read_bytes;         // Expected region callback traffic
+    uint64_t        write_bytes;
+    uint32_t        data_cap;           // Read buffer of the current batch
+    uint32_t        data_len;
+    int             retry;
+};
+
+static int ref_be_on(uint32_t i, uint32_t len_dw, uint8_t be)
+{
+    uint32_t bytes = len_dw * 4;
+
+    if (i < 4)
+        return (be >> i) & 1;
+    if (i >= bytes - 4)
+        return (be >> (4 + i - (bytes - 4))) & 1;
+    return 1;
+}
+
+static struct ref_bar *ref_claim(struct ref_model *m, uint64_t addr, uint32_t bytes, uint64_t *off)
+{
+    for (int i = 0; i < 2; i++) {
+        struct ref_bar *b = &m->bars[i];
+
+        if (addr >= b->base && addr + bytes <= b->base + b->size) {
+            *off = addr - b->base;
+            return b;
+        }
+    }
+    return NULL;
+}
+
+static int ref_apply(struct ref_model *m, int write, uint64_t addr, uint32_t len_dw, uint8_t be,
+                     uint32_t hdr_dw, const uint8_t *payload, uint8_t *read_out)
+{
+    uint32_t bytes = len_dw * 4;
+    struct ref_bar *b;
+    uint64_t off;
+
+    if (m->retry)
+        return TLP_BAR_RETRY;
+    b = ref_claim(m, addr, bytes, &off);
+    if (!b)
+        return TLP_BAR_UR;
+    if (write && bytes > TLP_QE_SIZE - hdr_dw * 4)
+        return TLP_BAR_MALFORMED;
+    if (!write) {
+        if (m->data_len + bytes > m->data_cap) {
+            m->retry = 1;
+            return TLP_BAR_RETRY;
+        }
+        m->data_len += bytes;
+    }
+
+    for (uint32_t i = 0; i < bytes; i++) {
+        uint8_t kind = b->kind[(off + i) / TLP_BAR_PAGE_SIZE];
+
+        if (write) {
+            if (kind == REF_UNMAPPED || !ref_be_on(i, len_dw, be))
+                continue;
+            b->mem[off + i] = payload[i];
+            m->write_bytes += kind == REF_REGION;
+        } else {
+            read_out[i] = kind == REF_UNMAPPED ? 0 : b->mem[off + i];
+            m->read_bytes += kind == REF_REGION;
+        }
+    }
+    return TLP_BAR_OK;
+}
+
+struct suite {
+    struct tlp_bar_set  *set;
+    struct test_region  reg0, reg2;
+    struct ref_model    ref;
+    uint8_t             ring[RING_QES * TLP_QE_SIZE];
+    uint8_t             expect_status[BATCH_QES];
+    uint8_t             expect_data[BATCH_QES][MAX_READ_DW * 4];
+    uint8_t             read_buf[BATCH_QES * MAX_READ_DW * 4];
+    uint32_t            ci;
+    uint64_t            seed;
+};
+
+static int suite_setup(struct suite *s)
+{
+    struct ref_bar *b0 = &s->ref.bars[0], *b2 = &s->ref.bars[1];
+
+    s->set = tlp_bar_set_create();
+    if (!s->set ||
+        tlp_bar_setup(s->set, 0, BAR0_SIZE, BAR0_BASE) ||
+        tlp_bar_map_ram(s->set, 0, 0, BAR0_RAM_LEN) ||
+        tlp_bar_map_region(s->set, 0, BAR0_REG_OFF, BAR0_REG_LEN, &test_region_ops, &s->reg0) ||
+        tlp_bar_setup(s->set, 2, BAR2_SIZE, BAR2_BASE) ||
+        tlp_bar_map_ram(s->set, 2, 0, BAR2_SIZE) ||
+        tlp_bar_map_region(s->set, 2, 0, BAR2_REG_LEN, &test_region_ops, &s->reg2))
+        return -1;
+
+    *b0 = (struct ref_bar) { .base = BAR0_BASE, .size = BAR0_SIZE };
+    *b2 = (struct ref_bar) { .base = BAR2_BASE, .size = BAR2_SIZE };
+    b0->mem = calloc(1, BAR0_SIZE);
+    b0->kind = calloc(1, BAR0_SIZE / TLP_BAR_PAGE_SIZE);
+    b2->mem = calloc(1, BAR2_SIZE);
+    b2->kind = calloc(1, BAR2_SIZE / TLP_BAR_PAGE_SIZE);
+    if (!b0->mem || !b0->kind || !b2->mem || !b2->kind)
+        return -1;
+    memset(b0->kind, REF_RAM, BAR0_RAM_LEN / TLP_BAR_PAGE_SIZE);
+    memset(b0->kind + BAR0_REG_OFF / TLP_BAR_PAGE_SIZE, REF_REGION, BAR0_REG_LEN / TLP_BAR_PAGE_SIZE);
+    memset(b2->kind, REF_RAM, BAR2_SIZE / TLP_BAR_PAGE_SIZE);
+    memset(b2->kind, REF_REGION, BAR2_REG_LEN / TLP_BAR_PAGE_SIZE);
+    return 0;
+}
+
+static void suite_teardown(struct suite *s)
+{
+    tlp_bar_set_destroy(s->set);
+    for (int i = 0; i < 2; i++) {
+        free(s->ref.bars[i].mem);
+        free(s->ref.bars[i].kind);
+    }
+}
+
+// Addresses biased to page, region and BAR edges, sometimes outside any BAR
+static uint64_t pick_addr(struct suite *s)
+{
+    static const uint64_t edges[] = {
+        0, TLP_BAR_PAGE_SIZE, BAR0_REG_OFF, BAR0_REG_OFF + BAR0_REG_LEN, BAR0_RAM_LEN, BAR0_SIZE,
+    };
+    uint32_t r = rnd(&s->seed);
+    const struct ref_bar *b = &s->ref.bars[r & 1];
+    uint64_t off;
+
+    switch ((r >> 1) % 8) {
+    case 0:     // Around an edge, possibly past the BAR end
+        off = edges[rnd(&s->seed) % 6] % (b->size + 1) + (rnd(&s->seed) % 64) * 4 - 128;
+        break;
+    case 1:     // Outside every BAR
+        return 0x1000 + (rnd(&s->seed) % 1024) * 4;
+    default:
+        off = (rnd(&s->seed) % (b->size / 4)) * 4;
+        break;
+    }
+    return b->base + off;
+}
+
+static uint8_t pick_be(struct suite *s, uint32_t len_dw)
+{
+    uint32_t r = rnd(&s->seed);
+
+    if (r % 4)
+        return len_dw == 1 ? 0x0f : 0xff;      // Full DWs, the common case
+    r = rnd(&s->seed);
+    if (len_dw == 1)
+        return r & 0xf;                         // Any mask, zero-length and holes included
+    return (r & 0xf ? r & 0xf : 0x1) | (r & 0xf0 ? r & 0xf0 : 0x80);
+}
+
+/**
+ * One batch of random MRd/MWr QEs through decode + serve, checked against the model
+ * @return: number of mismatches
+ */
+static uint32_t suite_batch(struct suite *s, struct tlp_batch *batch, struct tlp_bar_io *io)
+{
+    uint32_t mismatches = 0;
+
+    s->ref.data_cap = io->data_cap;
+    s->ref.data_len = 0;
+    s->ref.retry = 0;
+    for (uint32_t i = 0; i < BATCH_QES; i++) {
+        uint8_t *qe = s->ring + (size_t)((s->ci + i) % RING_QES) * TLP_QE_SIZE;
+        int write = rnd(&s->seed) & 1;
+        uint32_t len_dw = write ? 1 + rnd(&s->seed) % 14 : 1 + rnd(&s->seed) % MAX_READ_DW;
+        uint64_t addr = pick_addr(s);
+        uint8_t be = pick_be(s, len_dw), *payload;
+
+        if (rnd(&s->seed) % 2)
+            len_dw = rnd(&s->seed) % 2 + 1;     // Mostly DW and QW accesses
+        if (len_dw == 1)
+            be &= 0x0f;
+        payload = encode_mem(qe, write, addr, len_dw, be, i);
+        if (write) {
+            for (uint32_t k = 0; payload + k < qe + TLP_QE_SIZE; k++)
+                payload[k] = rnd(&s->seed);
+        }
+        s->expect_status[i] = ref_apply(&s->ref, write, addr & ~3ull, len_dw, be,
+                                        addr >> 32 ? 4 : 3, payload, s->expect_data[i]);
+    }
+
+    tlp_decode_qes(s->ring, RING_QES, s->ci, BATCH_QES, batch);
+    tlp_bar_serve(s->set, s->ring, batch, io);
+
+    for (uint32_t i = 0; i < BATCH_QES; i++) {
+        if (io->status[i] != s->expect_status[i]) {
+            mismatches++;
+            continue;
+        }
+        if (batch->kind[i] == TLP_KIND_MRD && io->status[i] == TLP_BAR_OK)
+            mismatches += memcmp(io->data + io->data_off[i], s->expect_data[i], batch->len_dw[i] * 4) != 0;
+    }
+    s->ci = (s->ci + BATCH_QES) % RING_QES;
+    return mismatches;
+}
+
+static uint32_t suite_compare_memory(struct suite *s)
+{
+    static uint8_t page[TLP_BAR_PAGE_SIZE];
+    uint32_t mismatches = 0;
+
+    // Callback traffic first, the dump below reads through the callbacks too
+    mismatches += s->reg0.read_bytes + s->reg2.read_bytes != s->ref.read_bytes;
+    mismatches += s->reg0.write_bytes + s->reg2.write_bytes != s->ref.write_bytes;
+
+    for (int i = 0; i < 2; i++) {
+        const struct ref_bar *b = &s->ref.bars[i];
+
+        for (uint64_t off = 0; off < b->size; off += TLP_BAR_PAGE_SIZE) {
+            if (b->kind[off / TLP_BAR_PAGE_SIZE] == REF_UNMAPPED)
+                continue;
+            tlp_bar_read(s->set, i * 2, off, page, TLP_BAR_PAGE_SIZE);
+            mismatches += memcmp(page, b->mem + off, TLP_BAR_PAGE_SIZE) != 0;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Correctness suite against the reference model
+ * @return: 0 if every access and the final memory match
+ */
+static int run_suite(uint32_t batches)
+{
+    static struct suite s;
+    static struct tlp_batch batch;
+    struct tlp_bar_io io = { .data = s.read_buf, .data_cap = sizeof(s.read_buf) };
+    uint32_t mismatches = 0, rebase = 0;
+
+    memset(&s, 0, sizeof(s));
+    s.seed = 0xba5e;
+    if (suite_setup(&s)) {
+        fprintf(stderr, "Suite setup failed\n");
+        suite_teardown(&s);
+        return -1;
+    }
+
+    for (uint32_t n = 0; n < batches; n++) {
+        // Every eighth batch gets a read buffer too small for all of its MRds
+        io.data_cap = n % 8 == 7 ? 1024 : sizeof(s.read_buf);
+        mismatches += suite_batch(&s, &batch, &io);
+
+        // The host moves BAR2 now and then; old addresses must turn into UR
+        if (n % 1000 == 999) {
+            uint64_t base = BAR2_BASE + (uint64_t)(++rebase % 4) * BAR2_SIZE;
+
+            tlp_bar_set_base(s.set, 2, base);
+            s.ref.bars[1].base = base;
+        }
+    }
+    mismatches += suite_compare_memory(&s);
+
+    printf("  %u batches of %d QEs, %u BAR2 rebases, region traffic %lu B read / %lu B written\n",
+           batches, BATCH_QES, rebase, s.ref.read_bytes, s.ref.write_bytes);
+    suite_teardown(&s);
+
+    if (mismatches) {
+        printf("✗ BAR backend disagrees with the reference model (%u mismatches)\n", mismatches);
+        return -1;
+    }
+    printf("✓ BAR backend matches the reference model\n");
+    return 0;
+}
+
+/*
+ * Throughput per access shape
+ */
+struct bench_case {
+    const char  *name;
+    int         write;
+    uint32_t    len_dw;
+    uint8_t     be;
+    uint64_t    region;         // Offsets inside BAR0: RAM or the MMIO pages
+    uint64_t    region_len;
+    uint32_t    align;
+};
+
+static const struct bench_case bench_cases[] = {
+    { "MWr 4B RAM",         1, 1,  0x0f, 0,            BAR0_RAM_LEN,  4 },
+    { "MRd 4B RAM",         0, 1,  0x0f, 0,            BAR0_RAM_LEN,  4 },
+    { "MWr 8B RAM",         1, 2,  0xff, 0,            BAR0_RAM_LEN,  8 },
+    { "MRd 8B RAM",         0, 2,  0xff, 0,            BAR0_RAM_LEN,  8 },
+    { "MWr 32B RAM",        1, 8,  0xff, 0,            BAR0_RAM_LEN,  4 },
+    { "MRd 256B RAM",       0, 64, 0xff, 0,            BAR0_RAM_LEN,  4 },
+    { "MWr 4B RAM, BE 0x6", 1, 1,  0x06, 0,            BAR0_RAM_LEN,  4 },
+    { "MWr 4B MMIO",        1, 1,  0x0f, BAR0_REG_OFF, BAR0_REG_LEN,  4 },
+    { "MRd 4B MMIO",        0, 1,  0x0f, BAR0_REG_OFF, BAR0_REG_LEN,  4 },
+};
+
+static void run_bench(const struct bench_case *c, uint64_t accesses)
+{
+    static uint8_t ring[RING_QES * TLP_QE_SIZE];
+    static uint8_t read_buf[BATCH_QES * MAX_READ_DW * 4];
+    static struct tlp_batch batches[RING_QES / BATCH_QES];
+    static struct test_region reg;
+    struct tlp_bar_io io = { .data = read_buf, .data_cap = sizeof(read_buf) };
+    struct tlp_bar_set *set = tlp_bar_set_create();
+    uint64_t seed = 0xacce55, done;
+    double serve, full, start;
+
+    if (!set || tlp_bar_setup(set, 0, BAR0_SIZE, BAR0_BASE) ||
+        tlp_bar_map_ram(set, 0, 0, BAR0_RAM_LEN) ||
+        tlp_bar_map_region(set, 0, BAR0_REG_OFF, BAR0_REG_LEN, &test_region_ops, &reg)) {
+        tlp_bar_set_destroy(set);
+        return;
+    }
+
+    for (uint32_t i = 0; i < RING_QES; i++) {
+        uint64_t off = c->region + (rnd(&seed) % (c->region_len / c->align)) * c->align;
+        uint8_t *qe = ring + (size_t)i * TLP_QE_SIZE;
+
+        if (off + c->len_dw * 4 > c->region + c->region_len)
+            off = c->region;
+        encode_mem(qe, c->write, BAR0_BASE + off, c->len_dw, c->be, i);
+    }
+    for (uint32_t b = 0; b < RING_QES / BATCH_QES; b++)
+        tlp_decode_qes(ring, RING_QES, b * BATCH_QES, BATCH_QES, &batches[b]);
+
+    // Populate RAM so reads take the fast path rather than the zero fill
+    for (uint64_t off = 0; off < BAR0_RAM_LEN; off += sizeof(read_buf))
+        tlp_bar_write(set, 0, off, read_buf, sizeof(read_buf));
+    for (uint32_t b = 0; b < RING_QES / BATCH_QES; b++)
+        tlp_bar_serve(set, ring, &batches[b], &io);
+
+    start = now_sec();
+    for (done = 0; done < accesses; done += BATCH_QES) {
+        tlp_bar_serve(set, ring, &batches[(done / BATCH_QES) % (RING_QES / BATCH_QES)], &io);
+        clobber(read_buf);
+    }
+    serve = now_sec() - start;
+
+    start = now_sec();
+    for (done = 0; done < accesses; done += BATCH_QES) {
+        tlp_decode_qes(ring, RING_QES, done % RING_QES, BATCH_QES, &batches[0]);
+        tlp_bar_serve(set, ring, &batches[0], &io);
+        clobber(read_buf);
+    }
+    full = now_sec() - start;
+
+    printf("  %-20s serve %7.1f M/s   decode + serve %7.1f M/s\n",
+           c->name, done / serve / 1e6, done / full / 1e6);
+    tlp_bar_set_destroy(set);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t accesses = argc > 1 ? strtoull(argv[1], NULL, 0) : 50000000;
+    uint32_t batches = argc > 2 ? strtoul(argv[2], NULL, 0) : 20000;
+
+    printf("TLP BAR Backend Benchmark\n");
+    printf("=========================\n");
+    printf("Usage: %s [accesses] [suite_batches]\n\n", argv[0]);
+
+    printf("Reference model suite:\n");
+    if (run_suite(batches))
+        return 1;
+
+    printf("\nAccesses per second (%lu per case, batches of %d QEs):\n", accesses, BATCH_QES);
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+        run_bench(&bench_cases[i], accesses);
+
+    return 0;
+}
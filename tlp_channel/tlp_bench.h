@@ -0,0 +1,140 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel benchmarks - helpers shared by the *_bench programs. Unless
+ * a bench says otherwise it runs on the CPU only and opens no device:
+ * queues live in host memory and the device's writes are simulated.
+ */
+
+#ifndef TLP_BENCH_H
+#define TLP_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <endian.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "tlp_numa.h"
+
+// Keep the compiler from dropping or merging iterations
+#define clobber(p)      __asm__ volatile("" : : "r"(p) : "memory")
+
+static inline double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// 64-bit LCG, high half out: reproducible streams from a seed
+static inline uint32_t rnd(uint64_t *s)
+{
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32_t)(*s >> 33);
+}
+
+// TLP headers are big endian DWs
+static inline void put_be32(uint8_t *p, uint32_t v)
+{
+    v = htobe32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline uint32_t get_be32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return be32toh(v);
+}
+
+// Spin a little, then give the CPU away (producer and consumer may share it)
+static inline void backoff(uint32_t *spins)
+{
+    if (++*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        return;
+    }
+    *spins = 0;
+    sched_yield();
+}
+
+// Evict [p, p + len) from the caches, as a device write to a queue would
+static inline void flush_lines(const void *p, size_t len)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    for (size_t off = 0; off < len; off += 64)
+        __builtin_ia32_clflush((const uint8_t *)p + off);
+    __builtin_ia32_mfence();
+#else
+    (void)p;
+    (void)len;
+#endif
+}
+
+/*
+ * CPUs of the first RDMA device's NUMA node, where its poller and workers
+ * belong. Without a device or NUMA information, every CPU the bench may
+ * use. Benches place threads on these instead of raw CPU numbers.
+ * @param node: Set to the node, -1 when the CPUs are not a node's
+ * @return: CPUs written to cpus, at least one (-1 for "unplaced")
+ */
+static inline int bench_cpus(int *node, int *cpus, int max)
+{
+    struct ibv_device **list;
+    int ndev = 0, n;
+
+    *node = -1;
+    list = ibv_get_device_list(&ndev);
+    if (list && ndev)
+        *node = tlp_numa_device_node(list[0]);
+    if (list)
+        ibv_free_device_list(list);
+    n = tlp_numa_node_cpus(*node, cpus, max);
+    if (n <= 0) {
+        *node = -1;
+        n = tlp_numa_thread_cpus(-1, cpus, max);
+    }
+    if (n <= 0) {
+        cpus[0] = -1;       // Unknown affinity, nothing is pinned
+        n = 1;
+    }
+    return n;
+}
+
+// Run the calling thread on one CPU, cpu < 0 leaves it to the scheduler
+static inline void pin_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0)
+        return;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// qsort() order for latency samples
+static inline int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+#endif /* TLP_BENCH_H */
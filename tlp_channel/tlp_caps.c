@@ -0,0 +1,260 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - per-device capability probe.
+ * TLP_EMU_CHANNEL support is read from the general_obj_types_127_64 bitmap
+ * in HCA_CAP_2, one firmware command instead of a buffer allocation, MR
+ * registration and a CREATE/DESTROY round trip. Results are cached per
+ * device in memory and persisted across runs by tlp_caps_snapshot.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_channel.h"
+#include "tlp_caps.h"
+#include "tlp_mr_cache.h"
+#include "tlp_pack.h"
+
+// general_obj_types_127_64 covers object types 0x40..0x7f
+#define TLP_CAPS_OBJ_TYPES_HI_BASE      0x40
+
+struct tlp_caps_entry {
+    struct ibv_context      *ctx;
+    struct tlp_device_caps  caps;
+    struct tlp_caps_entry   *next;
+};
+
+static pthread_mutex_t caps_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct tlp_caps_entry *caps_list;
+
+int tlp_caps_query(struct ibv_context *ctx, struct tlp_device_caps *caps)
+{
+    uint8_t in[DEVX_ST_SZ_BYTES(query_hca_cap_in)] = {0};
+    uint8_t out[DEVX_ST_SZ_BYTES(query_hca_cap_out)] = {0};
+
+    DEVX_SET(query_hca_cap_in, in, opcode, MLX5_CMD_OP_QUERY_HCA_CAP);
+    DEVX_SET(query_hca_cap_in, in, op_mod,
+             MLX5_SET_HCA_CAP_OP_MOD_GENERAL_DEVICE2 | HCA_CAP_OPMOD_GET_CUR);
+
+    if (mlx5dv_devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out))) {
+        fprintf(stderr, "QUERY_HCA_CAP(GENERAL_DEVICE2) failed, syndrome 0x%x: %s\n",
+                DEVX_GET(query_hca_cap_out, out, syndrome), strerror(errno));
+        return -1;
+    }
+
+    memset(caps, 0, sizeof(*caps));
+    snprintf(caps->dev_name, sizeof(caps->dev_name), "%s", ibv_get_device_name(ctx->device));
+    if (tlp_caps_read_identity(ctx->device, caps->fw_ver, sizeof(caps->fw_ver), &caps->hw_ver))
+        caps->fw_ver[0] = '\0';  // No snapshot key, caps are still usable
+    caps->general_obj_types_127_64 = DEVX_GET64(query_hca_cap_out, out,
+                                                capability.cmd_hca_cap2.general_obj_types_127_64);
+    caps->query_vuid = DEVX_GET(query_hca_cap_out, out, capability.cmd_hca_cap2.query_vuid);
+
+    caps->tlp_emu_channel = !!(caps->general_obj_types_127_64 &
+                               (1ULL << (MLX5_OBJ_TYPE_TLP_EMU_CHANNEL - TLP_CAPS_OBJ_TYPES_HI_BASE)));
+    if (caps->tlp_emu_channel)
+        caps->tlp_emu_channel_src = TLP_CAP_SRC_HCA_CAP2;
+
+    // PRM has no MODIFY support bit or queue limit fields for this object yet
+    caps->tlp_emu_channel_modify = 0;
+    caps->max_queue_size = TLP_CHANNEL_MAX_QUEUE_SIZE;
+
+    return 0;
+}
+
+static int caps_query_general(struct ibv_context *ctx, struct tlp_device_caps *caps)
+{
+    uint8_t in[DEVX_ST_SZ_BYTES(query_hca_cap_in)] = {0};
+    uint8_t out[DEVX_ST_SZ_BYTES(query_hca_cap_out)] = {0};
+    struct ibv_device_attr_ex attr_ex;
+    struct ibv_device_attr *device_attr = &attr_ex.orig_attr;
+    struct mlx5dv_context dv_ctx = {0};
+
+    if (ibv_query_device_ex(ctx, NULL, &attr_ex)) {
+        fprintf(stderr, "Failed to query device attributes\n");
+        return -1;
+    }
+    caps->vendor_id = device_attr->vendor_id;
+    caps->vendor_part_id = device_attr->vendor_part_id;
+    if (!caps->fw_ver[0]) {
+        // sysfs identity was unavailable, keep what verbs report
+        caps->hw_ver = device_attr->hw_ver;
+        snprintf(caps->fw_ver, sizeof(caps->fw_ver), "%s", device_attr->fw_ver);
+    }
+    caps->odp = !!(attr_ex.odp_caps.general_caps & IBV_ODP_SUPPORT);
+    caps->odp_implicit = !!(attr_ex.odp_caps.general_caps & IBV_ODP_SUPPORT_IMPLICIT);
+
+    caps->devx = mlx5dv_query_device(ctx, &dv_ctx) == 0;
+    caps->dv_version = dv_ctx.version;
+
+    DEVX_SET(query_hca_cap_in, in, opcode, MLX5_CMD_OP_QUERY_HCA_CAP);
+    DEVX_SET(query_hca_cap_in, in, op_mod,
+             MLX5_SET_HCA_CAP_OP_MOD_GENERAL_DEVICE | HCA_CAP_OPMOD_GET_CUR);
+    if (caps->devx && mlx5dv_devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out)) == 0)
+        caps->nvme_device_emulation_manager =
+            DEVX_GET(query_hca_cap_out, out, capability.cmd_hca_cap.nvme_device_emulation_manager);
+
+    caps->general_valid = 1;
+    return 0;
+}
+
+// Caller holds caps_lock
+static struct tlp_caps_entry *caps_lookup(struct ibv_context *ctx)
+{
+    struct tlp_caps_entry *entry;
+
+    for (entry = caps_list; entry; entry = entry->next) {
+        if (entry->ctx == ctx)
+            return entry;
+    }
+    return NULL;
+}
+
+const struct tlp_device_caps *tlp_caps_get(struct ibv_context *ctx)
+{
+    struct tlp_caps_entry *entry;
+
+    pthread_mutex_lock(&caps_lock);
+    entry = caps_lookup(ctx);
+    if (!entry) {
+        entry = calloc(1, sizeof(*entry));
+        if (!entry)
+            goto out;
+
+        // Warm start: snapshot still matches the running firmware
+        if (tlp_caps_snapshot_load(ctx->device, &entry->caps) != 0) {
+            if (tlp_caps_query(ctx, &entry->caps) != 0) {
+                free(entry);
+                entry = NULL;
+                goto out;
+            }
+            tlp_caps_snapshot_store(&entry->caps);
+        }
+
+        entry->ctx = ctx;
+        entry->next = caps_list;
+        caps_list = entry;
+    }
+out:
+    pthread_mutex_unlock(&caps_lock);
+
+    return entry ? &entry->caps : NULL;
+}
+
+const struct tlp_device_caps *tlp_caps_get_general(struct ibv_context *ctx)
+{
+    struct tlp_caps_entry *entry;
+
+    if (!tlp_caps_get(ctx))
+        return NULL;
+
+    pthread_mutex_lock(&caps_lock);
+    entry = caps_lookup(ctx);
+    if (entry && !entry->caps.general_valid) {
+        if (caps_query_general(ctx, &entry->caps) == 0)
+            tlp_caps_snapshot_store(&entry->caps);
+        else
+            entry = NULL;
+    }
+    pthread_mutex_unlock(&caps_lock);
+
+    return entry ? &entry->caps : NULL;
+}
+
+int tlp_caps_confirm_by_create(struct ibv_context *ctx, struct ibv_pd *pd)
+{
+    uint8_t in[TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ + TLP_PACK_TLP_EMU_CHANNEL_SZ];
+    uint8_t out[TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ] = {0};
+    struct tlp_pack_general_obj_out_cmd_hdr hdr_out;
+    struct tlp_caps_entry *entry;
+    struct ibv_mr *mr;
+    int ret;
+
+    // Minimal registered queue buffer, reused from the MR cache when one is idle
+    void *queue_buffer = tlp_mr_cache_alloc(pd, 512, IBV_ACCESS_LOCAL_WRITE, -1, &mr);
+    if (!queue_buffer) {
+        fprintf(stderr, "Failed to allocate registered queue buffer\n");
+        return -1;
+    }
+
+    // Setup CREATE command header
+    tlp_pack_general_obj_in_cmd_hdr(in, &(struct tlp_pack_general_obj_in_cmd_hdr) {
+        .opcode = MLX5_CMD_OP_CREATE_GENERAL_OBJECT,
+        .obj_type = MLX5_OBJ_TYPE_TLP_EMU_CHANNEL,
+    });
+
+    // Setup TLP_EMU_CHANNEL parameters
+    tlp_pack_tlp_emu_channel(in + TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ, &(struct tlp_pack_tlp_emu_channel) {
+        .q_protocol_mode = 0,
+        .q_mkey = mr->lkey,
+        .q_size = 512,
+        .q_addr = (uintptr_t)queue_buffer,
+        .tlp_channel_stride_index = 1,
+    });
+
+    ret = mlx5dv_devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out));
+    tlp_unpack_general_obj_out_cmd_hdr(out, &hdr_out);
+
+    printf("  DEVX call result: ret=%d, errno=%d (%s), syndrome=0x%x\n",
+           ret, errno, strerror(errno), hdr_out.syndrome);
+
+    // No probe object, nothing can still point at the buffer
+    if (ret || hdr_out.syndrome != 0) {
+        tlp_mr_cache_release(queue_buffer);
+        return -1;
+    }
+
+    // Clean up - destroy the probe object
+    uint8_t destroy_in[TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ];
+    uint8_t destroy_out[TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ] = {0};
+    struct tlp_pack_general_obj_out_cmd_hdr destroy_hdr;
+
+    tlp_pack_general_obj_in_cmd_hdr(destroy_in, &(struct tlp_pack_general_obj_in_cmd_hdr) {
+        .opcode = MLX5_CMD_OP_DESTROY_GENERAL_OBJECT,
+        .obj_type = MLX5_OBJ_TYPE_TLP_EMU_CHANNEL,
+        .obj_id = hdr_out.obj_id,
+    });
+
+    ret = mlx5dv_devx_general_cmd(ctx, destroy_in, sizeof(destroy_in), destroy_out, sizeof(destroy_out));
+    tlp_unpack_general_obj_out_cmd_hdr(destroy_out, &destroy_hdr);
+    // The buffer goes back to the MR cache, where another create on this PD may
+    // pick it up, only once no probe object points at it
+    if (ret == 0 && destroy_hdr.syndrome == 0)
+        tlp_mr_cache_release(queue_buffer);
+    else
+        fprintf(stderr, "Probe TLP_EMU_CHANNEL 0x%x not destroyed, keeping its queue registered\n",
+                hdr_out.obj_id);
+
+    tlp_caps_get(ctx);
+    pthread_mutex_lock(&caps_lock);
+    entry = caps_lookup(ctx);
+    if (entry) {
+        entry->caps.tlp_emu_channel = 1;
+        entry->caps.tlp_emu_channel_src = TLP_CAP_SRC_CREATE_PROBE;
+        tlp_caps_snapshot_store(&entry->caps);
+    }
+    pthread_mutex_unlock(&caps_lock);
+
+    return 0;
+}
+
+void tlp_caps_forget(struct ibv_context *ctx)
+{
+    struct tlp_caps_entry **link, *entry;
+
+    pthread_mutex_lock(&caps_lock);
+    for (link = &caps_list; (entry = *link) != NULL; link = &entry->next) {
+        if (entry->ctx == ctx) {
+            *link = entry->next;
+            free(entry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&caps_lock);
+}
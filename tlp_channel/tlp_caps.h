@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - per-device capability probe
+ */
+
+#ifndef TLP_CAPS_H
+#define TLP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+enum tlp_cap_source {
+    TLP_CAP_SRC_NONE            = 0,
+    TLP_CAP_SRC_HCA_CAP2        = 1,    // general_obj_types_127_64 bit
+    TLP_CAP_SRC_CREATE_PROBE    = 2,    // Confirmed by creating a real object
+};
+
+struct tlp_device_caps {
+    // Snapshot key, read from sysfs without a firmware command
+    char        dev_name[IBV_SYSFS_NAME_MAX];
+    char        fw_ver[64];
+    uint32_t    hw_ver;
+
+    // HCA_CAP_2 - always valid
+    uint64_t    general_obj_types_127_64;   // Object types 0x40..0x7f
+    uint8_t     tlp_emu_channel;            // Object type 0x59 supported
+    uint8_t     tlp_emu_channel_src;        // enum tlp_cap_source
+    uint8_t     tlp_emu_channel_modify;     // No PRM bit yet, always 0
+    uint8_t     query_vuid;
+    uint32_t    max_queue_size;             // No PRM field yet, spec limit
+
+    // Device attributes and HCA_CAP - valid once general_valid is set
+    uint8_t     general_valid;
+    uint8_t     devx;
+    uint8_t     nvme_device_emulation_manager;
+    uint8_t     odp;                        // IBV_ODP_SUPPORT
+    uint8_t     odp_implicit;               // IBV_ODP_SUPPORT_IMPLICIT
+    uint32_t    vendor_id;
+    uint32_t    vendor_part_id;
+    uint64_t    dv_version;
+};
+
+/**
+ * Query TLP capabilities with a single QUERY_HCA_CAP(GENERAL_DEVICE2)
+ *
+ * @param ctx: IBV context
+ * @param caps: Filled on success
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_caps_query(struct ibv_context *ctx, struct tlp_device_caps *caps);
+
+/**
+ * Get cached capabilities of a device, probing it on first use
+ *
+ * A persistent snapshot is tried first; it is used as long as the device's
+ * fw_ver/hw_ver in sysfs still match, so warm starts issue no commands.
+ * @return: Capability struct owned by the library, NULL if the probe failed
+ */
+const struct tlp_device_caps *tlp_caps_get(struct ibv_context *ctx);
+
+/**
+ * Same as tlp_caps_get() with the device attribute and HCA_CAP fields filled
+ *
+ * Costs ibv_query_device, mlx5dv_query_device and QUERY_HCA_CAP(GENERAL_DEVICE)
+ * only when the snapshot does not already carry them.
+ */
+const struct tlp_device_caps *tlp_caps_get_general(struct ibv_context *ctx);
+
+/**
+ * Confirm TLP_EMU_CHANNEL support by creating and destroying a real object
+ *
+ * Fallback for firmware that implements the object but does not advertise
+ * it in general_obj_types. Updates the cached capabilities on success.
+ * @return: 0 if supported, -1 otherwise
+ */
+int tlp_caps_confirm_by_create(struct ibv_context *ctx, struct ibv_pd *pd);
+
+/**
+ * Drop cached capabilities, call before ibv_close_device()
+ */
+void tlp_caps_forget(struct ibv_context *ctx);
+
+/*
+ * Persistent snapshot (tlp_caps_snapshot.c)
+ *
+ * One small binary file per device under $TLP_CAPS_CACHE_DIR (default
+ * /var/tmp/tlp_channel_caps). An empty TLP_CAPS_CACHE_DIR disables it.
+ */
+int tlp_caps_read_identity(struct ibv_device *dev, char *fw_ver, size_t fw_ver_len, uint32_t *hw_ver);
+int tlp_caps_snapshot_load(struct ibv_device *dev, struct tlp_device_caps *caps);
+int tlp_caps_snapshot_store(const struct tlp_device_caps *caps);
+
+#endif /* TLP_CAPS_H */
@@ -0,0 +1,190 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - persistent capability snapshot.
+ * The snapshot is keyed by device name, fw_ver and hw_ver. The key is read
+ * from sysfs, so a warm start validates and maps the file without issuing
+ * any verbs or firmware command; a firmware update changes fw_ver and the
+ * next start re-probes and rewrites the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tlp_caps.h"
+
+#define TLP_CAPS_SNAPSHOT_MAGIC         0x43504c54      // "TLPC"
+#define TLP_CAPS_SNAPSHOT_VERSION       2
+#define TLP_CAPS_SNAPSHOT_DEFAULT_DIR   "/var/tmp/tlp_channel_caps"
+
+struct tlp_caps_snapshot {
+    uint32_t                magic;
+    uint16_t                version;
+    uint16_t                caps_size;      // sizeof(struct tlp_device_caps) of the writer
+    uint32_t                checksum;       // FNV-1a over caps
+    uint32_t                reserved;
+    struct tlp_device_caps  caps;
+};
+
+static uint32_t snapshot_checksum(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int snapshot_path(const char *dev_name, char *path, size_t len)
+{
+    const char *dir = getenv("TLP_CAPS_CACHE_DIR");
+
+    if (!dir)
+        dir = TLP_CAPS_SNAPSHOT_DEFAULT_DIR;
+    if (!*dir)
+        return -1;  // Snapshot disabled
+
+    if (snprintf(path, len, "%s/%s.caps", dir, dev_name) >= (int)len)
+        return -1;
+    return 0;
+}
+
+static int read_sysfs_line(const char *dir, const char *file, char *buf, size_t len)
+{
+    char path[IBV_SYSFS_PATH_MAX + 32];
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    n = read(fd, buf, len - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+/**
+ * Read the snapshot key of a device from sysfs
+ */
+int tlp_caps_read_identity(struct ibv_device *dev, char *fw_ver, size_t fw_ver_len, uint32_t *hw_ver)
+{
+    char hw_rev[32];
+
+    if (read_sysfs_line(dev->ibdev_path, "fw_ver", fw_ver, fw_ver_len))
+        return -1;
+    if (read_sysfs_line(dev->ibdev_path, "hw_rev", hw_rev, sizeof(hw_rev)))
+        return -1;
+
+    // mlx5 prints hw_rev in hex, with or without 0x
+    *hw_ver = (uint32_t)strtoul(hw_rev, NULL, 16);
+    return 0;
+}
+
+/**
+ * Load the snapshot of a device if it is still valid for the running firmware
+ *
+ * @return: 0 if caps was filled from the snapshot, -1 if a probe is needed
+ */
+int tlp_caps_snapshot_load(struct ibv_device *dev, struct tlp_device_caps *caps)
+{
+    const struct tlp_caps_snapshot *snap;
+    char path[512], fw_ver[sizeof(caps->fw_ver)];
+    uint32_t hw_ver;
+    struct stat st;
+    int fd, ret = -1;
+
+    if (snapshot_path(ibv_get_device_name(dev), path, sizeof(path)))
+        return -1;
+    if (tlp_caps_read_identity(dev, fw_ver, sizeof(fw_ver), &hw_ver))
+        return -1;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) || st.st_size != sizeof(*snap)) {
+        close(fd);
+        return -1;
+    }
+
+    snap = mmap(NULL, sizeof(*snap), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (snap == MAP_FAILED)
+        return -1;
+
+    if (snap->magic == TLP_CAPS_SNAPSHOT_MAGIC &&
+        snap->version == TLP_CAPS_SNAPSHOT_VERSION &&
+        snap->caps_size == sizeof(snap->caps) &&
+        snap->checksum == snapshot_checksum(&snap->caps, sizeof(snap->caps)) &&
+        snap->caps.hw_ver == hw_ver &&
+        strncmp(snap->caps.dev_name, ibv_get_device_name(dev), sizeof(snap->caps.dev_name)) == 0 &&
+        strncmp(snap->caps.fw_ver, fw_ver, sizeof(snap->caps.fw_ver)) == 0) {
+        memcpy(caps, &snap->caps, sizeof(*caps));
+        ret = 0;
+    }
+
+    munmap((void *)snap, sizeof(*snap));
+    return ret;
+}
+
+/**
+ * Write the snapshot of a device, replacing any previous one atomically
+ */
+int tlp_caps_snapshot_store(const struct tlp_device_caps *caps)
+{
+    struct tlp_caps_snapshot snap;
+    char path[512], tmp[540];
+    char *slash;
+    int fd;
+
+    if (!caps->fw_ver[0] || snapshot_path(caps->dev_name, path, sizeof(path)))
+        return -1;
+
+    // Create the cache directory on first use
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    slash = strrchr(tmp, '/');
+    if (slash) {
+        *slash = '\0';
+        if (mkdir(tmp, 0755) && errno != EEXIST)
+            return -1;
+    }
+
+    memset(&snap, 0, sizeof(snap));
+    snap.magic = TLP_CAPS_SNAPSHOT_MAGIC;
+    snap.version = TLP_CAPS_SNAPSHOT_VERSION;
+    snap.caps_size = sizeof(snap.caps);
+    memcpy(&snap.caps, caps, sizeof(snap.caps));
+    snap.checksum = snapshot_checksum(&snap.caps, sizeof(snap.caps));
+
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return -1;
+    if (write(fd, &snap, sizeof(snap)) != sizeof(snap)) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+
+    if (rename(tmp, path)) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
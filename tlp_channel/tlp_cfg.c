@@ -0,0 +1,436 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - emulated configuration space.
+ * A layout holds everything known before the first TLP: the template image
+ * with the capability lists already linked, and per DW a write mask, an
+ * RW1C mask and a hook index. A function is a 4KB image plus a pointer to
+ * its layout, so serving a config TLP is a table lookup by BDF and one
+ * masked load or store; only registers with a hook take a call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <endian.h>
+
+#include "tlp_cfg.h"
+
+#define CFG_STATUS_CAP_LIST     0x0010
+#define CFG_CAP_START           0x40
+#define CFG_EXT_CAP_START       0x100
+
+struct tlp_cfg_layout {
+    uint8_t                         image[TLP_CFG_SIZE] __attribute__((aligned(64)));
+    uint32_t                        wmask[TLP_CFG_REGS];
+    uint32_t                        w1c[TLP_CFG_REGS];
+    uint8_t                         hook[TLP_CFG_REGS];     // 0 or hooks[] index + 1
+    const struct tlp_cfg_hook_ops   *hooks[TLP_CFG_HOOKS_MAX];
+    uint32_t                        nhooks;
+    uint16_t                        last_cap;       // Offset of the last capability, 0 if none
+    uint16_t                        cap_end;
+    uint16_t                        last_ext_cap;
+    uint16_t                        ext_cap_end;
+    uint8_t                         bar_flags[6];   // TLP_CFG_BAR_* | BAR_PRESENT / BAR_UPPER
+};
+
+#define BAR_PRESENT     (1u << 6)
+#define BAR_UPPER       (1u << 7)   // Upper half of the 64-bit BAR below
+
+struct tlp_cfg_func {
+    uint8_t                         image[TLP_CFG_SIZE] __attribute__((aligned(64)));
+    const struct tlp_cfg_layout     *layout;
+    struct tlp_bar_set              *bars;
+    void                            *priv;
+    uint16_t                        bdf;
+};
+
+struct tlp_cfg_port {
+    uint8_t                         sec_bus;
+    uint8_t                         sub_bus;
+    uint32_t                        nfuncs;
+    struct tlp_cfg_func             **funcs;        // (bus - sec_bus) << 8 | devfn
+};
+
+static int reg_ok(uint16_t off, uint32_t size)
+{
+    if ((size != 1 && size != 2 && size != 4) || off % size || off + size > TLP_CFG_SIZE) {
+        fprintf(stderr, "Invalid config register 0x%x size %u\n", off, size);
+        return 0;
+    }
+    return 1;
+}
+
+static uint32_t size_mask(uint32_t size)
+{
+    return size == 4 ? ~0u : (1u << (size * 8)) - 1;
+}
+
+int tlp_cfg_layout_set(struct tlp_cfg_layout *layout, uint16_t off, uint32_t size, uint32_t val)
+{
+    uint32_t le = htole32(val);
+
+    if (!reg_ok(off, size))
+        return -1;
+    memcpy(layout->image + off, &le, size);
+    return 0;
+}
+
+int tlp_cfg_layout_mask(struct tlp_cfg_layout *layout, uint16_t off, uint32_t size, uint32_t wmask, uint32_t w1c)
+{
+    uint32_t reg = off >> 2, shift = (off & 3) * 8, m;
+
+    if (!reg_ok(off, size))
+        return -1;
+    m = size_mask(size);
+    wmask &= m & ~w1c;
+    w1c &= m;
+    layout->wmask[reg] = (layout->wmask[reg] & ~(m << shift)) | wmask << shift;
+    layout->w1c[reg] = (layout->w1c[reg] & ~(m << shift)) | w1c << shift;
+    return 0;
+}
+
+struct tlp_cfg_layout *tlp_cfg_layout_create(uint16_t vendor, uint16_t device, uint32_t class_rev)
+{
+    struct tlp_cfg_layout *layout = aligned_alloc(64, sizeof(*layout));
+
+    if (!layout) {
+        fprintf(stderr, "Failed to allocate config layout\n");
+        return NULL;
+    }
+    memset(layout, 0, sizeof(*layout));
+    layout->cap_end = CFG_CAP_START;
+    layout->ext_cap_end = CFG_EXT_CAP_START;
+
+    tlp_cfg_layout_set(layout, 0x00, 2, vendor);
+    tlp_cfg_layout_set(layout, 0x02, 2, device);
+    tlp_cfg_layout_set(layout, 0x08, 4, class_rev);
+    // Command: I/O, memory, bus master, parity error response, SERR#, INTx disable
+    tlp_cfg_layout_mask(layout, 0x04, 2, 0x0547, 0);
+    // Status: master data parity error, target/master aborts, SERR#, parity error
+    tlp_cfg_layout_mask(layout, 0x06, 2, 0, 0xf900);
+    tlp_cfg_layout_mask(layout, 0x0c, 1, 0xff, 0);      // Cache line size
+    tlp_cfg_layout_mask(layout, 0x3c, 1, 0xff, 0);      // Interrupt line
+    return layout;
+}
+
+void tlp_cfg_layout_destroy(struct tlp_cfg_layout *layout)
+{
+    free(layout);
+}
+
+int tlp_cfg_layout_hook(struct tlp_cfg_layout *layout, uint16_t off, const struct tlp_cfg_hook_ops *ops)
+{
+    uint32_t slot;
+
+    if (off >= TLP_CFG_SIZE)
+        return -1;
+
+    // Registers sharing ops share the slot
+    for (slot = 0; slot < layout->nhooks; slot++)
+        if (layout->hooks[slot] == ops)
+            break;
+    if (slot == layout->nhooks) {
+        if (layout->nhooks == TLP_CFG_HOOKS_MAX) {
+            fprintf(stderr, "Config layout is out of hook slots\n");
+            return -1;
+        }
+        layout->hooks[layout->nhooks++] = ops;
+    }
+    layout->hook[off >> 2] = slot + 1;
+    return 0;
+}
+
+int tlp_cfg_layout_cap(struct tlp_cfg_layout *layout, uint8_t id, uint8_t len)
+{
+    uint16_t off = (layout->cap_end + 3) & ~3;
+
+    if (len < 2 || off + len > CFG_EXT_CAP_START) {
+        fprintf(stderr, "Capability 0x%x (%u bytes) does not fit\n", id, len);
+        return -1;
+    }
+
+    if (layout->last_cap) {
+        layout->image[layout->last_cap + 1] = off;
+    } else {
+        uint16_t status;
+
+        layout->image[0x34] = off;
+        memcpy(&status, layout->image + 0x06, 2);
+        status |= htole16(CFG_STATUS_CAP_LIST);
+        memcpy(layout->image + 0x06, &status, 2);
+    }
+    layout->image[off] = id;
+    layout->image[off + 1] = 0;
+    layout->last_cap = off;
+    layout->cap_end = off + len;
+    return off;
+}
+
+int tlp_cfg_layout_ext_cap(struct tlp_cfg_layout *layout, uint16_t id, uint8_t ver, uint16_t len)
+{
+    uint16_t off = (layout->ext_cap_end + 3) & ~3;
+    uint32_t hdr;
+
+    if (len < 4 || off + len > TLP_CFG_SIZE) {
+        fprintf(stderr, "Extended capability 0x%x (%u bytes) does not fit\n", id, len);
+        return -1;
+    }
+
+    if (layout->last_ext_cap) {
+        memcpy(&hdr, layout->image + layout->last_ext_cap, 4);
+        hdr = htole32(le32toh(hdr) | (uint32_t)off << 20);
+        memcpy(layout->image + layout->last_ext_cap, &hdr, 4);
+    }
+    tlp_cfg_layout_set(layout, off, 4, id | (uint32_t)(ver & 0xf) << 16);
+    layout->last_ext_cap = off;
+    layout->ext_cap_end = off + len;
+    return off;
+}
+
+/*
+ * BAR registers take the size-aligned address bits; attached BAR memory
+ * follows every write
+ */
+static void bar_hook_write(struct tlp_cfg_func *func, uint16_t off, uint32_t old, uint32_t data, uint8_t be)
+{
+    const struct tlp_cfg_layout *layout = func->layout;
+    int bar = (off - 0x10) >> 2;
+    uint32_t lo, hi = 0;
+
+    (void)old;
+    (void)data;
+    (void)be;
+    if (!func->bars)
+        return;
+    if (layout->bar_flags[bar] & BAR_UPPER)
+        bar--;
+
+    memcpy(&lo, func->image + 0x10 + bar * 4, 4);
+    if (layout->bar_flags[bar] & TLP_CFG_BAR_64)
+        memcpy(&hi, func->image + 0x14 + bar * 4, 4);
+    tlp_bar_set_base(func->bars, bar, (uint64_t)le32toh(hi) << 32 | (le32toh(lo) & ~0xfu));
+}
+
+static const struct tlp_cfg_hook_ops bar_hook_ops = {
+    .write = bar_hook_write,
+};
+
+int tlp_cfg_layout_bar(struct tlp_cfg_layout *layout, int bar, uint64_t size, uint32_t flags)
+{
+    int is64 = !!(flags & TLP_CFG_BAR_64);
+    uint16_t off = 0x10 + bar * 4;
+    uint64_t addr_mask = ~(size - 1);
+
+    if (bar < 0 || bar + is64 >= 6 || size < 16 || (size & (size - 1)) ||
+        (!is64 && size > (1ull << 31))) {
+        fprintf(stderr, "Invalid BAR%d size 0x%lx\n", bar, size);
+        return -1;
+    }
+
+    tlp_cfg_layout_set(layout, off, 4, (is64 ? 0x4 : 0) | (flags & TLP_CFG_BAR_PREFETCH ? 0x8 : 0));
+    tlp_cfg_layout_mask(layout, off, 4, (uint32_t)addr_mask & ~0xfu, 0);
+    layout->bar_flags[bar] = (flags & (TLP_CFG_BAR_64 | TLP_CFG_BAR_PREFETCH)) | BAR_PRESENT;
+    if (tlp_cfg_layout_hook(layout, off, &bar_hook_ops))
+        return -1;
+    if (is64) {
+        tlp_cfg_layout_set(layout, off + 4, 4, 0);
+        tlp_cfg_layout_mask(layout, off + 4, 4, (uint32_t)(addr_mask >> 32), 0);
+        layout->bar_flags[bar + 1] = BAR_UPPER;
+        if (tlp_cfg_layout_hook(layout, off + 4, &bar_hook_ops))
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * Functions behind a downstream port
+ */
+struct tlp_cfg_port *tlp_cfg_port_create(uint8_t sec_bus, uint8_t sub_bus)
+{
+    struct tlp_cfg_port *port;
+
+    if (sub_bus < sec_bus) {
+        fprintf(stderr, "Invalid bus range %02x-%02x\n", sec_bus, sub_bus);
+        return NULL;
+    }
+    port = calloc(1, sizeof(*port));
+    if (!port)
+        return NULL;
+    port->sec_bus = sec_bus;
+    port->sub_bus = sub_bus;
+    port->nfuncs = (sub_bus - sec_bus + 1) << 8;
+    port->funcs = calloc(port->nfuncs, sizeof(*port->funcs));
+    if (!port->funcs) {
+        free(port);
+        return NULL;
+    }
+    return port;
+}
+
+void tlp_cfg_port_destroy(struct tlp_cfg_port *port)
+{
+    if (!port)
+        return;
+    for (uint32_t i = 0; i < port->nfuncs; i++)
+        free(port->funcs[i]);
+    free(port->funcs);
+    free(port);
+}
+
+static inline struct tlp_cfg_func **func_slot(const struct tlp_cfg_port *port, uint16_t bdf)
+{
+    uint32_t idx = bdf - ((uint32_t)port->sec_bus << 8);
+
+    return idx < port->nfuncs ? &port->funcs[idx] : NULL;
+}
+
+struct tlp_cfg_func *tlp_cfg_func_add(struct tlp_cfg_port *port, uint16_t bdf,
+                                      const struct tlp_cfg_layout *layout, void *priv)
+{
+    struct tlp_cfg_func **slot = func_slot(port, bdf), *func;
+
+    if (!slot || *slot) {
+        fprintf(stderr, "BDF %02x:%02x.%x is %s\n", bdf >> 8, (bdf >> 3) & 0x1f, bdf & 7,
+                slot ? "already taken" : "outside the port bus range");
+        return NULL;
+    }
+    func = aligned_alloc(64, sizeof(*func));
+    if (!func) {
+        fprintf(stderr, "Failed to allocate config function\n");
+        return NULL;
+    }
+    memcpy(func->image, layout->image, TLP_CFG_SIZE);
+    func->layout = layout;
+    func->bars = NULL;
+    func->priv = priv;
+    func->bdf = bdf;
+    *slot = func;
+    return func;
+}
+
+int tlp_cfg_func_remove(struct tlp_cfg_port *port, uint16_t bdf)
+{
+    struct tlp_cfg_func **slot = func_slot(port, bdf);
+
+    if (!slot || !*slot)
+        return -1;
+    free(*slot);
+    *slot = NULL;
+    return 0;
+}
+
+struct tlp_cfg_func *tlp_cfg_func_get(const struct tlp_cfg_port *port, uint16_t bdf)
+{
+    struct tlp_cfg_func **slot = func_slot(port, bdf);
+
+    return slot ? *slot : NULL;
+}
+
+void *tlp_cfg_func_priv(const struct tlp_cfg_func *func)
+{
+    return func->priv;
+}
+
+uint16_t tlp_cfg_func_bdf(const struct tlp_cfg_func *func)
+{
+    return func->bdf;
+}
+
+void tlp_cfg_func_attach_bars(struct tlp_cfg_func *func, struct tlp_bar_set *bars)
+{
+    func->bars = bars;
+}
+
+void tlp_cfg_func_reset(struct tlp_cfg_func *func)
+{
+    memcpy(func->image, func->layout->image, TLP_CFG_SIZE);
+}
+
+int tlp_cfg_func_read(const struct tlp_cfg_func *func, uint16_t off, void *buf, uint32_t len)
+{
+    if (off + len > TLP_CFG_SIZE)
+        return -1;
+    memcpy(buf, func->image + off, len);
+    return 0;
+}
+
+int tlp_cfg_func_write(struct tlp_cfg_func *func, uint16_t off, const void *buf, uint32_t len)
+{
+    if (off + len > TLP_CFG_SIZE)
+        return -1;
+    memcpy(func->image + off, buf, len);
+    return 0;
+}
+
+/*
+ * TLP path
+ */
+#define BE_MASK(be)     (((be) & 1 ? 0xffu : 0) | ((be) & 2 ? 0xff00u : 0) | \
+                         ((be) & 4 ? 0xff0000u : 0) | ((be) & 8 ? 0xff000000u : 0))
+
+static const uint32_t be_mask[16] = {
+    BE_MASK(0),  BE_MASK(1),  BE_MASK(2),  BE_MASK(3),
+    BE_MASK(4),  BE_MASK(5),  BE_MASK(6),  BE_MASK(7),
+    BE_MASK(8),  BE_MASK(9),  BE_MASK(10), BE_MASK(11),
+    BE_MASK(12), BE_MASK(13), BE_MASK(14), BE_MASK(15),
+};
+
+uint32_t tlp_cfg_serve(struct tlp_cfg_port *port, const void *ring, const struct tlp_batch *batch,
+                       struct tlp_cfg_io *io)
+{
+    uint32_t served = 0;
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        uint8_t kind = batch->kind[i];
+        const struct tlp_cfg_layout *layout;
+        struct tlp_cfg_func **slot, *func;
+        uint16_t off;
+        uint32_t val, hook;
+
+        if (kind < TLP_KIND_CFGRD0 || kind > TLP_KIND_CFGWR1) {
+            io->status[i] = TLP_CFG_SKIP;
+            continue;
+        }
+        slot = func_slot(port, batch->target[i]);
+        func = slot ? *slot : NULL;
+        if (!func) {
+            io->status[i] = TLP_CFG_UR;
+            io->data[i] = ~0u;
+            continue;
+        }
+        if (batch->len_dw[i] != 1) {
+            io->status[i] = TLP_CFG_MALFORMED;
+            continue;
+        }
+
+        layout = func->layout;
+        off = batch->addr[i] & (TLP_CFG_SIZE - 4);
+        hook = layout->hook[off >> 2];
+        memcpy(&val, func->image + off, 4);
+        val = le32toh(val);
+
+        if (kind == TLP_KIND_CFGRD0 || kind == TLP_KIND_CFGRD1) {
+            if (hook && layout->hooks[hook - 1]->read)
+                val = layout->hooks[hook - 1]->read(func, off, val);
+            io->data[i] = val;
+        } else {
+            const uint8_t *payload = (const uint8_t *)ring + (size_t)batch->qe[i] * TLP_QE_SIZE +
+                                     batch->hdr_dw[i] * 4;
+            uint32_t data, m = be_mask[batch->be[i] & 0xf], wm, clear, le;
+
+            memcpy(&data, payload, 4);
+            data = le32toh(data);
+            wm = layout->wmask[off >> 2] & m;
+            clear = layout->w1c[off >> 2] & m & data;
+            le = htole32((val & ~wm & ~clear) | (data & wm));
+            memcpy(func->image + off, &le, 4);
+            if (hook && layout->hooks[hook - 1]->write)
+                layout->hooks[hook - 1]->write(func, off, val, data, batch->be[i] & 0xf);
+        }
+        io->status[i] = TLP_CFG_OK;
+        served++;
+    }
+    return served;
+}
@@ -0,0 +1,153 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - emulated configuration space
+ */
+
+#ifndef TLP_CFG_H
+#define TLP_CFG_H
+
+#include <stdint.h>
+
+#include "tlp_decode.h"
+#include "tlp_bar.h"
+
+#define TLP_CFG_SIZE            4096
+#define TLP_CFG_REGS            (TLP_CFG_SIZE / 4)
+#define TLP_CFG_HOOKS_MAX       31
+
+// tlp_cfg_layout_bar() flags
+#define TLP_CFG_BAR_64          (1u << 0)
+#define TLP_CFG_BAR_PREFETCH    (1u << 1)
+
+struct tlp_cfg_layout;
+struct tlp_cfg_func;
+struct tlp_cfg_port;
+
+/*
+ * Side effects of one config DW. Both run after the plain access: read may
+ * replace the value returned, write sees the DW before the store and the
+ * raw data with its byte enables (bits outside the write mask included).
+ */
+struct tlp_cfg_hook_ops {
+    uint32_t (*read)(struct tlp_cfg_func *func, uint16_t off, uint32_t val);
+    void (*write)(struct tlp_cfg_func *func, uint16_t off, uint32_t old, uint32_t data, uint8_t be);
+};
+
+// Per-row result of tlp_cfg_serve()
+enum tlp_cfg_status {
+    TLP_CFG_SKIP = 0,           // Not a CfgRd/CfgWr, left to other handlers
+    TLP_CFG_OK,
+    TLP_CFG_UR,                 // No function at the BDF (Unsupported Request)
+    TLP_CFG_MALFORMED,          // Length other than one DW
+};
+
+/**
+ * Config space template shared by functions of the same kind
+ *
+ * Starts as a type 0 header with the standard write masks (command, cache
+ * line size, interrupt line) and RW1C status bits. Capabilities, masks and
+ * hooks are added before functions are created from it; the layout must
+ * outlive them.
+ * @param class_rev: Class code << 8 | revision ID
+ * @return: layout, NULL on failure
+ */
+struct tlp_cfg_layout *tlp_cfg_layout_create(uint16_t vendor, uint16_t device, uint32_t class_rev);
+void tlp_cfg_layout_destroy(struct tlp_cfg_layout *layout);
+
+/**
+ * Declare a memory BAR; its register accepts only the size-aligned bits
+ *
+ * Functions with attached BAR memory (tlp_cfg_func_attach_bars()) follow
+ * the address programmed by the host.
+ * @param size: Power of two, at least 16 bytes
+ * @param flags: TLP_CFG_BAR_*, a 64-bit BAR also takes bar + 1
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_cfg_layout_bar(struct tlp_cfg_layout *layout, int bar, uint64_t size, uint32_t flags);
+
+/**
+ * Append a capability and link it into the list
+ *
+ * The body is zero, fill it with tlp_cfg_layout_set() and tlp_cfg_layout_mask().
+ * @param len: Bytes including the header
+ * @return: config offset of the capability, -1 if it does not fit
+ */
+int tlp_cfg_layout_cap(struct tlp_cfg_layout *layout, uint8_t id, uint8_t len);
+int tlp_cfg_layout_ext_cap(struct tlp_cfg_layout *layout, uint16_t id, uint8_t ver, uint16_t len);
+
+/**
+ * Template content and write behavior of a register
+ *
+ * @param size: 1, 2 or 4, naturally aligned
+ * @param wmask: Bits the host may write
+ * @param w1c: Bits the host clears by writing 1 (RW1C)
+ * @return: 0 on success, -1 on a bad offset or size
+ */
+int tlp_cfg_layout_set(struct tlp_cfg_layout *layout, uint16_t off, uint32_t size, uint32_t val);
+int tlp_cfg_layout_mask(struct tlp_cfg_layout *layout, uint16_t off, uint32_t size, uint32_t wmask, uint32_t w1c);
+
+/**
+ * Attach side effects to the DW holding off
+ *
+ * @return: 0 on success, -1 when all hook slots are used
+ */
+int tlp_cfg_layout_hook(struct tlp_cfg_layout *layout, uint16_t off, const struct tlp_cfg_hook_ops *ops);
+
+/**
+ * Downstream port with the functions below it
+ *
+ * Functions are looked up by BDF in a flat table covering the secondary
+ * to subordinate bus range, 256 functions per bus (ARI).
+ * @return: port, NULL on failure
+ */
+struct tlp_cfg_port *tlp_cfg_port_create(uint8_t sec_bus, uint8_t sub_bus);
+void tlp_cfg_port_destroy(struct tlp_cfg_port *port);
+
+/**
+ * Create a function at bdf from a layout
+ *
+ * @param priv: Device model state for hooks, see tlp_cfg_func_priv()
+ * @return: function, NULL on failure or if the BDF is taken
+ */
+struct tlp_cfg_func *tlp_cfg_func_add(struct tlp_cfg_port *port, uint16_t bdf,
+                                      const struct tlp_cfg_layout *layout, void *priv);
+int tlp_cfg_func_remove(struct tlp_cfg_port *port, uint16_t bdf);
+struct tlp_cfg_func *tlp_cfg_func_get(const struct tlp_cfg_port *port, uint16_t bdf);
+void *tlp_cfg_func_priv(const struct tlp_cfg_func *func);
+uint16_t tlp_cfg_func_bdf(const struct tlp_cfg_func *func);
+
+// Follow BAR programming of the function in a BAR backend, NULL to detach
+void tlp_cfg_func_attach_bars(struct tlp_cfg_func *func, struct tlp_bar_set *bars);
+
+// Restore the layout template, e.g. on Function Level Reset
+void tlp_cfg_func_reset(struct tlp_cfg_func *func);
+
+/**
+ * Device side access to the image, bypassing masks and hooks
+ *
+ * @return: 0 on success, -1 if the range is outside config space
+ */
+int tlp_cfg_func_read(const struct tlp_cfg_func *func, uint16_t off, void *buf, uint32_t len);
+int tlp_cfg_func_write(struct tlp_cfg_func *func, uint16_t off, const void *buf, uint32_t len);
+
+// Read data of the CfgRd rows in a batch, one DW each
+struct tlp_cfg_io {
+    uint8_t     status[TLP_BATCH_MAX];      // enum tlp_cfg_status
+    uint32_t    data[TLP_BATCH_MAX];        // CfgRd row: register value, all ones on UR
+};
+
+/**
+ * Serve the CfgRd/CfgWr rows of a decoded batch
+ *
+ * Rows are applied in order. A read is one load from the image and a write
+ * one masked store, unless the register has a hook; the capability lists
+ * are never walked.
+ * @param ring: Queue the batch was decoded from
+ * @return: number of rows served (TLP_CFG_OK)
+ */
+uint32_t tlp_cfg_serve(struct tlp_cfg_port *port, const void *ring, const struct tlp_batch *batch,
+                       struct tlp_cfg_io *io);
+
+#endif /* TLP_CFG_H */
@@ -0,0 +1,858 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel config space benchmark - 512 ARI functions behind one
+ * downstream port, served by the precomputed engine (tlp_cfg.h) and by a
+ * naive handler that walks the capability lists on every access. A random
+ * suite checks both agree on every completion and on the final images,
+ * then an enumeration trace and a random access mix are timed.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "tlp_cfg.h"
+#include "tlp_decode.h"
+
+#define RING_QES        1024
+#define BATCH_QES       64
+
+#define SEC_BUS         1
+#define SUB_BUS         3       // Buses 1 and 2 populated, bus 3 empty
+#define POP_BUSES       2
+#define NFUNCS          (POP_BUSES * 256)
+
+#define VENDOR_ID       0x15b3
+#define DEVICE_ID       0x101e
+#define CLASS_REV       0x02000000
+#define REQUESTER_ID    0x0000
+
+static uint32_t load32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return le32toh(v);
+}
+
+static void store32(uint8_t *p, uint32_t v)
+{
+    v = htole32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static void encode_cfg(uint8_t *qe, int write, uint16_t bdf, uint16_t off, uint8_t be,
+                       uint32_t data, uint16_t len_dw, uint8_t tag)
+{
+    uint8_t fmt_type = (write ? 0x44 : 0x04) | ((bdf >> 8) != SEC_BUS);   // Type 1 below the secondary bus
+
+    put_be32(qe, (uint32_t)fmt_type << 24 | len_dw);
+    put_be32(qe + 4, (uint32_t)REQUESTER_ID << 16 | (uint32_t)tag << 8 | (be & 0xf));
+    put_be32(qe + 8, (uint32_t)bdf << 16 | (off & 0xffc));
+    store32(qe + 12, data);
+}
+
+/*
+ * Device description shared by both handlers
+ */
+enum { HOOK_NONE, HOOK_FLR, HOOK_MSIX, HOOK_COUNTER, HOOK_MAX };
+
+struct field {
+    uint16_t    off;            // Relative to the capability
+    uint8_t     size;
+    uint32_t    init;
+    uint32_t    wmask;
+    uint32_t    w1c;
+    uint8_t     hook;
+};
+
+struct cap_desc {
+    uint16_t            id;
+    uint8_t             ver;
+    uint8_t             ext;
+    uint16_t            len;
+    const struct field  *fields;
+    uint32_t            nfields;
+};
+
+#define BAR0_SIZE       (16u << 20)     // 64-bit prefetchable
+#define BAR2_SIZE       (64u << 10)
+
+static const struct field header_fields[] = {
+    { 0x00, 2, VENDOR_ID,  0,                           0 },
+    { 0x02, 2, DEVICE_ID,  0,                           0 },
+    { 0x04, 2, 0,          0x0547,                      0 },
+    { 0x06, 2, 0x0010,     0,                           0xf900 },
+    { 0x08, 4, CLASS_REV,  0,                           0 },
+    { 0x0c, 1, 0,          0xff,                        0 },
+    { 0x10, 4, 0xc,        ~(BAR0_SIZE - 1) & ~0xfu,    0 },
+    { 0x14, 4, 0,          0xffffffff,                  0 },
+    { 0x18, 4, 0,          ~(BAR2_SIZE - 1) & ~0xfu,    0 },
+    { 0x3c, 1, 0,          0xff,                        0 },
+};
+
+static const struct field pm_fields[] = {
+    { 0x02, 2, 0x0003, 0,      0 },
+    { 0x04, 2, 0x0008, 0x0103, 0x8000 },
+};
+
+static const struct field msix_fields[] = {
+    { 0x02, 2, 0x003f,     0xc000, 0, HOOK_MSIX },
+    { 0x04, 4, 0x00000000, 0,      0 },
+    { 0x08, 4, 0x00008000, 0,      0 },
+};
+
+static const struct field pcie_fields[] = {
+    { 0x02, 2, 0x0002,     0,      0 },
+    { 0x04, 4, 0x10008fc2, 0,      0 },
+    { 0x08, 2, 0x2810,     0x7eff, 0, HOOK_FLR },  // Initiate FLR (bit 15) reads as 0
+    { 0x0a, 2, 0,          0,      0x000f },
+    { 0x0c, 4, 0x00400c43, 0,      0 },
+    { 0x10, 2, 0,          0x0ffb, 0 },
+    { 0x12, 2, 0x1043,     0,      0xc000 },
+    { 0x28, 2, 0,          0x061f, 0 },
+};
+
+static const struct field vendor_fields[] = {
+    { 0x02, 1, 16, 0,          0 },
+    { 0x04, 4, 0,  0xffffffff, 0 },                 // Scratch
+    { 0x08, 4, 0,  0,          0, HOOK_COUNTER },   // Returns its read count
+};
+
+static const struct field aer_fields[] = {
+    { 0x04, 4, 0,          0,          0x03fff030 },
+    { 0x08, 4, 0,          0x03fff030, 0 },
+    { 0x0c, 4, 0x00462030, 0x03fff030, 0 },
+    { 0x10, 4, 0,          0,          0x0000f1c1 },
+    { 0x14, 4, 0x00002000, 0x0000f1c1, 0 },
+    { 0x18, 4, 0,          0x00000140, 0 },
+};
+
+static const struct field ari_fields[] = {
+    { 0x04, 2, 0, 0,      0 },                      // Next function number, per function
+    { 0x06, 2, 0, 0x0070, 0 },
+};
+
+static const struct field dsn_fields[] = {
+    { 0x04, 4, 0x0000cafe, 0, 0 },
+    { 0x08, 4, 0x00c0ffee, 0, 0 },
+};
+
+#define CAP(i, v, e, l, f)  { i, v, e, l, f, sizeof(f) / sizeof(f[0]) }
+
+static const struct cap_desc caps[] = {
+    CAP(0x01,   0, 0, 8,    pm_fields),
+    CAP(0x11,   0, 0, 12,   msix_fields),
+    CAP(0x10,   0, 0, 0x3c, pcie_fields),
+    CAP(0x09,   0, 0, 16,   vendor_fields),
+    CAP(0x0001, 2, 1, 0x48, aer_fields),
+    CAP(0x000e, 1, 1, 8,    ari_fields),
+    CAP(0x0003, 1, 1, 12,   dsn_fields),
+};
+
+#define NCAPS           (sizeof(caps) / sizeof(caps[0]))
+
+// Offsets the layout assigned, filled by build_layout()
+static uint16_t cap_off[NCAPS];
+static uint16_t ari_cap_off, pcie_cap_off, aer_cap_off;
+
+static uint16_t next_fn(uint32_t idx)
+{
+    // ARI next function number: the chain covers the functions of one bus
+    return (idx & 0xff) == 0xff ? 0 : (uint16_t)(((idx & 0xff) + 1) << 8);
+}
+
+static uint16_t func_bdf(uint32_t idx)
+{
+    return (uint16_t)((SEC_BUS + idx / 256) << 8 | (idx & 0xff));
+}
+
+/*
+ * Hook side effects, mirrored by both handlers
+ */
+struct func_state {
+    uint32_t    idx;
+    uint32_t    flr;
+    uint32_t    msix_toggles;
+    uint32_t    counter_reads;
+};
+
+static void per_func_init(uint8_t *image, uint32_t idx)
+{
+    uint16_t v = htole16(next_fn(idx));
+
+    memcpy(image + ari_cap_off + 4, &v, 2);
+}
+
+/*
+ * Engine handler
+ */
+static struct func_state engine_state[NFUNCS];
+
+static void engine_func_init(struct tlp_cfg_func *func, uint32_t idx)
+{
+    uint16_t v = htole16(next_fn(idx));
+
+    tlp_cfg_func_write(func, ari_cap_off + 4, &v, 2);
+}
+
+static void engine_flr(struct tlp_cfg_func *func, uint16_t off, uint32_t old, uint32_t data, uint8_t be)
+{
+    struct func_state *st = tlp_cfg_func_priv(func);
+
+    (void)off;
+    (void)old;
+    if (!(be & 2) || !(data & 0x8000))
+        return;
+    st->flr++;
+    tlp_cfg_func_reset(func);
+    engine_func_init(func, st->idx);
+}
+
+static void engine_msix(struct tlp_cfg_func *func, uint16_t off, uint32_t old, uint32_t data, uint8_t be)
+{
+    struct func_state *st = tlp_cfg_func_priv(func);
+    uint8_t now[4];
+
+    (void)data;
+    (void)be;
+    tlp_cfg_func_read(func, off, now, 4);
+    st->msix_toggles += ((old ^ load32(now)) >> 31) & 1;
+}
+
+static uint32_t engine_counter(struct tlp_cfg_func *func, uint16_t off, uint32_t val)
+{
+    struct func_state *st = tlp_cfg_func_priv(func);
+
+    (void)off;
+    (void)val;
+    return ++st->counter_reads;
+}
+
+static const struct tlp_cfg_hook_ops engine_hooks[HOOK_MAX] = {
+    [HOOK_FLR] = { .write = engine_flr },
+    [HOOK_MSIX] = { .write = engine_msix },
+    [HOOK_COUNTER] = { .read = engine_counter },
+};
+
+static int add_fields(struct tlp_cfg_layout *layout, uint16_t base, const struct field *f, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t off = base + f[i].off;
+
+        if (tlp_cfg_layout_set(layout, off, f[i].size, f[i].init) ||
+            tlp_cfg_layout_mask(layout, off, f[i].size, f[i].wmask, f[i].w1c) ||
+            (f[i].hook && tlp_cfg_layout_hook(layout, off & ~3, &engine_hooks[f[i].hook])))
+            return -1;
+    }
+    return 0;
+}
+
+static struct tlp_cfg_layout *build_layout(void)
+{
+    struct tlp_cfg_layout *layout = tlp_cfg_layout_create(VENDOR_ID, DEVICE_ID, CLASS_REV);
+
+    if (!layout ||
+        tlp_cfg_layout_bar(layout, 0, BAR0_SIZE, TLP_CFG_BAR_64 | TLP_CFG_BAR_PREFETCH) ||
+        tlp_cfg_layout_bar(layout, 2, BAR2_SIZE, 0))
+        goto err;
+
+    for (uint32_t c = 0; c < NCAPS; c++) {
+        int off = caps[c].ext ? tlp_cfg_layout_ext_cap(layout, caps[c].id, caps[c].ver, caps[c].len) :
+                                tlp_cfg_layout_cap(layout, caps[c].id, caps[c].len);
+
+        if (off < 0 || add_fields(layout, off, caps[c].fields, caps[c].nfields))
+            goto err;
+        cap_off[c] = off;
+        if (caps[c].ext && caps[c].id == 0x000e)
+            ari_cap_off = off;
+        if (caps[c].ext && caps[c].id == 0x0001)
+            aer_cap_off = off;
+        if (!caps[c].ext && caps[c].id == 0x10)
+            pcie_cap_off = off;
+    }
+    return layout;
+
+err:
+    fprintf(stderr, "Failed to build config layout\n");
+    tlp_cfg_layout_destroy(layout);
+    return NULL;
+}
+
+static struct tlp_cfg_port *build_port(const struct tlp_cfg_layout *layout)
+{
+    struct tlp_cfg_port *port = tlp_cfg_port_create(SEC_BUS, SUB_BUS);
+
+    if (!port)
+        return NULL;
+    for (uint32_t i = 0; i < NFUNCS; i++) {
+        struct tlp_cfg_func *func;
+
+        engine_state[i] = (struct func_state) { .idx = i };
+        func = tlp_cfg_func_add(port, func_bdf(i), layout, &engine_state[i]);
+        if (!func) {
+            tlp_cfg_port_destroy(port);
+            return NULL;
+        }
+        engine_func_init(func, i);
+    }
+    return port;
+}
+
+/*
+ * Naive handler: builds its own images and, on every access, walks the
+ * header fields or the capability list to find the masks and hook of the DW
+ */
+struct naive_func {
+    uint8_t             image[TLP_CFG_SIZE];
+    struct func_state   st;
+};
+
+static uint8_t naive_template[TLP_CFG_SIZE];
+
+static void naive_fields(uint8_t *image, uint16_t base, const struct field *f, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = htole32(f[i].init);
+
+        memcpy(image + base + f[i].off, &v, f[i].size);
+    }
+}
+
+static void naive_build_template(void)
+{
+    uint8_t *img = naive_template;
+    uint16_t cap = 0x40, ext = 0x100, last = 0, last_ext = 0;
+
+    memset(img, 0, TLP_CFG_SIZE);
+    naive_fields(img, 0, header_fields, sizeof(header_fields) / sizeof(header_fields[0]));
+    for (uint32_t c = 0; c < NCAPS; c++) {
+        const struct cap_desc *d = &caps[c];
+
+        if (!d->ext) {
+            cap = (cap + 3) & ~3;
+            if (last)
+                img[last + 1] = cap;
+            else
+                img[0x34] = cap;
+            img[cap] = d->id;
+            naive_fields(img, cap, d->fields, d->nfields);
+            last = cap;
+            cap += d->len;
+        } else {
+            ext = (ext + 3) & ~3;
+            if (last_ext)
+                store32(img + last_ext, load32(img + last_ext) | (uint32_t)ext << 20);
+            store32(img + ext, d->id | (uint32_t)d->ver << 16);
+            naive_fields(img, ext, d->fields, d->nfields);
+            last_ext = ext;
+            ext += d->len;
+        }
+    }
+}
+
+static const struct cap_desc *naive_cap(uint16_t id, int ext)
+{
+    for (uint32_t c = 0; c < NCAPS; c++)
+        if (caps[c].id == id && caps[c].ext == ext)
+            return &caps[c];
+    return NULL;
+}
+
+static void naive_scan(uint16_t base, const struct field *f, uint32_t n, uint16_t off,
+                       uint32_t *wm, uint32_t *w1c, uint8_t *hook)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t fo = base + f[i].off;
+        uint32_t shift, m;
+
+        if (fo < off || fo >= off + 4)
+            continue;
+        shift = (fo - off) * 8;
+        m = f[i].size == 4 ? ~0u : (1u << (f[i].size * 8)) - 1;
+        *wm |= (f[i].wmask & m & ~f[i].w1c) << shift;
+        *w1c |= (f[i].w1c & m) << shift;
+        if (f[i].hook)
+            *hook = f[i].hook;
+    }
+}
+
+static void naive_lookup(const uint8_t *img, uint16_t off, uint32_t *wm, uint32_t *w1c, uint8_t *hook)
+{
+    const struct cap_desc *d;
+
+    *wm = *w1c = 0;
+    *hook = HOOK_NONE;
+    if (off < 0x40) {
+        naive_scan(0, header_fields, sizeof(header_fields) / sizeof(header_fields[0]), off, wm, w1c, hook);
+    } else if (off < 0x100) {
+        for (uint16_t p = img[0x34] & ~3, hops = 0; p && hops < 48; p = img[p + 1] & ~3, hops++) {
+            d = naive_cap(img[p], 0);
+            if (d && off + 4 > p && off < p + d->len) {
+                naive_scan(p, d->fields, d->nfields, off, wm, w1c, hook);
+                return;
+            }
+        }
+    } else {
+        for (uint16_t p = 0x100, hops = 0; p && hops < 960; hops++) {
+            uint32_t hdr = load32(img + p);
+
+            d = naive_cap(hdr & 0xffff, 1);
+            if (!d)
+                return;
+            if (off + 4 > p && off < p + d->len) {
+                naive_scan(p, d->fields, d->nfields, off, wm, w1c, hook);
+                return;
+            }
+            p = hdr >> 20;
+        }
+    }
+}
+
+static void naive_reset(struct naive_func *f)
+{
+    memcpy(f->image, naive_template, TLP_CFG_SIZE);
+    per_func_init(f->image, f->st.idx);
+}
+
+static struct naive_func *naive_get(struct naive_func *funcs, uint16_t bdf)
+{
+    uint32_t bus = bdf >> 8;
+
+    if (bus < SEC_BUS || bus >= SEC_BUS + POP_BUSES)
+        return NULL;
+    return &funcs[(bus - SEC_BUS) * 256 + (bdf & 0xff)];
+}
+
+static uint32_t naive_serve(struct naive_func *funcs, const void *ring, const struct tlp_batch *batch,
+                            struct tlp_cfg_io *io)
+{
+    uint32_t served = 0;
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        uint8_t kind = batch->kind[i], hook;
+        struct naive_func *f;
+        uint32_t wm, w1c, val;
+        uint16_t off;
+
+        if (kind < TLP_KIND_CFGRD0 || kind > TLP_KIND_CFGWR1) {
+            io->status[i] = TLP_CFG_SKIP;
+            continue;
+        }
+        f = naive_get(funcs, batch->target[i]);
+        if (!f) {
+            io->status[i] = TLP_CFG_UR;
+            io->data[i] = ~0u;
+            continue;
+        }
+        if (batch->len_dw[i] != 1) {
+            io->status[i] = TLP_CFG_MALFORMED;
+            continue;
+        }
+        off = batch->addr[i] & 0xffc;
+        naive_lookup(f->image, off, &wm, &w1c, &hook);
+        val = load32(f->image + off);
+
+        if (kind == TLP_KIND_CFGRD0 || kind == TLP_KIND_CFGRD1) {
+            if (hook == HOOK_COUNTER)
+                val = ++f->st.counter_reads;
+            io->data[i] = val;
+        } else {
+            const uint8_t *qe = (const uint8_t *)ring + (size_t)batch->qe[i] * TLP_QE_SIZE;
+            uint32_t data = load32(qe + batch->hdr_dw[i] * 4), m = 0, clear;
+            uint8_t be = batch->be[i] & 0xf;
+
+            for (int b = 0; b < 4; b++)
+                m |= be & (1 << b) ? 0xffu << (b * 8) : 0;
+            wm &= m;
+            clear = w1c & m & data;
+            store32(f->image + off, (val & ~wm & ~clear) | (data & wm));
+            if (hook == HOOK_FLR && (be & 2) && (data & 0x8000)) {
+                f->st.flr++;
+                naive_reset(f);
+            } else if (hook == HOOK_MSIX) {
+                f->st.msix_toggles += ((val ^ load32(f->image + off)) >> 31) & 1;
+            }
+        }
+        io->status[i] = TLP_CFG_OK;
+        served++;
+    }
+    return served;
+}
+
+static struct naive_func *naive_create(void)
+{
+    struct naive_func *funcs = calloc(NFUNCS, sizeof(*funcs));
+
+    if (!funcs)
+        return NULL;
+    naive_build_template();
+    for (uint32_t i = 0; i < NFUNCS; i++) {
+        funcs[i].st.idx = i;
+        naive_reset(&funcs[i]);
+    }
+    return funcs;
+}
+
+/*
+ * Correctness suite
+ */
+struct access {
+    uint8_t     write;
+    uint8_t     be;
+    uint16_t    len_dw;
+    uint16_t    bdf;
+    uint16_t    off;
+    uint32_t    data;
+};
+
+// Every DW holding a described register
+static uint16_t hot_regs[128];
+static uint32_t nhot;
+
+static void collect_hot_regs(void)
+{
+    nhot = 0;
+    for (uint32_t i = 0; i < sizeof(header_fields) / sizeof(header_fields[0]); i++)
+        hot_regs[nhot++] = header_fields[i].off & ~3;
+    for (uint32_t c = 0; c < NCAPS; c++) {
+        hot_regs[nhot++] = cap_off[c];
+        for (uint32_t i = 0; i < caps[c].nfields; i++)
+            hot_regs[nhot++] = (cap_off[c] + caps[c].fields[i].off) & ~3;
+    }
+}
+
+static void random_access(uint64_t *seed, struct access *a)
+{
+    uint32_t r = rnd(seed);
+
+    a->write = r % 5 < 2;
+    a->len_dw = r % 97 == 0 ? 2 : 1;
+    a->be = r % 3 ? 0xf : rnd(seed) & 0xf;
+    a->data = rnd(seed);
+    if (r % 13 == 0)
+        a->bdf = (uint16_t)((SEC_BUS + POP_BUSES + rnd(seed) % 2) << 8 | (rnd(seed) & 0xff));  // Empty bus or beyond
+    else
+        a->bdf = func_bdf(rnd(seed) % NFUNCS);
+    a->off = rnd(seed) % 5 ? hot_regs[rnd(seed) % nhot] : (rnd(seed) % TLP_CFG_REGS) * 4;
+
+    // Keep FLRs rare
+    if (a->off == pcie_cap_off + 8 && rnd(seed) % 64)
+        a->data &= ~0x8000u;
+}
+
+static void encode_accesses(uint8_t *ring, uint32_t ring_qes, uint32_t ci, const struct access *a, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+        encode_cfg(ring + (size_t)((ci + i) % ring_qes) * TLP_QE_SIZE, a[i].write, a[i].bdf,
+                   a[i].off, a[i].be, a[i].data, a[i].len_dw, i);
+}
+
+// Device side: raise status bits the host later clears with RW1C writes
+static void raise_errors(struct tlp_cfg_port *port, struct naive_func *naive, uint64_t *seed)
+{
+    const uint16_t regs[] = { 0x04, pcie_cap_off + 8, aer_cap_off + 4, aer_cap_off + 0x10 };
+    uint32_t idx = rnd(seed) % NFUNCS, bits = rnd(seed);
+    uint16_t off = regs[rnd(seed) % 4];
+    struct tlp_cfg_func *func = tlp_cfg_func_get(port, func_bdf(idx));
+    uint8_t cur[4];
+
+    tlp_cfg_func_read(func, off, cur, 4);
+    store32(cur, load32(cur) | (off == 0x04 || off == pcie_cap_off + 8 ? bits & 0xffff0000 : bits));
+    tlp_cfg_func_write(func, off, cur, 4);
+    memcpy(naive[idx].image + off, cur, 4);
+}
+
+// BAR programming through config writes must move the BAR memory
+static int check_bar_follow(struct tlp_cfg_port *port)
+{
+    static uint8_t ring[RING_QES * TLP_QE_SIZE];
+    static struct tlp_batch batch;
+    static struct tlp_cfg_io cio;
+    struct tlp_cfg_func *func = tlp_cfg_func_get(port, func_bdf(0));
+    struct tlp_bar_set *bars = tlp_bar_set_create();
+    struct tlp_bar_io bio = { 0 };
+    uint64_t base = 0x2400000000ull;
+    uint8_t data[8];
+    int ret = -1;
+
+    if (!bars || tlp_bar_setup(bars, 0, BAR0_SIZE, 0) || tlp_bar_setup(bars, 2, BAR2_SIZE, 0xe0000000))
+        goto out;
+    tlp_cfg_func_attach_bars(func, bars);
+
+    // Size BAR0 and program it, as the host does
+    encode_cfg(ring, 1, func_bdf(0), 0x10, 0xf, ~0u, 1, 0);
+    encode_cfg(ring + 64, 0, func_bdf(0), 0x10, 0xf, 0, 1, 1);
+    encode_cfg(ring + 128, 1, func_bdf(0), 0x10, 0xf, (uint32_t)base, 1, 2);
+    encode_cfg(ring + 192, 1, func_bdf(0), 0x14, 0xf, base >> 32, 1, 3);
+    tlp_decode_qes(ring, RING_QES, 0, 4, &batch);
+    tlp_cfg_serve(port, ring, &batch, &cio);
+
+    // 64-bit MRd of 2 DWs at the programmed address, then at a stale one
+    put_be32(ring, 0x20u << 24 | 2);
+    put_be32(ring + 4, 0xff);
+    put_be32(ring + 8, base >> 32);
+    put_be32(ring + 12, (uint32_t)base + 0x100);
+    memcpy(ring + 64, ring, 64);
+    put_be32(ring + 64 + 8, 0);
+    bio.data = data;
+    bio.data_cap = sizeof(data);
+    tlp_decode_qes(ring, RING_QES, 0, 2, &batch);
+    tlp_bar_serve(bars, ring, &batch, &bio);
+
+    if (cio.data[1] != (~(BAR0_SIZE - 1) | 0xc) || bio.status[0] != TLP_BAR_OK || bio.status[1] != TLP_BAR_UR) {
+        printf("✗ BAR programming: sizing read 0x%08x, access %d/%d\n", cio.data[1], bio.status[0], bio.status[1]);
+        goto out;
+    }
+    printf("✓ BAR sizing and programming reach the BAR backend\n");
+    ret = 0;
+
+out:
+    tlp_cfg_func_attach_bars(func, NULL);
+    tlp_bar_set_destroy(bars);
+    // Back to the template so the images still match the naive handler
+    tlp_cfg_func_reset(func);
+    engine_func_init(func, 0);
+    return ret;
+}
+
+static int run_suite(struct tlp_cfg_port *port, struct naive_func *naive, uint32_t batches)
+{
+    static uint8_t ring[RING_QES * TLP_QE_SIZE];
+    static struct tlp_batch batch;
+    static struct tlp_cfg_io eio, nio;
+    struct access acc[BATCH_QES];
+    uint64_t seed = 0xc0f1;
+    uint32_t ci = 0, mismatches = 0, reads = 0, writes = 0, ur = 0, flr = 0;
+
+    if (check_bar_follow(port))
+        return -1;
+
+    for (uint32_t n = 0; n < batches; n++) {
+        raise_errors(port, naive, &seed);
+        for (uint32_t i = 0; i < BATCH_QES; i++)
+            random_access(&seed, &acc[i]);
+        encode_accesses(ring, RING_QES, ci, acc, BATCH_QES);
+        tlp_decode_qes(ring, RING_QES, ci, BATCH_QES, &batch);
+        tlp_cfg_serve(port, ring, &batch, &eio);
+        naive_serve(naive, ring, &batch, &nio);
+
+        for (uint32_t i = 0; i < BATCH_QES; i++) {
+            int is_read = batch.kind[i] == TLP_KIND_CFGRD0 || batch.kind[i] == TLP_KIND_CFGRD1;
+
+            if (eio.status[i] != nio.status[i] ||
+                ((is_read || eio.status[i] == TLP_CFG_UR) && eio.data[i] != nio.data[i]))
+                mismatches++;
+            ur += eio.status[i] == TLP_CFG_UR;
+            reads += is_read && eio.status[i] == TLP_CFG_OK;
+            writes += !is_read && eio.status[i] == TLP_CFG_OK;
+        }
+        ci = (ci + BATCH_QES) % RING_QES;
+    }
+
+    for (uint32_t i = 0; i < NFUNCS; i++) {
+        uint8_t image[TLP_CFG_SIZE];
+
+        tlp_cfg_func_read(tlp_cfg_func_get(port, func_bdf(i)), 0, image, TLP_CFG_SIZE);
+        mismatches += memcmp(image, naive[i].image, TLP_CFG_SIZE) != 0;
+        mismatches += memcmp(&engine_state[i], &naive[i].st, sizeof(struct func_state)) != 0;
+        flr += engine_state[i].flr;
+    }
+
+    printf("  %u reads, %u writes, %u UR, %u FLRs over %d functions\n", reads, writes, ur, flr, NFUNCS);
+    if (mismatches) {
+        printf("✗ Engine disagrees with the naive handler (%u mismatches)\n", mismatches);
+        return -1;
+    }
+    printf("✓ Engine matches the naive handler\n");
+    return 0;
+}
+
+/*
+ * Timing
+ */
+typedef uint32_t (*serve_fn)(void *ctx, const void *ring, const struct tlp_batch *batch, struct tlp_cfg_io *io);
+
+static uint32_t serve_engine(void *ctx, const void *ring, const struct tlp_batch *batch, struct tlp_cfg_io *io)
+{
+    return tlp_cfg_serve(ctx, ring, batch, io);
+}
+
+static uint32_t serve_naive(void *ctx, const void *ring, const struct tlp_batch *batch, struct tlp_cfg_io *io)
+{
+    return naive_serve(ctx, ring, batch, io);
+}
+
+// Linux-style enumeration of every BDF below the port, in config accesses
+static uint32_t build_enum_trace(const struct naive_func *naive, struct access *t, uint32_t max)
+{
+    uint32_t n = 0;
+
+#define EMIT(w, b, o, d)    do { if (n < max) t[n++] = (struct access) { w, 0xf, 1, b, o, d }; } while (0)
+    for (uint32_t bus = SEC_BUS; bus <= SUB_BUS; bus++) {
+        for (uint32_t fn = 0; fn < 256; fn++) {
+            uint16_t bdf = (uint16_t)(bus << 8 | fn);
+            const uint8_t *img;
+
+            // The empty bus is probed without ARI: function 0 of each device
+            if (bus >= SEC_BUS + POP_BUSES && fn % 8)
+                continue;
+            EMIT(0, bdf, 0x00, 0);                  // Vendor/device ID
+            if (bus >= SEC_BUS + POP_BUSES)
+                continue;
+            img = naive_get((struct naive_func *)naive, bdf)->image;
+            EMIT(0, bdf, 0x08, 0);                  // Class
+            EMIT(0, bdf, 0x0c, 0);                  // Header type
+            EMIT(0, bdf, 0x2c, 0);                  // Subsystem
+            for (uint16_t bar = 0x10; bar < 0x28; bar += 4) {
+                EMIT(0, bdf, bar, 0);
+                EMIT(1, bdf, bar, ~0u);
+                EMIT(0, bdf, bar, 0);
+                EMIT(1, bdf, bar, 0);
+            }
+            EMIT(0, bdf, 0x04, 0);                  // Status: capability list
+            EMIT(0, bdf, 0x34, 0);
+            for (uint16_t p = img[0x34] & ~3; p; p = img[p + 1] & ~3) {
+                EMIT(0, bdf, p, 0);
+                EMIT(0, bdf, p + 4, 0);
+            }
+            for (uint16_t p = 0x100; p; p = load32(img + p) >> 20) {
+                EMIT(0, bdf, p, 0);
+                EMIT(0, bdf, p + 4, 0);
+            }
+            EMIT(0, bdf, 0x3c, 0);
+            EMIT(1, bdf, 0x10, 0xf000000c);         // Assign BARs, enable memory and bus master
+            EMIT(1, bdf, 0x14, 0x20 + fn);
+            EMIT(1, bdf, 0x18, 0xe0000000 + (fn << 16));
+            EMIT(1, bdf, 0x04, 0x0006);
+        }
+    }
+#undef EMIT
+    return n;
+}
+
+/*
+ * A trace encoded and decoded up front, so only serving is timed
+ */
+struct trace_ring {
+    uint8_t             *ring;
+    uint32_t            ring_qes;
+    struct tlp_batch    *batches;
+    uint32_t            nbatches;
+};
+
+static int trace_prepare(struct trace_ring *tr, const struct access *t, uint32_t n)
+{
+    tr->ring_qes = BATCH_QES;
+    while (tr->ring_qes < n)
+        tr->ring_qes <<= 1;
+    tr->nbatches = (n + BATCH_QES - 1) / BATCH_QES;
+    tr->ring = calloc(tr->ring_qes, TLP_QE_SIZE);
+    tr->batches = malloc((size_t)tr->nbatches * sizeof(*tr->batches));
+    if (!tr->ring || !tr->batches)
+        return -1;
+
+    encode_accesses(tr->ring, tr->ring_qes, 0, t, n);
+    for (uint32_t b = 0; b < tr->nbatches; b++) {
+        uint32_t cnt = n - b * BATCH_QES < BATCH_QES ? n - b * BATCH_QES : BATCH_QES;
+
+        tlp_decode_qes(tr->ring, tr->ring_qes, b * BATCH_QES, cnt, &tr->batches[b]);
+    }
+    return 0;
+}
+
+static void trace_free(struct trace_ring *tr)
+{
+    free(tr->ring);
+    free(tr->batches);
+}
+
+// Best of reps passes over the trace
+static double time_serve(serve_fn fn, void *ctx, const struct trace_ring *tr, uint32_t reps)
+{
+    static struct tlp_cfg_io io;
+    double best = 1e30;
+
+    for (uint32_t rep = 0; rep < reps; rep++) {
+        double start = now_sec(), t;
+
+        for (uint32_t b = 0; b < tr->nbatches; b++) {
+            fn(ctx, tr->ring, &tr->batches[b], &io);
+            clobber(&io);
+        }
+        t = now_sec() - start;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t batches = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+    struct tlp_cfg_layout *layout = NULL;
+    struct tlp_cfg_port *port = NULL;
+    struct naive_func *naive = NULL;
+    struct access *trace = NULL;
+    struct trace_ring tr = { 0 };
+    uint64_t seed = 0x5eed;
+    double eng, nai;
+    uint32_t n;
+    int ret = 1;
+
+    printf("TLP Config Space Benchmark\n");
+    printf("==========================\n");
+    printf("Usage: %s [suite_batches]\n\n", argv[0]);
+
+    layout = build_layout();
+    port = layout ? build_port(layout) : NULL;
+    naive = naive_create();
+    trace = calloc(65536, sizeof(*trace));
+    if (!port || !naive || !trace) {
+        fprintf(stderr, "Setup failed\n");
+        goto cleanup;
+    }
+    collect_hot_regs();
+
+    printf("Engine vs naive handler suite:\n");
+    if (run_suite(port, naive, batches))
+        goto cleanup;
+
+    // The enumeration trace writes BARs and the command register of every function
+    n = build_enum_trace(naive, trace, 65536);
+    if (trace_prepare(&tr, trace, n))
+        goto cleanup;
+    eng = time_serve(serve_engine, port, &tr, 20);
+    nai = time_serve(serve_naive, naive, &tr, 20);
+    trace_free(&tr);
+    printf("\nEnumeration of buses %02x-%02x (%d functions, %u config TLPs, serve only):\n",
+           SEC_BUS, SUB_BUS, NFUNCS, n);
+    printf("  engine %8.1f us  %6.1f ns/TLP\n", eng * 1e6, eng * 1e9 / n);
+    printf("  naive  %8.1f us  %6.1f ns/TLP  (%.1fx)\n", nai * 1e6, nai * 1e9 / n, nai / eng);
+
+    for (uint32_t i = 0; i < 65536; i++) {
+        random_access(&seed, &trace[i]);
+        trace[i].data &= ~0x8000u;      // No FLR while timing
+        trace[i].len_dw = 1;
+    }
+    if (trace_prepare(&tr, trace, 65536))
+        goto cleanup;
+    eng = time_serve(serve_engine, port, &tr, 5);
+    nai = time_serve(serve_naive, naive, &tr, 5);
+    printf("\nRandom CfgRd/CfgWr mix (%u TLPs, 40%% writes, 80%% on described registers):\n", 65536);
+    printf("  engine %7.1f M/s\n", 65536 / eng / 1e6);
+    printf("  naive  %7.1f M/s  (%.1fx slower)\n", 65536 / nai / 1e6, nai / eng);
+    ret = 0;
+
+cleanup:
+    trace_free(&tr);
+    free(trace);
+    free(naive);
+    tlp_cfg_port_destroy(port);
+    tlp_cfg_layout_destroy(layout);
+    return ret;
+}
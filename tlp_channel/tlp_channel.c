@@ -0,0 +1,914 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - CREATE, QUERY and DESTROY of TLP_EMU_CHANNEL objects.
+ * Every live channel is tracked in a process-wide registry so that the whole
+ * set can be torn down in parallel on exit or signal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_channel.h"
+#include "tlp_caps.h"
+#include "tlp_mr_cache.h"
+#include "tlp_numa.h"
+#include "tlp_pack.h"
+
+// Queue slab geometry: every slot fits the largest queue firmware accepts
+#define TLP_CHANNEL_SLAB_SLOT_SIZE      TLP_CHANNEL_MAX_QUEUE_SIZE
+#define TLP_CHANNEL_SLAB_MIN_SLOTS      16
+#define TLP_CHANNEL_SLAB_MAX_SLOTS      4096
+
+// Queue registration; ODP modes add IBV_ACCESS_ON_DEMAND
+#define TLP_CHANNEL_QUEUE_ACCESS        (IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE)
+
+// Parallel teardown tuning
+#define TLP_CHANNEL_TEARDOWN_MAX_THREADS        16
+#define TLP_CHANNEL_TEARDOWN_PER_THREAD         32
+
+/*
+ * One registered memory region carved into fixed-size queue slots.
+ * All channels allocated from a slab share its mkey, so teardown needs a
+ * single ibv_dereg_mr() per slab instead of one per channel.
+ */
+struct tlp_channel_slab {
+    struct ibv_pd           *pd;
+    void                    *base;
+    size_t                  len;
+    uint32_t                nslots;
+    uint32_t                nfree;
+    uint64_t                *free_map;      // Bit set = slot free
+    struct ibv_mr           *mr;            // The PD's implicit MR in TLP_CHANNEL_MEM_ODP_IMPLICIT
+    uint8_t                 mem_mode;
+    int                     numa_node;      // Node the pages were bound to, -1 for none
+    struct tlp_channel_slab *next;
+};
+
+// Implicit ODP MR of a PD, shared by all its queues in TLP_CHANNEL_MEM_ODP_IMPLICIT
+struct tlp_channel_odp_mr {
+    struct ibv_pd               *pd;
+    struct ibv_mr               *mr;
+    uint32_t                    users;      // Slabs and private queues, counted from allocation
+    struct tlp_channel_odp_mr   *next;
+};
+
+static struct {
+    pthread_mutex_t             lock;
+    struct mlx5_tlp_channel_obj *head;
+    struct tlp_channel_slab     *slabs;
+    struct tlp_channel_odp_mr   *odp_mrs;
+    uint32_t                    next_slab_slots;
+    int                         mem_mode;
+    int                         prefetch;
+    int                         numa_node;
+    size_t                      nr_channels;
+    int                         installed;
+    int                         sig_pipe[2];
+    pthread_t                   reaper;
+} registry = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .next_slab_slots = TLP_CHANNEL_SLAB_MIN_SLOTS,
+    .mem_mode = TLP_CHANNEL_MEM_PINNED,
+    .prefetch = 1,
+    .numa_node = TLP_CHANNEL_NUMA_DEVICE,
+    .sig_pipe = { -1, -1 },
+};
+
+static const int registry_signals[] = { SIGINT, SIGTERM, SIGHUP };
+
+// Per-thread progress output, multi-device runs silence their workers
+static __thread int channel_quiet;
+
+#define channel_log(...) do { if (!channel_quiet) printf(__VA_ARGS__); } while (0)
+
+void mlx5_tlp_channel_set_quiet(int quiet)
+{
+    channel_quiet = quiet;
+}
+
+int mlx5_tlp_channel_set_mem_mode(enum tlp_channel_mem_mode mode, int prefetch)
+{
+    if (mode > TLP_CHANNEL_MEM_ODP_IMPLICIT) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&registry.lock);
+    registry.mem_mode = mode;
+    registry.prefetch = !!prefetch;
+    pthread_mutex_unlock(&registry.lock);
+    return 0;
+}
+
+int mlx5_tlp_channel_set_numa_node(int node)
+{
+    if (node < TLP_CHANNEL_NUMA_NONE || node >= TLP_NUMA_MAX_NODES) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&registry.lock);
+    registry.numa_node = node;
+    pthread_mutex_unlock(&registry.lock);
+    return 0;
+}
+
+/*
+ * Implicit ODP MRs - caller holds registry.lock
+ */
+static struct ibv_mr *odp_implicit_mr(struct ibv_pd *pd)
+{
+    struct tlp_channel_odp_mr *odp;
+
+    for (odp = registry.odp_mrs; odp; odp = odp->next) {
+        if (odp->pd == pd) {
+            odp->users++;
+            return odp->mr;
+        }
+    }
+
+    odp = calloc(1, sizeof(*odp));
+    if (!odp)
+        return NULL;
+
+    // Whole address space, pages are faulted in by the device on access
+    odp->mr = ibv_reg_mr(pd, NULL, SIZE_MAX, TLP_CHANNEL_QUEUE_ACCESS | IBV_ACCESS_ON_DEMAND);
+    if (!odp->mr) {
+        fprintf(stderr, "Failed to register implicit ODP MR: %s\n", strerror(errno));
+        free(odp);
+        return NULL;
+    }
+
+    odp->pd = pd;
+    odp->users = 1;
+    odp->next = registry.odp_mrs;
+    registry.odp_mrs = odp;
+    return odp->mr;
+}
+
+// Drop a user taken by odp_implicit_mr(), the MR itself goes at teardown
+static void odp_implicit_mr_put(struct ibv_pd *pd)
+{
+    for (struct tlp_channel_odp_mr *odp = registry.odp_mrs; odp; odp = odp->next) {
+        if (odp->pd == pd) {
+            odp->users--;
+            return;
+        }
+    }
+}
+
+/*
+ * Map an ODP queue in the device now instead of on the first access.
+ * Advisory only, a failure leaves the pages to be faulted in on demand.
+ */
+static void queue_prefetch(struct ibv_pd *pd, struct mlx5_tlp_channel_obj *obj)
+{
+    struct ibv_sge sge = {
+        .addr = (uintptr_t)obj->queue_buffer,
+        .length = obj->queue_size,
+        .lkey = obj->mr->lkey,
+    };
+    int ret;
+
+    // FLUSH returns once the translation is in place
+    ret = ibv_advise_mr(pd, IBV_ADVISE_MR_ADVICE_PREFETCH_WRITE, IBV_ADVISE_MR_FLAG_FLUSH, &sge, 1);
+    if (ret)
+        fprintf(stderr, "Queue prefetch failed, pages fault in on first access: %s\n", strerror(ret));
+}
+
+/*
+ * Slab management - caller holds registry.lock
+ */
+static struct tlp_channel_slab *slab_create(struct ibv_pd *pd, uint32_t nslots, int mem_mode, int numa_node)
+{
+    struct tlp_channel_slab *slab;
+    size_t map_words = (nslots + 63) / 64;
+
+    slab = calloc(1, sizeof(*slab));
+    if (!slab)
+        return NULL;
+
+    slab->free_map = calloc(map_words, sizeof(uint64_t));
+    if (!slab->free_map)
+        goto err_free_slab;
+
+    slab->len = (size_t)nslots * TLP_CHANNEL_SLAB_SLOT_SIZE;
+    slab->base = mmap(NULL, slab->len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab->base == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %zu byte queue slab: %s\n", slab->len, strerror(errno));
+        goto err_free_map;
+    }
+    // Before registration faults the pages in; placement is best effort
+    if (numa_node >= 0)
+        tlp_numa_bind(slab->base, slab->len, numa_node);
+
+    if (mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT)
+        slab->mr = odp_implicit_mr(pd);
+    else if (mem_mode == TLP_CHANNEL_MEM_ODP)
+        slab->mr = ibv_reg_mr(pd, slab->base, slab->len, TLP_CHANNEL_QUEUE_ACCESS | IBV_ACCESS_ON_DEMAND);
+    else
+        slab->mr = ibv_reg_mr(pd, slab->base, slab->len, TLP_CHANNEL_QUEUE_ACCESS);
+    if (!slab->mr) {
+        fprintf(stderr, "Failed to register queue slab: %s\n", strerror(errno));
+        goto err_unmap;
+    }
+
+    for (uint32_t i = 0; i < nslots; i++)
+        slab->free_map[i / 64] |= 1ULL << (i % 64);
+
+    slab->pd = pd;
+    slab->mem_mode = mem_mode;
+    slab->numa_node = numa_node;
+    slab->nslots = nslots;
+    slab->nfree = nslots;
+    return slab;
+
+err_unmap:
+    munmap(slab->base, slab->len);
+err_free_map:
+    free(slab->free_map);
+err_free_slab:
+    free(slab);
+    return NULL;
+}
+
+static void slab_release(struct tlp_channel_slab *slab)
+{
+    // The implicit MR outlives its slabs, registry_teardown() drops it per PD
+    if (slab->mem_mode != TLP_CHANNEL_MEM_ODP_IMPLICIT && ibv_dereg_mr(slab->mr))
+        fprintf(stderr, "Failed to deregister queue slab: %s\n", strerror(errno));
+    munmap(slab->base, slab->len);
+    free(slab->free_map);
+    free(slab);
+}
+
+static int slab_alloc_slot(struct ibv_pd *pd, int mem_mode, int numa_node,
+                           struct tlp_channel_slab **slab_out, uint32_t *slot_out)
+{
+    struct tlp_channel_slab *slab;
+
+    for (slab = registry.slabs; slab; slab = slab->next) {
+        if (slab->pd == pd && slab->mem_mode == mem_mode && slab->numa_node == numa_node && slab->nfree)
+            break;
+    }
+
+    if (!slab) {
+        slab = slab_create(pd, registry.next_slab_slots, mem_mode, numa_node);
+        if (!slab)
+            return -1;
+        slab->next = registry.slabs;
+        registry.slabs = slab;
+        if (registry.next_slab_slots < TLP_CHANNEL_SLAB_MAX_SLOTS)
+            registry.next_slab_slots *= 2;
+    }
+
+    for (uint32_t w = 0; w < (slab->nslots + 63) / 64; w++) {
+        if (!slab->free_map[w])
+            continue;
+        uint32_t bit = __builtin_ctzll(slab->free_map[w]);
+        slab->free_map[w] &= ~(1ULL << bit);
+        slab->nfree--;
+        *slab_out = slab;
+        *slot_out = w * 64 + bit;
+        return 0;
+    }
+
+    return -1;
+}
+
+static void slab_free_slot(struct tlp_channel_slab *slab, uint32_t slot)
+{
+    slab->free_map[slot / 64] |= 1ULL << (slot % 64);
+    slab->nfree++;
+}
+
+/*
+ * Registry list - caller holds registry.lock
+ */
+static void registry_link(struct mlx5_tlp_channel_obj *obj)
+{
+    obj->reg_prev = NULL;
+    obj->reg_next = registry.head;
+    if (registry.head)
+        registry.head->reg_prev = obj;
+    registry.head = obj;
+    registry.nr_channels++;
+}
+
+static void registry_unlink(struct mlx5_tlp_channel_obj *obj)
+{
+    if (obj->reg_prev)
+        obj->reg_prev->reg_next = obj->reg_next;
+    else
+        registry.head = obj->reg_next;
+    if (obj->reg_next)
+        obj->reg_next->reg_prev = obj->reg_prev;
+    obj->reg_prev = obj->reg_next = NULL;
+    registry.nr_channels--;
+}
+
+/*
+ * Private queues, for sizes that do not fit a slab slot
+ */
+static int private_queue_alloc(struct ibv_pd *pd, struct mlx5_tlp_channel_obj *obj)
+{
+    size_t len = (obj->queue_size + 4095) & ~4095UL;
+
+    if (obj->mem_mode != TLP_CHANNEL_MEM_ODP_IMPLICIT) {
+        // Registered once and reused through the MR cache, by node
+        obj->queue_buffer = tlp_mr_cache_alloc(pd, obj->queue_size,
+                                               obj->mem_mode == TLP_CHANNEL_MEM_ODP ?
+                                               TLP_CHANNEL_QUEUE_ACCESS | IBV_ACCESS_ON_DEMAND :
+                                               TLP_CHANNEL_QUEUE_ACCESS,
+                                               obj->numa_node, &obj->mr);
+        return obj->queue_buffer ? 0 : -1;
+    }
+
+    obj->queue_buffer = aligned_alloc(4096, len ? len : 4096);
+    if (!obj->queue_buffer)
+        return -1;
+    if (obj->numa_node >= 0)
+        tlp_numa_bind(obj->queue_buffer, len ? len : 4096, obj->numa_node);
+    pthread_mutex_lock(&registry.lock);
+    obj->mr = odp_implicit_mr(pd);
+    pthread_mutex_unlock(&registry.lock);
+    if (!obj->mr) {
+        free(obj->queue_buffer);
+        obj->queue_buffer = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void private_queue_release(struct mlx5_tlp_channel_obj *obj)
+{
+    if (obj->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT) {
+        pthread_mutex_lock(&registry.lock);
+        odp_implicit_mr_put(obj->mr->pd);
+        pthread_mutex_unlock(&registry.lock);
+        free(obj->queue_buffer);
+    } else {
+        tlp_mr_cache_release(obj->queue_buffer);
+    }
+}
+
+/**
+ * Create TLP_EMU_CHANNEL object (Official Specification: Object Type 0x0059)
+ *
+ * @param ctx: IBV context
+ * @param pd: Protection domain for memory registration
+ * @param q_protocol_mode: Protocol mode (8 bit) - Mode0: Mkey covers 64KB buffer (1K × 64B QEs)
+ * @param q_size: Queue size in bytes (32 bit) - Communication channel queue size
+ * @param tlp_channel_stride_index: TLP channel stride index (16 bits) - from mlx5dv_alloc_ear API
+ * @return: Pointer to created object or NULL on failure
+ *
+ * Note: This object is associated to topology behind a single downstream port of NVIDIA switch.
+ * The mkey ownership moves to device for entire lifecycle of TLP_EMULATION_CHANNEL object.
+ * Queues up to TLP_CHANNEL_MAX_QUEUE_SIZE are carved from a shared registered slab; larger
+ * (invalid) sizes get a private buffer from the MR cache so firmware validation can still be
+ * exercised without registering memory on every create.
+ */
+struct mlx5_tlp_channel_obj *mlx5_tlp_channel_create(struct ibv_context *ctx,
+                                                     struct ibv_pd *pd,
+                                                     uint8_t q_protocol_mode,
+                                                     uint32_t q_size,
+                                                     uint16_t tlp_channel_stride_index)
+{
+    // Every byte of the input is written by the pack functions
+    uint8_t in[TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ + TLP_PACK_TLP_EMU_CHANNEL_SZ];
+    uint8_t out[TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ] = {0};
+    struct tlp_pack_general_obj_out_cmd_hdr hdr_out;
+    const struct tlp_device_caps *caps;
+    struct mlx5_tlp_channel_obj *obj;
+    int mem_mode, prefetch, numa_node;
+
+    channel_log("Creating TLP_EMU_CHANNEL with:\n");
+    channel_log("  - Protocol Mode: %d\n", q_protocol_mode);
+    channel_log("  - Queue Size: %d bytes\n", q_size);
+    channel_log("  - Stride Index: %d\n", tlp_channel_stride_index);
+
+    // Fail fast on devices known not to support the object type
+    caps = tlp_caps_get(ctx);
+    if (caps && !caps->tlp_emu_channel) {
+        fprintf(stderr, "TLP_EMU_CHANNEL not supported on %s\n", caps->dev_name);
+        errno = EOPNOTSUPP;
+        return NULL;
+    }
+
+    pthread_mutex_lock(&registry.lock);
+    mem_mode = registry.mem_mode;
+    prefetch = registry.prefetch;
+    numa_node = registry.numa_node;
+    pthread_mutex_unlock(&registry.lock);
+    if (numa_node == TLP_CHANNEL_NUMA_DEVICE)
+        numa_node = tlp_numa_device_node(ctx->device);
+
+    if (mem_mode != TLP_CHANNEL_MEM_PINNED) {
+        caps = tlp_caps_get_general(ctx);
+        if (caps && !(mem_mode == TLP_CHANNEL_MEM_ODP ? caps->odp : caps->odp_implicit)) {
+            fprintf(stderr, "%s ODP not supported on %s\n",
+                    mem_mode == TLP_CHANNEL_MEM_ODP ? "Explicit" : "Implicit", caps->dev_name);
+            errno = EOPNOTSUPP;
+            return NULL;
+        }
+    }
+
+    obj = calloc(1, sizeof(*obj));
+    if (!obj) {
+        fprintf(stderr, "Failed to allocate object structure\n");
+        return NULL;
+    }
+
+    obj->queue_size = q_size;
+    obj->mem_mode = mem_mode;
+    obj->numa_node = numa_node < 0 ? -1 : numa_node;
+
+    if (q_size && q_size <= TLP_CHANNEL_SLAB_SLOT_SIZE) {
+        // Take a queue slot from the registered slab
+        pthread_mutex_lock(&registry.lock);
+        if (slab_alloc_slot(pd, mem_mode, obj->numa_node, &obj->slab, &obj->slab_slot) == 0) {
+            obj->queue_buffer = (uint8_t *)obj->slab->base +
+                                (size_t)obj->slab_slot * TLP_CHANNEL_SLAB_SLOT_SIZE;
+            obj->mr = obj->slab->mr;
+        }
+        pthread_mutex_unlock(&registry.lock);
+        if (!obj->slab) {
+            fprintf(stderr, "Failed to allocate queue slot\n");
+            goto err_free_obj;
+        }
+    } else if (private_queue_alloc(pd, obj)) {
+        fprintf(stderr, "Failed to allocate registered queue buffer: %s\n", strerror(errno));
+        goto err_free_obj;
+    }
+
+    // Initialize queue buffer with test pattern
+    memset(obj->queue_buffer, 0xAB, q_size);
+
+    if (mem_mode != TLP_CHANNEL_MEM_PINNED && prefetch && q_size)
+        queue_prefetch(pd, obj);
+
+    channel_log("  - Queue Buffer VA: %p\n", obj->queue_buffer);
+    channel_log("  - Memory Key (mkey): 0x%x\n", obj->mr->lkey);
+    if (obj->numa_node >= 0)
+        channel_log("  - Queue NUMA Node: %d\n", obj->numa_node);
+
+    // Setup command input
+    tlp_pack_general_obj_in_cmd_hdr(in, &(struct tlp_pack_general_obj_in_cmd_hdr) {
+        .opcode = MLX5_CMD_OP_CREATE_GENERAL_OBJECT,
+        .obj_type = MLX5_OBJ_TYPE_TLP_EMU_CHANNEL,
+    });
+
+    // Set TLP_EMU_CHANNEL parameters based on firmware structure
+    tlp_pack_tlp_emu_channel(in + TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ, &(struct tlp_pack_tlp_emu_channel) {
+        .q_protocol_mode = q_protocol_mode,
+        .q_mkey = obj->mr->lkey,
+        .q_size = q_size,
+        .q_addr = (uint64_t)obj->queue_buffer,
+        .tlp_channel_stride_index = tlp_channel_stride_index,
+    });
+
+    // Execute CREATE command
+    obj->obj = mlx5dv_devx_obj_create(ctx, in, sizeof(in), out, sizeof(out));
+    tlp_unpack_general_obj_out_cmd_hdr(out, &hdr_out);
+    if (!obj->obj) {
+        fprintf(stderr, "TLP_EMU_CHANNEL create failed, syndrome 0x%x: %s\n",
+                hdr_out.syndrome, strerror(errno));
+
+        // Print detailed syndrome information based on firmware error codes
+        switch (hdr_out.syndrome) {
+            case 0xE1E101:
+                fprintf(stderr, "  Error: Invalid protocol mode (only mode 0 is supported)\n");
+                break;
+            case 0xE1E102:
+                fprintf(stderr, "  Error: Invalid queue size (must be between 1 and 64KB)\n");
+                break;
+            case 0xE1E103:
+                fprintf(stderr, "  Error: Invalid queue address (cannot be zero)\n");
+                break;
+            case 0xE1E104:
+                fprintf(stderr, "  Error: Failed to allocate object resource\n");
+                break;
+            case 0xE1E108:
+                fprintf(stderr, "  Error: VA to PA translation failed (check mkey validity)\n");
+                break;
+            case 0xE1E109:
+                fprintf(stderr, "  Error: Invalid mkey (cannot be zero)\n");
+                break;
+            case 0x3590f5:
+                fprintf(stderr, "  Error: TLP_EMU_CHANNEL object type not supported by firmware\n");
+                fprintf(stderr, "  Possible causes:\n");
+                fprintf(stderr, "    - Firmware does not include TLP_EMU_CHANNEL support\n");
+                fprintf(stderr, "    - Object type 0x59 not registered in firmware\n");
+                fprintf(stderr, "    - Firmware configuration missing MCONFIG_GENERIC_EMU\n");
+                break;
+            default:
+                fprintf(stderr, "  Error: Unknown syndrome (0x%x)\n", hdr_out.syndrome);
+                fprintf(stderr, "  This may indicate:\n");
+                fprintf(stderr, "    - Firmware version mismatch\n");
+                fprintf(stderr, "    - Missing firmware features or configuration\n");
+                fprintf(stderr, "    - Device capability limitations\n");
+                break;
+        }
+        goto err_release_buffer;
+    }
+
+    obj->obj_id = hdr_out.obj_id;
+    channel_log("✓ TLP_EMU_CHANNEL created successfully with object ID: 0x%x\n", obj->obj_id);
+
+    pthread_mutex_lock(&registry.lock);
+    registry_link(obj);
+    pthread_mutex_unlock(&registry.lock);
+
+    return obj;
+
+err_release_buffer:
+    if (obj->slab) {
+        pthread_mutex_lock(&registry.lock);
+        slab_free_slot(obj->slab, obj->slab_slot);
+        pthread_mutex_unlock(&registry.lock);
+    } else {
+        private_queue_release(obj);
+    }
+err_free_obj:
+    free(obj);
+    return NULL;
+}
+
+/**
+ * Query TLP_EMU_CHANNEL object
+ */
+int mlx5_tlp_channel_query(struct ibv_context *ctx, struct mlx5_tlp_channel_obj *obj)
+{
+    uint8_t in[TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ];
+    uint8_t out[TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ + TLP_PACK_TLP_EMU_CHANNEL_SZ] = {0};
+    struct tlp_pack_general_obj_out_cmd_hdr hdr_out;
+    struct tlp_pack_tlp_emu_channel channel;
+
+    channel_log("\nQuerying TLP_EMU_CHANNEL object ID: 0x%x\n", obj->obj_id);
+
+    // Setup QUERY command
+    tlp_pack_general_obj_in_cmd_hdr(in, &(struct tlp_pack_general_obj_in_cmd_hdr) {
+        .opcode = MLX5_CMD_OP_QUERY_GENERAL_OBJECT,
+        .obj_type = MLX5_OBJ_TYPE_TLP_EMU_CHANNEL,
+        .obj_id = obj->obj_id,
+    });
+
+    // Execute QUERY command using the existing object (leveraging mlx5dv_devx_obj_query)
+    if (mlx5dv_devx_obj_query(obj->obj, in, sizeof(in), out, sizeof(out))) {
+        tlp_unpack_general_obj_out_cmd_hdr(out, &hdr_out);
+        fprintf(stderr, "TLP_EMU_CHANNEL query failed, syndrome 0x%x: %s\n",
+                hdr_out.syndrome, strerror(errno));
+
+        if (hdr_out.syndrome == 0xE1E105) {
+            fprintf(stderr, "  Error: Invalid object ID for query operation\n");
+        }
+        return -1;
+    }
+
+    // Parse query results
+    tlp_unpack_tlp_emu_channel(out + TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ, &channel);
+
+    channel_log("Query Results:\n");
+    channel_log("  - Protocol Mode: %d\n", channel.q_protocol_mode);
+    channel_log("  - Queue MKey: 0x%x\n", channel.q_mkey);
+    channel_log("  - Queue Size: %d bytes\n", channel.q_size);
+    channel_log("  - Queue Address: 0x%lx\n", channel.q_addr);
+    channel_log("  - Stride Index: %d\n", channel.tlp_channel_stride_index);
+    channel_log("✓ TLP_EMU_CHANNEL query completed successfully\n");
+
+    return 0;
+}
+
+/**
+ * Destroy TLP_EMU_CHANNEL object
+ */
+int mlx5_tlp_channel_destroy(struct mlx5_tlp_channel_obj *obj)
+{
+    if (!obj) return -1;
+
+    channel_log("\nDestroying TLP_EMU_CHANNEL object ID: 0x%x\n", obj->obj_id);
+
+    // Destroy the DevX object
+    if (obj->obj) {
+        if (mlx5dv_devx_obj_destroy(obj->obj)) {
+            fprintf(stderr, "Failed to destroy TLP_EMU_CHANNEL object: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&registry.lock);
+    registry_unlink(obj);
+    if (obj->slab) {
+        // Slot goes back to the slab, the slab stays registered for reuse
+        slab_free_slot(obj->slab, obj->slab_slot);
+        obj->mr = NULL;
+        obj->queue_buffer = NULL;
+    }
+    pthread_mutex_unlock(&registry.lock);
+
+    // Private queues stay registered in the MR cache for the next create
+    if (obj->queue_buffer)
+        private_queue_release(obj);
+
+    free(obj);
+    channel_log("✓ TLP_EMU_CHANNEL destroyed successfully\n");
+
+    return 0;
+}
+
+/*
+ * Parallel teardown
+ */
+struct teardown_worker {
+    pthread_t                   thread;
+    struct mlx5_tlp_channel_obj **objs;
+    size_t                      nobjs;
+    size_t                      first;
+    size_t                      stride;
+    int                         free_host;
+    int                         running;
+};
+
+static void teardown_one(struct mlx5_tlp_channel_obj *obj, int free_host)
+{
+    if (obj->obj && mlx5dv_devx_obj_destroy(obj->obj) == 0)
+        obj->obj = NULL;
+
+    // Private queues go back to the MR cache; slab and implicit ODP queues are
+    // released per slab and per PD
+    if (!free_host || obj->slab || !obj->mr || obj->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT)
+        return;
+    if (obj->obj) {
+        // Firmware may still write the queue, keep it pinned out of the idle cache
+        fprintf(stderr, "TLP_EMU_CHANNEL 0x%x not destroyed, keeping its %zu byte queue registered\n",
+                obj->obj_id, obj->queue_size);
+        return;
+    }
+    tlp_mr_cache_release(obj->queue_buffer);
+    obj->mr = NULL;
+}
+
+static void *teardown_worker_fn(void *arg)
+{
+    struct teardown_worker *w = arg;
+
+    for (size_t i = w->first; i < w->nobjs; i += w->stride)
+        teardown_one(w->objs[i], w->free_host);
+
+    return NULL;
+}
+
+static struct ibv_pd *channel_pd(const struct mlx5_tlp_channel_obj *obj)
+{
+    return obj->slab ? obj->slab->pd : obj->mr ? obj->mr->pd : NULL;
+}
+
+/*
+ * A channel still uses the slab or the PD's implicit MR - caller holds
+ * registry.lock. Counted from allocation, so a create that has not reached
+ * the registry yet keeps them too.
+ */
+static int slab_in_use(const struct tlp_channel_slab *slab)
+{
+    return slab->nfree != slab->nslots;
+}
+
+static int odp_mr_in_use(const struct tlp_channel_odp_mr *odp)
+{
+    return odp->users != 0;
+}
+
+/*
+ * Detach channels (all, or those of one PD) from the registry and destroy
+ * them. Host memory is only released when free_host is set: on the signal
+ * path other threads may still hold channel pointers while the process is
+ * going down, so slabs, MRs and queues are left as they are. A channel
+ * firmware failed to destroy goes back to the registry, and its slab or
+ * implicit MR stays registered and mapped under it. So does a slab or MR a
+ * create still in flight took a slot or queue from.
+ */
+
+static int registry_teardown(struct ibv_pd *pd, int free_host)
+{
+    struct mlx5_tlp_channel_obj *head = NULL, *obj, *next, **objs;
+    struct tlp_channel_slab *slabs = NULL, *slab, **link;
+    struct tlp_channel_odp_mr *odp_mrs = NULL, *odp, **odp_link;
+    struct teardown_worker workers[TLP_CHANNEL_TEARDOWN_MAX_THREADS];
+    size_t n = 0, failed = 0, nthreads;
+    long ncpus;
+
+    pthread_mutex_lock(&registry.lock);
+    for (obj = registry.head; obj; obj = next) {
+        next = obj->reg_next;
+        if (pd && channel_pd(obj) != pd)
+            continue;
+        registry_unlink(obj);
+        obj->reg_next = head;
+        head = obj;
+        n++;
+    }
+    pthread_mutex_unlock(&registry.lock);
+
+    objs = n ? malloc(n * sizeof(*objs)) : NULL;
+    if (objs) {
+        size_t i = 0;
+        for (obj = head; obj; obj = obj->reg_next)
+            objs[i++] = obj;
+
+        ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (n + TLP_CHANNEL_TEARDOWN_PER_THREAD - 1) / TLP_CHANNEL_TEARDOWN_PER_THREAD;
+        if (ncpus > 0 && nthreads > (size_t)ncpus)
+            nthreads = ncpus;
+        if (nthreads > TLP_CHANNEL_TEARDOWN_MAX_THREADS)
+            nthreads = TLP_CHANNEL_TEARDOWN_MAX_THREADS;
+
+        // Worker 0 runs on the calling thread
+        for (size_t t = 0; t < nthreads; t++) {
+            workers[t] = (struct teardown_worker) {
+                .objs = objs, .nobjs = n, .first = t, .stride = nthreads, .free_host = free_host,
+            };
+            if (t && pthread_create(&workers[t].thread, NULL, teardown_worker_fn, &workers[t]) == 0)
+                workers[t].running = 1;
+            else if (t)
+                teardown_worker_fn(&workers[t]);
+        }
+        teardown_worker_fn(&workers[0]);
+        for (size_t t = 1; t < nthreads; t++) {
+            if (workers[t].running)
+                pthread_join(workers[t].thread, NULL);
+        }
+        free(objs);
+    } else {
+        for (obj = head; obj; obj = obj->reg_next)
+            teardown_one(obj, free_host);
+    }
+
+    // Channels firmware still holds keep their memory, a later teardown retries them
+    pthread_mutex_lock(&registry.lock);
+    for (struct mlx5_tlp_channel_obj **obj_link = &head; (obj = *obj_link) != NULL; ) {
+        if (!obj->obj) {
+            obj_link = &obj->reg_next;
+            continue;
+        }
+        *obj_link = obj->reg_next;
+        registry_link(obj);
+        failed++;
+    }
+    if (failed)
+        fprintf(stderr, "%zu TLP_EMU_CHANNEL objects failed to destroy, their queues stay registered\n",
+                failed);
+    // Destroyed channels give back their slot or implicit MR user
+    for (obj = head; free_host && obj; obj = obj->reg_next) {
+        if (obj->slab)
+            slab_free_slot(obj->slab, obj->slab_slot);
+        else if (obj->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT && obj->mr)
+            odp_implicit_mr_put(obj->mr->pd);
+    }
+    // Slabs and implicit MRs of the PD no channel uses, nor a create in flight
+    for (link = &registry.slabs; free_host && (slab = *link) != NULL; ) {
+        if ((pd && slab->pd != pd) || slab_in_use(slab)) {
+            link = &slab->next;
+            continue;
+        }
+        if (slab->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT)
+            odp_implicit_mr_put(slab->pd);
+        *link = slab->next;
+        slab->next = slabs;
+        slabs = slab;
+    }
+    if (!registry.slabs)
+        registry.next_slab_slots = TLP_CHANNEL_SLAB_MIN_SLOTS;
+    for (odp_link = &registry.odp_mrs; free_host && (odp = *odp_link) != NULL; ) {
+        if ((pd && odp->pd != pd) || odp_mr_in_use(odp)) {
+            odp_link = &odp->next;
+            continue;
+        }
+        *odp_link = odp->next;
+        odp->next = odp_mrs;
+        odp_mrs = odp;
+    }
+    pthread_mutex_unlock(&registry.lock);
+
+    // One deregistration per slab covers every slab-backed queue
+    while (slabs) {
+        slab = slabs;
+        slabs = slab->next;
+        slab_release(slab);
+    }
+
+    // Implicit ODP MRs go last, after every queue using them
+    while (odp_mrs) {
+        odp = odp_mrs;
+        odp_mrs = odp->next;
+        if (ibv_dereg_mr(odp->mr))
+            fprintf(stderr, "Failed to deregister implicit ODP MR: %s\n", strerror(errno));
+        free(odp);
+    }
+
+    if (free_host) {
+        while (head) {
+            obj = head;
+            head = obj->reg_next;
+            if (!obj->slab && obj->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT)
+                free(obj->queue_buffer);
+            free(obj);
+        }
+        // Idle private queues of the PD, deregistered and freed by the cache
+        tlp_mr_cache_flush(pd);
+    }
+
+    return (int)(n - failed);
+}
+
+int mlx5_tlp_channel_teardown_all(void)
+{
+    return registry_teardown(NULL, 1);
+}
+
+int mlx5_tlp_channel_release_pd(struct ibv_pd *pd)
+{
+    return registry_teardown(pd, 1);
+}
+
+static void registry_atexit(void)
+{
+    registry_teardown(NULL, 1);
+}
+
+static void registry_signal_handler(int signo)
+{
+    unsigned char sig = (unsigned char)signo;
+    ssize_t ret;
+
+    // Only async-signal-safe work here, the reaper thread does the rest
+    ret = write(registry.sig_pipe[1], &sig, 1);
+    (void)ret;
+}
+
+static void *registry_reaper(void *arg)
+{
+    unsigned char sig;
+    ssize_t ret;
+
+    (void)arg;
+    do {
+        ret = read(registry.sig_pipe[0], &sig, 1);
+    } while (ret < 0 && errno == EINTR);
+    if (ret != 1)
+        return NULL;
+
+    registry_teardown(NULL, 0);
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+    return NULL;
+}
+
+int mlx5_tlp_channel_registry_install(void)
+{
+    struct sigaction sa;
+    int ret = 0;
+
+    pthread_mutex_lock(&registry.lock);
+    if (registry.installed)
+        goto out;
+
+    if (pipe(registry.sig_pipe)) {
+        fprintf(stderr, "Failed to create registry signal pipe: %s\n", strerror(errno));
+        ret = -1;
+        goto out;
+    }
+
+    if (pthread_create(&registry.reaper, NULL, registry_reaper, NULL)) {
+        fprintf(stderr, "Failed to start registry reaper thread\n");
+        close(registry.sig_pipe[0]);
+        close(registry.sig_pipe[1]);
+        registry.sig_pipe[0] = registry.sig_pipe[1] = -1;
+        ret = -1;
+        goto out;
+    }
+    pthread_detach(registry.reaper);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = registry_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    for (size_t i = 0; i < sizeof(registry_signals) / sizeof(registry_signals[0]); i++)
+        sigaction(registry_signals[i], &sa, NULL);
+
+    atexit(registry_atexit);
+    registry.installed = 1;
+out:
+    pthread_mutex_unlock(&registry.lock);
+    return ret;
+}
@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - TLP_EMU_CHANNEL object lifecycle and channel registry
+ */
+
+#ifndef TLP_CHANNEL_H
+#define TLP_CHANNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+#include <infiniband/mlx5dv.h>
+
+// TLP_EMU_CHANNEL object type as defined in firmware (prm_enums.h)
+#define MLX5_OBJ_TYPE_TLP_EMU_CHANNEL  0x59
+
+// Largest queue accepted by firmware (Mode0: 1K × 64B QEs)
+#define TLP_CHANNEL_MAX_QUEUE_SIZE     (64 * 1024)
+
+// How queue memory is registered
+enum tlp_channel_mem_mode {
+    TLP_CHANNEL_MEM_PINNED          = 0,    // Pages pinned for the registration lifetime
+    TLP_CHANNEL_MEM_ODP             = 1,    // Explicit ODP MR per slab or private queue
+    TLP_CHANNEL_MEM_ODP_IMPLICIT    = 2,    // One implicit ODP MR covering the PD's address space
+};
+
+// Queue memory placement, see mlx5_tlp_channel_set_numa_node()
+#define TLP_CHANNEL_NUMA_DEVICE         (-1)    // The node of the device's PCI function
+#define TLP_CHANNEL_NUMA_NONE           (-2)    // No memory policy
+
+struct tlp_channel_slab;
+
+struct mlx5_tlp_channel_obj {
+    struct mlx5dv_devx_obj  *obj;
+    uint32_t                obj_id;
+    void                    *queue_buffer;
+    size_t                  queue_size;
+    struct ibv_mr           *mr;
+    uint8_t                 mem_mode;       // enum tlp_channel_mem_mode
+    int                     numa_node;      // Node the queue pages prefer, -1 for none
+
+    // Registry bookkeeping - queue comes from a shared slab when slab != NULL
+    struct tlp_channel_slab     *slab;
+    uint32_t                    slab_slot;
+    struct mlx5_tlp_channel_obj *reg_prev;
+    struct mlx5_tlp_channel_obj *reg_next;
+};
+
+struct mlx5_tlp_channel_obj *mlx5_tlp_channel_create(struct ibv_context *ctx,
+                                                     struct ibv_pd *pd,
+                                                     uint8_t q_protocol_mode,
+                                                     uint32_t q_size,
+                                                     uint16_t tlp_channel_stride_index);
+int mlx5_tlp_channel_query(struct ibv_context *ctx, struct mlx5_tlp_channel_obj *obj);
+int mlx5_tlp_channel_destroy(struct mlx5_tlp_channel_obj *obj);
+
+/**
+ * Install process-exit teardown for every live channel
+ *
+ * Registers an atexit() hook and SIGINT/SIGTERM/SIGHUP handlers. On signal a
+ * reaper thread tears all registered channels down and re-raises the signal
+ * with its default action, so aborted runs leave no objects in firmware.
+ * @return: 0 on success, -1 on failure
+ */
+int mlx5_tlp_channel_registry_install(void);
+
+/**
+ * Destroy every registered channel in parallel
+ *
+ * DevX objects are destroyed from a pool of worker threads, then each queue
+ * slab is deregistered once instead of one MR per channel. A channel that
+ * fails to destroy stays registered, with its queue memory, for a later call.
+ * @return: number of channels torn down
+ */
+int mlx5_tlp_channel_teardown_all(void);
+
+/**
+ * Same as mlx5_tlp_channel_teardown_all() limited to the channels and slabs
+ * of one protection domain, for callers that drive several devices at once
+ */
+int mlx5_tlp_channel_release_pd(struct ibv_pd *pd);
+
+/**
+ * Select how the queues of channels created afterwards are registered
+ *
+ * ODP modes register with IBV_ACCESS_ON_DEMAND, so queue pages are not pinned
+ * and registration cost no longer grows with size. They need IBV_ODP_SUPPORT
+ * (IBV_ODP_SUPPORT_IMPLICIT for the implicit mode) and creation fails with
+ * EOPNOTSUPP on devices without it. With prefetch set each new ODP queue is
+ * mapped with ibv_advise_mr() before the CREATE command, so neither firmware's
+ * VA to PA translation nor the first TLP written to the queue takes a page fault.
+ * Process-wide, defaults to TLP_CHANNEL_MEM_PINNED.
+ * @return: 0 on success, -1 on an unknown mode
+ */
+int mlx5_tlp_channel_set_mem_mode(enum tlp_channel_mem_mode mode, int prefetch);
+
+/**
+ * Select the NUMA node for the queues of channels created afterwards
+ *
+ * By default (TLP_CHANNEL_NUMA_DEVICE) a queue prefers the node of the
+ * device's PCI function, read from sysfs, so TLP writes from the device and
+ * the poller on that node stay local. A node number forces that node, e.g.
+ * to measure cross-node polling; TLP_CHANNEL_NUMA_NONE leaves placement to
+ * the kernel. Slabs are bound with mbind(2) before registration faults
+ * their pages in. Placement is best effort and creation never fails on it.
+ * Process-wide.
+ * @return: 0 on success, -1 on an invalid node
+ */
+int mlx5_tlp_channel_set_numa_node(int node);
+
+/**
+ * Silence per-channel progress output on the calling thread
+ */
+void mlx5_tlp_channel_set_quiet(int quiet);
+
+#endif /* TLP_CHANNEL_H */
@@ -0,0 +1,165 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - completion TLPs for served non-posted requests.
+ * The completer writes Cpl/CplD QEs for a whole batch into an outbound
+ * ring and publishes the producer index once. Requesters match the
+ * completions to their requests with tlp_np.h.
+ */
+
+#include <string.h>
+#include <endian.h>
+
+#include "tlp_cmpl.h"
+
+#define FMT_TYPE_CPL        0x0a
+#define FMT_TYPE_CPLD       0x4a
+#define FMT_TYPE_CPLLK      0x0b
+
+void tlp_cmpl_queue_init(struct tlp_cmpl_queue *q, void *ring, uint32_t ring_qes,
+                         uint32_t *pi_db, const uint32_t *ci_db, uint16_t completer_id)
+{
+    memset(q, 0, sizeof(*q));
+    q->ring = ring;
+    q->ring_qes = ring_qes;
+    q->pi_db = pi_db;
+    q->ci_db = ci_db;
+    q->completer_id = completer_id;
+    q->pi = q->ci = __atomic_load_n(pi_db, __ATOMIC_RELAXED);
+}
+
+// Byte count of a read and the offset of its first enabled byte
+static inline uint32_t read_span(uint16_t len_dw, uint8_t be, uint32_t *lead)
+{
+    uint8_t first = be & 0xf, last = be >> 4;
+
+    if (len_dw == 1) {
+        // Zero-length read: one byte, whatever the (disabled) data
+        if (!first) {
+            *lead = 0;
+            return 1;
+        }
+        *lead = __builtin_ctz(first);
+        return 32 - __builtin_clz(first) - *lead;
+    }
+    *lead = first ? __builtin_ctz(first) : 0;
+    return len_dw * 4u - *lead - (last ? __builtin_clz(last) - 28 : 0);
+}
+
+// Completion header at the next QE, returns where the payload goes
+static inline uint8_t *cpl_header(struct tlp_cmpl_queue *q, uint8_t fmt_type, uint32_t len_dw, uint8_t status,
+                                  uint32_t byte_count, uint16_t requester, uint16_t tag, uint32_t lower_addr)
+{
+    uint8_t *qe = q->ring + (size_t)(q->pi++ & (q->ring_qes - 1)) * TLP_QE_SIZE;
+    uint32_t dw[3] = {
+        // T9 and T8 of a 10-bit tag go to DW0 bits 23 and 19
+        htobe32((uint32_t)fmt_type << 24 | (tag & 0x200u) << 14 | (tag & 0x100u) << 11 | (len_dw & 0x3ff)),
+        htobe32((uint32_t)q->completer_id << 16 | (uint32_t)status << 13 | (byte_count & 0xfff)),
+        htobe32((uint32_t)requester << 16 | (tag & 0xffu) << 8 | (lower_addr & 0x7f)),
+    };
+
+    memcpy(qe, dw, sizeof(dw));
+    return qe + sizeof(dw);
+}
+
+// One CplD per TLP_CMPL_CHUNK window the read touches
+static inline uint32_t read_chunks(uint64_t addr, uint16_t len_dw)
+{
+    return (uint32_t)(((addr + len_dw * 4u - 1) / TLP_CMPL_CHUNK) - addr / TLP_CMPL_CHUNK + 1);
+}
+
+static void complete_read(struct tlp_cmpl_queue *q, const struct tlp_batch *batch, uint32_t i, const uint8_t *data)
+{
+    uint64_t addr = batch->addr[i];
+    uint32_t lead, left = batch->len_dw[i] * 4u;
+    uint32_t byte_count = read_span(batch->len_dw[i], batch->be[i], &lead);
+    uint32_t lower_addr = (uint32_t)(addr + lead);
+
+    while (left) {
+        uint32_t n = TLP_CMPL_CHUNK - (addr & (TLP_CMPL_CHUNK - 1));
+        uint8_t *payload;
+
+        if (n > left)
+            n = left;
+        payload = cpl_header(q, FMT_TYPE_CPLD, n / 4, TLP_CPL_SC, byte_count,
+                             batch->requester[i], batch->tag[i], lower_addr);
+        memcpy(payload, data, n);
+
+        // Later completions count from their DW-aligned start
+        byte_count -= n - lead < byte_count ? n - lead : byte_count;
+        lead = 0;
+        addr += n;
+        data += n;
+        left -= n;
+        lower_addr = (uint32_t)addr;
+    }
+}
+
+uint32_t tlp_cmpl_submit(struct tlp_cmpl_queue *q, const struct tlp_batch *batch, uint32_t first,
+                         uint32_t count, const struct tlp_bar_io *bar_io, const struct tlp_cfg_io *cfg_io)
+{
+    uint32_t end = first + count < batch->count ? first + count : batch->count;
+    uint32_t start_pi = q->pi, i;
+
+    for (i = first; i < end; i++) {
+        uint8_t kind = batch->kind[i], status;
+        uint32_t need = 1, lead, byte_count;
+        int is_cfg = kind >= TLP_KIND_CFGRD0 && kind <= TLP_KIND_CFGWR1;
+
+        if (kind == TLP_KIND_MRD) {
+            status = bar_io ? bar_io->status[i] : TLP_BAR_SKIP;
+            if (status == TLP_BAR_RETRY)
+                break;
+            if (status == TLP_BAR_MALFORMED)
+                continue;
+            status = status == TLP_BAR_OK ? TLP_CPL_SC : TLP_CPL_UR;
+            if (status == TLP_CPL_SC)
+                need = read_chunks(batch->addr[i], batch->len_dw[i]);
+        } else if (is_cfg) {
+            status = cfg_io ? cfg_io->status[i] : TLP_CFG_SKIP;
+            if (status == TLP_CFG_MALFORMED)
+                continue;
+            status = status == TLP_CFG_OK ? TLP_CPL_SC : TLP_CPL_UR;
+        } else if (kind == TLP_KIND_MRDLK || kind == TLP_KIND_IORD || kind == TLP_KIND_IOWR ||
+                   kind == TLP_KIND_FETCHADD || kind == TLP_KIND_SWAP || kind == TLP_KIND_CAS) {
+            status = TLP_CPL_UR;
+        } else {
+            continue;   // Posted, completions and invalid QEs
+        }
+
+        if (q->ring_qes - (q->pi - q->ci) < need) {
+            q->ci = __atomic_load_n(q->ci_db, __ATOMIC_ACQUIRE);
+            if (q->ring_qes - (q->pi - q->ci) < need) {
+                q->stalls++;
+                break;
+            }
+        }
+
+        if (kind == TLP_KIND_MRD && status == TLP_CPL_SC) {
+            complete_read(q, batch, i, bar_io->data + bar_io->data_off[i]);
+        } else if (is_cfg && status == TLP_CPL_SC) {
+            // Config completions: byte count 4, lower address 0
+            if (kind == TLP_KIND_CFGRD0 || kind == TLP_KIND_CFGRD1) {
+                uint32_t le = htole32(cfg_io->data[i]);
+
+                memcpy(cpl_header(q, FMT_TYPE_CPLD, 1, TLP_CPL_SC, 4, batch->requester[i], batch->tag[i], 0),
+                       &le, 4);
+            } else {
+                cpl_header(q, FMT_TYPE_CPL, 0, TLP_CPL_SC, 4, batch->requester[i], batch->tag[i], 0);
+            }
+        } else if (kind == TLP_KIND_MRD || kind == TLP_KIND_MRDLK || kind >= TLP_KIND_FETCHADD) {
+            byte_count = read_span(batch->len_dw[i], batch->be[i], &lead);
+            cpl_header(q, kind == TLP_KIND_MRDLK ? FMT_TYPE_CPLLK : FMT_TYPE_CPL, 0, status, byte_count,
+                       batch->requester[i], batch->tag[i], (uint32_t)batch->addr[i] + lead);
+        } else {
+            cpl_header(q, FMT_TYPE_CPL, 0, status, 4, batch->requester[i], batch->tag[i], 0);
+        }
+    }
+
+    if (q->pi != start_pi) {
+        q->cpls += q->pi - start_pi;
+        __atomic_store_n(q->pi_db, q->pi, __ATOMIC_RELEASE);
+    }
+    return i - first;
+}
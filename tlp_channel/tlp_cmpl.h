@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - completion TLPs for served non-posted requests
+ */
+
+#ifndef TLP_CMPL_H
+#define TLP_CMPL_H
+
+#include <stdint.h>
+
+#include "tlp_decode.h"
+#include "tlp_bar.h"
+#include "tlp_cfg.h"
+
+// Read data per CplD. Completions of one MRd split at naturally aligned
+// boundaries of this size, so header and payload always fit one QE.
+#define TLP_CMPL_CHUNK          32
+
+/*
+ * Outbound queue of completion QEs, same 64B Mode0 format as requests.
+ * pi and ci are free running; the consumer owns *ci_db.
+ */
+struct tlp_cmpl_queue {
+    uint8_t         *ring;
+    uint32_t        ring_qes;           // Power of two
+    uint32_t        pi;
+    uint32_t        ci;                 // Last consumer index seen
+    uint32_t        *pi_db;             // Published once per submit
+    const uint32_t  *ci_db;
+    uint16_t        completer_id;
+    uint64_t        cpls;               // Completion TLPs submitted
+    uint64_t        stalls;             // Submits cut short by a full ring
+};
+
+void tlp_cmpl_queue_init(struct tlp_cmpl_queue *q, void *ring, uint32_t ring_qes,
+                         uint32_t *pi_db, const uint32_t *ci_db, uint16_t completer_id);
+
+/**
+ * Complete the non-posted rows [first, first + count) of a served batch
+ *
+ * MRd rows take their status and data from bar_io, Cfg rows from cfg_io;
+ * either may be NULL, its rows then complete with UR like IO and AtomicOp
+ * requests. Posted and malformed rows get no completion. All completion
+ * QEs are written first, then pi is published with a single release store.
+ * Stops early at a row bar_io asks to retry or whose completions do not fit
+ * the ring.
+ * @return: number of rows handled, the caller resubmits from there
+ */
+uint32_t tlp_cmpl_submit(struct tlp_cmpl_queue *q, const struct tlp_batch *batch, uint32_t first,
+                         uint32_t count, const struct tlp_bar_io *bar_io, const struct tlp_cfg_io *cfg_io);
+
+#endif /* TLP_CMPL_H */
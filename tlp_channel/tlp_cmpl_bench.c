@@ -0,0 +1,588 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel completion benchmark - a simulated requester issues MRd,
+ * CfgRd/CfgWr and other requests into a request ring; the completer
+ * decodes them, serves them from BAR and config space and answers each
+ * batch with one tlp_cmpl_submit(). The requester matches completions by
+ * tag. A verification pass checks every completion header and payload,
+ * then completions/sec and request-to-completion latency are reported.
+ * Requester and completer run interleaved on one core or on two
+ * threads when more CPUs are online.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tlp_bench.h"
+#include "tlp_cmpl.h"
+#include "tlp_np.h"
+
+#define REQ_RING_QES    1024
+#define CPL_RING_QES    4096
+#define BATCH_QES       32
+
+#define REQUESTER_ID    0x0000          // Root port
+#define COMPLETER_ID    0x0100          // 01:00.0, the emulated function
+#define BAR0_BASE       0x100000000ull
+#define BAR0_SIZE       (1u << 20)
+#define READ_AREA       (BAR0_SIZE / 2) // MWrs go to the upper half
+#define VENDOR_ID       0x15b3
+#define DEVICE_ID       0x1021
+#define NFUNCS          8
+
+static uint8_t pattern(uint64_t off)
+{
+    return (uint8_t)(off ^ (off >> 8) ^ 0x5a);
+}
+
+/*
+ * Requests and what their completions must look like
+ */
+struct request {
+    uint8_t     kind;           // enum tlp_kind
+    uint8_t     be;
+    uint8_t     expect_status;  // enum tlp_cpl_status
+    uint8_t     done;
+    uint16_t    len_dw;
+    uint16_t    bdf;
+    uint64_t    addr;           // MRd/MWr/IO: bus address, Cfg: register
+    uint64_t    next;           // Address the next CplD must start at
+    uint32_t    bytes;          // Byte count expected
+    uint32_t    data;           // CfgWr data
+    uint64_t    issued_ns;
+};
+
+enum mix {
+    MIX_RANDOM,                 // Every request kind, for verification
+    MIX_MRD4,
+    MIX_MRD64,
+    MIX_MRD256,
+    MIX_CFGRD,
+};
+
+static const char *mix_names[] = {
+    [MIX_RANDOM] = "random",
+    [MIX_MRD4] = "MRd 4B",
+    [MIX_MRD64] = "MRd 64B",
+    [MIX_MRD256] = "MRd 256B",
+    [MIX_CFGRD] = "CfgRd",
+};
+
+// Reference byte count: enabled bytes from the first to the last one
+static uint32_t ref_bytes(uint16_t len_dw, uint8_t be)
+{
+    uint32_t total = len_dw * 4, first = total, last = 0;
+
+    for (uint32_t i = 0; i < total; i++) {
+        uint32_t on = i < 4 ? (be >> i) & 1 : i >= total - 4 ? (be >> (4 + i - (total - 4))) & 1 : 1;
+
+        if (len_dw == 1 && i >= 4)
+            break;
+        if (on) {
+            first = first < i ? first : i;
+            last = i;
+        }
+    }
+    return first == total ? 1 : last - first + 1;
+}
+
+static uint8_t random_be(uint64_t *seed, uint16_t len_dw)
+{
+    uint32_t r = rnd(seed);
+
+    if (r % 3)
+        return len_dw == 1 ? 0x0f : 0xff;
+    if (len_dw == 1)
+        return (r >> 8) & 0xf;
+    return ((r >> 8) & 0xf ? (r >> 8) & 0xf : 1) | ((r >> 12) & 0xf ? ((r >> 12) & 0xf) << 4 : 0x80);
+}
+
+static void gen_mrd(uint64_t *seed, struct request *r, uint16_t len_dw, uint8_t be)
+{
+    r->kind = TLP_KIND_MRD;
+    r->len_dw = len_dw;
+    r->be = be;
+    r->addr = BAR0_BASE + (rnd(seed) % ((READ_AREA - len_dw * 4) / 4)) * 4;
+    r->expect_status = TLP_CPL_SC;
+}
+
+static void gen_request(uint64_t *seed, enum mix mix, struct request *r)
+{
+    uint32_t pick = rnd(seed) % 100;
+
+    memset(r, 0, sizeof(*r));
+    switch (mix) {
+    case MIX_MRD4:
+        gen_mrd(seed, r, 1, 0x0f);
+        break;
+    case MIX_MRD64:
+        gen_mrd(seed, r, 16, 0xff);
+        break;
+    case MIX_MRD256:
+        gen_mrd(seed, r, 64, 0xff);
+        break;
+    case MIX_CFGRD:
+        r->kind = TLP_KIND_CFGRD0;
+        r->bdf = COMPLETER_ID + rnd(seed) % NFUNCS;
+        r->expect_status = TLP_CPL_SC;
+        break;
+    case MIX_RANDOM:
+        if (pick < 45) {
+            uint16_t len_dw = 1 + rnd(seed) % 64;
+
+            gen_mrd(seed, r, len_dw, random_be(seed, len_dw));
+        } else if (pick < 50) {
+            gen_mrd(seed, r, 1 + rnd(seed) % 64, 0xff);
+            r->addr = 0x80000000ull + (rnd(seed) % 1024) * 4;      // No BAR there
+            r->expect_status = TLP_CPL_UR;
+        } else if (pick < 60) {
+            r->kind = TLP_KIND_MWR;
+            r->len_dw = 1 + rnd(seed) % 8;
+            r->be = r->len_dw == 1 ? 0x0f : 0xff;
+            r->addr = BAR0_BASE + READ_AREA + (rnd(seed) % (READ_AREA / 4 - 8)) * 4;
+        } else if (pick < 80) {
+            r->kind = TLP_KIND_CFGRD0;
+            r->bdf = COMPLETER_ID + rnd(seed) % (NFUNCS + 4);      // Some are absent
+            r->expect_status = r->bdf < COMPLETER_ID + NFUNCS ? TLP_CPL_SC : TLP_CPL_UR;
+        } else if (pick < 92) {
+            r->kind = TLP_KIND_CFGWR0;
+            r->bdf = COMPLETER_ID + rnd(seed) % (NFUNCS + 4);
+            r->addr = 0x0c;
+            r->data = rnd(seed) & 0xff;
+            r->expect_status = r->bdf < COMPLETER_ID + NFUNCS ? TLP_CPL_SC : TLP_CPL_UR;
+        } else {
+            r->kind = TLP_KIND_IORD;
+            r->len_dw = 1;
+            r->be = 0x0f;
+            r->addr = 0x1000 + (rnd(seed) % 64) * 4;
+            r->expect_status = TLP_CPL_UR;
+        }
+        break;
+    }
+    if (r->kind >= TLP_KIND_CFGRD0 && r->kind <= TLP_KIND_CFGWR1) {
+        r->len_dw = 1;
+        r->be = 0x0f;
+    }
+    r->bytes = r->kind == TLP_KIND_MRD ? ref_bytes(r->len_dw, r->be) : 4;
+    r->next = r->addr;
+}
+
+static void encode_request(uint8_t *qe, const struct request *r, uint16_t tag)
+{
+    uint32_t tag_hi = (tag & 0x200u) << 14 | (tag & 0x100u) << 11;
+    uint32_t dw1 = (uint32_t)REQUESTER_ID << 16 | (tag & 0xffu) << 8 | r->be;
+
+    switch (r->kind) {
+    case TLP_KIND_MRD:
+    case TLP_KIND_MWR:
+        put_be32(qe, (r->kind == TLP_KIND_MRD ? 0x20u : 0x60u) << 24 | tag_hi | (r->len_dw & 0x3ff));
+        put_be32(qe + 4, dw1);
+        put_be32(qe + 8, r->addr >> 32);
+        put_be32(qe + 12, (uint32_t)r->addr);
+        for (uint32_t i = 0; r->kind == TLP_KIND_MWR && i < r->len_dw * 4u; i++)
+            qe[16 + i] = (uint8_t)(i * 29);
+        break;
+    case TLP_KIND_CFGRD0:
+    case TLP_KIND_CFGWR0:
+        put_be32(qe, (r->kind == TLP_KIND_CFGRD0 ? 0x04u : 0x44u) << 24 | tag_hi | 1);
+        put_be32(qe + 4, dw1);
+        put_be32(qe + 8, (uint32_t)r->bdf << 16 | (uint32_t)r->addr);
+        if (r->kind == TLP_KIND_CFGWR0) {
+            uint32_t le = htole32(r->data);
+
+            memcpy(qe + 12, &le, 4);
+        }
+        break;
+    default:
+        put_be32(qe, 0x02u << 24 | tag_hi | 1);
+        put_be32(qe + 4, dw1);
+        put_be32(qe + 8, (uint32_t)r->addr);
+        break;
+    }
+}
+
+/*
+ * Requester / completer pair
+ */
+struct pair {
+    // Shared indices, one cache line each
+    uint32_t            req_pi __attribute__((aligned(64)));
+    uint32_t            req_ci __attribute__((aligned(64)));
+    uint32_t            cpl_pi __attribute__((aligned(64)));
+    uint32_t            cpl_ci __attribute__((aligned(64)));
+
+    uint8_t             *req_ring;
+    uint8_t             *cpl_ring;
+    uint32_t            cpl_qes;
+
+    // Completer
+    struct tlp_bar_set  *bars;
+    struct tlp_cfg_port *port;
+    struct tlp_cmpl_queue cq;
+    struct tlp_batch    batch;
+    struct tlp_bar_io   bio;
+    struct tlp_cfg_io   cio;
+    uint32_t            cons_ci;
+    uint32_t            row;
+    int                 have_batch;
+    uint32_t            submit_rows;        // Rows per tlp_cmpl_submit()
+
+    // Requester: tags from a free stack, completions matched by the tracker
+    struct tlp_np_tracker *np;
+    uint16_t            free_tags[TLP_NP_TAGS];
+    uint32_t            nfree;
+    struct tlp_batch    cbatch;
+    struct request      *reqs;
+    uint32_t            nreqs;
+    uint32_t            issued;
+    uint32_t            completed;
+    uint32_t            prod_pi;
+    uint32_t            cpl_cons;
+    uint32_t            depth;              // Outstanding non-posted requests at most
+    uint32_t            *lat_ns;
+    uint32_t            nlat;
+    uint32_t            errors;
+    int                 verify;
+};
+
+static int completer_step(struct pair *p)
+{
+    uint32_t done;
+
+    if (!p->have_batch) {
+        uint32_t avail = __atomic_load_n(&p->req_pi, __ATOMIC_ACQUIRE) - p->cons_ci;
+
+        if (!avail)
+            return 0;
+        tlp_decode_qes(p->req_ring, REQ_RING_QES, p->cons_ci, avail < BATCH_QES ? avail : BATCH_QES, &p->batch);
+        tlp_bar_serve(p->bars, p->req_ring, &p->batch, &p->bio);
+        // Rows from the first retry on are decoded again next time
+        p->batch.count = p->bio.retry_from;
+        tlp_cfg_serve(p->port, p->req_ring, &p->batch, &p->cio);
+        p->row = 0;
+        p->have_batch = 1;
+    }
+
+    do {
+        done = tlp_cmpl_submit(&p->cq, &p->batch, p->row, p->submit_rows, &p->bio, &p->cio);
+        p->row += done;
+    } while (done && p->row < p->batch.count);
+
+    if (p->row == p->batch.count) {
+        p->cons_ci += p->batch.count;
+        __atomic_store_n(&p->req_ci, p->cons_ci, __ATOMIC_RELEASE);
+        p->have_batch = 0;
+    }
+    return 1;
+}
+
+static void check_completion(struct pair *p, uint32_t i, struct request *r)
+{
+    const struct tlp_batch *b = &p->cbatch;
+    const uint8_t *payload = p->cpl_ring + (size_t)b->qe[i] * TLP_QE_SIZE + 12;
+
+    if (b->requester[i] != REQUESTER_ID || b->target[i] != COMPLETER_ID ||
+        b->cpl_status[i] != r->expect_status) {
+        p->errors++;
+        return;
+    }
+    if (b->kind[i] != TLP_KIND_CPLD)
+        return;
+
+    if (r->kind == TLP_KIND_MRD) {
+        if ((b->addr[i] & 0x7c) != (r->next & 0x7c))
+            p->errors++;
+        for (uint32_t k = 0; k < b->len_dw[i] * 4u; k++)
+            p->errors += payload[k] != pattern((r->next & ~3ull) - BAR0_BASE + k);
+        r->next = (r->next & ~3ull) + b->len_dw[i] * 4u;
+    } else if (r->kind == TLP_KIND_CFGRD0) {
+        uint32_t v;
+
+        memcpy(&v, payload, 4);
+        p->errors += le32toh(v) != ((uint32_t)DEVICE_ID << 16 | VENDOR_ID);
+    }
+}
+
+static int requester_step(struct pair *p)
+{
+    uint32_t req_free = REQ_RING_QES - (p->prod_pi - __atomic_load_n(&p->req_ci, __ATOMIC_ACQUIRE));
+    uint32_t cpl_pi, n = 0, start_pi = p->prod_pi;
+    uint64_t now = p->verify ? 0 : now_ns();
+
+    // Issue
+    while (n < BATCH_QES && n < req_free && p->issued < p->nreqs) {
+        struct request *r = &p->reqs[p->issued];
+        int tag = 0;
+
+        if (r->kind != TLP_KIND_MWR) {
+            // First enabled byte of a read, 0 for Cfg and IO
+            uint32_t lower_addr = r->kind != TLP_KIND_MRD ? 0 :
+                                  (uint32_t)r->addr + ((r->be & 0xf) ? __builtin_ctz(r->be & 0xf) : 0);
+
+            if (tlp_np_outstanding(p->np) >= p->depth || !p->nfree)
+                break;
+            tag = p->free_tags[--p->nfree];
+            if (tlp_np_insert(p->np, REQUESTER_ID, tag, r->bytes, lower_addr, p->issued, now) != TLP_NP_OK) {
+                p->errors++;
+                break;
+            }
+        }
+        encode_request(p->req_ring + (size_t)(p->prod_pi++ & (REQ_RING_QES - 1)) * TLP_QE_SIZE, r, tag);
+        r->issued_ns = now;
+        if (r->kind == TLP_KIND_MWR) {
+            r->done = 1;
+            p->completed++;
+        }
+        p->issued++;
+        n++;
+    }
+    if (p->prod_pi != start_pi)
+        __atomic_store_n(&p->req_pi, p->prod_pi, __ATOMIC_RELEASE);
+
+    // Match completions
+    cpl_pi = __atomic_load_n(&p->cpl_pi, __ATOMIC_ACQUIRE);
+    if (cpl_pi == p->cpl_cons)
+        return n != 0;
+    now = p->verify ? 0 : now_ns();
+    while (p->cpl_cons != cpl_pi) {
+        uint32_t cnt = tlp_decode_qes(p->cpl_ring, p->cpl_qes, p->cpl_cons, cpl_pi - p->cpl_cons, &p->cbatch);
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            uint64_t cookie;
+            int rc = tlp_np_complete(p->np, &p->cbatch, i, &cookie);
+            struct request *r;
+
+            if (rc != TLP_NP_OK && rc != TLP_NP_DONE) {
+                p->errors++;
+                continue;
+            }
+            r = &p->reqs[cookie];
+            if (p->verify)
+                check_completion(p, i, r);
+            if (rc == TLP_NP_DONE) {
+                p->free_tags[p->nfree++] = p->cbatch.tag[i];
+                if (p->verify && r->kind == TLP_KIND_MRD && r->expect_status == TLP_CPL_SC &&
+                    r->next != r->addr + r->len_dw * 4u)
+                    p->errors++;
+                r->done = 1;
+                p->completed++;
+                if (p->lat_ns)
+                    p->lat_ns[p->nlat++] = (uint32_t)(now - r->issued_ns);
+            }
+        }
+        p->cpl_cons += cnt;
+    }
+    __atomic_store_n(&p->cpl_ci, p->cpl_cons, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void *completer_thread(void *arg)
+{
+    struct pair *p = arg;
+
+    while (__atomic_load_n(&p->completed, __ATOMIC_RELAXED) < p->nreqs &&
+           !__atomic_load_n(&p->errors, __ATOMIC_RELAXED))
+        if (!completer_step(p))
+            sched_yield();
+    return NULL;
+}
+
+static int setup_completer(struct pair *p, struct tlp_cfg_layout **layout)
+{
+    static uint8_t chunk[4096];
+
+    p->bars = tlp_bar_set_create();
+    if (!p->bars || tlp_bar_setup(p->bars, 0, BAR0_SIZE, BAR0_BASE) ||
+        tlp_bar_map_ram(p->bars, 0, 0, BAR0_SIZE))
+        return -1;
+    for (uint64_t off = 0; off < BAR0_SIZE; off += sizeof(chunk)) {
+        for (uint32_t k = 0; k < sizeof(chunk); k++)
+            chunk[k] = pattern(off + k);
+        tlp_bar_write(p->bars, 0, off, chunk, sizeof(chunk));
+    }
+
+    *layout = tlp_cfg_layout_create(VENDOR_ID, DEVICE_ID, 0x020000);
+    p->port = tlp_cfg_port_create(COMPLETER_ID >> 8, COMPLETER_ID >> 8);
+    if (!*layout || !p->port)
+        return -1;
+    for (uint32_t f = 0; f < NFUNCS; f++)
+        if (!tlp_cfg_func_add(p->port, COMPLETER_ID + f, *layout, NULL))
+            return -1;
+    return 0;
+}
+
+/**
+ * Run one requester/completer session
+ *
+ * @param cpl_qes: Completion ring size, small rings exercise partial submits
+ * @param read_cap: Read buffer of the completer, small ones exercise retries
+ * @return: elapsed seconds, negative on failure
+ */
+static double run_pair(enum mix mix, uint32_t nreqs, uint32_t cpl_qes, uint32_t read_cap,
+                       uint32_t submit_rows, uint32_t depth, int verify, int threads, struct pair **out)
+{
+    struct tlp_cfg_layout *layout = NULL;
+    struct pair *p = aligned_alloc(64, sizeof(*p));
+    uint64_t seed = 0xc91 + mix;
+    pthread_t thread;
+    double elapsed = -1;
+    uint64_t start;
+
+    if (!p)
+        return -1;
+    memset(p, 0, sizeof(*p));
+    p->req_ring = calloc(REQ_RING_QES, TLP_QE_SIZE);
+    p->cpl_ring = calloc(CPL_RING_QES, TLP_QE_SIZE);
+    p->bio.data = malloc(read_cap);
+    p->bio.data_cap = read_cap;
+    p->reqs = malloc((size_t)nreqs * sizeof(*p->reqs));
+    p->lat_ns = verify ? NULL : malloc((size_t)nreqs * sizeof(*p->lat_ns));
+    if (!p->req_ring || !p->cpl_ring || !p->bio.data || !p->reqs || (!verify && !p->lat_ns) ||
+        setup_completer(p, &layout))
+        goto out;
+
+    // Small completion rings use the start of the allocated one
+    p->cpl_qes = cpl_qes;
+    tlp_cmpl_queue_init(&p->cq, p->cpl_ring, cpl_qes, &p->cpl_pi, &p->cpl_ci, COMPLETER_ID);
+    // Completion timeout far beyond a run, nothing is expired
+    p->np = tlp_np_tracker_create(60000000000ull, 1000000);
+    if (!p->np)
+        goto out;
+    // Hand out low tags first
+    for (uint32_t t = 0; t < TLP_NP_TAGS; t++)
+        p->free_tags[p->nfree++] = TLP_NP_TAGS - 1 - t;
+    p->submit_rows = submit_rows;
+    p->nreqs = nreqs;
+    p->depth = depth;
+    p->verify = verify;
+    for (uint32_t i = 0; i < nreqs; i++)
+        gen_request(&seed, mix, &p->reqs[i]);
+
+    start = now_ns();
+    if (threads) {
+        if (pthread_create(&thread, NULL, completer_thread, p))
+            goto out;
+        while (p->completed < nreqs && !p->errors)
+            if (!requester_step(p))
+                sched_yield();
+        pthread_join(thread, NULL);
+    } else {
+        // A lost completion keeps its tag busy, stop at the first error
+        while (p->completed < nreqs && !p->errors) {
+            requester_step(p);
+            completer_step(p);
+        }
+    }
+    elapsed = (now_ns() - start) / 1e9;
+
+    if (p->nfree != TLP_NP_TAGS || tlp_np_outstanding(p->np))
+        p->errors++;
+    for (uint32_t i = 0; i < nreqs; i++)
+        p->errors += !p->reqs[i].done;
+
+out:
+    tlp_np_tracker_destroy(p->np);
+    p->np = NULL;
+    tlp_cfg_port_destroy(p->port);
+    tlp_cfg_layout_destroy(layout);
+    tlp_bar_set_destroy(p->bars);
+    free(p->req_ring);
+    free(p->cpl_ring);
+    free(p->bio.data);
+    free(p->reqs);
+    p->req_ring = p->cpl_ring = NULL;
+    p->reqs = NULL;
+    *out = p;
+    return elapsed;
+}
+
+static int verify(uint32_t nreqs)
+{
+    static const struct {
+        const char  *name;
+        uint32_t    cpl_qes;
+        uint32_t    read_cap;
+        uint32_t    submit_rows;
+    } cases[] = {
+        { "batched submit",                     CPL_RING_QES, 64 * 1024, BATCH_QES },
+        { "per-row submit",                     CPL_RING_QES, 64 * 1024, 1 },
+        { "4KB read buffer (retries)",          CPL_RING_QES, 4096,      BATCH_QES },
+        { "16-QE completion ring (stalls)",     16,           64 * 1024, BATCH_QES },
+    };
+    int ret = 0;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        struct pair *p = NULL;
+        double t = run_pair(MIX_RANDOM, nreqs, cases[c].cpl_qes, cases[c].read_cap,
+                            cases[c].submit_rows, 256, 1, 0, &p);
+
+        if (t < 0 || !p || p->errors) {
+            printf("✗ %s: %u errors\n", cases[c].name, p ? p->errors : 0);
+            ret = -1;
+        } else {
+            printf("✓ %s: %u requests, %lu completions, %lu full-ring stalls\n", cases[c].name,
+                   nreqs, p->cq.cpls, p->cq.stalls);
+        }
+        if (p)
+            free(p->lat_ns);
+        free(p);
+    }
+    return ret;
+}
+
+static void bench(enum mix mix, uint32_t nreqs, uint32_t submit_rows, uint32_t depth, int threads)
+{
+    struct pair *p = NULL;
+    double t = run_pair(mix, nreqs, CPL_RING_QES, 64 * 1024, submit_rows, depth, 0, threads, &p);
+    uint64_t sum = 0;
+
+    if (t < 0 || !p || p->errors || !p->nlat) {
+        printf("  %-9s failed\n", mix_names[mix]);
+    } else {
+        qsort(p->lat_ns, p->nlat, sizeof(*p->lat_ns), cmp_u32);
+        for (uint32_t i = 0; i < p->nlat; i++)
+            sum += p->lat_ns[i];
+        printf("  %-9s %-6s %8.2f M/s %9.2f M/s %9.2f %9.2f %9.2f\n", mix_names[mix],
+               submit_rows == 1 ? "row" : "batch", nreqs / t / 1e6, p->cq.cpls / t / 1e6,
+               sum / (double)p->nlat / 1e3, p->lat_ns[p->nlat / 2] / 1e3, p->lat_ns[p->nlat * 99ull / 100] / 1e3);
+    }
+    if (p)
+        free(p->lat_ns);
+    free(p);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t nreqs = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    uint32_t depth = argc > 2 ? strtoul(argv[2], NULL, 0) : 64;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    static const enum mix mixes[] = { MIX_MRD4, MIX_MRD64, MIX_MRD256, MIX_CFGRD };
+
+    if (argc > 3)
+        threads = atoi(argv[3]);
+
+    printf("TLP Completion Benchmark\n");
+    printf("========================\n");
+    printf("Usage: %s [requests] [outstanding] [threads]\n\n", argv[0]);
+
+    printf("Verification (requester checks every completion):\n");
+    if (verify(200000))
+        return 1;
+
+    printf("\n%u requests per run, up to %u outstanding, %s\n", nreqs, depth,
+           threads ? "requester and completer on two threads" : "requester and completer interleaved on one thread");
+    printf("  %-9s %-6s %12s %13s %9s %9s %9s\n", "Mix", "Submit", "Requests", "Completions",
+           "Avg us", "p50 us", "p99 us");
+    for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+        bench(mixes[m], nreqs, BATCH_QES, depth, threads);
+        bench(mixes[m], nreqs, 1, depth, threads);
+    }
+    return 0;
+}
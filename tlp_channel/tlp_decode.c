@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - PCIe TLP header decoder for queue elements.
+ * The fmt/type byte indexes a table that says which header DW holds each
+ * field and how to mask it, so every QE is decoded with the same straight
+ * line of loads, shifts and ANDs whatever its type.
+ */
+
+#include <string.h>
+#include <endian.h>
+
+#include "tlp_decode.h"
+
+#define LEN_FIELD       0x7ff           // Length 0 means 1024 DWs
+#define BC_FIELD        0x1fff          // Byte count 0 means 4096 bytes
+#define ADDR_DW_MASK    0xfffffffcu     // Address bits 1:0 are reserved
+
+// Memory and IO requests, address in DW2 (3DW) or DW2:DW3 (4DW)
+#define REQ3(k, be)     { .kind = k, .hdr_dw = 3, .id_dw = 1, .addr_hi_dw = 2, .addr_lo_dw = 2, \
+                          .be_mask = be, .len_mask = LEN_FIELD, .id_mask = 0xffff,               \
+                          .addr_lo_mask = ADDR_DW_MASK }
+#define REQ4(k, be)     { .kind = k, .hdr_dw = 4, .id_dw = 1, .addr_hi_dw = 2, .addr_lo_dw = 3, \
+                          .be_mask = be, .len_mask = LEN_FIELD, .id_mask = 0xffff,               \
+                          .addr_hi_mask = 0xffffffffu, .addr_lo_mask = ADDR_DW_MASK }
+
+// Config requests, DW2 = bus/dev/fn and register number
+#define CFG(k)          { .kind = k, .hdr_dw = 3, .id_dw = 1, .target_dw = 2, .addr_lo_dw = 2,   \
+                          .be_mask = 0xff, .len_mask = LEN_FIELD, .id_mask = 0xffff,             \
+                          .target_mask = 0xffff, .addr_lo_mask = 0xffc }
+
+// Completions, DW1 = completer ID/status/byte count, DW2 = requester ID/tag/lower address
+#define CPL(k, len)     { .kind = k, .hdr_dw = 3, .id_dw = 2, .target_dw = 1, .addr_lo_dw = 2,   \
+                          .status_mask = 0x7, .len_mask = len, .id_mask = 0xffff,                \
+                          .target_mask = 0xffff, .bc_mask = BC_FIELD, .addr_lo_mask = 0x7f }
+
+// Messages, always 4DW; only routing 001 (by address) carries an address
+#define MSG(k, len, a)  { .kind = k, .hdr_dw = 4, .id_dw = 1, .addr_hi_dw = 2, .addr_lo_dw = 3, \
+                          .msg_mask = 0xff, .len_mask = len, .id_mask = 0xffff,                  \
+                          .addr_hi_mask = (a) ? 0xffffffffu : 0, .addr_lo_mask = (a) ? ADDR_DW_MASK : 0 }
+
+const struct tlp_fmt_type_desc tlp_fmt_type_table[256] = {
+    [0x00] = REQ3(TLP_KIND_MRD, 0xff),
+    [0x20] = REQ4(TLP_KIND_MRD, 0xff),
+    [0x01] = REQ3(TLP_KIND_MRDLK, 0xff),
+    [0x21] = REQ4(TLP_KIND_MRDLK, 0xff),
+    [0x40] = REQ3(TLP_KIND_MWR, 0xff),
+    [0x60] = REQ4(TLP_KIND_MWR, 0xff),
+    [0x02] = REQ3(TLP_KIND_IORD, 0xff),
+    [0x42] = REQ3(TLP_KIND_IOWR, 0xff),
+    [0x04] = CFG(TLP_KIND_CFGRD0),
+    [0x44] = CFG(TLP_KIND_CFGWR0),
+    [0x05] = CFG(TLP_KIND_CFGRD1),
+    [0x45] = CFG(TLP_KIND_CFGWR1),
+    // Routing 110 and 111 are reserved and stay invalid
+    [0x30] = MSG(TLP_KIND_MSG, 0, 0),
+    [0x31] = MSG(TLP_KIND_MSG, 0, 1),
+    [0x32 ... 0x35] = MSG(TLP_KIND_MSG, 0, 0),
+    [0x70] = MSG(TLP_KIND_MSGD, LEN_FIELD, 0),
+    [0x71] = MSG(TLP_KIND_MSGD, LEN_FIELD, 1),
+    [0x72 ... 0x75] = MSG(TLP_KIND_MSGD, LEN_FIELD, 0),
+    [0x0a] = CPL(TLP_KIND_CPL, 0),
+    [0x4a] = CPL(TLP_KIND_CPLD, LEN_FIELD),
+    [0x0b] = CPL(TLP_KIND_CPLLK, 0),
+    [0x4b] = CPL(TLP_KIND_CPLDLK, LEN_FIELD),
+    // AtomicOp byte enables are reserved
+    [0x4c] = REQ3(TLP_KIND_FETCHADD, 0),
+    [0x6c] = REQ4(TLP_KIND_FETCHADD, 0),
+    [0x4d] = REQ3(TLP_KIND_SWAP, 0),
+    [0x6d] = REQ4(TLP_KIND_SWAP, 0),
+    [0x4e] = REQ3(TLP_KIND_CAS, 0),
+    [0x6e] = REQ4(TLP_KIND_CAS, 0),
+};
+
+static const char *const tlp_kind_names[TLP_KIND_MAX] = {
+    [TLP_KIND_INVALID]  = "invalid",
+    [TLP_KIND_MRD]      = "MRd",
+    [TLP_KIND_MRDLK]    = "MRdLk",
+    [TLP_KIND_MWR]      = "MWr",
+    [TLP_KIND_IORD]     = "IORd",
+    [TLP_KIND_IOWR]     = "IOWr",
+    [TLP_KIND_CFGRD0]   = "CfgRd0",
+    [TLP_KIND_CFGWR0]   = "CfgWr0",
+    [TLP_KIND_CFGRD1]   = "CfgRd1",
+    [TLP_KIND_CFGWR1]   = "CfgWr1",
+    [TLP_KIND_MSG]      = "Msg",
+    [TLP_KIND_MSGD]     = "MsgD",
+    [TLP_KIND_CPL]      = "Cpl",
+    [TLP_KIND_CPLD]     = "CplD",
+    [TLP_KIND_CPLLK]    = "CplLk",
+    [TLP_KIND_CPLDLK]   = "CplDLk",
+    [TLP_KIND_FETCHADD] = "FetchAdd",
+    [TLP_KIND_SWAP]     = "Swap",
+    [TLP_KIND_CAS]      = "CAS",
+};
+
+const char *tlp_kind_str(uint8_t kind)
+{
+    return kind < TLP_KIND_MAX ? tlp_kind_names[kind] : "invalid";
+}
+
+uint32_t tlp_decode_qes(const void *ring, uint32_t ring_qes, uint32_t ci, uint32_t count,
+                        struct tlp_batch *batch)
+{
+    const uint8_t *base = ring;
+    uint32_t mask = ring_qes - 1, invalid = 0;
+
+    if (count > TLP_BATCH_MAX)
+        count = TLP_BATCH_MAX;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t idx = (ci + i) & mask;
+        const struct tlp_fmt_type_desc *d;
+        uint32_t dw[4];
+
+        // A QE always holds 4 header DWs, 3DW TLPs just ignore the last one
+        memcpy(dw, base + (size_t)idx * TLP_QE_SIZE, sizeof(dw));
+        dw[0] = be32toh(dw[0]);
+        dw[1] = be32toh(dw[1]);
+        dw[2] = be32toh(dw[2]);
+        dw[3] = be32toh(dw[3]);
+        d = &tlp_fmt_type_table[dw[0] >> 24];
+
+        batch->kind[i] = d->kind;
+        batch->fmt_type[i] = dw[0] >> 24;
+        batch->hdr_dw[i] = d->hdr_dw;
+        batch->qe[i] = idx;
+        batch->len_dw[i] = ((((dw[0] & 0x3ff) - 1) & 0x3ff) + 1) & d->len_mask;
+        batch->requester[i] = (dw[d->id_dw] >> 16) & d->id_mask;
+        // 10-bit tag: T9 is DW0 bit 23, T8 is DW0 bit 19
+        batch->tag[i] = (((dw[d->id_dw] >> 8) & 0xff) |
+                         ((dw[0] >> 11) & 0x100) | ((dw[0] >> 14) & 0x200)) & d->id_mask;
+        batch->be[i] = dw[1] & d->be_mask;
+        batch->msg_code[i] = dw[1] & d->msg_mask;
+        batch->target[i] = (dw[d->target_dw] >> 16) & d->target_mask;
+        batch->cpl_status[i] = (dw[1] >> 13) & d->status_mask;
+        batch->byte_count[i] = ((((dw[1] & 0xfff) - 1) & 0xfff) + 1) & d->bc_mask;
+        batch->addr[i] = (uint64_t)(dw[d->addr_hi_dw] & d->addr_hi_mask) << 32 |
+                         (dw[d->addr_lo_dw] & d->addr_lo_mask);
+        invalid += d->kind == TLP_KIND_INVALID;
+    }
+
+    batch->count = count;
+    batch->invalid = invalid;
+    return count;
+}
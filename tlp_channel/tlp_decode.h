@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - PCIe TLP header decoder for queue elements
+ */
+
+#ifndef TLP_DECODE_H
+#define TLP_DECODE_H
+
+#include <stdint.h>
+
+// Mode0 queue element: the TLP header as on the wire (DW0 first, big-endian),
+// followed by its payload
+#define TLP_QE_SIZE             64
+
+// Largest run of QEs decoded into one batch
+#define TLP_BATCH_MAX           256
+
+enum tlp_kind {
+    TLP_KIND_INVALID = 0,       // Reserved fmt/type or TLP prefix
+    TLP_KIND_MRD,
+    TLP_KIND_MRDLK,
+    TLP_KIND_MWR,
+    TLP_KIND_IORD,
+    TLP_KIND_IOWR,
+    TLP_KIND_CFGRD0,
+    TLP_KIND_CFGWR0,
+    TLP_KIND_CFGRD1,
+    TLP_KIND_CFGWR1,
+    TLP_KIND_MSG,
+    TLP_KIND_MSGD,
+    TLP_KIND_CPL,
+    TLP_KIND_CPLD,
+    TLP_KIND_CPLLK,
+    TLP_KIND_CPLDLK,
+    TLP_KIND_FETCHADD,
+    TLP_KIND_SWAP,
+    TLP_KIND_CAS,
+    TLP_KIND_MAX,
+};
+
+// Completion status, batch->cpl_status
+enum tlp_cpl_status {
+    TLP_CPL_SC  = 0,            // Successful Completion
+    TLP_CPL_UR  = 1,            // Unsupported Request
+    TLP_CPL_CRS = 2,            // Configuration Request Retry Status
+    TLP_CPL_CA  = 4,            // Completer Abort
+};
+
+/*
+ * Decoding rules of one fmt/type byte (DW0 bits 31:24). Each field is read
+ * from a fixed header DW and masked, a zero mask yields 0 for TLPs that do
+ * not carry the field, so decoding needs no switch on the type.
+ */
+struct tlp_fmt_type_desc {
+    uint8_t     kind;               // enum tlp_kind
+    uint8_t     hdr_dw;             // 3 or 4, 0 when invalid
+    uint8_t     id_dw;              // DW with requester ID and tag
+    uint8_t     target_dw;          // DW with completer ID / config BDF
+    uint8_t     addr_hi_dw;
+    uint8_t     addr_lo_dw;
+    uint8_t     be_mask;            // DW1 byte enables, requests only
+    uint8_t     msg_mask;           // DW1 message code, messages only
+    uint8_t     status_mask;        // Completion status
+    uint8_t     pad;
+    uint16_t    len_mask;           // Length in DWs, 0x7ff where meaningful
+    uint16_t    id_mask;
+    uint16_t    target_mask;
+    uint16_t    bc_mask;            // Completion byte count, 0x1fff for completions
+    uint32_t    addr_hi_mask;
+    uint32_t    addr_lo_mask;
+};
+
+extern const struct tlp_fmt_type_desc tlp_fmt_type_table[256];
+
+/*
+ * Decoded QEs as struct-of-arrays, index i is the i-th QE of the run.
+ * Per kind:
+ *   Memory/IO/AtomicOp  addr = address, be = last << 4 | first byte enable
+ *   CfgRd/CfgWr         addr = register byte offset (ext reg << 8 | reg << 2),
+ *                       target = bus << 8 | dev << 3 | fn, be as above
+ *   Cpl*                target = completer ID, addr = lower address,
+ *                       cpl_status, byte_count (1..4096)
+ *   Msg/MsgD            msg_code, addr for address-routed messages
+ * requester and tag (10 bits, T9/T8 included) are set for every valid kind.
+ */
+struct tlp_batch {
+    uint32_t    count;
+    uint32_t    invalid;                    // QEs with kind TLP_KIND_INVALID
+    uint8_t     kind[TLP_BATCH_MAX];
+    uint8_t     fmt_type[TLP_BATCH_MAX];
+    uint8_t     hdr_dw[TLP_BATCH_MAX];      // Payload starts at hdr_dw * 4 in the QE
+    uint8_t     be[TLP_BATCH_MAX];
+    uint8_t     cpl_status[TLP_BATCH_MAX];
+    uint8_t     msg_code[TLP_BATCH_MAX];
+    uint16_t    len_dw[TLP_BATCH_MAX];      // 1..1024, 0 for TLPs without a length
+    uint16_t    requester[TLP_BATCH_MAX];
+    uint16_t    tag[TLP_BATCH_MAX];
+    uint16_t    target[TLP_BATCH_MAX];
+    uint16_t    byte_count[TLP_BATCH_MAX];
+    uint16_t    qe[TLP_BATCH_MAX];          // Ring index of the QE
+    uint64_t    addr[TLP_BATCH_MAX];
+};
+
+/**
+ * Decode a run of ready QEs into a batch
+ *
+ * @param ring: Queue buffer
+ * @param ring_qes: QEs in the ring, power of two (Mode0: 1024)
+ * @param ci: Ring index of the first ready QE, wraps around the ring
+ * @param count: Ready QEs, at most TLP_BATCH_MAX are decoded
+ * @return: number of QEs decoded
+ */
+uint32_t tlp_decode_qes(const void *ring, uint32_t ring_qes, uint32_t ci, uint32_t count,
+                        struct tlp_batch *batch);
+
+const char *tlp_kind_str(uint8_t kind);
+
+// Config register number (0..1023) of a CfgRd/CfgWr row
+static inline uint16_t tlp_batch_cfg_reg(const struct tlp_batch *batch, uint32_t i)
+{
+    return (uint16_t)(batch->addr[i] >> 2);
+}
+
+#endif /* TLP_DECODE_H */
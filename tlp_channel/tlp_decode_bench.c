@@ -0,0 +1,316 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel decode benchmark - decodes rings of 64B QEs with the
+ * table-driven tlp_decode_qes() and with a switch-per-type reference decoder,
+ * checks both agree field by field, and reports millions of TLPs/s.
+ * Synthetic streams are generated in memory; a recorded stream is a file of
+ * raw QEs (e.g. a dumped queue buffer).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "tlp_decode.h"
+
+// Mode0 ring: 1K x 64B QEs
+#define RING_QES        1024
+
+struct stream_mix {
+    const char  *name;
+    uint8_t     fmt_type[12];
+    uint8_t     weight[12];     // Percent, same order as fmt_type
+};
+
+static const struct stream_mix mixes[] = {
+    { "mixed",
+      { 0x60, 0x20, 0x00, 0x4a, 0x0a, 0x04, 0x44, 0x34, 0x70, 0x4c, 0x6e, 0x80 },
+      {   30,   20,   10,   15,    5,    7,    5,    3,    1,    1,    1,    2 } },
+    { "posted writes (MWr 4DW)",
+      { 0x60 }, { 100 } },
+    { "enumeration (CfgRd0/CfgWr0/Cpl)",
+      { 0x04, 0x44, 0x4a, 0x0a }, { 50, 10, 30, 10 } },
+    { "messages (every routing)",
+      { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x70, 0x71, 0x73, 0x77 },
+      {    9,    9,    8,    8,    8,    8,    8,    8,    9,    9,    8,    8 } },
+};
+
+// One QE: random header fields under the given fmt/type, random payload
+static void gen_qe(uint8_t *qe, uint8_t fmt_type, uint64_t *seed)
+{
+    for (int k = 0; k < TLP_QE_SIZE; k += 4)
+        put_be32(qe + k, rnd(seed));
+    // DW0: fmt/type, random TC/attr/tag bits and length
+    put_be32(qe, (uint32_t)fmt_type << 24 | (rnd(seed) & 0x00ffffff));
+}
+
+static void gen_ring(uint8_t *ring, const struct stream_mix *mix, uint64_t seed)
+{
+    for (uint32_t i = 0; i < RING_QES; i++) {
+        uint32_t pick = rnd(&seed) % 100, acc = 0, k = 0;
+
+        while (k < 11 && mix->weight[k + 1] && pick >= acc + mix->weight[k])
+            acc += mix->weight[k++];
+        gen_qe(ring + (size_t)i * TLP_QE_SIZE, mix->fmt_type[k], &seed);
+    }
+}
+
+/*
+ * Reference decoder: a switch on every fmt/type, written straight from the
+ * PCIe header layouts independently of the table
+ */
+static void ref_decode_one(const uint8_t *qe, uint32_t idx, struct tlp_batch *b, uint32_t i)
+{
+    uint32_t dw0 = get_be32(qe), dw1 = get_be32(qe + 4);
+    uint32_t dw2 = get_be32(qe + 8), dw3 = get_be32(qe + 12);
+    uint8_t fmt_type = dw0 >> 24;
+    uint16_t len = (dw0 & 0x3ff) ? (dw0 & 0x3ff) : 1024;
+    uint16_t tag_hi = ((dw0 & (1u << 19)) ? 0x100 : 0) | ((dw0 & (1u << 23)) ? 0x200 : 0);
+    int four_dw = fmt_type & 0x20, atomic = 0;
+
+    b->kind[i] = TLP_KIND_INVALID;
+    b->fmt_type[i] = fmt_type;
+    b->qe[i] = idx;
+    b->hdr_dw[i] = 0;
+    b->be[i] = b->cpl_status[i] = b->msg_code[i] = 0;
+    b->len_dw[i] = b->requester[i] = b->tag[i] = b->target[i] = b->byte_count[i] = 0;
+    b->addr[i] = 0;
+
+    switch (fmt_type) {
+    case 0x00: case 0x20: b->kind[i] = TLP_KIND_MRD; goto mem;
+    case 0x01: case 0x21: b->kind[i] = TLP_KIND_MRDLK; goto mem;
+    case 0x40: case 0x60: b->kind[i] = TLP_KIND_MWR; goto mem;
+    case 0x02: b->kind[i] = TLP_KIND_IORD; goto mem;
+    case 0x42: b->kind[i] = TLP_KIND_IOWR; goto mem;
+    case 0x4c: case 0x6c: b->kind[i] = TLP_KIND_FETCHADD; atomic = 1; goto mem;
+    case 0x4d: case 0x6d: b->kind[i] = TLP_KIND_SWAP; atomic = 1; goto mem;
+    case 0x4e: case 0x6e: b->kind[i] = TLP_KIND_CAS; atomic = 1; goto mem;
+    case 0x04: b->kind[i] = TLP_KIND_CFGRD0; goto cfg;
+    case 0x44: b->kind[i] = TLP_KIND_CFGWR0; goto cfg;
+    case 0x05: b->kind[i] = TLP_KIND_CFGRD1; goto cfg;
+    case 0x45: b->kind[i] = TLP_KIND_CFGWR1; goto cfg;
+    case 0x0a: b->kind[i] = TLP_KIND_CPL; goto cpl;
+    case 0x4a: b->kind[i] = TLP_KIND_CPLD; goto cpl;
+    case 0x0b: b->kind[i] = TLP_KIND_CPLLK; goto cpl;
+    case 0x4b: b->kind[i] = TLP_KIND_CPLDLK; goto cpl;
+    case 0x30 ... 0x35: b->kind[i] = TLP_KIND_MSG; goto msg;
+    case 0x70 ... 0x75: b->kind[i] = TLP_KIND_MSGD; goto msg;
+    default:
+        return;
+    }
+
+mem:
+    b->hdr_dw[i] = four_dw ? 4 : 3;
+    b->len_dw[i] = len;
+    b->requester[i] = dw1 >> 16;
+    b->tag[i] = ((dw1 >> 8) & 0xff) | tag_hi;
+    b->be[i] = atomic ? 0 : dw1 & 0xff;
+    b->addr[i] = four_dw ? ((uint64_t)dw2 << 32 | (dw3 & ~3u)) : (dw2 & ~3u);
+    return;
+
+cfg:
+    b->hdr_dw[i] = 3;
+    b->len_dw[i] = len;
+    b->requester[i] = dw1 >> 16;
+    b->tag[i] = ((dw1 >> 8) & 0xff) | tag_hi;
+    b->be[i] = dw1 & 0xff;
+    b->target[i] = dw2 >> 16;
+    b->addr[i] = (dw2 >> 8 & 0xf) << 8 | (dw2 >> 2 & 0x3f) << 2;
+    return;
+
+cpl:
+    b->hdr_dw[i] = 3;
+    b->len_dw[i] = (fmt_type & 0x40) ? len : 0;
+    b->target[i] = dw1 >> 16;
+    b->cpl_status[i] = (dw1 >> 13) & 0x7;
+    b->byte_count[i] = (dw1 & 0xfff) ? (dw1 & 0xfff) : 4096;
+    b->requester[i] = dw2 >> 16;
+    b->tag[i] = ((dw2 >> 8) & 0xff) | tag_hi;
+    b->addr[i] = dw2 & 0x7f;
+    return;
+
+msg:
+    b->hdr_dw[i] = 4;
+    b->len_dw[i] = (fmt_type & 0x40) ? len : 0;
+    b->requester[i] = dw1 >> 16;
+    b->tag[i] = ((dw1 >> 8) & 0xff) | tag_hi;
+    b->msg_code[i] = dw1 & 0xff;
+    // Routed by address
+    if ((fmt_type & 0x7) == 1)
+        b->addr[i] = (uint64_t)dw2 << 32 | (dw3 & ~3u);
+}
+
+static uint32_t ref_decode_qes(const void *ring, uint32_t ring_qes, uint32_t ci, uint32_t count,
+                               struct tlp_batch *batch)
+{
+    uint32_t invalid = 0;
+
+    if (count > TLP_BATCH_MAX)
+        count = TLP_BATCH_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t idx = (ci + i) & (ring_qes - 1);
+
+        ref_decode_one((const uint8_t *)ring + (size_t)idx * TLP_QE_SIZE, idx, batch, i);
+        invalid += batch->kind[i] == TLP_KIND_INVALID;
+    }
+    batch->count = count;
+    batch->invalid = invalid;
+    return count;
+}
+
+/**
+ * Both decoders must agree before their speed means anything
+ * @return: number of mismatching QEs
+ */
+static uint32_t verify(const uint8_t *ring, uint32_t ring_qes)
+{
+    static struct tlp_batch a, b;
+    uint32_t mismatches = 0;
+
+    // Odd start and batch size so runs cross the ring end
+    for (uint32_t ci = 7; ci < ring_qes * 2; ci += 97) {
+        uint32_t n = tlp_decode_qes(ring, ring_qes, ci, 97, &a);
+
+        ref_decode_qes(ring, ring_qes, ci, 97, &b);
+        mismatches += a.invalid != b.invalid;
+        for (uint32_t i = 0; i < n; i++) {
+            mismatches += a.kind[i] != b.kind[i] || a.fmt_type[i] != b.fmt_type[i] ||
+                          a.hdr_dw[i] != b.hdr_dw[i] || a.be[i] != b.be[i] ||
+                          a.cpl_status[i] != b.cpl_status[i] || a.msg_code[i] != b.msg_code[i] ||
+                          a.len_dw[i] != b.len_dw[i] || a.requester[i] != b.requester[i] ||
+                          a.tag[i] != b.tag[i] || a.target[i] != b.target[i] ||
+                          a.byte_count[i] != b.byte_count[i] || a.qe[i] != b.qe[i] ||
+                          a.addr[i] != b.addr[i];
+        }
+    }
+    return mismatches;
+}
+
+// Inlined into main so each decoder is compiled in place instead of called indirectly
+static inline __attribute__((always_inline))
+double bench(uint32_t (*decode)(const void *, uint32_t, uint32_t, uint32_t, struct tlp_batch *),
+             const uint8_t *ring, uint32_t ring_qes, uint32_t batch_qes, uint64_t tlps)
+{
+    static struct tlp_batch batch;
+    uint64_t done = 0, sum = 0;
+    uint32_t ci = 0;
+    double start = now_sec();
+
+    while (done < tlps) {
+        uint32_t n = decode(ring, ring_qes, ci, batch_qes, &batch);
+
+        clobber(&batch);
+        sum += batch.kind[n - 1] + batch.addr[0] + batch.invalid;
+        ci = (ci + n) & (ring_qes - 1);
+        done += n;
+    }
+    clobber(&sum);
+    return now_sec() - start;
+}
+
+static void report(const char *name, double table, double ref, uint64_t tlps)
+{
+    printf("  %-34s table %8.1f MTLPs/s   switch %8.1f MTLPs/s   %.2fx\n",
+           name, tlps / table / 1e6, tlps / ref / 1e6, ref / table);
+}
+
+static int run_stream(const char *name, const uint8_t *ring, uint32_t ring_qes,
+                      uint32_t batch_qes, uint64_t tlps)
+{
+    uint32_t mismatches = verify(ring, ring_qes);
+    double table, ref;
+
+    if (mismatches) {
+        printf("  %-34s ✗ table and switch decoders disagree on %u QEs\n", name, mismatches);
+        return -1;
+    }
+
+    // Warm up both decoders before timing
+    bench(tlp_decode_qes, ring, ring_qes, batch_qes, tlps / 10);
+    bench(ref_decode_qes, ring, ring_qes, batch_qes, tlps / 10);
+
+    table = bench(tlp_decode_qes, ring, ring_qes, batch_qes, tlps);
+    ref = bench(ref_decode_qes, ring, ring_qes, batch_qes, tlps);
+    report(name, table, ref, tlps);
+    return 0;
+}
+
+/*
+ * Recorded stream: raw QEs repeated to fill a power-of-two ring
+ */
+static uint8_t *load_recorded(const char *path, uint32_t *ring_qes)
+{
+    uint8_t *file_buf = NULL, *ring = NULL;
+    long size;
+    size_t nqes;
+    FILE *f = fopen(path, "rb");
+
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < TLP_QE_SIZE || fseek(f, 0, SEEK_SET)) {
+        fprintf(stderr, "%s: need at least one %d byte QE\n", path, TLP_QE_SIZE);
+        goto out;
+    }
+    nqes = size / TLP_QE_SIZE;
+    file_buf = malloc(nqes * TLP_QE_SIZE);
+    if (!file_buf || fread(file_buf, TLP_QE_SIZE, nqes, f) != nqes) {
+        fprintf(stderr, "%s: read failed\n", path);
+        goto out;
+    }
+
+    for (*ring_qes = RING_QES; *ring_qes < nqes; *ring_qes *= 2)
+        ;
+    ring = malloc((size_t)*ring_qes * TLP_QE_SIZE);
+    for (uint32_t i = 0; ring && i < *ring_qes; i++)
+        memcpy(ring + (size_t)i * TLP_QE_SIZE, file_buf + (i % nqes) * TLP_QE_SIZE, TLP_QE_SIZE);
+    printf("Recorded stream: %zu QEs from %s\n", nqes, path);
+
+out:
+    free(file_buf);
+    fclose(f);
+    return ring;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t tlps = argc > 1 ? strtoull(argv[1], NULL, 0) : 100000000;
+    uint32_t batch_qes = argc > 2 ? strtoul(argv[2], NULL, 0) : 64;
+    const char *recorded = argc > 3 ? argv[3] : NULL;
+    static uint8_t ring[RING_QES * TLP_QE_SIZE];
+    int ret = 0;
+
+    printf("TLP Decode Benchmark\n");
+    printf("====================\n");
+    printf("Usage: %s [tlps] [batch_qes] [recorded_qes.bin]\n\n", argv[0]);
+
+    if (batch_qes < 1 || batch_qes > TLP_BATCH_MAX) {
+        fprintf(stderr, "batch_qes must be 1..%d\n", TLP_BATCH_MAX);
+        return 1;
+    }
+    printf("TLPs per stream: %lu, batch: %u QEs, ring: %d QEs\n", tlps, batch_qes, RING_QES);
+
+    for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+        gen_ring(ring, &mixes[m], 0x5eed + m);
+        ret |= run_stream(mixes[m].name, ring, RING_QES, batch_qes, tlps);
+    }
+
+    if (recorded) {
+        uint32_t ring_qes;
+        uint8_t *rec = load_recorded(recorded, &ring_qes);
+
+        if (!rec)
+            return 1;
+        ret |= run_stream("recorded", rec, ring_qes, batch_qes, tlps);
+        free(rec);
+    }
+
+    if (ret == 0)
+        printf("\n✓ table decoder matches the switch decoder on every stream\n");
+    return ret ? 1 : 0;
+}
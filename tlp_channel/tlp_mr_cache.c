@@ -0,0 +1,567 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - memory registration cache.
+ * Registrations are kept in an interval tree (a treap ordered by start
+ * address, each node tracking the largest end address below it) so a
+ * covering MR is found in O(log n). Entries are refcounted; when the last
+ * user puts one it stays registered on an idle LRU and is only dropped
+ * when the idle set grows past its limits, on flush, or when its range is
+ * freed or unmapped through the invalidating wrappers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "tlp_mr_cache.h"
+#include "tlp_numa.h"
+
+struct mr_entry {
+    // Interval tree, ordered by (start, entry address)
+    uintptr_t           start;
+    uintptr_t           end;
+    uintptr_t           max_end;        // Largest end in this subtree
+    uint32_t            prio;
+    struct mr_entry     *left;
+    struct mr_entry     *right;
+
+    struct ibv_pd       *pd;
+    struct ibv_mr       *mr;
+    int                 access;
+    int                 numa_node;      // Owned buffers: node asked for, -1 for none
+    uint32_t            refcnt;
+    uint8_t             owned;          // Buffer allocated by the cache
+    uint8_t             in_tree;        // Cleared when invalidated while in use
+
+    // Idle LRU (oldest first), or the stale list once out of the tree
+    struct mr_entry     *lru_prev;
+    struct mr_entry     *lru_next;
+};
+
+static struct {
+    pthread_mutex_t             lock;
+    struct mr_entry             *root;
+    struct mr_entry             *lru_head;
+    struct mr_entry             *lru_tail;
+    struct mr_entry             *stale;
+    uint32_t                    nidle;
+    size_t                      idle_bytes;
+    uint32_t                    seed;
+    struct tlp_mr_cache_stats   stats;
+} cache = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .seed = 0x2545f491,
+};
+
+static size_t page_size(void)
+{
+    static size_t size;
+    size_t cur = __atomic_load_n(&size, __ATOMIC_RELAXED);
+
+    if (!cur) {
+        long ret = sysconf(_SC_PAGESIZE);
+        cur = ret > 0 ? (size_t)ret : 4096;
+        __atomic_store_n(&size, cur, __ATOMIC_RELAXED);
+    }
+    return cur;
+}
+
+// Wider access is fine, but pinned and ODP registrations never stand in for each other
+static int access_ok(int have, int want)
+{
+    return (have & want) == want && !((have ^ want) & IBV_ACCESS_ON_DEMAND);
+}
+
+/*
+ * Treap - caller holds cache.lock
+ */
+static uint32_t next_prio(void)
+{
+    // xorshift32, priorities only need to look random
+    cache.seed ^= cache.seed << 13;
+    cache.seed ^= cache.seed >> 17;
+    cache.seed ^= cache.seed << 5;
+    return cache.seed;
+}
+
+static int entry_less(const struct mr_entry *a, const struct mr_entry *b)
+{
+    return a->start < b->start || (a->start == b->start && (uintptr_t)a < (uintptr_t)b);
+}
+
+static void tree_update(struct mr_entry *n)
+{
+    n->max_end = n->end;
+    if (n->left && n->left->max_end > n->max_end)
+        n->max_end = n->left->max_end;
+    if (n->right && n->right->max_end > n->max_end)
+        n->max_end = n->right->max_end;
+}
+
+static struct mr_entry *rotate_right(struct mr_entry *n)
+{
+    struct mr_entry *l = n->left;
+
+    n->left = l->right;
+    l->right = n;
+    tree_update(n);
+    tree_update(l);
+    return l;
+}
+
+static struct mr_entry *rotate_left(struct mr_entry *n)
+{
+    struct mr_entry *r = n->right;
+
+    n->right = r->left;
+    r->left = n;
+    tree_update(n);
+    tree_update(r);
+    return r;
+}
+
+static struct mr_entry *tree_insert(struct mr_entry *root, struct mr_entry *e)
+{
+    if (!root) {
+        e->left = e->right = NULL;
+        tree_update(e);
+        return e;
+    }
+    if (entry_less(e, root)) {
+        root->left = tree_insert(root->left, e);
+        if (root->left->prio > root->prio)
+            return rotate_right(root);
+    } else {
+        root->right = tree_insert(root->right, e);
+        if (root->right->prio > root->prio)
+            return rotate_left(root);
+    }
+    tree_update(root);
+    return root;
+}
+
+// Every key in a is below every key in b
+static struct mr_entry *tree_merge(struct mr_entry *a, struct mr_entry *b)
+{
+    if (!a)
+        return b;
+    if (!b)
+        return a;
+    if (a->prio > b->prio) {
+        a->right = tree_merge(a->right, b);
+        tree_update(a);
+        return a;
+    }
+    b->left = tree_merge(a, b->left);
+    tree_update(b);
+    return b;
+}
+
+static struct mr_entry *tree_erase(struct mr_entry *root, struct mr_entry *e)
+{
+    if (!root)
+        return NULL;
+    if (root == e)
+        return tree_merge(e->left, e->right);
+    if (entry_less(e, root))
+        root->left = tree_erase(root->left, e);
+    else
+        root->right = tree_erase(root->right, e);
+    tree_update(root);
+    return root;
+}
+
+// First entry in address order covering [start, end) with the PD and access
+static struct mr_entry *tree_cover(struct mr_entry *n, struct ibv_pd *pd,
+                                   uintptr_t start, uintptr_t end, int access)
+{
+    struct mr_entry *found;
+
+    if (!n || n->max_end < end)
+        return NULL;
+    found = tree_cover(n->left, pd, start, end, access);
+    if (found)
+        return found;
+    if (n->start > start)
+        return NULL;    // Everything to the right starts even later
+    if (n->end >= end && n->pd == pd && access_ok(n->access, access))
+        return n;
+    return tree_cover(n->right, pd, start, end, access);
+}
+
+static struct mr_entry *tree_find(struct mr_entry *n, uintptr_t start,
+                                  const struct ibv_mr *mr, int owned)
+{
+    struct mr_entry *found;
+
+    if (!n)
+        return NULL;
+    if (start < n->start)
+        return tree_find(n->left, start, mr, owned);
+    if (start > n->start)
+        return tree_find(n->right, start, mr, owned);
+    if (owned ? n->owned : n->mr == mr)
+        return n;
+    // Equal starts may sit on either side
+    found = tree_find(n->left, start, mr, owned);
+    return found ? found : tree_find(n->right, start, mr, owned);
+}
+
+// Collect entries overlapping [start, end), caller-owned memory only
+static void tree_overlap(struct mr_entry *n, uintptr_t start, uintptr_t end,
+                         struct mr_entry ***out, size_t *count, size_t *cap)
+{
+    if (!n || n->max_end <= start)
+        return;
+    tree_overlap(n->left, start, end, out, count, cap);
+    if (n->start >= end)
+        return;
+    if (n->end > start && !n->owned) {
+        if (*count == *cap) {
+            size_t ncap = *cap ? *cap * 2 : 16;
+            struct mr_entry **grown = realloc(*out, ncap * sizeof(**out));
+
+            if (!grown)
+                return;
+            *out = grown;
+            *cap = ncap;
+        }
+        (*out)[(*count)++] = n;
+    }
+    tree_overlap(n->right, start, end, out, count, cap);
+}
+
+/*
+ * Idle LRU and stale list - caller holds cache.lock
+ */
+static void lru_push(struct mr_entry *e)
+{
+    e->lru_next = NULL;
+    e->lru_prev = cache.lru_tail;
+    if (cache.lru_tail)
+        cache.lru_tail->lru_next = e;
+    else
+        cache.lru_head = e;
+    cache.lru_tail = e;
+    cache.nidle++;
+    cache.idle_bytes += e->end - e->start;
+}
+
+static void lru_unlink(struct mr_entry *e)
+{
+    if (e->lru_prev)
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        cache.lru_head = e->lru_next;
+    if (e->lru_next)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        cache.lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+    cache.nidle--;
+    cache.idle_bytes -= e->end - e->start;
+}
+
+static void stale_unlink(struct mr_entry *e)
+{
+    struct mr_entry **link;
+
+    for (link = &cache.stale; *link; link = &(*link)->lru_next) {
+        if (*link == e) {
+            *link = e->lru_next;
+            break;
+        }
+    }
+}
+
+static struct mr_entry *stale_find(uintptr_t start, const struct ibv_mr *mr, int owned)
+{
+    for (struct mr_entry *e = cache.stale; e; e = e->lru_next) {
+        if (e->start == start && (owned ? e->owned : e->mr == mr))
+            return e;
+    }
+    return NULL;
+}
+
+// Unlink an idle entry and queue it for deregistration outside the lock
+static void evict(struct mr_entry *e, struct mr_entry **victims)
+{
+    lru_unlink(e);
+    cache.root = tree_erase(cache.root, e);
+    e->in_tree = 0;
+    e->lru_next = *victims;
+    *victims = e;
+}
+
+static void evict_excess(struct mr_entry **victims)
+{
+    while (cache.lru_head && (cache.nidle > TLP_MR_CACHE_MAX_IDLE ||
+                              cache.idle_bytes > TLP_MR_CACHE_MAX_IDLE_BYTES)) {
+        evict(cache.lru_head, victims);
+        cache.stats.evictions++;
+    }
+}
+
+/*
+ * Deregistration, without cache.lock held
+ */
+static void entry_destroy(struct mr_entry *e)
+{
+    if (ibv_dereg_mr(e->mr))
+        fprintf(stderr, "Failed to deregister cached MR: %s\n", strerror(errno));
+    if (e->owned)
+        free((void *)e->start);
+    free(e);
+}
+
+static void destroy_victims(struct mr_entry *victims)
+{
+    while (victims) {
+        struct mr_entry *e = victims;
+
+        victims = e->lru_next;
+        entry_destroy(e);
+    }
+}
+
+static struct mr_entry *entry_register(struct ibv_pd *pd, void *buf, size_t len, int access, int owned,
+                                       int node)
+{
+    struct mr_entry *e;
+
+    e = calloc(1, sizeof(*e));
+    if (!e)
+        return NULL;
+
+    e->mr = ibv_reg_mr(pd, buf, len, access);
+    if (!e->mr) {
+        free(e);
+        return NULL;
+    }
+
+    e->start = (uintptr_t)buf;
+    e->end = e->start + len;
+    e->pd = pd;
+    e->access = access;
+    e->numa_node = node;
+    e->refcnt = 1;
+    e->owned = owned;
+    e->in_tree = 1;
+
+    pthread_mutex_lock(&cache.lock);
+    e->prio = next_prio();
+    cache.root = tree_insert(cache.root, e);
+    pthread_mutex_unlock(&cache.lock);
+    return e;
+}
+
+struct ibv_mr *tlp_mr_cache_get(struct ibv_pd *pd, void *addr, size_t len, int access)
+{
+    uintptr_t start = (uintptr_t)addr & ~(page_size() - 1);
+    uintptr_t end = ((uintptr_t)addr + len + page_size() - 1) & ~(page_size() - 1);
+    struct mr_entry *e, *victims = NULL;
+    struct ibv_mr *mr;
+
+    if (!len) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache.lock);
+    e = tree_cover(cache.root, pd, (uintptr_t)addr, (uintptr_t)addr + len, access);
+    if (e) {
+        if (e->refcnt++ == 0)
+            lru_unlink(e);
+        cache.stats.hits++;
+        mr = e->mr;
+        pthread_mutex_unlock(&cache.lock);
+        return mr;
+    }
+    cache.stats.misses++;
+    evict_excess(&victims);
+    pthread_mutex_unlock(&cache.lock);
+    destroy_victims(victims);
+
+    // Whole pages, so neighbouring buffers on the same pages hit as well
+    e = entry_register(pd, (void *)start, end - start, access, 0, -1);
+    return e ? e->mr : NULL;
+}
+
+static void entry_put(struct mr_entry *e)
+{
+    struct mr_entry *victims = NULL;
+
+    if (--e->refcnt) {
+        pthread_mutex_unlock(&cache.lock);
+        return;
+    }
+    if (!e->in_tree) {
+        // Range was freed while in use, nothing can hit it any more
+        stale_unlink(e);
+        pthread_mutex_unlock(&cache.lock);
+        entry_destroy(e);
+        return;
+    }
+    lru_push(e);
+    evict_excess(&victims);
+    pthread_mutex_unlock(&cache.lock);
+    destroy_victims(victims);
+}
+
+void tlp_mr_cache_put(struct ibv_mr *mr)
+{
+    uintptr_t start = (uintptr_t)mr->addr;
+    struct mr_entry *e;
+
+    pthread_mutex_lock(&cache.lock);
+    e = tree_find(cache.root, start, mr, 0);
+    if (!e)
+        e = stale_find(start, mr, 0);
+    if (!e || !e->refcnt) {
+        pthread_mutex_unlock(&cache.lock);
+        fprintf(stderr, "MR cache: put of unknown MR %p\n", (void *)mr);
+        return;
+    }
+    entry_put(e);   // Drops cache.lock
+}
+
+void *tlp_mr_cache_alloc(struct ibv_pd *pd, size_t len, int access, int node, struct ibv_mr **mr)
+{
+    size_t size = (len + page_size() - 1) & ~(page_size() - 1);
+    struct mr_entry *e, *best = NULL;
+    void *buf;
+
+    // Zero-sized queues are still handed to firmware for validation
+    if (!size)
+        size = page_size();
+
+    pthread_mutex_lock(&cache.lock);
+    // Best fit among idle cache-owned buffers, at most twice the size asked for
+    for (e = cache.lru_head; e; e = e->lru_next) {
+        size_t have = e->end - e->start;
+
+        if (!e->owned || e->pd != pd || !access_ok(e->access, access) || e->numa_node != node ||
+            have < size || have / 2 > size)
+            continue;
+        if (!best || have < best->end - best->start)
+            best = e;
+    }
+    if (best) {
+        lru_unlink(best);
+        best->refcnt = 1;
+        cache.stats.hits++;
+        *mr = best->mr;
+        pthread_mutex_unlock(&cache.lock);
+        return (void *)best->start;
+    }
+    cache.stats.misses++;
+    pthread_mutex_unlock(&cache.lock);
+
+    buf = aligned_alloc(page_size(), size);
+    if (!buf)
+        return NULL;
+    // Best effort, before registration pins or maps the pages
+    if (node >= 0)
+        tlp_numa_bind(buf, size, node);
+    e = entry_register(pd, buf, size, access, 1, node);
+    if (!e) {
+        free(buf);
+        return NULL;
+    }
+    *mr = e->mr;
+    return buf;
+}
+
+void tlp_mr_cache_release(void *buf)
+{
+    struct mr_entry *e;
+
+    if (!buf)
+        return;
+
+    pthread_mutex_lock(&cache.lock);
+    e = tree_find(cache.root, (uintptr_t)buf, NULL, 1);
+    if (!e)
+        e = stale_find((uintptr_t)buf, NULL, 1);
+    if (!e || !e->refcnt) {
+        pthread_mutex_unlock(&cache.lock);
+        fprintf(stderr, "MR cache: release of unknown buffer %p\n", buf);
+        return;
+    }
+    entry_put(e);   // Drops cache.lock
+}
+
+void tlp_mr_cache_invalidate(const void *addr, size_t len)
+{
+    struct mr_entry **hits = NULL, *victims = NULL;
+    size_t count = 0, cap = 0;
+
+    if (!len)
+        return;
+
+    pthread_mutex_lock(&cache.lock);
+    tree_overlap(cache.root, (uintptr_t)addr, (uintptr_t)addr + len, &hits, &count, &cap);
+    for (size_t i = 0; i < count; i++) {
+        struct mr_entry *e = hits[i];
+
+        cache.stats.invalidations++;
+        if (!e->refcnt) {
+            evict(e, &victims);
+            continue;
+        }
+        // Still in use: hide it, the last put deregisters it
+        cache.root = tree_erase(cache.root, e);
+        e->in_tree = 0;
+        e->lru_next = cache.stale;
+        cache.stale = e;
+    }
+    pthread_mutex_unlock(&cache.lock);
+
+    free(hits);
+    destroy_victims(victims);
+}
+
+void tlp_mr_cache_free(void *ptr)
+{
+    if (!ptr)
+        return;
+    tlp_mr_cache_invalidate(ptr, malloc_usable_size(ptr));
+    free(ptr);
+}
+
+int tlp_mr_cache_munmap(void *addr, size_t len)
+{
+    tlp_mr_cache_invalidate(addr, len);
+    return munmap(addr, len);
+}
+
+void tlp_mr_cache_flush(struct ibv_pd *pd)
+{
+    struct mr_entry *e, *next, *victims = NULL;
+
+    pthread_mutex_lock(&cache.lock);
+    for (e = cache.lru_head; e; e = next) {
+        next = e->lru_next;
+        if (pd && e->pd != pd)
+            continue;
+        evict(e, &victims);
+        cache.stats.evictions++;
+    }
+    pthread_mutex_unlock(&cache.lock);
+
+    destroy_victims(victims);
+}
+
+void tlp_mr_cache_get_stats(struct tlp_mr_cache_stats *stats)
+{
+    pthread_mutex_lock(&cache.lock);
+    *stats = cache.stats;
+    pthread_mutex_unlock(&cache.lock);
+}
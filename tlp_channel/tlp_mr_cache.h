@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - memory registration cache
+ */
+
+#ifndef TLP_MR_CACHE_H
+#define TLP_MR_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+// Idle registrations kept before the least recently used ones are dropped
+#define TLP_MR_CACHE_MAX_IDLE           64
+#define TLP_MR_CACHE_MAX_IDLE_BYTES     (256UL << 20)
+
+struct tlp_mr_cache_stats {
+    uint64_t    hits;           // Served from an existing registration
+    uint64_t    misses;         // Needed ibv_reg_mr()
+    uint64_t    evictions;      // Idle registrations dropped (LRU or flush)
+    uint64_t    invalidations;  // Registrations dropped by free/munmap of their range
+};
+
+/**
+ * Get a registration covering [addr, addr + len)
+ *
+ * Returns a cached MR of the same PD whose range covers the request and whose
+ * access flags include access, registering the enclosing pages on a miss.
+ * IBV_ACCESS_ON_DEMAND must match exactly, pinned and ODP MRs never mix.
+ * Every successful get must be paired with tlp_mr_cache_put(). The memory
+ * must be released with tlp_mr_cache_free()/tlp_mr_cache_munmap() (or
+ * tlp_mr_cache_invalidate() called first) so that no stale translation is
+ * handed out for a recycled address.
+ * @return: MR, NULL on failure with errno set
+ */
+struct ibv_mr *tlp_mr_cache_get(struct ibv_pd *pd, void *addr, size_t len, int access);
+void tlp_mr_cache_put(struct ibv_mr *mr);
+
+/**
+ * Registered buffer owned by the cache
+ *
+ * Reuses an idle cached buffer of the same PD, access and node when one
+ * fits, so create/destroy cycles do not register memory again. The buffer
+ * is page aligned, at least one page long, and its content is undefined.
+ * @param node: NUMA node a new buffer is bound to before registration, -1
+ *              to leave placement to the kernel
+ * @param mr: Registration of the buffer
+ * @return: buffer, NULL on failure
+ */
+void *tlp_mr_cache_alloc(struct ibv_pd *pd, size_t len, int access, int node, struct ibv_mr **mr);
+void tlp_mr_cache_release(void *buf);
+
+/**
+ * Drop registrations overlapping [addr, addr + len)
+ *
+ * Idle registrations are deregistered at once; ones still in use stop being
+ * handed out and are deregistered by their last put.
+ */
+void tlp_mr_cache_invalidate(const void *addr, size_t len);
+
+/**
+ * free()/munmap() that invalidate the released range first
+ */
+void tlp_mr_cache_free(void *ptr);
+int tlp_mr_cache_munmap(void *addr, size_t len);
+
+/**
+ * Deregister every idle registration of a PD (all PDs when NULL)
+ *
+ * Call before ibv_dealloc_pd(). Cache-owned buffers that are idle are
+ * freed as well.
+ */
+void tlp_mr_cache_flush(struct ibv_pd *pd);
+
+void tlp_mr_cache_get_stats(struct tlp_mr_cache_stats *stats);
+
+#endif /* TLP_MR_CACHE_H */
@@ -0,0 +1,238 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - outstanding non-posted request tracker. Each
+ * requester ID gets a fixed table of 1024 entries indexed by tag, found
+ * through a flat map of all 64K requester IDs, so insert and completion
+ * lookup are two array reads. Entries with a pending timeout are linked
+ * into a hashed timer wheel through 32-bit handles (table << 10 | tag);
+ * nothing is allocated per request.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_np.h"
+
+#define NIL                 0xffffffffu
+#define WHEEL_MASK          (TLP_NP_WHEEL_SLOTS - 1)
+
+struct np_table {
+    struct tlp_np_entry ent[TLP_NP_TAGS];
+    uint16_t            requester;
+};
+
+struct tlp_np_tracker {
+    uint32_t            map[65536];         // Requester ID -> table index + 1
+    struct np_table     **tables;
+    uint32_t            ntables;
+    uint32_t            cap;
+    uint32_t            wheel[TLP_NP_WHEEL_SLOTS];
+    uint32_t            cur_tick;           // Next tick tlp_np_expire() walks
+    uint32_t            tick_shift;
+    uint64_t            timeout_ns;
+    uint32_t            outstanding;
+    struct tlp_np_stats stats;
+};
+
+_Static_assert(sizeof(struct tlp_np_entry) == 32, "tag entry must be half a cache line");
+
+static inline struct tlp_np_entry *handle_entry(const struct tlp_np_tracker *t, uint32_t h)
+{
+    return &t->tables[h >> 10]->ent[h & (TLP_NP_TAGS - 1)];
+}
+
+struct tlp_np_tracker *tlp_np_tracker_create(uint64_t timeout_ns, uint64_t tick_ns)
+{
+    struct tlp_np_tracker *t = aligned_alloc(64, sizeof(*t));
+
+    if (!t) {
+        fprintf(stderr, "Failed to allocate request tracker\n");
+        return NULL;
+    }
+    memset(t, 0, sizeof(*t));
+    memset(t->wheel, 0xff, sizeof(t->wheel));
+    while ((1ull << t->tick_shift) < tick_ns)
+        t->tick_shift++;
+    t->timeout_ns = timeout_ns;
+    return t;
+}
+
+void tlp_np_tracker_destroy(struct tlp_np_tracker *t)
+{
+    if (!t)
+        return;
+    for (uint32_t i = 0; i < t->ntables; i++)
+        free(t->tables[i]);
+    free(t->tables);
+    free(t);
+}
+
+static struct np_table *table_get(struct tlp_np_tracker *t, uint16_t requester)
+{
+    struct np_table *table;
+
+    if (t->map[requester])
+        return t->tables[t->map[requester] - 1];
+
+    if (t->ntables == t->cap) {
+        uint32_t cap = t->cap ? t->cap * 2 : 64;
+        struct np_table **tables = realloc(t->tables, cap * sizeof(*tables));
+
+        if (!tables)
+            goto err;
+        t->tables = tables;
+        t->cap = cap;
+    }
+    table = aligned_alloc(64, sizeof(*table));
+    if (!table)
+        goto err;
+    memset(table, 0, sizeof(*table));
+    table->requester = requester;
+    t->tables[t->ntables++] = table;
+    t->map[requester] = t->ntables;
+    return table;
+
+err:
+    fprintf(stderr, "Failed to allocate tag table of requester %04x\n", requester);
+    return NULL;
+}
+
+static inline void wheel_unlink(struct tlp_np_tracker *t, struct tlp_np_entry *e)
+{
+    if (e->prev == NIL)
+        t->wheel[e->deadline & WHEEL_MASK] = e->next;
+    else
+        handle_entry(t, e->prev)->next = e->next;
+    if (e->next != NIL)
+        handle_entry(t, e->next)->prev = e->prev;
+}
+
+static inline void release(struct tlp_np_tracker *t, struct tlp_np_entry *e)
+{
+    wheel_unlink(t, e);
+    e->busy = 0;
+    t->outstanding--;
+}
+
+int tlp_np_insert(struct tlp_np_tracker *t, uint16_t requester, uint16_t tag, uint32_t bytes,
+                  uint32_t lower_addr, uint64_t cookie, uint64_t now_ns)
+{
+    struct np_table *table = table_get(t, requester);
+    uint32_t h, *slot;
+    struct tlp_np_entry *e;
+
+    if (!table)
+        return -1;
+    tag &= TLP_NP_TAGS - 1;
+    e = &table->ent[tag];
+    if (e->busy) {
+        t->stats.duplicate++;
+        return TLP_NP_DUPLICATE;
+    }
+
+    // An empty wheel may start over at the caller's clock
+    if (!t->outstanding)
+        t->cur_tick = (uint32_t)(now_ns >> t->tick_shift);
+
+    e->cookie = cookie;
+    e->remaining = (uint16_t)bytes;
+    e->next_la = lower_addr & 0x7f;
+    e->busy = 1;
+    // One tick late rather than early; never behind the wheel
+    e->deadline = (uint32_t)((now_ns + t->timeout_ns) >> t->tick_shift) + 1;
+    if ((int32_t)(e->deadline - t->cur_tick) < 0)
+        e->deadline = t->cur_tick;
+
+    h = (t->map[requester] - 1) << 10 | tag;
+    slot = &t->wheel[e->deadline & WHEEL_MASK];
+    e->prev = NIL;
+    e->next = *slot;
+    if (*slot != NIL)
+        handle_entry(t, *slot)->prev = h;
+    *slot = h;
+
+    t->outstanding++;
+    t->stats.inserted++;
+    return TLP_NP_OK;
+}
+
+int tlp_np_complete(struct tlp_np_tracker *t, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie)
+{
+    uint32_t idx = t->map[batch->requester[i]];
+    uint8_t kind = batch->kind[i];
+    struct tlp_np_entry *e;
+
+    if (!idx || kind < TLP_KIND_CPL || kind > TLP_KIND_CPLDLK)
+        goto unexpected;
+    e = &t->tables[idx - 1]->ent[batch->tag[i] & (TLP_NP_TAGS - 1)];
+    if (!e->busy)
+        goto unexpected;
+    *cookie = e->cookie;
+
+    if ((kind == TLP_KIND_CPLD || kind == TLP_KIND_CPLDLK) && batch->cpl_status[i] == TLP_CPL_SC) {
+        uint32_t la = (uint32_t)batch->addr[i] & 0x7f;
+        uint32_t bytes = batch->len_dw[i] * 4u - (la & 3);
+
+        if (batch->byte_count[i] != e->remaining || la != e->next_la) {
+            t->stats.order++;
+            return TLP_NP_ORDER;
+        }
+        if (bytes < e->remaining) {
+            e->remaining -= bytes;
+            e->next_la = ((la & ~3u) + batch->len_dw[i] * 4u) & 0x7f;
+            return TLP_NP_OK;
+        }
+    }
+
+    release(t, e);
+    t->stats.done++;
+    return TLP_NP_DONE;
+
+unexpected:
+    t->stats.unexpected++;
+    return TLP_NP_UNEXPECTED;
+}
+
+uint32_t tlp_np_expire(struct tlp_np_tracker *t, uint64_t now_ns, tlp_np_expire_cb cb, void *arg)
+{
+    uint32_t target = (uint32_t)(now_ns >> t->tick_shift);
+    uint32_t ticks = target - t->cur_tick + 1, expired = 0;
+
+    if ((int32_t)(target - t->cur_tick) < 0)
+        return 0;
+    if (ticks > TLP_NP_WHEEL_SLOTS)
+        ticks = TLP_NP_WHEEL_SLOTS;
+
+    for (uint32_t k = 0; k < ticks; k++) {
+        uint32_t h = t->wheel[(t->cur_tick + k) & WHEEL_MASK];
+
+        while (h != NIL) {
+            struct tlp_np_entry *e = handle_entry(t, h);
+            uint32_t next = e->next;
+
+            if ((int32_t)(e->deadline - target) <= 0) {
+                release(t, e);
+                expired++;
+                if (cb)
+                    cb(arg, t->tables[h >> 10]->requester, h & (TLP_NP_TAGS - 1), e->cookie);
+            }
+            h = next;
+        }
+    }
+    t->cur_tick = target + 1;
+    t->stats.expired += expired;
+    return expired;
+}
+
+uint32_t tlp_np_outstanding(const struct tlp_np_tracker *t)
+{
+    return t->outstanding;
+}
+
+const struct tlp_np_stats *tlp_np_stats(const struct tlp_np_tracker *t)
+{
+    return &t->stats;
+}
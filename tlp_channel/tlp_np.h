@@ -0,0 +1,99 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - outstanding non-posted request tracker
+ */
+
+#ifndef TLP_NP_H
+#define TLP_NP_H
+
+#include <stdint.h>
+
+#include "tlp_decode.h"
+
+#define TLP_NP_TAGS             1024    // 10-bit tags per requester
+#define TLP_NP_WHEEL_SLOTS      4096    // Power of two
+
+// Result of tlp_np_insert() and tlp_np_complete()
+enum tlp_np_event {
+    TLP_NP_OK = 0,              // Tracked, or completion accounted with more to follow
+    TLP_NP_DONE,                // Last completion of the request, tag released
+    TLP_NP_DUPLICATE,           // Tag already outstanding for this requester
+    TLP_NP_UNEXPECTED,          // No outstanding request with this tag
+    TLP_NP_ORDER,               // Byte count or lower address does not continue the request
+};
+
+// Slot of a requester's tag table, two per cache line
+struct tlp_np_entry {
+    uint64_t    cookie;
+    uint32_t    deadline;           // Timer wheel tick
+    uint32_t    next;               // Wheel slot list, handles
+    uint32_t    prev;
+    uint16_t    remaining;          // Bytes still to be completed
+    uint8_t     next_la;            // Lower address of the next CplD
+    uint8_t     busy;
+} __attribute__((aligned(32)));
+
+struct tlp_np_stats {
+    uint64_t    inserted;
+    uint64_t    done;
+    uint64_t    expired;
+    uint64_t    duplicate;
+    uint64_t    unexpected;
+    uint64_t    order;
+};
+
+struct tlp_np_tracker;
+
+/**
+ * @param timeout_ns: Completion timeout of every request
+ * @param tick_ns: Timer wheel resolution, rounded up to a power of two.
+ *                 Requests expire between timeout_ns and timeout_ns plus
+ *                 one tick after they were inserted.
+ */
+struct tlp_np_tracker *tlp_np_tracker_create(uint64_t timeout_ns, uint64_t tick_ns);
+void tlp_np_tracker_destroy(struct tlp_np_tracker *t);
+
+/**
+ * Track a non-posted request
+ *
+ * The tag table of a requester is allocated the first time it is seen.
+ * @param bytes: Byte count the completions must cover, 4 for Cfg and IO
+ * @param lower_addr: Address of the first enabled byte, only bits 6:0 are
+ *                    checked, 0 for Cfg and IO
+ * @return: TLP_NP_OK, TLP_NP_DUPLICATE (the request is not tracked), -1 on
+ *          allocation failure
+ */
+int tlp_np_insert(struct tlp_np_tracker *t, uint16_t requester, uint16_t tag, uint32_t bytes,
+                  uint32_t lower_addr, uint64_t cookie, uint64_t now_ns);
+
+/**
+ * Account a decoded completion to its request
+ *
+ * A CplD with SC must carry the byte count still outstanding and the next
+ * lower address, so reordered or lost completions of one request are
+ * reported. A completion with another status or without data ends the
+ * request. The request stays tracked on TLP_NP_ORDER.
+ * @param cookie: Set to the cookie of the request for TLP_NP_OK/DONE/ORDER
+ * @return: enum tlp_np_event
+ */
+int tlp_np_complete(struct tlp_np_tracker *t, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie);
+
+typedef void (*tlp_np_expire_cb)(void *arg, uint16_t requester, uint16_t tag, uint64_t cookie);
+
+/**
+ * Release every request whose completion timeout passed by now_ns
+ *
+ * Walks the wheel slots of the ticks since the last call, at most one
+ * turn of the wheel. Entries due on a later turn stay in place.
+ * @param cb: Called for each expired request after its tag was released,
+ *            it may insert requests but not complete them
+ * @return: number of expired requests
+ */
+uint32_t tlp_np_expire(struct tlp_np_tracker *t, uint64_t now_ns, tlp_np_expire_cb cb, void *arg);
+
+uint32_t tlp_np_outstanding(const struct tlp_np_tracker *t);
+const struct tlp_np_stats *tlp_np_stats(const struct tlp_np_tracker *t);
+
+#endif /* TLP_NP_H */
@@ -0,0 +1,530 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel outstanding request benchmark - the tag table tracker
+ * (tlp_np.h) against a naive tracker that allocates every request, hashes
+ * it by requester and tag and scans everything for timeouts. A random
+ * suite with duplicate tags, reordered and unexpected completions and
+ * timeouts checks both agree, then insert, lookup and expire are timed at
+ * 100K outstanding requests.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "tlp_np.h"
+#include "tlp_cmpl.h"           // Completions split as tlp_cmpl_submit() does
+
+#define NAIVE_BUCKETS   16384           // Hashed with the top 14 bits
+#define BENCH_REQUESTERS 100
+#define BENCH_TAGS      1000            // 100K outstanding
+
+/*
+ * Naive tracker: one allocation per request in a chained hash, timeouts by
+ * scanning every bucket. Same rules as tlp_np.c, also the suite reference.
+ */
+struct naive_req {
+    struct naive_req    *next;
+    uint64_t            cookie;
+    uint64_t            deadline;       // Tick, as in tlp_np.c
+    uint16_t            requester;
+    uint16_t            tag;
+    uint16_t            remaining;
+    uint8_t             next_la;
+};
+
+struct naive {
+    struct naive_req    *bucket[NAIVE_BUCKETS];
+    uint64_t            timeout_ns;
+    uint32_t            tick_shift;
+    uint32_t            outstanding;
+    struct tlp_np_stats stats;
+};
+
+static inline struct naive_req **naive_find(struct naive *n, uint16_t requester, uint16_t tag)
+{
+    uint32_t h = ((uint32_t)requester << 16 | tag) * 2654435761u >> 18;
+    struct naive_req **pp = &n->bucket[h];
+
+    while (*pp && ((*pp)->requester != requester || (*pp)->tag != tag))
+        pp = &(*pp)->next;
+    return pp;
+}
+
+static int naive_insert(struct naive *n, uint16_t requester, uint16_t tag, uint32_t bytes,
+                        uint32_t lower_addr, uint64_t cookie, uint64_t now_ns)
+{
+    struct naive_req **pp = naive_find(n, requester, tag), *r;
+
+    if (*pp) {
+        n->stats.duplicate++;
+        return TLP_NP_DUPLICATE;
+    }
+    r = malloc(sizeof(*r));
+    if (!r)
+        return -1;
+    r->next = NULL;
+    r->cookie = cookie;
+    r->deadline = ((now_ns + n->timeout_ns) >> n->tick_shift) + 1;
+    r->requester = requester;
+    r->tag = tag;
+    r->remaining = (uint16_t)bytes;
+    r->next_la = lower_addr & 0x7f;
+    *pp = r;
+    n->outstanding++;
+    n->stats.inserted++;
+    return TLP_NP_OK;
+}
+
+static int naive_complete(struct naive *n, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie)
+{
+    uint8_t kind = batch->kind[i];
+    struct naive_req **pp, *r;
+
+    if (kind < TLP_KIND_CPL || kind > TLP_KIND_CPLDLK || !*(pp = naive_find(n, batch->requester[i], batch->tag[i]))) {
+        n->stats.unexpected++;
+        return TLP_NP_UNEXPECTED;
+    }
+    r = *pp;
+    *cookie = r->cookie;
+    if ((kind == TLP_KIND_CPLD || kind == TLP_KIND_CPLDLK) && batch->cpl_status[i] == TLP_CPL_SC) {
+        uint32_t la = batch->addr[i] & 0x7f, bytes = batch->len_dw[i] * 4u - (la & 3);
+
+        if (batch->byte_count[i] != r->remaining || la != r->next_la) {
+            n->stats.order++;
+            return TLP_NP_ORDER;
+        }
+        if (bytes < r->remaining) {
+            r->remaining -= bytes;
+            r->next_la = ((la & ~3u) + batch->len_dw[i] * 4u) & 0x7f;
+            return TLP_NP_OK;
+        }
+    }
+    *pp = r->next;
+    free(r);
+    n->outstanding--;
+    n->stats.done++;
+    return TLP_NP_DONE;
+}
+
+static uint32_t naive_expire(struct naive *n, uint64_t now_ns, tlp_np_expire_cb cb, void *arg)
+{
+    uint64_t target = now_ns >> n->tick_shift;
+    uint32_t expired = 0;
+
+    for (uint32_t b = 0; b < NAIVE_BUCKETS; b++) {
+        struct naive_req **pp = &n->bucket[b];
+
+        while (*pp) {
+            struct naive_req *r = *pp;
+
+            if (r->deadline > target) {
+                pp = &r->next;
+                continue;
+            }
+            *pp = r->next;
+            if (cb)
+                cb(arg, r->requester, r->tag, r->cookie);
+            free(r);
+            expired++;
+        }
+    }
+    n->outstanding -= expired;
+    n->stats.expired += expired;
+    return expired;
+}
+
+static struct naive *naive_create(uint64_t timeout_ns, uint64_t tick_ns)
+{
+    struct naive *n = calloc(1, sizeof(*n));
+
+    if (!n)
+        return NULL;
+    n->timeout_ns = timeout_ns;
+    while ((1ull << n->tick_shift) < tick_ns)
+        n->tick_shift++;
+    return n;
+}
+
+static void naive_destroy(struct naive *n)
+{
+    naive_expire(n, ~0ull, NULL, NULL);
+    free(n);
+}
+
+/*
+ * Requests of the suite and the completions they should get
+ */
+struct sreq {
+    uint16_t    requester;
+    uint16_t    tag;
+    uint32_t    cur;            // Next completion starts here (DW aligned)
+    uint32_t    end;            // DW aligned end of the read
+    uint32_t    lead;           // Disabled bytes in the first DW
+    uint32_t    remaining;
+    uint32_t    index;          // Position in the outstanding list
+    uint64_t    cookie;
+};
+
+struct expired_rec {
+    uint64_t    key;
+    uint64_t    cookie;
+};
+
+struct expired_log {
+    struct expired_rec  *rec;
+    uint32_t            n;
+};
+
+static void log_expired(void *arg, uint16_t requester, uint16_t tag, uint64_t cookie)
+{
+    struct expired_log *log = arg;
+
+    log->rec[log->n].key = (uint32_t)requester << 16 | tag;
+    log->rec[log->n++].cookie = cookie;
+}
+
+static int cmp_rec(const void *a, const void *b)
+{
+    const struct expired_rec *x = a, *y = b;
+
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+// Next in-order completion of a request, into row 0 of the batch
+static void next_cpl(const struct sreq *r, struct tlp_batch *batch, uint32_t *n)
+{
+    *n = TLP_CMPL_CHUNK - (r->cur & (TLP_CMPL_CHUNK - 1));
+    if (*n > r->end - r->cur)
+        *n = r->end - r->cur;
+    batch->count = 1;
+    batch->kind[0] = TLP_KIND_CPLD;
+    batch->cpl_status[0] = TLP_CPL_SC;
+    batch->requester[0] = r->requester;
+    batch->tag[0] = r->tag;
+    batch->len_dw[0] = *n / 4;
+    batch->byte_count[0] = r->remaining;
+    batch->addr[0] = (r->cur + r->lead) & 0x7f;
+}
+
+static int suite(uint64_t timeout_ns, uint64_t tick_ns, uint32_t steps, uint64_t seed)
+{
+    struct tlp_np_tracker *t = tlp_np_tracker_create(timeout_ns, tick_ns);
+    struct naive *n = naive_create(timeout_ns, tick_ns);
+    uint32_t nreq = 40 * 256, nout = 0, mismatches = 0;
+    struct sreq *reqs = calloc(nreq, sizeof(*reqs));
+    struct sreq **out = calloc(nreq, sizeof(*out));
+    struct expired_log tl = { calloc(nreq, sizeof(struct expired_rec)), 0 };
+    struct expired_log nl = { calloc(nreq, sizeof(struct expired_rec)), 0 };
+    static struct tlp_batch batch;
+    uint16_t requesters[40];
+    uint64_t now = 1000000000ull + rnd(&seed);
+    int ret = -1;
+
+    if (!t || !n || !reqs || !out || !tl.rec || !nl.rec)
+        goto out;
+    for (uint32_t k = 0; k < 40; k++)
+        requesters[k] = (uint16_t)(k * 409 + seed % 409);      // Distinct, bit 15 clear
+
+    for (uint32_t s = 0; s < steps; s++) {
+        uint32_t op = rnd(&seed) % 100;
+
+        if (op < 40) {
+            // Insert, tags from a small range so duplicates are common
+            uint32_t ri = rnd(&seed) % 40, tag = rnd(&seed) % 64 | (rnd(&seed) & 3) << 8;   // T9/T8 too
+            struct sreq *r = &reqs[ri * 256 + ((tag >> 8) << 6 | (tag & 63))], tmp;
+            uint32_t len_dw, trail, addr;
+            int te, ne;
+
+            tmp.requester = requesters[ri];
+            tmp.tag = (uint16_t)tag;
+            tmp.cookie = ((uint64_t)s << 20) | rnd(&seed) % 1000;
+            if (rnd(&seed) % 4) {
+                len_dw = 1 + rnd(&seed) % 64;
+                addr = (rnd(&seed) & 0xfff) * 4;
+                tmp.lead = rnd(&seed) % 4;
+                trail = rnd(&seed) % 4;
+                if (len_dw == 1 && tmp.lead + trail > 3)
+                    trail = 3 - tmp.lead;
+                tmp.cur = addr;
+                tmp.end = addr + len_dw * 4;
+                tmp.remaining = len_dw * 4 - tmp.lead - trail;
+            } else {
+                tmp.cur = 0;            // Cfg/IO: one DW at lower address 0
+                tmp.end = 4;
+                tmp.lead = 0;
+                tmp.remaining = 4;
+            }
+            te = tlp_np_insert(t, tmp.requester, tmp.tag, tmp.remaining, tmp.cur + tmp.lead, tmp.cookie, now);
+            ne = naive_insert(n, tmp.requester, tmp.tag, tmp.remaining, tmp.cur + tmp.lead, tmp.cookie, now);
+            mismatches += te != ne;
+            if (ne == TLP_NP_OK) {
+                // Accepted, so the reference slot must be free
+                if (r->end) {
+                    mismatches++;
+                    continue;
+                }
+                *r = tmp;
+                r->index = nout;
+                out[nout++] = r;
+            }
+        } else if (op < 85 && nout) {
+            struct sreq *r = out[rnd(&seed) % nout];
+            uint32_t mut = rnd(&seed) % 100, bytes;
+            uint64_t tc = 0, nc = 0;
+            int te, ne;
+
+            next_cpl(r, &batch, &bytes);
+            if (mut < 4) {
+                batch.byte_count[0] += 4;           // Lost or reordered completion
+            } else if (mut < 8) {
+                batch.addr[0] ^= 0x20;
+            } else if (mut < 12) {
+                batch.kind[0] = TLP_KIND_CPL;       // UR ends the request
+                batch.cpl_status[0] = TLP_CPL_UR;
+                batch.len_dw[0] = 0;
+            } else if (mut < 16) {
+                batch.tag[0] ^= 0x40;               // Tag never used
+            } else if (mut < 18) {
+                batch.requester[0] ^= 0x8000;
+            }
+            te = tlp_np_complete(t, &batch, 0, &tc);
+            ne = naive_complete(n, &batch, 0, &nc);
+            mismatches += te != ne || (ne != TLP_NP_UNEXPECTED && tc != nc);
+            if (mut >= 12 && mut < 18)
+                continue;
+            if (ne == TLP_NP_OK) {
+                r->remaining -= bytes - r->lead;
+                r->cur += bytes;
+                r->lead = 0;
+            } else if (ne == TLP_NP_DONE) {
+                mismatches += mut >= 18 && r->cur + bytes != r->end;
+                out[r->index] = out[--nout];
+                out[r->index]->index = r->index;
+                r->end = 0;
+            }
+        } else {
+            // Time passes, now and then by more than a wheel turn
+            uint32_t te, ne;
+
+            now += rnd(&seed) % 64 ? rnd(&seed) % (tick_ns * 16) : rnd(&seed) % (tick_ns * TLP_NP_WHEEL_SLOTS * 2);
+            if (rnd(&seed) % 2)
+                continue;
+            tl.n = nl.n = 0;
+            te = tlp_np_expire(t, now, log_expired, &tl);
+            ne = naive_expire(n, now, log_expired, &nl);
+            qsort(tl.rec, tl.n, sizeof(*tl.rec), cmp_rec);
+            qsort(nl.rec, nl.n, sizeof(*nl.rec), cmp_rec);
+            if (te != ne || tl.n != nl.n || memcmp(tl.rec, nl.rec, nl.n * sizeof(*nl.rec))) {
+                mismatches++;
+                continue;
+            }
+            // Drop expired requests from the outstanding list
+            for (uint32_t k = 0; k < nout; ) {
+                struct sreq *r = out[k];
+                uint64_t key = (uint32_t)r->requester << 16 | r->tag;
+                struct expired_rec probe = { key, 0 };
+
+                if (bsearch(&probe, nl.rec, nl.n, sizeof(probe), cmp_rec)) {
+                    out[k] = out[--nout];
+                    out[k]->index = k;
+                    r->end = 0;
+                } else {
+                    k++;
+                }
+            }
+        }
+        if (tlp_np_outstanding(t) != n->outstanding || n->outstanding != nout)
+            mismatches++;
+    }
+    if (memcmp(tlp_np_stats(t), &n->stats, sizeof(n->stats)))
+        mismatches++;
+
+    if (mismatches) {
+        printf("✗ timeout %lu ns, tick %lu ns: %u mismatches\n", timeout_ns, tick_ns, mismatches);
+    } else {
+        const struct tlp_np_stats *st = tlp_np_stats(t);
+
+        printf("✓ timeout %lu ns, tick %lu ns: %u steps, %lu done, %lu expired, %lu duplicate, "
+               "%lu unexpected, %lu out of order\n", timeout_ns, tick_ns, steps, st->done, st->expired,
+               st->duplicate, st->unexpected, st->order);
+        ret = 0;
+    }
+
+out:
+    tlp_np_tracker_destroy(t);
+    if (n)
+        naive_destroy(n);
+    free(reqs);
+    free(out);
+    free(tl.rec);
+    free(nl.rec);
+    return ret;
+}
+
+/*
+ * Timing at 100K outstanding
+ */
+struct tracker_ops {
+    const char  *name;
+    int         (*insert)(void *t, uint16_t requester, uint16_t tag, uint32_t bytes, uint32_t lower_addr,
+                          uint64_t cookie, uint64_t now_ns);
+    int         (*complete)(void *t, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie);
+    uint32_t    (*expire)(void *t, uint64_t now_ns, tlp_np_expire_cb cb, void *arg);
+};
+
+static int np_insert(void *t, uint16_t requester, uint16_t tag, uint32_t bytes, uint32_t lower_addr,
+                     uint64_t cookie, uint64_t now_ns)
+{
+    return tlp_np_insert(t, requester, tag, bytes, lower_addr, cookie, now_ns);
+}
+
+static int np_complete(void *t, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie)
+{
+    return tlp_np_complete(t, batch, i, cookie);
+}
+
+static uint32_t np_expire(void *t, uint64_t now_ns, tlp_np_expire_cb cb, void *arg)
+{
+    return tlp_np_expire(t, now_ns, cb, arg);
+}
+
+static int nv_insert(void *t, uint16_t requester, uint16_t tag, uint32_t bytes, uint32_t lower_addr,
+                     uint64_t cookie, uint64_t now_ns)
+{
+    return naive_insert(t, requester, tag, bytes, lower_addr, cookie, now_ns);
+}
+
+static int nv_complete(void *t, const struct tlp_batch *batch, uint32_t i, uint64_t *cookie)
+{
+    return naive_complete(t, batch, i, cookie);
+}
+
+static uint32_t nv_expire(void *t, uint64_t now_ns, tlp_np_expire_cb cb, void *arg)
+{
+    return naive_expire(t, now_ns, cb, arg);
+}
+
+static const struct tracker_ops np_ops = { "tag table", np_insert, np_complete, np_expire };
+static const struct tracker_ops naive_ops = { "naive", nv_insert, nv_complete, nv_expire };
+
+#define BENCH_TIMEOUT_NS    10000000ull     // 10ms completion timeout
+#define BENCH_TICK_NS       16384ull
+
+static int bench(const struct tracker_ops *o, void *t, const uint32_t *keys, uint32_t ops)
+{
+    uint32_t nkeys = BENCH_REQUESTERS * BENCH_TAGS, errors = 0, pos = 0, idle_calls = 500;
+    uint64_t now = 1000000000ull, cookie = 0;
+    static struct tlp_batch batch;
+    double t0, fill, lookup = 0, insert = 0, idle, expire;
+
+    // Fill: every key once, in random order
+    t0 = now_sec();
+    for (uint32_t k = 0; k < nkeys; k++)
+        errors += o->insert(t, keys[k] >> 16, keys[k] & 0xffff, 4, 0, k, now) != TLP_NP_OK;
+    fill = now_sec() - t0;
+
+    // Steady state: complete a batch of requests, issue them again
+    batch.count = TLP_BATCH_MAX;
+    for (uint32_t i = 0; i < TLP_BATCH_MAX; i++) {
+        batch.kind[i] = TLP_KIND_CPLD;
+        batch.cpl_status[i] = TLP_CPL_SC;
+        batch.len_dw[i] = 1;
+        batch.byte_count[i] = 4;
+        batch.addr[i] = 0;
+    }
+    for (uint32_t done = 0; done < ops; done += TLP_BATCH_MAX) {
+        for (uint32_t i = 0; i < TLP_BATCH_MAX; i++) {
+            uint32_t key = keys[(pos + i * 397) % nkeys];
+
+            batch.requester[i] = key >> 16;
+            batch.tag[i] = key & 0xffff;
+        }
+        pos = (pos + 7919) % nkeys;
+
+        t0 = now_sec();
+        for (uint32_t i = 0; i < TLP_BATCH_MAX; i++)
+            errors += o->complete(t, &batch, i, &cookie) != TLP_NP_DONE;
+        clobber(&cookie);
+        lookup += now_sec() - t0;
+
+        t0 = now_sec();
+        for (uint32_t i = 0; i < TLP_BATCH_MAX; i++)
+            errors += o->insert(t, batch.requester[i], batch.tag[i], 4, 0, done + i, now) != TLP_NP_OK;
+        insert += now_sec() - t0;
+    }
+
+    // Periodic timeout checks with nothing due yet
+    t0 = now_sec();
+    for (uint32_t k = 0; k < idle_calls; k++) {
+        now += BENCH_TICK_NS;
+        errors += o->expire(t, now, NULL, NULL) != 0;
+    }
+    idle = now_sec() - t0;
+
+    // Everything times out
+    t0 = now_sec();
+    errors += o->expire(t, now + 2 * BENCH_TIMEOUT_NS, NULL, NULL) != nkeys;
+    expire = now_sec() - t0;
+
+    if (errors) {
+        printf("  %-10s %u errors\n", o->name, errors);
+        return -1;
+    }
+    printf("  %-10s %8.1f ns %8.1f ns %8.1f ns %9.2f us %9.1f ns\n", o->name, fill / nkeys * 1e9,
+           insert / ops * 1e9, lookup / ops * 1e9, idle / idle_calls * 1e6, expire / nkeys * 1e9);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t steps = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    uint32_t ops = argc > 2 ? strtoul(argv[2], NULL, 0) : 2000000;
+    uint32_t nkeys = BENCH_REQUESTERS * BENCH_TAGS;
+    uint32_t *keys = malloc(nkeys * sizeof(*keys));
+    struct tlp_np_tracker *t;
+    struct naive *n;
+    uint64_t seed = 0x5eed;
+    int ret = 0;
+
+    printf("TLP Outstanding Request Benchmark\n");
+    printf("=================================\n");
+    printf("Usage: %s [suite_steps] [ops]\n\n", argv[0]);
+
+    printf("Suite (tag table vs naive tracker):\n");
+    // Short timeout within one wheel turn, long timeout over several turns
+    if (suite(20000, 256, steps, 1) || suite(5000000, 256, steps, 2))
+        return 1;
+
+    if (!keys)
+        return 1;
+    // Requester IDs spread over buses, tags 0..999, shuffled
+    for (uint32_t r = 0; r < BENCH_REQUESTERS; r++)
+        for (uint32_t tag = 0; tag < BENCH_TAGS; tag++)
+            keys[r * BENCH_TAGS + tag] = (uint32_t)((r % 16) << 8 | (r / 16) << 3 | 0x1000) << 16 | tag;
+    for (uint32_t k = nkeys - 1; k; k--) {
+        uint32_t j = rnd(&seed) % (k + 1), tmp = keys[k];
+
+        keys[k] = keys[j];
+        keys[j] = tmp;
+    }
+
+    printf("\n%u outstanding (%u requesters x %u tags), timeout %llu ms, tick %llu ns, %u ops\n",
+           nkeys, BENCH_REQUESTERS, BENCH_TAGS, BENCH_TIMEOUT_NS / 1000000, BENCH_TICK_NS, ops);
+    printf("  %-10s %11s %11s %11s %12s %12s\n", "Tracker", "Fill", "Insert", "Lookup", "Idle expire",
+           "Expire/req");
+
+    t = tlp_np_tracker_create(BENCH_TIMEOUT_NS, BENCH_TICK_NS);
+    n = naive_create(BENCH_TIMEOUT_NS, BENCH_TICK_NS);
+    if (!t || !n || bench(&np_ops, t, keys, ops) || bench(&naive_ops, n, keys, ops))
+        ret = 1;
+    tlp_np_tracker_destroy(t);
+    if (n)
+        naive_destroy(n);
+    free(keys);
+    return ret;
+}
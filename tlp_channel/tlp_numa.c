@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - NUMA placement of queue memory and threads.
+ * Topology comes from sysfs and memory policy from the mbind(2) and
+ * get_mempolicy(2) syscalls, so there is no libnuma dependency.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "tlp_numa.h"
+
+// <linux/mempolicy.h> values, numaif.h comes with libnuma
+#define TLP_MPOL_PREFERRED      1
+#define TLP_MPOL_MF_MOVE        (1 << 1)
+#define TLP_MPOL_F_NODE         (1 << 0)
+#define TLP_MPOL_F_ADDR         (1 << 1)
+
+#define NODE_SYSFS              "/sys/devices/system/node"
+
+static int read_sysfs_file(const char *path, char *buf, size_t len)
+{
+    ssize_t n;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    n = read(fd, buf, len - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+int tlp_numa_device_node(struct ibv_device *dev)
+{
+    char path[IBV_SYSFS_PATH_MAX + 32], buf[16];
+    int node;
+
+    snprintf(path, sizeof(path), "%s/device/numa_node", dev->ibdev_path);
+    if (read_sysfs_file(path, buf, sizeof(buf)))
+        return -1;
+    node = atoi(buf);
+    return node >= 0 && node < TLP_NUMA_MAX_NODES ? node : -1;
+}
+
+int tlp_numa_parse_list(const char *s, int *out, int max)
+{
+    int n = 0;
+
+    while (*s) {
+        char *end;
+        long lo = strtol(s, &end, 10), hi = lo;
+
+        if (end == s || lo < 0)
+            return -1;
+        if (*end == '-') {
+            s = end + 1;
+            hi = strtol(s, &end, 10);
+            if (end == s || hi < lo)
+                return -1;
+        }
+        for (long v = lo; v <= hi && n < max; v++)
+            out[n++] = v;
+        if (*end == ',')
+            end++;
+        else if (*end)
+            return -1;
+        s = end;
+    }
+    return n;
+}
+
+int tlp_numa_nodes(int *nodes, int max)
+{
+    char buf[256];
+
+    if (read_sysfs_file(NODE_SYSFS "/online", buf, sizeof(buf)))
+        return -1;
+    return tlp_numa_parse_list(buf, nodes, max);
+}
+
+int tlp_numa_node_cpus(int node, int *cpus, int max)
+{
+    char path[64], buf[1024];
+    int all[TLP_NUMA_MAX_CPUS], n, k = 0;
+    cpu_set_t allowed;
+
+    if (node < 0)
+        return -1;
+    snprintf(path, sizeof(path), NODE_SYSFS "/node%d/cpulist", node);
+    if (read_sysfs_file(path, buf, sizeof(buf)))
+        return -1;
+    n = tlp_numa_parse_list(buf, all, TLP_NUMA_MAX_CPUS);
+    if (n < 0 || pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed))
+        return -1;
+    // A container or taskset may hand the process only part of the node
+    for (int i = 0; i < n && k < max; i++)
+        if (all[i] < CPU_SETSIZE && CPU_ISSET(all[i], &allowed))
+            cpus[k++] = all[i];
+    return k;
+}
+
+int tlp_numa_thread_cpus(int node, int *cpus, int max)
+{
+    int n = tlp_numa_node_cpus(node, cpus, max), k = 0;
+    cpu_set_t allowed;
+
+    if (n > 0)
+        return n;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed))
+        return -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE && k < max; cpu++)
+        if (CPU_ISSET(cpu, &allowed))
+            cpus[k++] = cpu;
+    return k ? k : -1;
+}
+
+int tlp_numa_pin_thread(int node)
+{
+    int cpus[TLP_NUMA_MAX_CPUS], n = tlp_numa_node_cpus(node, cpus, TLP_NUMA_MAX_CPUS);
+    cpu_set_t set;
+
+    if (n <= 0)
+        return -1;
+    CPU_ZERO(&set);
+    for (int i = 0; i < n; i++)
+        CPU_SET(cpus[i], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) ? -1 : 0;
+}
+
+int tlp_numa_bind(void *addr, size_t len, int node)
+{
+    unsigned long mask[TLP_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+
+    if (node < 0 || node >= TLP_NUMA_MAX_NODES) {
+        errno = EINVAL;
+        return -1;
+    }
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    // maxnode counts one past the last bit, as the kernel drops the top one
+    if (syscall(SYS_mbind, addr, len, TLP_MPOL_PREFERRED, mask, TLP_NUMA_MAX_NODES + 1, TLP_MPOL_MF_MOVE)) {
+        fprintf(stderr, "Failed to bind %zu bytes to NUMA node %d: %s\n", len, node, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int tlp_numa_addr_node(const void *addr)
+{
+    int node = -1;
+
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr, TLP_MPOL_F_NODE | TLP_MPOL_F_ADDR))
+        return -1;
+    return node;
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - NUMA placement of queue memory and threads
+ */
+
+#ifndef TLP_NUMA_H
+#define TLP_NUMA_H
+
+#include <stddef.h>
+#include <infiniband/verbs.h>
+
+#define TLP_NUMA_MAX_NODES      64
+#define TLP_NUMA_MAX_CPUS       1024
+
+/**
+ * NUMA node of the PCI function behind an RDMA device
+ *
+ * @return: node from <ibdev_path>/device/numa_node, -1 when sysfs has none
+ */
+int tlp_numa_device_node(struct ibv_device *dev);
+
+/**
+ * Parse a sysfs list such as "0-3,8,10-11"
+ *
+ * @return: number of entries written to out, -1 on a malformed list
+ */
+int tlp_numa_parse_list(const char *s, int *out, int max);
+
+/**
+ * @return: online nodes written to nodes, -1 without NUMA support in sysfs
+ */
+int tlp_numa_nodes(int *nodes, int max);
+
+/**
+ * CPUs of a node that the calling thread may run on
+ *
+ * @return: CPUs written to cpus, -1 on failure
+ */
+int tlp_numa_node_cpus(int node, int *cpus, int max);
+
+/**
+ * CPUs to run a device's threads on: the usable CPUs of its node, or every
+ * CPU the calling thread may use when the node is unknown (-1) or has none
+ *
+ * @return: CPUs written to cpus, -1 on failure
+ */
+int tlp_numa_thread_cpus(int node, int *cpus, int max);
+
+/**
+ * Restrict the calling thread to the CPUs of a node
+ *
+ * @return: 0 on success, -1 for node < 0 or a node without usable CPUs
+ */
+int tlp_numa_pin_thread(int node);
+
+/**
+ * Prefer node for the pages of [addr, addr + len) with mbind(2), moving
+ * pages already there. addr must be page aligned.
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_numa_bind(void *addr, size_t len, int node);
+
+/**
+ * @return: node of the page backing addr, -1 if not faulted in or unknown
+ */
+int tlp_numa_addr_node(const void *addr);
+
+#endif /* TLP_NUMA_H */
@@ -0,0 +1,246 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel NUMA benchmark - prints the node of every RDMA device and
+ * the CPUs of every node as the library sees them (tlp_numa.h), checks
+ * list parsing, mbind placement and thread pinning, then polls a set of
+ * channel-sized queues bound to one node from a poller pinned to another.
+ * Queue lines are flushed before each pass as after a device write, so
+ * every pass reads the queues from their node's memory. Cross-node rows
+ * need a multi-socket host.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "tlp_bench.h"
+#include "tlp_numa.h"
+#include "tlp_queue.h"
+
+// Mode0 queues: 1K x 64B QEs
+#define QUEUE_QES       1024
+#define QUEUE_BYTES     (QUEUE_QES * TLP_QE_SIZE)
+
+static void topology(void)
+{
+    int nodes[TLP_NUMA_MAX_NODES], nnodes = tlp_numa_nodes(nodes, TLP_NUMA_MAX_NODES), ndev = 0;
+    struct ibv_device **list = ibv_get_device_list(&ndev);
+
+    printf("Topology:\n");
+    if (nnodes < 0)
+        printf("  No NUMA information in sysfs\n");
+    for (int i = 0; i < nnodes; i++) {
+        int cpus[TLP_NUMA_MAX_CPUS], n = tlp_numa_node_cpus(nodes[i], cpus, TLP_NUMA_MAX_CPUS);
+
+        printf("  node %d: %d usable CPUs", nodes[i], n < 0 ? 0 : n);
+        if (n > 0)
+            printf(" (%d-%d)", cpus[0], cpus[n - 1]);
+        printf("\n");
+    }
+    for (int i = 0; list && i < ndev; i++)
+        printf("  %s: node %d\n", ibv_get_device_name(list[i]), tlp_numa_device_node(list[i]));
+    if (!list || !ndev)
+        printf("  No RDMA devices\n");
+    if (list)
+        ibv_free_device_list(list);
+}
+
+static int suite_parse(void)
+{
+    static const struct {
+        const char  *s;
+        int         n;
+        int         last;
+    } cases[] = {
+        { "0", 1, 0 }, { "0-3", 4, 3 }, { "0-3,8,10-11", 7, 11 }, { "", 0, -1 },
+        { "3-1", -1, -1 }, { "1,,2", -1, -1 }, { "x", -1, -1 },
+    };
+    uint32_t errors = 0;
+    int out[16];
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        int n = tlp_numa_parse_list(cases[c].s, out, 16);
+
+        errors += n != cases[c].n || (n > 0 && out[n - 1] != cases[c].last);
+    }
+    // Truncated at max
+    errors += tlp_numa_parse_list("0-99", out, 16) != 16 || out[15] != 15;
+    printf("%s sysfs list parsing\n", errors ? "✗" : "✓");
+    return errors ? -1 : 0;
+}
+
+/*
+ * Every online node: pages bound before first touch land there, and a
+ * pinned thread runs on the node's CPUs
+ */
+static int suite_place(void)
+{
+    int nodes[TLP_NUMA_MAX_NODES], nnodes = tlp_numa_nodes(nodes, TLP_NUMA_MAX_NODES), ret = 0;
+    size_t len = 16 * QUEUE_BYTES;
+
+    if (nnodes <= 0) {
+        printf("- no NUMA nodes in sysfs, placement not checked\n");
+        return 0;
+    }
+    for (int i = 0; i < nnodes; i++) {
+        uint8_t *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        int cpus[TLP_NUMA_MAX_CPUS], ncpus = tlp_numa_node_cpus(nodes[i], cpus, TLP_NUMA_MAX_CPUS);
+        uint32_t wrong = 0, on_node = 0;
+        int cpu;
+
+        if (p == MAP_FAILED)
+            return -1;
+        if (tlp_numa_bind(p, len, nodes[i])) {
+            // Containers may filter mbind; nothing else depends on it
+            printf("- node %d: mbind unavailable, placement not checked\n", nodes[i]);
+        } else {
+            memset(p, 0, len);
+            for (size_t off = 0; off < len; off += 4096)
+                wrong += tlp_numa_addr_node(p + off) != nodes[i];
+            printf("%s node %d: %zu queue pages bound before first touch\n", wrong ? "✗" : "✓", nodes[i],
+                   len / 4096);
+            if (wrong)
+                ret = -1;
+        }
+        munmap(p, len);
+
+        if (ncpus <= 0) {
+            printf("- node %d: no usable CPUs, pinning not checked\n", nodes[i]);
+            continue;
+        }
+        if (tlp_numa_pin_thread(nodes[i])) {
+            printf("✗ node %d: pinning failed\n", nodes[i]);
+            ret = -1;
+            continue;
+        }
+        sched_yield();
+        cpu = sched_getcpu();
+        for (int k = 0; k < ncpus; k++)
+            on_node |= cpus[k] == cpu;
+        printf("%s node %d: pinned thread runs on CPU %d\n", on_node ? "✓" : "✗", nodes[i], cpu);
+        if (!on_node)
+            ret = -1;
+    }
+    return ret;
+}
+
+// Reset affinity to every CPU the process started with
+static void unpin(const cpu_set_t *all)
+{
+    sched_setaffinity(0, sizeof(*all), all);
+}
+
+/*
+ * Poll nqueues queues bound to mem_node from a thread on cpu_node
+ *
+ * @return: GB/s of QEs decoded, negative when the node cannot be used
+ */
+static double poll_queues(int cpu_node, int mem_node, uint32_t nqueues, uint32_t passes)
+{
+    struct tlp_batch *batch = malloc(sizeof(*batch));
+    size_t len = (size_t)nqueues * QUEUE_BYTES;
+    uint8_t *mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    struct tlp_queue *q = calloc(nqueues, sizeof(*q));
+    uint32_t *idx = calloc(2 * nqueues, sizeof(*idx));
+    uint64_t sum = 0;
+    double t = 0, ret = -1;
+
+    if (!batch || mem == MAP_FAILED || !q || !idx)
+        goto out;
+    if (tlp_numa_bind(mem, len, mem_node) || tlp_numa_pin_thread(cpu_node))
+        goto out;
+
+    // Every queue full of MWr 32B, written once from the poller's side
+    for (uint32_t k = 0; k < nqueues * QUEUE_QES; k++) {
+        uint8_t *qe = mem + (size_t)k * TLP_QE_SIZE;
+
+        memset(qe, 0, TLP_QE_SIZE);
+        put_be32(qe, 0x60u << 24 | 8);
+        put_be32(qe + 4, 0x0100u << 16 | 0xff);
+        put_be32(qe + 12, (k & 0xffff) * 64);
+    }
+    for (uint32_t i = 0; i < nqueues; i++)
+        tlp_queue_init(&q[i], mem + (size_t)i * QUEUE_BYTES, QUEUE_QES, &idx[2 * i], &idx[2 * i + 1]);
+
+    for (uint32_t p = 0; p < passes; p++) {
+        double t0;
+
+        flush_lines(mem, len);
+        for (uint32_t i = 0; i < nqueues; i++)
+            __atomic_store_n(&idx[2 * i], idx[2 * i] + QUEUE_QES, __ATOMIC_RELEASE);
+        t0 = now_sec();
+        for (uint32_t i = 0; i < nqueues; i++) {
+            struct tlp_qe_run run;
+
+            while (tlp_queue_borrow(&q[i], TLP_BATCH_MAX, &run)) {
+                uint32_t n = tlp_queue_decode(&q[i], &run, batch);
+
+                for (uint32_t k = 0; k < n; k++)
+                    sum += batch->addr[k] + batch->len_dw[k];
+                tlp_queue_return(&q[i], &run);
+            }
+        }
+        t += now_sec() - t0;
+    }
+    clobber(&sum);
+    ret = (double)passes * len / t / 1e9;
+out:
+    if (mem != MAP_FAILED)
+        munmap(mem, len);
+    free(batch);
+    free(q);
+    free(idx);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t nqueues = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+    uint32_t passes = argc > 2 ? strtoul(argv[2], NULL, 0) : 200;
+    int nodes[TLP_NUMA_MAX_NODES], nnodes;
+    cpu_set_t all;
+
+    printf("TLP NUMA Placement Benchmark\n");
+    printf("============================\n");
+    printf("Usage: %s [queues] [passes]\n\n", argv[0]);
+
+    sched_getaffinity(0, sizeof(all), &all);
+    topology();
+
+    printf("\nSuite:\n");
+    if (suite_parse() || suite_place())
+        return 1;
+    unpin(&all);
+
+    nnodes = tlp_numa_nodes(nodes, TLP_NUMA_MAX_NODES);
+    if (nnodes <= 0) {
+        printf("\nNo NUMA nodes in sysfs, nothing to measure\n");
+        return 0;
+    }
+    printf("\nPolling %u queues of %u QEs (%u KB) from flushed lines, %u passes\n", nqueues, QUEUE_QES,
+           nqueues * QUEUE_BYTES / 1024, passes);
+    printf("  %-8s %-8s %12s %9s\n", "CPU node", "Mem node", "Decode", "vs local");
+    for (int c = 0; c < nnodes; c++) {
+        double local = poll_queues(nodes[c], nodes[c], nqueues, passes);
+
+        for (int m = 0; m < nnodes; m++) {
+            double gbs = m == c ? local : poll_queues(nodes[c], nodes[m], nqueues, passes);
+
+            if (gbs < 0) {
+                printf("  %-8d %-8d unavailable (no CPUs or mbind)\n", nodes[c], nodes[m]);
+                continue;
+            }
+            printf("  %-8d %-8d %7.2f GB/s %8.2fx\n", nodes[c], nodes[m], gbs, local > 0 ? gbs / local : 0);
+        }
+        unpin(&all);
+    }
+    if (nnodes == 1)
+        printf("  Single NUMA node: cross-node rows need a multi-socket host\n");
+    return 0;
+}
@@ -0,0 +1,434 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel ODP benchmark - pinned vs on-demand-paging queues.
+ * For each registration mode it reports registration time and pinned memory,
+ * channel create time, the latency of the first 64B QE the device writes into
+ * each fresh queue, and steady-state QE write throughput. QEs are written by
+ * the device itself through a loopback RC QP with RDMA WRITEs to the queue
+ * mkey, the same translation path TLPs landing in the queue take.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "tlp_bench.h"
+#include "tlp_channel.h"
+
+#define QE_SIZE                 64
+
+// Loopback QP geometry; one CQE per BENCH_SIGNAL_EVERY writes
+#define BENCH_SQ_DEPTH          512
+#define BENCH_SIGNAL_EVERY      32
+#define BENCH_STEADY_WRITES     (4u << 20)
+
+struct bench_mode {
+    const char  *name;
+    int         mem_mode;       // enum tlp_channel_mem_mode
+    int         prefetch;
+};
+
+static const struct bench_mode bench_modes[] = {
+    { "pinned",                 TLP_CHANNEL_MEM_PINNED,         0 },
+    { "ODP",                    TLP_CHANNEL_MEM_ODP,            0 },
+    { "ODP + prefetch",         TLP_CHANNEL_MEM_ODP,            1 },
+    { "implicit ODP",           TLP_CHANNEL_MEM_ODP_IMPLICIT,   0 },
+    { "implicit ODP + prefetch", TLP_CHANNEL_MEM_ODP_IMPLICIT,  1 },
+};
+
+struct bench_queue {
+    uint8_t     *buf;
+    uint32_t    rkey;
+};
+
+struct loopback {
+    struct ibv_cq   *cq;
+    struct ibv_qp   *qp;
+    uint8_t         *src;
+    struct ibv_mr   *src_mr;
+};
+
+// Pinned memory of the process (ib_umem accounts pinned pages here)
+static long vm_pin_kb(void)
+{
+    char line[128];
+    long kb = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmPin: %ld kB", &kb) == 1)
+            break;
+    }
+    fclose(f);
+    return kb;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Loopback RC QP: the device writes QEs into its own queues
+ */
+static int loopback_open(struct ibv_context *ctx, struct ibv_pd *pd, int gid_index, struct loopback *lb)
+{
+    struct ibv_qp_init_attr init_attr = {0};
+    struct ibv_qp_attr attr;
+    struct ibv_port_attr port;
+    union ibv_gid gid;
+
+    memset(lb, 0, sizeof(*lb));
+    if (ibv_query_port(ctx, 1, &port)) {
+        fprintf(stderr, "Failed to query port 1: %s\n", strerror(errno));
+        return -1;
+    }
+    if (port.link_layer == IBV_LINK_LAYER_ETHERNET && ibv_query_gid(ctx, 1, gid_index, &gid)) {
+        fprintf(stderr, "Failed to query GID %d: %s\n", gid_index, strerror(errno));
+        return -1;
+    }
+
+    lb->src = aligned_alloc(4096, 4096);
+    if (!lb->src)
+        return -1;
+    memset(lb->src, 0x5A, 4096);
+    lb->src_mr = ibv_reg_mr(pd, lb->src, 4096, IBV_ACCESS_LOCAL_WRITE);
+    if (!lb->src_mr) {
+        fprintf(stderr, "Failed to register source buffer: %s\n", strerror(errno));
+        goto err_free_src;
+    }
+
+    lb->cq = ibv_create_cq(ctx, BENCH_SQ_DEPTH, NULL, NULL, 0);
+    if (!lb->cq) {
+        fprintf(stderr, "Failed to create CQ: %s\n", strerror(errno));
+        goto err_dereg_src;
+    }
+
+    init_attr.send_cq = lb->cq;
+    init_attr.recv_cq = lb->cq;
+    init_attr.qp_type = IBV_QPT_RC;
+    init_attr.cap.max_send_wr = BENCH_SQ_DEPTH;
+    init_attr.cap.max_recv_wr = 1;
+    init_attr.cap.max_send_sge = 1;
+    init_attr.cap.max_recv_sge = 1;
+    lb->qp = ibv_create_qp(pd, &init_attr);
+    if (!lb->qp) {
+        fprintf(stderr, "Failed to create loopback QP: %s\n", strerror(errno));
+        goto err_destroy_cq;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_INIT;
+    attr.port_num = 1;
+    attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE;
+    if (ibv_modify_qp(lb->qp, &attr, IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT | IBV_QP_ACCESS_FLAGS))
+        goto err_modify;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTR;
+    attr.path_mtu = port.active_mtu;
+    attr.dest_qp_num = lb->qp->qp_num;     // Connected to itself
+    attr.max_dest_rd_atomic = 1;
+    attr.min_rnr_timer = 12;
+    attr.ah_attr.dlid = port.lid;
+    attr.ah_attr.port_num = 1;
+    if (port.link_layer == IBV_LINK_LAYER_ETHERNET) {
+        attr.ah_attr.is_global = 1;
+        attr.ah_attr.grh.dgid = gid;
+        attr.ah_attr.grh.sgid_index = gid_index;
+        attr.ah_attr.grh.hop_limit = 1;
+    }
+    if (ibv_modify_qp(lb->qp, &attr, IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU | IBV_QP_DEST_QPN |
+                      IBV_QP_RQ_PSN | IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER))
+        goto err_modify;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTS;
+    attr.timeout = 14;
+    attr.retry_cnt = 7;
+    attr.rnr_retry = 7;
+    attr.max_rd_atomic = 1;
+    if (ibv_modify_qp(lb->qp, &attr, IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                      IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN | IBV_QP_MAX_QP_RD_ATOMIC))
+        goto err_modify;
+
+    return 0;
+
+err_modify:
+    fprintf(stderr, "Failed to connect loopback QP: %s\n", strerror(errno));
+    ibv_destroy_qp(lb->qp);
+err_destroy_cq:
+    ibv_destroy_cq(lb->cq);
+err_dereg_src:
+    ibv_dereg_mr(lb->src_mr);
+err_free_src:
+    free(lb->src);
+    return -1;
+}
+
+static void loopback_close(struct loopback *lb)
+{
+    ibv_destroy_qp(lb->qp);
+    ibv_destroy_cq(lb->cq);
+    ibv_dereg_mr(lb->src_mr);
+    free(lb->src);
+}
+
+static int post_qe(struct loopback *lb, const struct bench_queue *q, size_t offset, int signaled)
+{
+    struct ibv_sge sge = {
+        .addr = (uintptr_t)lb->src,
+        .length = QE_SIZE,
+        .lkey = lb->src_mr->lkey,
+    };
+    struct ibv_send_wr wr = {
+        .sg_list = &sge,
+        .num_sge = 1,
+        .opcode = IBV_WR_RDMA_WRITE,
+        .send_flags = signaled ? IBV_SEND_SIGNALED : 0,
+        .wr.rdma = { .remote_addr = (uintptr_t)q->buf + offset, .rkey = q->rkey },
+    }, *bad;
+
+    return ibv_post_send(lb->qp, &wr, &bad);
+}
+
+// @return: number of CQEs reaped, -1 on a failed write
+static int poll_qes(struct loopback *lb, int min)
+{
+    struct ibv_wc wc[16];
+    int done = 0;
+
+    while (done < min) {
+        int n = ibv_poll_cq(lb->cq, 16, wc);
+
+        if (n < 0)
+            return -1;
+        for (int i = 0; i < n; i++) {
+            if (wc[i].status != IBV_WC_SUCCESS) {
+                fprintf(stderr, "QE write failed: %s\n", ibv_wc_status_str(wc[i].status));
+                return -1;
+            }
+        }
+        done += n;
+    }
+    return done;
+}
+
+/*
+ * Queues without TLP_EMU_CHANNEL objects, for firmware that lacks them:
+ * one region registered the way the channel library would register its slab
+ */
+static struct ibv_mr *raw_register(struct ibv_pd *pd, const struct bench_mode *m, void *buf, size_t len)
+{
+    int access = IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE;
+
+    if (m->mem_mode == TLP_CHANNEL_MEM_ODP_IMPLICIT)
+        return ibv_reg_mr(pd, NULL, SIZE_MAX, access | IBV_ACCESS_ON_DEMAND);
+    if (m->mem_mode == TLP_CHANNEL_MEM_ODP)
+        return ibv_reg_mr(pd, buf, len, access | IBV_ACCESS_ON_DEMAND);
+    return ibv_reg_mr(pd, buf, len, access);
+}
+
+static double first_qe_latency(struct loopback *lb, const struct bench_queue *queues, uint32_t nqueues,
+                               double *lat)
+{
+    for (uint32_t i = 0; i < nqueues; i++) {
+        double start = now_sec();
+
+        if (post_qe(lb, &queues[i], 0, 1) || poll_qes(lb, 1) < 0)
+            return -1;
+        lat[i] = (now_sec() - start) * 1e6;
+    }
+    qsort(lat, nqueues, sizeof(*lat), cmp_double);
+    return 0;
+}
+
+// Round-robin QEs over every queue, advancing through each ring
+static double steady_qes(struct loopback *lb, const struct bench_queue *queues, uint32_t nqueues,
+                         uint32_t qes_per_queue, uint32_t writes)
+{
+    uint32_t posted = 0, completed = 0;
+    double start = now_sec();
+
+    while (completed < writes) {
+        while (posted < writes && posted - completed < BENCH_SQ_DEPTH - BENCH_SIGNAL_EVERY) {
+            const struct bench_queue *q = &queues[posted % nqueues];
+            size_t offset = (size_t)(posted / nqueues % qes_per_queue) * QE_SIZE;
+
+            if (post_qe(lb, q, offset, (posted + 1) % BENCH_SIGNAL_EVERY == 0))
+                return -1;
+            posted++;
+        }
+        int n = poll_qes(lb, 1);
+        if (n < 0)
+            return -1;
+        completed += n * BENCH_SIGNAL_EVERY;
+    }
+    return now_sec() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dev_name = argc > 1 ? argv[1] : "mlx5_0";
+    uint32_t nqueues = argc > 2 ? strtoul(argv[2], NULL, 0) : 256;
+    uint32_t q_size = argc > 3 ? strtoul(argv[3], NULL, 0) : TLP_CHANNEL_MAX_QUEUE_SIZE;
+    int gid_index = argc > 4 ? atoi(argv[4]) : 0;
+    uint32_t writes = BENCH_STEADY_WRITES;
+    struct mlx5_tlp_channel_obj **objs = NULL;
+    struct bench_queue *queues = NULL;
+    struct ibv_device **list = NULL;
+    struct ibv_context *ctx = NULL;
+    struct ibv_pd *pd = NULL;
+    struct loopback lb;
+    double *lat = NULL;
+    int use_channels = 1, ret = 1;
+
+    printf("TLP Channel ODP Benchmark\n");
+    printf("=========================\n");
+    printf("Usage: %s [device] [queues] [queue_size] [gid_index]\n\n", argv[0]);
+
+    q_size = (q_size + QE_SIZE - 1) & ~(QE_SIZE - 1);
+    if (!nqueues || !q_size) {
+        fprintf(stderr, "Need at least one queue of one QE\n");
+        return 1;
+    }
+
+    list = ibv_get_device_list(NULL);
+    for (int i = 0; list && list[i]; i++) {
+        if (strcmp(ibv_get_device_name(list[i]), dev_name) == 0) {
+            ctx = ibv_open_device(list[i]);
+            break;
+        }
+    }
+    if (!ctx) {
+        fprintf(stderr, "Failed to open device %s\n", dev_name);
+        goto cleanup;
+    }
+    pd = ibv_alloc_pd(ctx);
+    if (!pd) {
+        fprintf(stderr, "Failed to allocate protection domain: %s\n", strerror(errno));
+        goto cleanup;
+    }
+    if (loopback_open(ctx, pd, gid_index, &lb))
+        goto cleanup;
+
+    objs = calloc(nqueues, sizeof(*objs));
+    queues = calloc(nqueues, sizeof(*queues));
+    lat = calloc(nqueues, sizeof(*lat));
+    if (!objs || !queues || !lat)
+        goto cleanup_loopback;
+
+    mlx5_tlp_channel_set_quiet(1);
+    printf("Device: %s, %u queues of %u bytes, %u steady-state QEs of %d bytes\n\n",
+           dev_name, nqueues, q_size, writes, QE_SIZE);
+    printf("%-24s %9s %9s %9s %11s %24s %10s\n", "", "reg", "prefetch", "VmPin",
+           "create", "first QE us", "steady");
+    printf("%-24s %9s %9s %9s %11s %24s %10s\n", "mode", "ms", "ms", "MB",
+           "us/channel", "avg / p99 / max", "MQE/s");
+
+    for (size_t m = 0; m < sizeof(bench_modes) / sizeof(bench_modes[0]); m++) {
+        const struct bench_mode *mode = &bench_modes[m];
+        size_t region_len = (size_t)nqueues * q_size;
+        double reg_ms, prefetch_ms = 0, create_us = 0, steady;
+        struct ibv_mr *region_mr;
+        long pin_kb = vm_pin_kb();
+        uint8_t *region;
+        double t;
+
+        // Registration of every queue's memory as one region
+        region = mmap(NULL, region_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            fprintf(stderr, "Failed to map %zu bytes: %s\n", region_len, strerror(errno));
+            goto cleanup_loopback;
+        }
+        memset(region, 0xAB, region_len);
+        t = now_sec();
+        region_mr = raw_register(pd, mode, region, region_len);
+        reg_ms = (now_sec() - t) * 1e3;
+        if (!region_mr) {
+            printf("%-24s ✗ not supported: %s\n", mode->name, strerror(errno));
+            munmap(region, region_len);
+            continue;
+        }
+        if (mode->prefetch) {
+            struct ibv_sge sge = {
+                .addr = (uintptr_t)region, .length = region_len, .lkey = region_mr->lkey,
+            };
+
+            t = now_sec();
+            if (ibv_advise_mr(pd, IBV_ADVISE_MR_ADVICE_PREFETCH_WRITE, IBV_ADVISE_MR_FLAG_FLUSH, &sge, 1))
+                fprintf(stderr, "Region prefetch failed\n");
+            prefetch_ms = (now_sec() - t) * 1e3;
+        }
+        pin_kb = vm_pin_kb() - pin_kb;
+
+        // Channels, their queues are registered by the library in the same mode
+        if (use_channels) {
+            mlx5_tlp_channel_set_mem_mode(mode->mem_mode, mode->prefetch);
+            t = now_sec();
+            for (uint32_t i = 0; i < nqueues; i++) {
+                objs[i] = mlx5_tlp_channel_create(ctx, pd, 0, q_size, i & 0xffff);
+                if (!objs[i]) {
+                    printf("✗ channel create failed, timing registered queues without channel objects\n");
+                    mlx5_tlp_channel_release_pd(pd);
+                    memset(objs, 0, nqueues * sizeof(*objs));
+                    use_channels = 0;
+                    break;
+                }
+                queues[i] = (struct bench_queue) { objs[i]->queue_buffer, objs[i]->mr->rkey };
+            }
+            create_us = (now_sec() - t) * 1e6 / nqueues;
+        }
+        if (!use_channels) {
+            for (uint32_t i = 0; i < nqueues; i++)
+                queues[i] = (struct bench_queue) { region + (size_t)i * q_size, region_mr->rkey };
+        }
+
+        if (first_qe_latency(&lb, queues, nqueues, lat) ||
+            (steady = steady_qes(&lb, queues, nqueues, q_size / QE_SIZE, writes)) < 0) {
+            printf("%-24s ✗ QE writes failed\n", mode->name);
+        } else {
+            double sum = 0;
+
+            for (uint32_t i = 0; i < nqueues; i++)
+                sum += lat[i];
+            printf("%-24s %9.2f %9.2f %9.1f %11.1f %8.2f / %6.2f / %6.1f %10.2f\n",
+                   mode->name, reg_ms, prefetch_ms, pin_kb / 1024.0, create_us,
+                   sum / nqueues, lat[(size_t)(nqueues - 1) * 99 / 100], lat[nqueues - 1],
+                   writes / steady / 1e6);
+        }
+
+        if (use_channels)
+            mlx5_tlp_channel_release_pd(pd);
+        ibv_dereg_mr(region_mr);
+        munmap(region, region_len);
+    }
+
+    printf("\nreg/prefetch/VmPin: one %u x %u byte region; create includes the library's own\n"
+           "registration and prefetch. First QE is the device's first write into each queue.\n",
+           nqueues, q_size);
+    ret = 0;
+
+cleanup_loopback:
+    loopback_close(&lb);
+cleanup:
+    free(objs);
+    free(queues);
+    free(lat);
+    if (pd)
+        ibv_dealloc_pd(pd);
+    if (ctx)
+        ibv_close_device(ctx);
+    if (list)
+        ibv_free_device_list(list);
+    return ret;
+}
@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - whole-dword pack/unpack of command layouts.
+ * Generated by gen_tlp_pack.py from mlx5_ifc.h, do not edit.
+ */
+
+#ifndef TLP_PACK_H
+#define TLP_PACK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_adb.h"
+
+// memcpy compiles to a single store/load, buffers need no particular alignment
+static inline void tlp_pack_put32(void *buf, unsigned int dw, uint32_t val)
+{
+    val = htobe32(val);
+    memcpy((uint8_t *)buf + dw * 4, &val, sizeof(val));
+}
+
+static inline void tlp_pack_put64(void *buf, unsigned int qw, uint64_t val)
+{
+    val = htobe64(val);
+    memcpy((uint8_t *)buf + qw * 8, &val, sizeof(val));
+}
+
+static inline uint32_t tlp_pack_get32(const void *buf, unsigned int dw)
+{
+    uint32_t val;
+
+    memcpy(&val, (const uint8_t *)buf + dw * 4, sizeof(val));
+    return be32toh(val);
+}
+
+static inline uint64_t tlp_pack_get64(const void *buf, unsigned int qw)
+{
+    uint64_t val;
+
+    memcpy(&val, (const uint8_t *)buf + qw * 8, sizeof(val));
+    return be64toh(val);
+}
+
+/* mlx5_ifc_general_obj_in_cmd_hdr_bits, 16 bytes */
+#define TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_general_obj_in_cmd_hdr_bits) == 0x80, "mlx5_ifc_general_obj_in_cmd_hdr_bits resized");
+_Static_assert(__devx_bit_off(general_obj_in_cmd_hdr, opcode) == 0x0 && __devx_bit_sz(general_obj_in_cmd_hdr, opcode) == 0x10,
+               "mlx5_ifc_general_obj_in_cmd_hdr_bits.opcode moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_in_cmd_hdr, uid) == 0x10 && __devx_bit_sz(general_obj_in_cmd_hdr, uid) == 0x10,
+               "mlx5_ifc_general_obj_in_cmd_hdr_bits.uid moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_in_cmd_hdr, obj_type) == 0x30 && __devx_bit_sz(general_obj_in_cmd_hdr, obj_type) == 0x10,
+               "mlx5_ifc_general_obj_in_cmd_hdr_bits.obj_type moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_in_cmd_hdr, obj_id) == 0x40 && __devx_bit_sz(general_obj_in_cmd_hdr, obj_id) == 0x20,
+               "mlx5_ifc_general_obj_in_cmd_hdr_bits.obj_id moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_in_cmd_hdr, alias_object) == 0x60 && __devx_bit_sz(general_obj_in_cmd_hdr, alias_object) == 0x1,
+               "mlx5_ifc_general_obj_in_cmd_hdr_bits.alias_object moved, regenerate tlp_pack.h");
+
+struct tlp_pack_general_obj_in_cmd_hdr {
+    uint16_t  opcode;
+    uint16_t  uid;
+    uint16_t  obj_type;
+    uint32_t  obj_id;
+    uint8_t   alias_object;
+};
+
+static inline void tlp_pack_general_obj_in_cmd_hdr(void *buf, const struct tlp_pack_general_obj_in_cmd_hdr *v)
+{
+    tlp_pack_put64(buf, 0, ((uint64_t)v->opcode << 48) |
+                           ((uint64_t)v->uid << 32) |
+                           (uint64_t)v->obj_type);
+    tlp_pack_put64(buf, 1, ((uint64_t)v->obj_id << 32) |
+                           ((uint64_t)(v->alias_object & 0x1) << 31));
+}
+
+static inline void tlp_unpack_general_obj_in_cmd_hdr(const void *buf, struct tlp_pack_general_obj_in_cmd_hdr *v)
+{
+    v->opcode = (tlp_pack_get32(buf, 0) >> 16) & 0xffff;
+    v->uid = tlp_pack_get32(buf, 0) & 0xffff;
+    v->obj_type = tlp_pack_get32(buf, 1) & 0xffff;
+    v->obj_id = tlp_pack_get32(buf, 2);
+    v->alias_object = (tlp_pack_get32(buf, 3) >> 31) & 0x1;
+}
+
+/* mlx5_ifc_general_obj_out_cmd_hdr_bits, 16 bytes */
+#define TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_general_obj_out_cmd_hdr_bits) == 0x80, "mlx5_ifc_general_obj_out_cmd_hdr_bits resized");
+_Static_assert(__devx_bit_off(general_obj_out_cmd_hdr, status) == 0x0 && __devx_bit_sz(general_obj_out_cmd_hdr, status) == 0x8,
+               "mlx5_ifc_general_obj_out_cmd_hdr_bits.status moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_out_cmd_hdr, syndrome) == 0x20 && __devx_bit_sz(general_obj_out_cmd_hdr, syndrome) == 0x20,
+               "mlx5_ifc_general_obj_out_cmd_hdr_bits.syndrome moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(general_obj_out_cmd_hdr, obj_id) == 0x40 && __devx_bit_sz(general_obj_out_cmd_hdr, obj_id) == 0x20,
+               "mlx5_ifc_general_obj_out_cmd_hdr_bits.obj_id moved, regenerate tlp_pack.h");
+
+struct tlp_pack_general_obj_out_cmd_hdr {
+    uint8_t   status;
+    uint32_t  syndrome;
+    uint32_t  obj_id;
+};
+
+static inline void tlp_pack_general_obj_out_cmd_hdr(void *buf, const struct tlp_pack_general_obj_out_cmd_hdr *v)
+{
+    tlp_pack_put64(buf, 0, ((uint64_t)v->status << 56) |
+                           (uint64_t)v->syndrome);
+    tlp_pack_put64(buf, 1, ((uint64_t)v->obj_id << 32));
+}
+
+static inline void tlp_unpack_general_obj_out_cmd_hdr(const void *buf, struct tlp_pack_general_obj_out_cmd_hdr *v)
+{
+    v->status = (tlp_pack_get32(buf, 0) >> 24) & 0xff;
+    v->syndrome = tlp_pack_get32(buf, 1);
+    v->obj_id = tlp_pack_get32(buf, 2);
+}
+
+/* mlx5_ifc_tlp_emu_channel_bits, 32 bytes */
+#define TLP_PACK_TLP_EMU_CHANNEL_SZ 32
+_Static_assert(sizeof(struct mlx5_ifc_tlp_emu_channel_bits) == 0x100, "mlx5_ifc_tlp_emu_channel_bits resized");
+_Static_assert(__devx_bit_off(tlp_emu_channel, q_protocol_mode) == 0x18 && __devx_bit_sz(tlp_emu_channel, q_protocol_mode) == 0x8,
+               "mlx5_ifc_tlp_emu_channel_bits.q_protocol_mode moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(tlp_emu_channel, q_mkey) == 0x20 && __devx_bit_sz(tlp_emu_channel, q_mkey) == 0x20,
+               "mlx5_ifc_tlp_emu_channel_bits.q_mkey moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(tlp_emu_channel, q_size) == 0x40 && __devx_bit_sz(tlp_emu_channel, q_size) == 0x20,
+               "mlx5_ifc_tlp_emu_channel_bits.q_size moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(tlp_emu_channel, q_addr) == 0x80 && __devx_bit_sz(tlp_emu_channel, q_addr) == 0x40,
+               "mlx5_ifc_tlp_emu_channel_bits.q_addr moved, regenerate tlp_pack.h");
+_Static_assert(__devx_bit_off(tlp_emu_channel, tlp_channel_stride_index) == 0xd0 && __devx_bit_sz(tlp_emu_channel, tlp_channel_stride_index) == 0x10,
+               "mlx5_ifc_tlp_emu_channel_bits.tlp_channel_stride_index moved, regenerate tlp_pack.h");
+
+struct tlp_pack_tlp_emu_channel {
+    uint8_t   q_protocol_mode;
+    uint32_t  q_mkey;
+    uint32_t  q_size;
+    uint64_t  q_addr;
+    uint16_t  tlp_channel_stride_index;
+};
+
+static inline void tlp_pack_tlp_emu_channel(void *buf, const struct tlp_pack_tlp_emu_channel *v)
+{
+    tlp_pack_put64(buf, 0, ((uint64_t)v->q_protocol_mode << 32) |
+                           (uint64_t)v->q_mkey);
+    tlp_pack_put64(buf, 1, ((uint64_t)v->q_size << 32));
+    tlp_pack_put64(buf, 2, (uint64_t)v->q_addr);
+    tlp_pack_put64(buf, 3, ((uint64_t)v->tlp_channel_stride_index << 32));
+}
+
+static inline void tlp_unpack_tlp_emu_channel(const void *buf, struct tlp_pack_tlp_emu_channel *v)
+{
+    v->q_protocol_mode = tlp_pack_get32(buf, 0) & 0xff;
+    v->q_mkey = tlp_pack_get32(buf, 1);
+    v->q_size = tlp_pack_get32(buf, 2);
+    v->q_addr = tlp_pack_get64(buf, 2);
+    v->tlp_channel_stride_index = tlp_pack_get32(buf, 6) & 0xffff;
+}
+
+#endif /* TLP_PACK_H */
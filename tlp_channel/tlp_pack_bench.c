@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel pack benchmark - builds the TLP_EMU_CHANNEL create input and
+ * parses the query output with the DEVX_SET/DEVX_GET macros and with the
+ * generated tlp_pack.h functions.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "mlx5_ifc.h"
+#include "tlp_channel.h"
+#include "tlp_pack.h"
+
+#define CREATE_IN_SZ    (TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ + TLP_PACK_TLP_EMU_CHANNEL_SZ)
+#define QUERY_OUT_SZ    (TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ + TLP_PACK_TLP_EMU_CHANNEL_SZ)
+
+// Commands in flight; buffers are reused round-robin like a command queue
+#define BENCH_BUFS      256
+
+static void channel_params(uint32_t i, struct tlp_pack_tlp_emu_channel *ch)
+{
+    ch->q_protocol_mode = i & 0xff;
+    ch->q_mkey = i * 0x9e3779b9u;
+    ch->q_size = 64 << (i % 11);
+    ch->q_addr = 0x7f0000000000ull + (uint64_t)i * 4096;
+    ch->tlp_channel_stride_index = i & 0xffff;
+}
+
+// The create input as built before tlp_pack.h: zero, then read-modify-write per field
+static inline void create_in_devx(uint8_t *in, const struct tlp_pack_tlp_emu_channel *ch)
+{
+    uint8_t *tlp_channel_in = in + DEVX_ST_SZ_BYTES(general_obj_in_cmd_hdr);
+
+    memset(in, 0, CREATE_IN_SZ);
+    DEVX_SET(general_obj_in_cmd_hdr, in, opcode, MLX5_CMD_OP_CREATE_GENERAL_OBJECT);
+    DEVX_SET(general_obj_in_cmd_hdr, in, obj_type, MLX5_OBJ_TYPE_TLP_EMU_CHANNEL);
+    DEVX_SET(tlp_emu_channel, tlp_channel_in, q_protocol_mode, ch->q_protocol_mode);
+    DEVX_SET(tlp_emu_channel, tlp_channel_in, q_mkey, ch->q_mkey);
+    DEVX_SET(tlp_emu_channel, tlp_channel_in, q_size, ch->q_size);
+    DEVX_SET64(tlp_emu_channel, tlp_channel_in, q_addr, ch->q_addr);
+    DEVX_SET(tlp_emu_channel, tlp_channel_in, tlp_channel_stride_index, ch->tlp_channel_stride_index);
+}
+
+static inline void create_in_pack(uint8_t *in, const struct tlp_pack_tlp_emu_channel *ch)
+{
+    tlp_pack_general_obj_in_cmd_hdr(in, &(struct tlp_pack_general_obj_in_cmd_hdr) {
+        .opcode = MLX5_CMD_OP_CREATE_GENERAL_OBJECT,
+        .obj_type = MLX5_OBJ_TYPE_TLP_EMU_CHANNEL,
+    });
+    tlp_pack_tlp_emu_channel(in + TLP_PACK_GENERAL_OBJ_IN_CMD_HDR_SZ, ch);
+}
+
+static inline void query_out_devx(const uint8_t *out, uint32_t *syndrome, struct tlp_pack_tlp_emu_channel *ch)
+{
+    const uint8_t *tlp_channel_out = out + DEVX_ST_SZ_BYTES(general_obj_out_cmd_hdr);
+
+    *syndrome = DEVX_GET(general_obj_out_cmd_hdr, out, syndrome);
+    ch->q_protocol_mode = DEVX_GET(tlp_emu_channel, tlp_channel_out, q_protocol_mode);
+    ch->q_mkey = DEVX_GET(tlp_emu_channel, tlp_channel_out, q_mkey);
+    ch->q_size = DEVX_GET(tlp_emu_channel, tlp_channel_out, q_size);
+    ch->q_addr = DEVX_GET64(tlp_emu_channel, tlp_channel_out, q_addr);
+    ch->tlp_channel_stride_index = DEVX_GET(tlp_emu_channel, tlp_channel_out, tlp_channel_stride_index);
+}
+
+static inline void query_out_pack(const uint8_t *out, uint32_t *syndrome, struct tlp_pack_tlp_emu_channel *ch)
+{
+    struct tlp_pack_general_obj_out_cmd_hdr hdr;
+
+    tlp_unpack_general_obj_out_cmd_hdr(out, &hdr);
+    *syndrome = hdr.syndrome;
+    tlp_unpack_tlp_emu_channel(out + TLP_PACK_GENERAL_OBJ_OUT_CMD_HDR_SZ, ch);
+}
+
+/**
+ * Both paths must agree before their speed means anything
+ * @return: number of mismatching iterations
+ */
+static uint32_t verify(uint32_t iterations)
+{
+    uint8_t a[CREATE_IN_SZ], b[CREATE_IN_SZ], out[QUERY_OUT_SZ];
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        struct tlp_pack_tlp_emu_channel ch, ca, cb;
+        uint32_t sa, sb;
+
+        channel_params(i, &ch);
+        memset(b, 0xff, sizeof(b));     // Pack must not rely on a zeroed buffer
+        create_in_devx(a, &ch);
+        create_in_pack(b, &ch);
+        mismatches += memcmp(a, b, sizeof(a)) != 0;
+
+        for (size_t k = 0; k < sizeof(out); k++)
+            out[k] = (uint8_t)(i * 131 + k * 7);
+        query_out_devx(out, &sa, &ca);
+        query_out_pack(out, &sb, &cb);
+        mismatches += sa != sb || ca.q_protocol_mode != cb.q_protocol_mode ||
+                      ca.q_mkey != cb.q_mkey || ca.q_size != cb.q_size ||
+                      ca.q_addr != cb.q_addr ||
+                      ca.tlp_channel_stride_index != cb.tlp_channel_stride_index;
+    }
+    return mismatches;
+}
+
+// Inlined into main so each path is compiled in place instead of called indirectly
+static inline __attribute__((always_inline))
+double bench_create(void (*build)(uint8_t *, const struct tlp_pack_tlp_emu_channel *),
+                    uint32_t iterations)
+{
+    static uint8_t in[BENCH_BUFS][CREATE_IN_SZ];
+    double start = now_sec();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        struct tlp_pack_tlp_emu_channel ch;
+
+        channel_params(i, &ch);
+        build(in[i % BENCH_BUFS], &ch);
+        clobber(in[i % BENCH_BUFS]);
+    }
+    return now_sec() - start;
+}
+
+static inline __attribute__((always_inline))
+double bench_query(void (*parse)(const uint8_t *, uint32_t *, struct tlp_pack_tlp_emu_channel *),
+                   uint32_t iterations)
+{
+    static uint8_t out[BENCH_BUFS][QUERY_OUT_SZ];
+    uint64_t sum = 0;
+    double start;
+
+    for (uint32_t b = 0; b < BENCH_BUFS; b++)
+        for (size_t k = 0; k < QUERY_OUT_SZ; k++)
+            out[b][k] = (uint8_t)(b * 31 + k);
+
+    start = now_sec();
+    for (uint32_t i = 0; i < iterations; i++) {
+        struct tlp_pack_tlp_emu_channel ch;
+        uint32_t syndrome;
+
+        clobber(out[i % BENCH_BUFS]);
+        parse(out[i % BENCH_BUFS], &syndrome, &ch);
+        sum += syndrome + ch.q_protocol_mode + ch.q_mkey + ch.q_size + ch.q_addr +
+               ch.tlp_channel_stride_index;
+    }
+    clobber(&sum);
+    return now_sec() - start;
+}
+
+static void report(const char *name, double devx, double pack, uint32_t iterations)
+{
+    printf("  %-28s DEVX %7.2f ns/op (%7.1f Mops/s)   pack %7.2f ns/op (%7.1f Mops/s)   %.2fx\n",
+           name, devx * 1e9 / iterations, iterations / devx / 1e6,
+           pack * 1e9 / iterations, iterations / pack / 1e6, devx / pack);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 50000000;
+    uint32_t mismatches;
+    double devx, pack;
+
+    printf("TLP Channel Pack Benchmark\n");
+    printf("==========================\n");
+    printf("Usage: %s [iterations]\n\n", argv[0]);
+
+    mismatches = verify(100000);
+    if (mismatches) {
+        printf("✗ pack/unpack disagrees with DEVX_SET/DEVX_GET in %u iterations\n", mismatches);
+        return 1;
+    }
+    printf("✓ pack/unpack byte-identical to DEVX_SET/DEVX_GET\n\n");
+
+    printf("Iterations: %u\n", iterations);
+
+    // Warm up both paths before timing
+    bench_create(create_in_devx, iterations / 10);
+    bench_create(create_in_pack, iterations / 10);
+
+    devx = bench_create(create_in_devx, iterations);
+    pack = bench_create(create_in_pack, iterations);
+    report("create input (hdr + channel)", devx, pack, iterations);
+
+    devx = bench_query(query_out_devx, iterations);
+    pack = bench_query(query_out_pack, iterations);
+    report("query output (hdr + channel)", devx, pack, iterations);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - zero-copy consumer side of a QE ring. Ready QEs
+ * are lent out as pointers into the ring instead of being copied out, and
+ * their slots go back to the producer when the whole run is returned.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tlp_queue.h"
+
+void tlp_queue_init(struct tlp_queue *q, void *base, uint32_t qes, const uint32_t *pi_db, uint32_t *ci_db)
+{
+    memset(q, 0, sizeof(*q));
+    q->base = base;
+    q->qes = qes;
+    q->pi_db = pi_db;
+    q->ci_db = ci_db;
+    q->ci = q->head = q->pi = __atomic_load_n(ci_db, __ATOMIC_RELAXED);
+}
+
+uint32_t tlp_queue_borrow(struct tlp_queue *q, uint32_t max, struct tlp_qe_run *run)
+{
+    uint32_t avail = q->pi - q->head, slot;
+
+    if (!avail) {
+        q->pi = __atomic_load_n(q->pi_db, __ATOMIC_ACQUIRE);
+        avail = q->pi - q->head;
+        if (!avail)
+            return 0;
+    }
+    if (avail > max)
+        avail = max;
+
+    slot = q->head & (q->qes - 1);
+    run->ci = q->head;
+    run->count = avail;
+    run->span[0] = q->base + (size_t)slot * TLP_QE_SIZE;
+    run->n[0] = avail < q->qes - slot ? avail : q->qes - slot;
+    run->span[1] = q->base;
+    run->n[1] = avail - run->n[0];
+    q->head += avail;
+    return avail;
+}
+
+int tlp_queue_return(struct tlp_queue *q, const struct tlp_qe_run *run)
+{
+    if (run->ci != q->ci || run->count > q->head - q->ci) {
+        fprintf(stderr, "QE run %u+%u returned out of order (ci %u)\n", run->ci, run->count, q->ci);
+        return -1;
+    }
+    q->ci += run->count;
+    __atomic_store_n(q->ci_db, q->ci, __ATOMIC_RELEASE);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - zero-copy consumer side of a QE ring
+ */
+
+#ifndef TLP_QUEUE_H
+#define TLP_QUEUE_H
+
+#include <stdint.h>
+
+#include "tlp_decode.h"
+
+/*
+ * Consumer view of a ring of 64B QEs, e.g. the queue_buffer of a channel.
+ * Indices are free running. QEs between ci and head are borrowed: the
+ * consumer reads them in place and the producer must not reuse their slots
+ * until they are returned.
+ */
+struct tlp_queue {
+    uint8_t         *base;
+    uint32_t        qes;                // Power of two
+    uint32_t        ci;                 // Returned up to here
+    uint32_t        head;               // Borrowed up to here
+    uint32_t        pi;                 // Last producer index seen
+    const uint32_t  *pi_db;             // Written by the producer
+    uint32_t        *ci_db;             // Published on return
+};
+
+/*
+ * Ready QEs handed out by tlp_queue_borrow(). A run that crosses the end of
+ * the ring is two contiguous spans, the second starting at the ring base.
+ */
+struct tlp_qe_run {
+    uint8_t         *span[2];
+    uint32_t        n[2];               // QEs per span, n[1] == 0 without wrap
+    uint32_t        ci;                 // Free running index of the first QE
+    uint32_t        count;
+};
+
+void tlp_queue_init(struct tlp_queue *q, void *base, uint32_t qes, const uint32_t *pi_db, uint32_t *ci_db);
+
+/**
+ * Borrow up to max ready QEs after the ones already borrowed
+ *
+ * Reads the producer index only when the QEs seen so far are used up.
+ * Several runs may be borrowed before any is returned.
+ * @return: QEs in the run, 0 if none is ready
+ */
+uint32_t tlp_queue_borrow(struct tlp_queue *q, uint32_t max, struct tlp_qe_run *run);
+
+/**
+ * Give back a run, which must be the oldest one still borrowed. Its slots
+ * are published to the producer with one release store.
+ * @return: 0 on success, -1 if the run is not the oldest
+ */
+int tlp_queue_return(struct tlp_queue *q, const struct tlp_qe_run *run);
+
+// k-th QE of a run
+static inline uint8_t *tlp_qe_run_at(const struct tlp_qe_run *run, uint32_t k)
+{
+    return k < run->n[0] ? run->span[0] + (size_t)k * TLP_QE_SIZE
+                         : run->span[1] + (size_t)(k - run->n[0]) * TLP_QE_SIZE;
+}
+
+/**
+ * Decode a borrowed run in place. batch->qe indexes the queue ring, so
+ * tlp_bar_serve() and tlp_cfg_serve() take q->base as their ring.
+ * @return: QEs decoded, at most TLP_BATCH_MAX
+ */
+static inline uint32_t tlp_queue_decode(const struct tlp_queue *q, const struct tlp_qe_run *run,
+                                        struct tlp_batch *batch)
+{
+    return tlp_decode_qes(q->base, q->qes, run->ci, run->count, batch);
+}
+
+#endif /* TLP_QUEUE_H */
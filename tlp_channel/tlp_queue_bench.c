@@ -0,0 +1,270 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel QE handoff benchmark - a consumer that borrows runs of QEs
+ * and decodes them in place (tlp_queue.h) against one that copies every
+ * QE out of the ring before decoding. A random suite checks run spans at
+ * the ring wrap, in-place decoding and return ordering, then the consume
+ * bandwidth of both is timed with the ring in cache and with its lines
+ * flushed as after a device write.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_bench.h"
+#include "tlp_queue.h"
+
+// Mode0 ring: 1K x 64B QEs
+#define RING_QES        1024
+
+static uint32_t get32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// MWr 4DW with 8 payload DWs; the first payload DW is the sequence number
+static void produce(uint8_t *qe, uint32_t seq)
+{
+    put_be32(qe, 0x60u << 24 | 8);
+    put_be32(qe + 4, 0x0100u << 16 | 0xff);
+    put_be32(qe + 8, 0x1);
+    put_be32(qe + 12, (seq & 0xffff) * 64);
+    memcpy(qe + 16, &seq, 4);
+    for (uint32_t k = 20; k < 48; k += 4)
+        memcpy(qe + k, &k, 4);
+}
+
+static int suite(uint32_t steps)
+{
+    static struct tlp_batch batch;
+    uint8_t *ring = aligned_alloc(64, RING_QES * TLP_QE_SIZE);
+    uint32_t pi = 0, ci = 0, prod = 0, next = 0, errors = 0, nruns = 0;
+    struct tlp_qe_run runs[4];
+    struct tlp_queue q;
+    uint64_t seed = 7;
+
+    if (!ring)
+        return -1;
+    // Start near the top of the index space so free running indices wrap
+    pi = ci = prod = next = 0xfffff000u;
+    tlp_queue_init(&q, ring, RING_QES, &pi, &ci);
+
+    for (uint32_t s = 0; s < steps; s++) {
+        uint32_t op = rnd(&seed) % 3;
+
+        if (op == 0) {
+            uint32_t free_qes = RING_QES - (prod - __atomic_load_n(&ci, __ATOMIC_ACQUIRE));
+            uint32_t n = free_qes ? rnd(&seed) % (free_qes + 1) : 0;
+
+            for (uint32_t k = 0; k < n; k++, prod++)
+                produce(ring + (size_t)(prod & (RING_QES - 1)) * TLP_QE_SIZE, prod);
+            __atomic_store_n(&pi, prod, __ATOMIC_RELEASE);
+        } else if (op == 1 && nruns < 4) {
+            struct tlp_qe_run *run = &runs[nruns];
+            uint32_t max = 1 + rnd(&seed) % (rnd(&seed) % 8 ? 64 : 600);
+            uint32_t n = tlp_queue_borrow(&q, max, run), d;
+
+            if (!n)
+                continue;
+            nruns++;
+            errors += n > max || run->ci != next || run->n[0] + run->n[1] != n;
+            // A span never runs past the ring, the second one starts at its base
+            errors += run->span[0] + (size_t)run->n[0] * TLP_QE_SIZE > ring + RING_QES * TLP_QE_SIZE;
+            errors += run->n[1] && (run->span[0] + (size_t)run->n[0] * TLP_QE_SIZE != ring + RING_QES * TLP_QE_SIZE ||
+                                    run->span[1] != ring);
+            for (uint32_t k = 0; k < n; k++)
+                errors += get32(tlp_qe_run_at(run, k) + 16) != next + k;
+
+            d = tlp_queue_decode(&q, run, &batch);
+            errors += d != (n < TLP_BATCH_MAX ? n : TLP_BATCH_MAX);
+            for (uint32_t k = 0; k < d; k++)
+                errors += batch.kind[k] != TLP_KIND_MWR || batch.qe[k] != ((next + k) & (RING_QES - 1)) ||
+                          batch.addr[k] != (0x100000000ull | ((next + k) & 0xffff) * 64);
+            next += n;
+        } else if (nruns) {
+            uint32_t before = ci;
+
+            errors += tlp_queue_return(&q, &runs[0]) != 0;
+            errors += ci != before + runs[0].count;
+            memmove(&runs[0], &runs[1], --nruns * sizeof(runs[0]));
+        }
+    }
+    free(ring);
+
+    if (errors) {
+        printf("✗ %u random steps: %u errors\n", steps, errors);
+        return -1;
+    }
+    printf("✓ %u random steps, runs across the ring wrap and several runs borrowed at once\n", steps);
+    return 0;
+}
+
+// Returning a run that is not the oldest is refused
+static int suite_order(void)
+{
+    uint8_t *ring = aligned_alloc(64, RING_QES * TLP_QE_SIZE);
+    uint32_t pi = 0, ci = 0;
+    struct tlp_qe_run a, b;
+    struct tlp_queue q;
+    int ok;
+
+    if (!ring)
+        return -1;
+    tlp_queue_init(&q, ring, RING_QES, &pi, &ci);
+    pi = 100;
+    tlp_queue_borrow(&q, 10, &a);
+    tlp_queue_borrow(&q, 10, &b);
+    printf("  (expect one out-of-order message)\n");
+    ok = tlp_queue_return(&q, &b) == -1 && ci == 0 && !tlp_queue_return(&q, &a) &&
+         !tlp_queue_return(&q, &b) && ci == 20;
+    free(ring);
+    printf("%s out-of-order return refused\n", ok ? "✓" : "✗");
+    return ok ? 0 : -1;
+}
+
+// Read every byte of a QE, the least work a consumer can do
+static inline uint64_t read_qe(const uint8_t *qe)
+{
+    uint64_t sum = 0;
+
+    for (uint32_t k = 0; k < TLP_QE_SIZE; k += 8) {
+        uint64_t v;
+
+        memcpy(&v, qe + k, 8);
+        sum += v;
+    }
+    return sum;
+}
+
+// Decoded rows: touch each row's payload
+static inline uint64_t process(const uint8_t *ring, const struct tlp_batch *batch)
+{
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const uint8_t *payload = ring + (size_t)batch->qe[i] * TLP_QE_SIZE + batch->hdr_dw[i] * 4;
+
+        for (uint32_t k = 0; k < 32; k += 8) {
+            uint64_t v;
+
+            memcpy(&v, payload + k, 8);
+            sum += v;
+        }
+        sum += batch->addr[i];
+    }
+    return sum;
+}
+
+static double consume_zero_copy(struct tlp_queue *q, struct tlp_batch *batch, uint32_t max, int decode,
+                                uint64_t *sum)
+{
+    struct tlp_qe_run run;
+    double t0 = now_sec();
+
+    while (tlp_queue_borrow(q, max, &run)) {
+        if (decode) {
+            tlp_queue_decode(q, &run, batch);
+            *sum += process(q->base, batch);
+        } else {
+            for (uint32_t k = 0; k < run.count; k++)
+                *sum += read_qe(tlp_qe_run_at(&run, k));
+        }
+        tlp_queue_return(q, &run);
+    }
+    return now_sec() - t0;
+}
+
+static double consume_copy_out(struct tlp_queue *q, struct tlp_batch *batch, uint32_t max, int decode,
+                               uint8_t *copy, uint64_t *sum)
+{
+    struct tlp_qe_run run;
+    double t0 = now_sec();
+
+    while (tlp_queue_borrow(q, max, &run)) {
+        // QE by QE out of the ring, the slots go back right away
+        for (uint32_t k = 0; k < run.count; k++)
+            memcpy(copy + (size_t)k * TLP_QE_SIZE, tlp_qe_run_at(&run, k), TLP_QE_SIZE);
+        clobber(copy);
+        tlp_queue_return(q, &run);
+        if (decode) {
+            tlp_decode_qes(copy, TLP_BATCH_MAX, 0, run.count, batch);
+            *sum += process(copy, batch);
+        } else {
+            for (uint32_t k = 0; k < run.count; k++)
+                *sum += read_qe(copy + (size_t)k * TLP_QE_SIZE);
+        }
+    }
+    return now_sec() - t0;
+}
+
+static void bench(uint32_t rounds, uint32_t max, int cold, int decode)
+{
+    struct tlp_batch *batch = malloc(sizeof(*batch));
+    uint8_t *ring = aligned_alloc(64, RING_QES * TLP_QE_SIZE);
+    uint8_t *copy = aligned_alloc(64, TLP_BATCH_MAX * TLP_QE_SIZE);
+    uint32_t pi = 0, ci = 0, prod = 0;
+    double t_zero = 0, t_copy = 0;
+    uint64_t sum_zero = 0, sum_copy = 0;
+    struct tlp_queue q;
+
+    if (!batch || !ring || !copy)
+        goto out;
+    tlp_queue_init(&q, ring, RING_QES, &pi, &ci);
+
+    // Alternate consumers round by round
+    for (uint32_t r = 0; r < rounds * 2; r++) {
+        // The ring is full when a round starts, the consumer drains it
+        for (uint32_t k = 0; k < RING_QES; k++, prod++)
+            produce(ring + (size_t)(prod & (RING_QES - 1)) * TLP_QE_SIZE, prod);
+        if (cold)
+            flush_lines(ring, RING_QES * TLP_QE_SIZE);
+        __atomic_store_n(&pi, prod, __ATOMIC_RELEASE);
+
+        if (r & 1)
+            t_copy += consume_copy_out(&q, batch, max, decode, copy, &sum_copy);
+        else
+            t_zero += consume_zero_copy(&q, batch, max, decode, &sum_zero);
+    }
+
+    clobber(&sum_zero);
+    clobber(&sum_copy);
+    printf("  %-6s %-6s %4u %10.2f GB/s %10.2f GB/s %8.2fx\n", decode ? "decode" : "read",
+           cold ? "cold" : "warm", max,
+           (double)rounds * RING_QES * TLP_QE_SIZE / t_copy / 1e9,
+           (double)rounds * RING_QES * TLP_QE_SIZE / t_zero / 1e9, t_copy / t_zero);
+out:
+    free(batch);
+    free(ring);
+    free(copy);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t steps = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    uint32_t rounds = argc > 2 ? strtoul(argv[2], NULL, 0) : 20000;
+    static const uint32_t batch_sizes[] = { 16, 64, 256 };
+
+    printf("TLP QE Handoff Benchmark\n");
+    printf("========================\n");
+    printf("Usage: %s [suite_steps] [rounds]\n\n", argv[0]);
+
+    printf("Suite:\n");
+    if (suite(steps) || suite_order())
+        return 1;
+
+    printf("\nConsume bandwidth, %u rounds of a full %u-QE ring\n", rounds, RING_QES);
+    printf("  read: every QE byte once, decode: tlp_decode_qes() and the payload\n");
+    printf("  %-6s %-6s %4s %15s %15s %9s\n", "Work", "Ring", "Run", "Copy-out", "Zero-copy", "Speedup");
+    for (int decode = 0; decode < 2; decode++)
+        for (int cold = 0; cold < 2; cold++)
+            for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++)
+                bench(rounds, batch_sizes[b], cold, decode);
+    return 0;
+}
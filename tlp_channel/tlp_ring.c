@@ -0,0 +1,217 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - lock-free rings of decoded TLP descriptors, from
+ * the thread polling a channel to the threads running the device model.
+ * Indices are free running 32-bit counters; entries are one cache line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_ring.h"
+
+static struct tlp_ring_slot *slots_alloc(uint32_t size)
+{
+    struct tlp_ring_slot *slot;
+
+    if (!size || (size & (size - 1))) {
+        fprintf(stderr, "Invalid ring size %u, must be a power of two\n", size);
+        return NULL;
+    }
+    slot = aligned_alloc(64, (size_t)size * sizeof(*slot));
+    if (!slot) {
+        fprintf(stderr, "Failed to allocate ring of %u entries\n", size);
+        return NULL;
+    }
+    memset(slot, 0, (size_t)size * sizeof(*slot));
+    for (uint32_t i = 0; i < size; i++)
+        slot[i].seq = i;
+    return slot;
+}
+
+/*
+ * SPSC
+ */
+struct tlp_spsc *tlp_spsc_create(uint32_t size)
+{
+    struct tlp_spsc *r = aligned_alloc(64, sizeof(*r));
+
+    if (!r)
+        return NULL;
+    memset(r, 0, sizeof(*r));
+    r->size = size;
+    r->slot = slots_alloc(size);
+    if (!r->slot) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+void tlp_spsc_destroy(struct tlp_spsc *r)
+{
+    if (!r)
+        return;
+    free(r->slot);
+    free(r);
+}
+
+// Free slots for up to n entries from *head on
+static inline uint32_t spsc_claim(struct tlp_spsc *r, uint32_t n, uint32_t *head)
+{
+    uint32_t h = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    uint32_t room = r->size - (h - r->tail_cache);
+
+    if (room < n) {
+        r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        room = r->size - (h - r->tail_cache);
+    }
+    *head = h;
+    return n < room ? n : room;
+}
+
+uint32_t tlp_spsc_push(struct tlp_spsc *r, const struct tlp_desc *d, uint32_t n)
+{
+    uint32_t h, mask = r->size - 1;
+
+    n = spsc_claim(r, n, &h);
+    for (uint32_t i = 0; i < n; i++)
+        r->slot[(h + i) & mask].d = d[i];
+    if (n)
+        __atomic_store_n(&r->head, h + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+uint32_t tlp_spsc_push_batch(struct tlp_spsc *r, const struct tlp_batch *batch, uint32_t first,
+                             uint32_t count, uint16_t channel, uint32_t cookie)
+{
+    uint32_t h, mask = r->size - 1, n = spsc_claim(r, count, &h);
+
+    for (uint32_t i = 0; i < n; i++)
+        tlp_desc_from_batch(&r->slot[(h + i) & mask].d, batch, first + i, channel, cookie + i);
+    if (n)
+        __atomic_store_n(&r->head, h + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+uint32_t tlp_spsc_pop(struct tlp_spsc *r, struct tlp_desc *out, uint32_t max)
+{
+    uint32_t t = __atomic_load_n(&r->tail, __ATOMIC_RELAXED), mask = r->size - 1;
+    uint32_t avail = r->head_cache - t;
+
+    if (!avail) {
+        r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        avail = r->head_cache - t;
+        if (!avail)
+            return 0;
+    }
+    if (avail > max)
+        avail = max;
+    for (uint32_t i = 0; i < avail; i++)
+        out[i] = r->slot[(t + i) & mask].d;
+    __atomic_store_n(&r->tail, t + avail, __ATOMIC_RELEASE);
+    return avail;
+}
+
+/*
+ * MPMC: a slot is free for position p when seq == p and ready when
+ * seq == p + 1. Popping position p frees the slot for p + size.
+ */
+struct tlp_mpmc *tlp_mpmc_create(uint32_t size)
+{
+    struct tlp_mpmc *r = aligned_alloc(64, sizeof(*r));
+
+    if (!r)
+        return NULL;
+    memset(r, 0, sizeof(*r));
+    r->size = size;
+    r->slot = slots_alloc(size);
+    if (!r->slot) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+void tlp_mpmc_destroy(struct tlp_mpmc *r)
+{
+    if (!r)
+        return;
+    free(r->slot);
+    free(r);
+}
+
+/*
+ * Claim up to n consecutive slots whose seq is pos + i + ready, starting at
+ * *idx. The slots stay ours once the CAS moved the index past them.
+ */
+static inline uint32_t mpmc_claim(struct tlp_mpmc *r, uint32_t *idx, uint32_t n, uint32_t ready, uint32_t *pos)
+{
+    uint32_t p = __atomic_load_n(idx, __ATOMIC_RELAXED), mask = r->size - 1;
+
+    for (;;) {
+        uint32_t k = 0, seq = 0;
+
+        while (k < n) {
+            seq = __atomic_load_n(&r->slot[(p + k) & mask].seq, __ATOMIC_ACQUIRE);
+            if (seq != p + k + ready)
+                break;
+            k++;
+        }
+        if (!k) {
+            // Behind the position: full (push) or empty (pop)
+            if ((int32_t)(seq - (p + ready)) < 0)
+                return 0;
+            p = __atomic_load_n(idx, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(idx, &p, p + k, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            *pos = p;
+            return k;
+        }
+    }
+}
+
+uint32_t tlp_mpmc_push(struct tlp_mpmc *r, const struct tlp_desc *d, uint32_t n)
+{
+    uint32_t pos, mask = r->size - 1;
+
+    n = mpmc_claim(r, &r->head, n, 0, &pos);
+    for (uint32_t i = 0; i < n; i++) {
+        struct tlp_ring_slot *s = &r->slot[(pos + i) & mask];
+
+        s->d = d[i];
+        __atomic_store_n(&s->seq, pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+uint32_t tlp_mpmc_push_batch(struct tlp_mpmc *r, const struct tlp_batch *batch, uint32_t first,
+                             uint32_t count, uint16_t channel, uint32_t cookie)
+{
+    uint32_t pos, mask = r->size - 1, n = mpmc_claim(r, &r->head, count, 0, &pos);
+
+    for (uint32_t i = 0; i < n; i++) {
+        struct tlp_ring_slot *s = &r->slot[(pos + i) & mask];
+
+        tlp_desc_from_batch(&s->d, batch, first + i, channel, cookie + i);
+        __atomic_store_n(&s->seq, pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+uint32_t tlp_mpmc_pop(struct tlp_mpmc *r, struct tlp_desc *out, uint32_t max)
+{
+    uint32_t pos, mask = r->size - 1, n = mpmc_claim(r, &r->tail, max, 1, &pos);
+
+    for (uint32_t i = 0; i < n; i++) {
+        struct tlp_ring_slot *s = &r->slot[(pos + i) & mask];
+
+        out[i] = s->d;
+        __atomic_store_n(&s->seq, pos + i + r->size, __ATOMIC_RELEASE);
+    }
+    return n;
+}
@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - lock-free rings from channel pollers to workers
+ */
+
+#ifndef TLP_RING_H
+#define TLP_RING_H
+
+#include <stdint.h>
+
+#include "tlp_decode.h"
+
+/*
+ * One decoded TLP, a row of struct tlp_batch plus where it came from. The
+ * payload stays in the channel queue at index qe.
+ */
+struct tlp_desc {
+    uint64_t    addr;
+    uint32_t    cookie;             // Caller's, e.g. poll sequence number
+    uint16_t    channel;            // Source queue
+    uint16_t    qe;
+    uint16_t    len_dw;
+    uint16_t    requester;
+    uint16_t    tag;
+    uint16_t    target;
+    uint16_t    byte_count;
+    uint8_t     kind;
+    uint8_t     fmt_type;
+    uint8_t     hdr_dw;
+    uint8_t     be;
+    uint8_t     cpl_status;
+    uint8_t     msg_code;
+};
+
+// Ring entry, one per cache line so neighbouring producers and consumers never share one
+struct tlp_ring_slot {
+    struct tlp_desc d;
+    uint32_t        seq;            // MPMC only: ready/free state of the slot
+} __attribute__((aligned(64)));
+
+static inline void tlp_desc_from_batch(struct tlp_desc *d, const struct tlp_batch *batch, uint32_t i,
+                                       uint16_t channel, uint32_t cookie)
+{
+    d->addr = batch->addr[i];
+    d->cookie = cookie;
+    d->channel = channel;
+    d->qe = batch->qe[i];
+    d->len_dw = batch->len_dw[i];
+    d->requester = batch->requester[i];
+    d->tag = batch->tag[i];
+    d->target = batch->target[i];
+    d->byte_count = batch->byte_count[i];
+    d->kind = batch->kind[i];
+    d->fmt_type = batch->fmt_type[i];
+    d->hdr_dw = batch->hdr_dw[i];
+    d->be = batch->be[i];
+    d->cpl_status = batch->cpl_status[i];
+    d->msg_code = batch->msg_code[i];
+}
+
+/*
+ * Single producer, single consumer. Each side keeps a cached copy of the
+ * other's index on its own cache line and reads the shared one only when
+ * the cache says the ring is full (or empty). A push or pop of n entries
+ * is published with one release store.
+ */
+struct tlp_spsc {
+    uint32_t                head __attribute__((aligned(64)));     // Written by the producer
+    uint32_t                tail_cache;
+    uint32_t                tail __attribute__((aligned(64)));     // Written by the consumer
+    uint32_t                head_cache;
+    uint32_t                size __attribute__((aligned(64)));
+    struct tlp_ring_slot    *slot;
+};
+
+/**
+ * @param size: Entries, power of two
+ * @return: ring, NULL on failure
+ */
+struct tlp_spsc *tlp_spsc_create(uint32_t size);
+void tlp_spsc_destroy(struct tlp_spsc *r);
+
+/**
+ * @return: entries pushed, fewer than n when the ring fills up
+ */
+uint32_t tlp_spsc_push(struct tlp_spsc *r, const struct tlp_desc *d, uint32_t n);
+
+/**
+ * Push rows [first, first + count) of a decoded batch without staging them
+ *
+ * @param cookie: Stored in the first row's descriptor, incremented per row
+ * @return: rows pushed
+ */
+uint32_t tlp_spsc_push_batch(struct tlp_spsc *r, const struct tlp_batch *batch, uint32_t first,
+                             uint32_t count, uint16_t channel, uint32_t cookie);
+
+/**
+ * @return: entries popped into out, 0 when the ring is empty
+ */
+uint32_t tlp_spsc_pop(struct tlp_spsc *r, struct tlp_desc *out, uint32_t max);
+
+/*
+ * Multiple producers and consumers, bounded queue with a sequence number
+ * per slot. A push claims a run of free slots with one CAS on head, fills
+ * them and marks each ready; a pop claims a run of ready slots with one CAS
+ * on tail. Entries of one producer reach each consumer in push order.
+ */
+struct tlp_mpmc {
+    uint32_t                head __attribute__((aligned(64)));
+    uint32_t                tail __attribute__((aligned(64)));
+    uint32_t                size __attribute__((aligned(64)));
+    struct tlp_ring_slot    *slot;
+};
+
+struct tlp_mpmc *tlp_mpmc_create(uint32_t size);
+void tlp_mpmc_destroy(struct tlp_mpmc *r);
+uint32_t tlp_mpmc_push(struct tlp_mpmc *r, const struct tlp_desc *d, uint32_t n);
+uint32_t tlp_mpmc_push_batch(struct tlp_mpmc *r, const struct tlp_batch *batch, uint32_t first,
+                             uint32_t count, uint16_t channel, uint32_t cookie);
+uint32_t tlp_mpmc_pop(struct tlp_mpmc *r, struct tlp_desc *out, uint32_t max);
+
+#endif /* TLP_RING_H */
@@ -0,0 +1,306 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel handoff ring benchmark - poller threads push batches of
+ * decoded TLP descriptors into an SPSC or MPMC ring (tlp_ring.h), worker
+ * threads pop them. A suite checks that nothing is lost or duplicated and
+ * that each worker sees every poller's descriptors in order, then
+ * throughput and push-to-pop latency are timed across thread counts,
+ * publish batch sizes and core placements.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tlp_bench.h"
+#include "tlp_ring.h"
+
+#define RING_SIZE       1024
+#define MAX_THREADS     16
+#define LAT_EVERY       64              // Latency sample every n-th descriptor
+
+enum placement {
+    PLACE_NONE,                 // Left to the scheduler
+    PLACE_PACKED,               // Every thread on the node's first CPU
+    PLACE_SPREAD,               // Thread i on the node's CPU i modulo its CPUs
+};
+
+static const char *placement_names[] = { "none", "packed", "spread" };
+
+// CPUs of the device's node, where a poller and its workers run
+static int ncpus, cpu_node, cpus[TLP_NUMA_MAX_CPUS];
+
+static void place(enum placement p, uint32_t thread)
+{
+    if (p != PLACE_NONE)
+        pin_cpu(cpus[p == PLACE_PACKED ? 0 : thread % ncpus]);
+}
+
+/*
+ * One run: producers push, consumers pop until every descriptor arrived
+ */
+struct run {
+    int                 mpmc;
+    void                *ring;
+    uint32_t            producers;
+    uint32_t            consumers;
+    uint32_t            per_producer;
+    uint32_t            publish;        // Descriptors per push
+    enum placement      placement;
+    int                 check;
+    uint64_t            total;
+    uint64_t            consumed __attribute__((aligned(64)));
+    uint8_t             *seen;          // check: one byte per descriptor
+};
+
+struct worker {
+    struct run          *run;
+    uint32_t            id;
+    uint32_t            errors;
+    uint32_t            nlat;
+    uint32_t            *lat_ns;
+    pthread_t           thread;
+};
+
+static void *producer(void *arg)
+{
+    struct worker *w = arg;
+    struct run *run = w->run;
+    struct tlp_batch *batch = calloc(1, sizeof(*batch));
+    uint8_t *qes = calloc(TLP_BATCH_MAX, TLP_QE_SIZE);
+    uint32_t seq = 0, spins = 0;
+
+    place(run->placement, w->id);
+    if (!batch || !qes) {
+        w->errors++;
+        goto out;
+    }
+    // A polled batch of MWr 64B
+    for (uint32_t i = 0; i < TLP_BATCH_MAX; i++) {
+        put_be32(qes + i * TLP_QE_SIZE, 0x60u << 24 | 16);
+        put_be32(qes + i * TLP_QE_SIZE + 4, 0x0100u << 16 | 0xff);
+        put_be32(qes + i * TLP_QE_SIZE + 12, i * 64);
+    }
+    tlp_decode_qes(qes, TLP_BATCH_MAX, 0, run->publish, batch);
+
+    while (seq < run->per_producer) {
+        uint32_t n = run->per_producer - seq < run->publish ? run->per_producer - seq : run->publish;
+        uint64_t stamp = now_ns();
+
+        for (uint32_t i = 0; i < n; i++)
+            batch->addr[i] = stamp;
+        for (uint32_t done = 0; done < n; ) {
+            uint32_t k = run->mpmc ?
+                tlp_mpmc_push_batch(run->ring, batch, done, n - done, w->id, seq + done) :
+                tlp_spsc_push_batch(run->ring, batch, done, n - done, w->id, seq + done);
+
+            if (k) {
+                done += k;
+                spins = 0;
+            } else {
+                backoff(&spins);
+            }
+        }
+        seq += n;
+    }
+out:
+    free(batch);
+    free(qes);
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    struct worker *w = arg;
+    struct run *run = w->run;
+    struct tlp_desc out[64];
+    uint32_t last[MAX_THREADS], spins = 0;
+    uint64_t count = 0;
+
+    place(run->placement, run->producers + w->id);
+    memset(last, 0xff, sizeof(last));
+    while (__atomic_load_n(&run->consumed, __ATOMIC_RELAXED) < run->total) {
+        uint32_t n = run->mpmc ? tlp_mpmc_pop(run->ring, out, 64) : tlp_spsc_pop(run->ring, out, 64);
+        uint64_t now;
+
+        if (!n) {
+            backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        now = now_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            const struct tlp_desc *d = &out[i];
+
+            if (run->check) {
+                uint64_t idx = (uint64_t)d->channel * run->per_producer + d->cookie;
+
+                // Per poller order, no loss, no duplicates
+                w->errors += d->channel >= run->producers || d->cookie >= run->per_producer ||
+                             (last[d->channel] != ~0u && d->cookie <= last[d->channel]) ||
+                             d->kind != TLP_KIND_MWR || d->len_dw != 16;
+                if (d->channel < run->producers && d->cookie < run->per_producer)
+                    w->errors += run->seen[idx]++ != 0;
+                if (d->channel < MAX_THREADS)
+                    last[d->channel] = d->cookie;
+            }
+            if (w->lat_ns && ++count % LAT_EVERY == 0 && w->nlat < run->total / LAT_EVERY + 1)
+                w->lat_ns[w->nlat++] = (uint32_t)(now - d->addr);
+        }
+        __atomic_fetch_add(&run->consumed, n, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/**
+ * @return: elapsed seconds, negative on failure; errors and latency
+ *          percentiles (ns) through the pointers
+ */
+static double run_ring(int mpmc, uint32_t producers, uint32_t consumers, uint32_t publish, uint64_t total,
+                       enum placement placement, int check, uint32_t *errors, uint32_t *p50, uint32_t *p99)
+{
+    struct run run = {
+        .mpmc = mpmc, .producers = producers, .consumers = consumers,
+        .per_producer = (uint32_t)(total / producers), .publish = publish,
+        .placement = placement, .check = check,
+    };
+    struct worker w[2 * MAX_THREADS];
+    uint32_t nlat = 0, *lat = NULL;
+    double elapsed = -1;
+    uint64_t start;
+
+    run.total = (uint64_t)run.per_producer * producers;
+    run.ring = mpmc ? (void *)tlp_mpmc_create(RING_SIZE) : (void *)tlp_spsc_create(RING_SIZE);
+    run.seen = check ? calloc(run.total, 1) : NULL;
+    memset(w, 0, sizeof(w));
+    *errors = 0;
+    if (!run.ring || (check && !run.seen))
+        goto out;
+
+    for (uint32_t i = 0; i < consumers; i++) {
+        w[producers + i].lat_ns = check ? NULL : malloc((run.total / LAT_EVERY + 1) * sizeof(uint32_t));
+        if (!check && !w[producers + i].lat_ns)
+            goto out;
+    }
+    start = now_ns();
+    for (uint32_t i = 0; i < producers + consumers; i++) {
+        w[i].run = &run;
+        w[i].id = i < producers ? i : i - producers;
+        pthread_create(&w[i].thread, NULL, i < producers ? producer : consumer, &w[i]);
+    }
+    for (uint32_t i = 0; i < producers + consumers; i++) {
+        pthread_join(w[i].thread, NULL);
+        *errors += w[i].errors;
+        nlat += w[i].nlat;
+    }
+    elapsed = (now_ns() - start) / 1e9;
+
+    if (check) {
+        for (uint64_t k = 0; k < run.total; k++)
+            *errors += run.seen[k] != 1;
+    } else if (nlat && (lat = malloc(nlat * sizeof(*lat)))) {
+        nlat = 0;
+        for (uint32_t i = 0; i < consumers; i++) {
+            memcpy(lat + nlat, w[producers + i].lat_ns, w[producers + i].nlat * sizeof(*lat));
+            nlat += w[producers + i].nlat;
+        }
+        qsort(lat, nlat, sizeof(*lat), cmp_u32);
+        *p50 = lat[nlat / 2];
+        *p99 = lat[nlat * 99ull / 100];
+        free(lat);
+    }
+
+out:
+    for (uint32_t i = 0; i < consumers; i++)
+        free(w[producers + i].lat_ns);
+    if (mpmc)
+        tlp_mpmc_destroy(run.ring);
+    else
+        tlp_spsc_destroy(run.ring);
+    free(run.seen);
+    return elapsed;
+}
+
+static int suite(uint64_t total)
+{
+    static const struct {
+        int         mpmc;
+        uint32_t    producers;
+        uint32_t    consumers;
+        uint32_t    publish;
+    } cases[] = {
+        { 0, 1, 1, 1 }, { 0, 1, 1, 32 }, { 0, 1, 1, 256 },
+        { 1, 1, 1, 32 }, { 1, 1, 4, 32 }, { 1, 4, 1, 32 }, { 1, 4, 4, 1 }, { 1, 4, 4, 32 }, { 1, 3, 5, 7 },
+    };
+    int ret = 0;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint32_t errors, p50, p99;
+        double t = run_ring(cases[c].mpmc, cases[c].producers, cases[c].consumers, cases[c].publish, total,
+                            PLACE_NONE, 1, &errors, &p50, &p99);
+
+        printf("%s %s %uP/%uC, %u per push: %s\n", t >= 0 && !errors ? "✓" : "✗",
+               cases[c].mpmc ? "MPMC" : "SPSC", cases[c].producers, cases[c].consumers, cases[c].publish,
+               t < 0 ? "setup failed" : errors ? "lost, duplicated or reordered descriptors" : "all in order");
+        if (t < 0 || errors)
+            ret = -1;
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t total = argc > 1 ? strtoull(argv[1], NULL, 0) : 4000000;
+    static const struct {
+        int         mpmc;
+        uint32_t    producers;
+        uint32_t    consumers;
+    } configs[] = {
+        { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 2 }, { 1, 1, 4 }, { 1, 1, 8 }, { 1, 2, 2 }, { 1, 4, 4 },
+    };
+    static const uint32_t publish[] = { 1, 32 };
+
+    ncpus = bench_cpus(&cpu_node, cpus, TLP_NUMA_MAX_CPUS);
+
+    printf("TLP Handoff Ring Benchmark\n");
+    printf("==========================\n");
+    printf("Usage: %s [descriptors]\n\n", argv[0]);
+
+    printf("Suite:\n");
+    if (suite(400000))
+        return 1;
+
+    printf("\n%lu descriptors per run, %u-entry ring, %d CPUs %s\n", total, RING_SIZE, ncpus,
+           cpu_node >= 0 ? "on the device's node" : "(no device node)");
+    printf("  %-5s %-7s %-7s %5s %12s %10s %10s\n", "Ring", "Threads", "Place", "Push", "Desc/s", "p50 us",
+           "p99 us");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        for (int p = PLACE_NONE; p <= PLACE_SPREAD; p++) {
+            for (size_t b = 0; b < sizeof(publish) / sizeof(publish[0]); b++) {
+                uint32_t errors, p50 = 0, p99 = 0;
+                char threads[16];
+                double t;
+
+                // Placement only matters with more than one CPU
+                if (ncpus == 1 && p != PLACE_NONE)
+                    continue;
+                t = run_ring(configs[c].mpmc, configs[c].producers, configs[c].consumers, publish[b], total, p, 0,
+                             &errors, &p50, &p99);
+                snprintf(threads, sizeof(threads), "%uP/%uC", configs[c].producers, configs[c].consumers);
+                if (t < 0 || errors) {
+                    printf("  %-5s %-7s failed\n", configs[c].mpmc ? "MPMC" : "SPSC", threads);
+                    continue;
+                }
+                printf("  %-5s %-7s %-7s %5u %10.2f M %10.2f %10.2f\n", configs[c].mpmc ? "MPMC" : "SPSC",
+                       threads, placement_names[p], publish[b], total / t / 1e6, p50 / 1e3, p99 / 1e3);
+            }
+        }
+    }
+    return 0;
+}
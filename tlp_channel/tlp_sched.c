@@ -0,0 +1,292 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - work-stealing scheduler for emulated functions.
+ * The unit of work is a function, not a TLP: a function with pending
+ * descriptors is queued on one worker at a time, so its TLPs are handled
+ * in arrival order wherever it runs, and a steal moves all of its backlog.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "tlp_sched.h"
+#include "tlp_numa.h"
+
+struct sched_func {
+    struct tlp_spsc     *q;
+    uint32_t            queued;         // In a run queue or running
+    uint32_t            owner;          // Worker whose run queue takes it next
+} __attribute__((aligned(64)));
+
+struct sched_worker {
+    struct tlp_sched        *s;
+    struct tlp_mpmc         *runq;      // Function numbers, in desc.cookie
+    uint32_t                id;
+    int                     cpu;
+    pthread_t               thread;
+    struct tlp_sched_stats  stats;
+} __attribute__((aligned(64)));
+
+struct tlp_sched {
+    uint32_t            nfuncs;
+    uint32_t            nworkers;
+    uint32_t            started;
+    int                 steal;
+    tlp_sched_fn        fn;
+    void                *arg;
+    struct sched_func   *funcs;
+    struct sched_worker *workers;
+    uint64_t            submitted __attribute__((aligned(64)));
+    uint64_t            done __attribute__((aligned(64)));
+    uint32_t            stop;
+};
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Spin a little, then give the CPU away (the poller may share it)
+static inline void backoff(uint32_t *spins)
+{
+    if (++*spins < 64) {
+        cpu_relax();
+        return;
+    }
+    *spins = 0;
+    sched_yield();
+}
+
+// Consumer side view of a function queue
+static inline int func_pending(const struct tlp_spsc *q)
+{
+    return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) != q->tail;
+}
+
+static void runq_push(struct sched_worker *w, uint32_t func)
+{
+    struct tlp_desc d = { .cookie = func };
+
+    // Room for every function; a full answer only means a pop is still storing its slot
+    while (!tlp_mpmc_push(w->runq, &d, 1))
+        cpu_relax();
+}
+
+struct tlp_sched *tlp_sched_create(uint32_t nfuncs, uint32_t nworkers, uint32_t queue_size, int steal,
+                                   tlp_sched_fn fn, void *arg)
+{
+    struct tlp_sched *s;
+    uint32_t runq_size = 1;
+
+    if (!nfuncs || !nworkers || nworkers > TLP_SCHED_WORKERS_MAX || !fn) {
+        fprintf(stderr, "Invalid scheduler config: %u functions, %u workers\n", nfuncs, nworkers);
+        return NULL;
+    }
+    s = aligned_alloc(64, sizeof(*s));
+    if (!s)
+        return NULL;
+    memset(s, 0, sizeof(*s));
+    s->nfuncs = nfuncs;
+    s->nworkers = nworkers;
+    s->steal = steal;
+    s->fn = fn;
+    s->arg = arg;
+    s->funcs = aligned_alloc(64, (size_t)nfuncs * sizeof(*s->funcs));
+    s->workers = aligned_alloc(64, (size_t)nworkers * sizeof(*s->workers));
+    if (!s->funcs || !s->workers)
+        goto err_alloc;
+    memset(s->funcs, 0, (size_t)nfuncs * sizeof(*s->funcs));
+    memset(s->workers, 0, (size_t)nworkers * sizeof(*s->workers));
+
+    while (runq_size < 2 * nfuncs)
+        runq_size <<= 1;
+    for (uint32_t w = 0; w < nworkers; w++) {
+        s->workers[w].s = s;
+        s->workers[w].id = w;
+        s->workers[w].cpu = -1;
+        s->workers[w].runq = tlp_mpmc_create(runq_size);
+        if (!s->workers[w].runq)
+            goto err_alloc;
+    }
+    for (uint32_t f = 0; f < nfuncs; f++) {
+        s->funcs[f].owner = f % nworkers;
+        s->funcs[f].q = tlp_spsc_create(queue_size);
+        if (!s->funcs[f].q)
+            goto err_alloc;
+    }
+    return s;
+
+err_alloc:
+    fprintf(stderr, "Failed to allocate scheduler for %u functions\n", nfuncs);
+    tlp_sched_destroy(s);
+    return NULL;
+}
+
+void tlp_sched_destroy(struct tlp_sched *s)
+{
+    if (!s)
+        return;
+    if (s->started)
+        tlp_sched_stop(s);
+    if (s->funcs)
+        for (uint32_t f = 0; f < s->nfuncs; f++)
+            tlp_spsc_destroy(s->funcs[f].q);
+    if (s->workers)
+        for (uint32_t w = 0; w < s->nworkers; w++)
+            tlp_mpmc_destroy(s->workers[w].runq);
+    free(s->funcs);
+    free(s->workers);
+    free(s);
+}
+
+// Oldest queued function of the next worker that has one
+static int steal(struct tlp_sched *s, struct sched_worker *w, struct tlp_desc *d)
+{
+    for (uint32_t k = 1; k < s->nworkers; k++) {
+        struct sched_worker *victim = &s->workers[(w->id + k) % s->nworkers];
+
+        if (tlp_mpmc_pop(victim->runq, d, 1))
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * Done with a run of func: requeue it behind the functions already waiting
+ * if it has more work, otherwise mark it idle. The fence pairs with the one
+ * in tlp_sched_submit(): either the poller sees the function idle and queues
+ * it, or we see the new descriptors and do.
+ */
+static void release(struct sched_worker *w, struct sched_func *fn, uint32_t func)
+{
+    uint32_t idle = 0;
+
+    if (func_pending(fn->q)) {
+        runq_push(w, func);
+        return;
+    }
+    __atomic_store_n(&fn->queued, 0, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (func_pending(fn->q) &&
+        __atomic_compare_exchange_n(&fn->queued, &idle, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        runq_push(w, func);
+}
+
+static void *worker_main(void *arg)
+{
+    struct sched_worker *w = arg;
+    struct tlp_sched *s = w->s;
+    struct tlp_desc d[TLP_SCHED_BUDGET], entry;
+    uint32_t spins = 0;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+        struct sched_func *fn;
+        uint32_t n, func;
+        int stolen = 0;
+
+        if (!tlp_mpmc_pop(w->runq, &entry, 1)) {
+            if (!s->steal || !steal(s, w, &entry)) {
+                backoff(&spins);
+                continue;
+            }
+            stolen = 1;
+        }
+        spins = 0;
+        func = entry.cookie;
+        fn = &s->funcs[func];
+        if (stolen) {
+            // The function and its backlog now live here
+            __atomic_store_n(&fn->owner, w->id, __ATOMIC_RELAXED);
+            w->stats.steals++;
+        }
+
+        n = tlp_spsc_pop(fn->q, d, TLP_SCHED_BUDGET);
+        if (n) {
+            s->fn(s->arg, func, d, n, w->id);
+            w->stats.descs += n;
+            w->stats.runs++;
+            __atomic_add_fetch(&s->done, n, __ATOMIC_RELEASE);
+        }
+        release(w, fn, func);
+    }
+    return NULL;
+}
+
+int tlp_sched_start(struct tlp_sched *s, const int *cpus)
+{
+    for (uint32_t w = 0; w < s->nworkers; w++) {
+        s->workers[w].cpu = cpus ? cpus[w] : -1;
+        if (pthread_create(&s->workers[w].thread, NULL, worker_main, &s->workers[w])) {
+            fprintf(stderr, "Failed to start scheduler worker %u\n", w);
+            tlp_sched_stop(s);
+            return -1;
+        }
+        s->started++;
+    }
+    return 0;
+}
+
+int tlp_sched_start_node(struct tlp_sched *s, int node)
+{
+    int all[TLP_NUMA_MAX_CPUS], cpus[TLP_SCHED_WORKERS_MAX];
+    int n = tlp_numa_thread_cpus(node, all, TLP_NUMA_MAX_CPUS);
+
+    if (n <= 0) {
+        fprintf(stderr, "No usable CPUs for scheduler workers on node %d\n", node);
+        return -1;
+    }
+    for (uint32_t w = 0; w < s->nworkers; w++)
+        cpus[w] = all[w % n];
+    return tlp_sched_start(s, cpus);
+}
+
+uint32_t tlp_sched_submit(struct tlp_sched *s, uint32_t func, const struct tlp_desc *d, uint32_t n)
+{
+    struct sched_func *fn = &s->funcs[func];
+    uint32_t idle = 0;
+
+    n = tlp_spsc_push(fn->q, d, n);
+    if (!n)
+        return 0;
+    __atomic_add_fetch(&s->submitted, n, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&fn->queued, __ATOMIC_RELAXED) &&
+        __atomic_compare_exchange_n(&fn->queued, &idle, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        runq_push(&s->workers[__atomic_load_n(&fn->owner, __ATOMIC_RELAXED)], func);
+    return n;
+}
+
+void tlp_sched_stop(struct tlp_sched *s)
+{
+    uint32_t spins = 0;
+
+    // Nothing is left behind when every worker started
+    if (s->started == s->nworkers)
+        while (__atomic_load_n(&s->done, __ATOMIC_ACQUIRE) != __atomic_load_n(&s->submitted, __ATOMIC_RELAXED))
+            backoff(&spins);
+    __atomic_store_n(&s->stop, 1, __ATOMIC_RELEASE);
+    for (uint32_t w = 0; w < s->started; w++)
+        pthread_join(s->workers[w].thread, NULL);
+    s->started = 0;
+}
+
+const struct tlp_sched_stats *tlp_sched_worker_stats(const struct tlp_sched *s, uint32_t worker)
+{
+    return &s->workers[worker].stats;
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - work-stealing scheduler for emulated functions
+ */
+
+#ifndef TLP_SCHED_H
+#define TLP_SCHED_H
+
+#include <stdint.h>
+
+#include "tlp_ring.h"
+
+#define TLP_SCHED_BUDGET        32      // Descriptors per function run
+#define TLP_SCHED_WORKERS_MAX   64
+
+/**
+ * Device model entry point, called with consecutive descriptors of one
+ * function. Never runs for the same function on two workers at once.
+ */
+typedef void (*tlp_sched_fn)(void *arg, uint32_t func, const struct tlp_desc *d, uint32_t n, uint32_t worker);
+
+struct tlp_sched_stats {
+    uint64_t    descs;              // Descriptors handled
+    uint64_t    runs;               // Function runs
+    uint64_t    steals;             // Runs of functions taken from another worker
+};
+
+struct tlp_sched;
+
+/**
+ * Each function has an SPSC queue of descriptors and a home worker. A
+ * function with work sits in exactly one worker's run queue. A worker
+ * takes functions from its own run queue and runs each for up to
+ * TLP_SCHED_BUDGET descriptors. With steal set, a worker whose run queue
+ * is empty takes the oldest function from another worker, together with
+ * all of that function's pending work. The function then stays with the
+ * thief. Without steal, functions stay on worker func % nworkers (static
+ * sharding).
+ * @param queue_size: Descriptors queued per function, power of two
+ * @return: scheduler, NULL on failure
+ */
+struct tlp_sched *tlp_sched_create(uint32_t nfuncs, uint32_t nworkers, uint32_t queue_size, int steal,
+                                   tlp_sched_fn fn, void *arg);
+
+/**
+ * Start the worker threads
+ *
+ * @param cpus: CPU for each worker, NULL to leave placement to the system
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_sched_start(struct tlp_sched *s, const int *cpus);
+
+/**
+ * Start the worker threads on the CPUs of a NUMA node, normally
+ * tlp_numa_device_node() of the device whose channels feed the scheduler
+ *
+ * Worker w runs on the w-th usable CPU of the node, round robin. Without
+ * NUMA information (node -1) the workers spread the same way over every
+ * CPU the caller may use.
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_sched_start_node(struct tlp_sched *s, int node);
+
+/**
+ * Queue descriptors for a function. Each function must have a single
+ * submitting thread, e.g. the poller of its channel.
+ * @return: descriptors queued, fewer than n when the function queue is full
+ */
+uint32_t tlp_sched_submit(struct tlp_sched *s, uint32_t func, const struct tlp_desc *d, uint32_t n);
+
+/**
+ * Wait until everything submitted was handled, then stop the workers
+ */
+void tlp_sched_stop(struct tlp_sched *s);
+void tlp_sched_destroy(struct tlp_sched *s);
+
+const struct tlp_sched_stats *tlp_sched_worker_stats(const struct tlp_sched *s, uint32_t worker);
+
+#endif /* TLP_SCHED_H */
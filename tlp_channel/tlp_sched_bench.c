@@ -0,0 +1,335 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel scheduler benchmark - one poller spreads a Zipf distributed
+ * stream of TLPs over many emulated functions, worker threads run the
+ * device model through tlp_sched.h with work stealing or with static
+ * sharding (function modulo workers). Every run checks that each function
+ * saw its TLPs once and in order and that no function ran on two workers
+ * at once. Reported are throughput and the share of the work done by the
+ * busiest worker, which bounds the speedup on that many cores, next to the
+ * least share each policy allows on the stream. With fewer CPUs than
+ * workers the measured share follows time slicing.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "tlp_bench.h"
+#include "tlp_sched.h"
+
+// CPUs of the device's node, the poller keeps the first
+static int ncpus, cpu_node, cpus[TLP_NUMA_MAX_CPUS];
+
+/*
+ * Function number of each TLP: rank k is drawn with weight 1/(k+1)^skew,
+ * ranks are shuffled over function numbers so hot functions land on
+ * arbitrary static shards.
+ */
+static uint32_t *zipf_stream(uint32_t nfuncs, double skew, uint32_t n, uint64_t seed)
+{
+    double *cdf = malloc(nfuncs * sizeof(*cdf)), sum = 0;
+    uint32_t *perm = malloc(nfuncs * sizeof(*perm));
+    uint32_t *out = malloc((size_t)n * sizeof(*out));
+
+    if (!cdf || !perm || !out) {
+        free(out);
+        out = NULL;
+        goto out;
+    }
+    for (uint32_t k = 0; k < nfuncs; k++) {
+        sum += 1.0 / pow(k + 1, skew);
+        cdf[k] = sum;
+        perm[k] = k;
+    }
+    for (uint32_t k = nfuncs - 1; k > 0; k--) {
+        uint32_t j = rnd(&seed) % (k + 1), t = perm[k];
+
+        perm[k] = perm[j];
+        perm[j] = t;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        double u = (rnd(&seed) + 0.5) / 2147483648.0 * sum;
+        uint32_t lo = 0, hi = nfuncs - 1;
+
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        out[i] = perm[lo];
+    }
+out:
+    free(cdf);
+    free(perm);
+    return out;
+}
+
+/*
+ * Device model state of one function
+ */
+struct func_state {
+    uint32_t    next;               // Expected cookie
+    uint32_t    busy;               // Set while a worker runs the function
+    uint32_t    errors;
+    uint64_t    sum;
+} __attribute__((aligned(64)));
+
+struct model {
+    struct func_state   *funcs;
+    uint32_t            work;       // Mixing rounds per TLP
+};
+
+static void handle(void *arg, uint32_t func, const struct tlp_desc *d, uint32_t n, uint32_t worker)
+{
+    struct model *m = arg;
+    struct func_state *f = &m->funcs[func];
+
+    (void)worker;
+    if (__atomic_exchange_n(&f->busy, 1, __ATOMIC_ACQUIRE))
+        f->errors++;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t h = f->sum ^ d[i].addr;
+
+        f->errors += d[i].cookie != f->next++ || d[i].target != func;
+        for (uint32_t k = 0; k < m->work; k++)
+            h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ull;
+        f->sum = h;
+    }
+    clobber(&f->sum);
+    __atomic_store_n(&f->busy, 0, __ATOMIC_RELEASE);
+}
+
+struct result {
+    double      tlps_per_sec;
+    double      busiest;            // Busiest worker's share of all TLPs
+    uint64_t    steals;
+    uint32_t    errors;
+};
+
+static int run(const uint32_t *stream, uint32_t n, uint32_t nfuncs, uint32_t nworkers, int steal_on,
+               uint32_t queue_size, uint32_t work, struct result *res)
+{
+    struct model m = { .work = work };
+    uint32_t *gen = calloc(nfuncs, sizeof(*gen)), spins = 0;
+    int wcpus[TLP_SCHED_WORKERS_MAX], ret = -1;
+    struct tlp_sched *s = NULL;
+    uint64_t max_descs = 0;
+    double t0;
+
+    m.funcs = aligned_alloc(64, (size_t)nfuncs * sizeof(*m.funcs));
+    if (!gen || !m.funcs)
+        goto out;
+    memset(m.funcs, 0, (size_t)nfuncs * sizeof(*m.funcs));
+    memset(res, 0, sizeof(*res));
+
+    s = tlp_sched_create(nfuncs, nworkers, queue_size, steal_on, handle, &m);
+    if (!s)
+        goto out;
+    // The poller keeps the node's first CPU, workers spread over the others
+    pin_cpu(cpus[0]);
+    for (uint32_t w = 0; w < nworkers; w++)
+        wcpus[w] = cpus[ncpus > 1 ? 1 + w % (ncpus - 1) : 0];
+    if (tlp_sched_start(s, wcpus))
+        goto out;
+
+    t0 = now_sec();
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t func = stream[i];
+        struct tlp_desc d = { .addr = i, .cookie = gen[func], .target = func };
+
+        while (!tlp_sched_submit(s, func, &d, 1)) {
+            // Function queue full: give the workers the CPU
+            if (++spins >= 64) {
+                spins = 0;
+                sched_yield();
+            }
+        }
+        gen[func]++;
+    }
+    tlp_sched_stop(s);
+    res->tlps_per_sec = n / (now_sec() - t0);
+
+    for (uint32_t w = 0; w < nworkers; w++) {
+        const struct tlp_sched_stats *st = tlp_sched_worker_stats(s, w);
+
+        if (st->descs > max_descs)
+            max_descs = st->descs;
+        res->steals += st->steals;
+    }
+    res->busiest = (double)max_descs / n;
+    for (uint32_t f = 0; f < nfuncs; f++)
+        res->errors += m.funcs[f].errors + (m.funcs[f].next != gen[f]);
+    ret = 0;
+out:
+    tlp_sched_destroy(s);
+    free(m.funcs);
+    free(gen);
+    return ret;
+}
+
+/*
+ * Least busiest share each policy allows for this stream, whatever the
+ * timing: the largest static shard, or for stealing the hottest function
+ * (its TLPs stay on one worker at a time) but no less than an even split.
+ */
+static double busiest_bound(const uint32_t *stream, uint32_t n, uint32_t nfuncs, uint32_t nworkers, int steal_on)
+{
+    uint64_t *count = calloc(nfuncs + nworkers, sizeof(*count)), *shard = count + nfuncs, max = 0;
+
+    if (!count)
+        return 0;
+    for (uint32_t i = 0; i < n; i++)
+        count[stream[i]]++;
+    for (uint32_t f = 0; f < nfuncs; f++) {
+        shard[f % nworkers] += count[f];
+        if (steal_on && count[f] > max)
+            max = count[f];
+    }
+    for (uint32_t w = 0; w < nworkers && !steal_on; w++)
+        if (shard[w] > max)
+            max = shard[w];
+    free(count);
+    if (steal_on && max * nworkers < n)
+        return 1.0 / nworkers;
+    return (double)max / n;
+}
+
+// Records the CPU each worker ran on
+static void where(void *arg, uint32_t func, const struct tlp_desc *d, uint32_t n, uint32_t worker)
+{
+    int *ran_on = arg;
+
+    (void)func;
+    (void)d;
+    (void)n;
+    __atomic_store_n(&ran_on[worker], sched_getcpu(), __ATOMIC_RELAXED);
+}
+
+// tlp_sched_start_node() keeps every worker on the node's CPUs
+static int suite_node(void)
+{
+    int ran_on[8] = { -1, -1, -1, -1, -1, -1, -1, -1 }, node_cpus[TLP_NUMA_MAX_CPUS], n, wrong = 0;
+    // Static sharding, so every worker gets functions of its own
+    struct tlp_sched *s = tlp_sched_create(64, 8, 64, 0, where, ran_on);
+
+    n = tlp_numa_thread_cpus(cpu_node, node_cpus, TLP_NUMA_MAX_CPUS);
+    if (!s || n <= 0 || tlp_sched_start_node(s, cpu_node)) {
+        tlp_sched_destroy(s);
+        printf("✗ workers on node %d: setup failed\n", cpu_node);
+        return -1;
+    }
+    for (uint32_t r = 0; r < 64; r++)
+        for (uint32_t f = 0; f < 64; f++) {
+            struct tlp_desc d = { .target = f };
+
+            while (!tlp_sched_submit(s, f, &d, 1))
+                sched_yield();
+        }
+    tlp_sched_stop(s);
+    for (uint32_t w = 0; w < 8; w++) {
+        int on_node = 0;
+
+        for (int k = 0; k < n; k++)
+            on_node |= node_cpus[k] == ran_on[w];
+        wrong += !on_node;
+    }
+    tlp_sched_destroy(s);
+    printf("%s 8 workers started on node %d run on its %d CPUs\n", wrong ? "✗" : "✓", cpu_node, n);
+    return wrong ? -1 : 0;
+}
+
+static int suite(void)
+{
+    static const struct {
+        uint32_t    nfuncs;
+        uint32_t    workers;
+        uint32_t    queue_size;
+        double      skew;
+    } cases[] = {
+        { 1, 4, 4, 0 },             // One function: never on two workers
+        { 16, 4, 4, 1.2 },          // Full function queues, constant requeueing
+        { 256, 8, 64, 1.0 },
+        { 1024, 3, 256, 0.6 },
+    };
+    const uint32_t n = 200000;
+    int ret = 0;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint32_t *stream = zipf_stream(cases[c].nfuncs, cases[c].skew, n, 11 + c);
+
+        if (!stream)
+            return -1;
+        for (int st = 0; st < 2; st++) {
+            struct result res;
+            int failed = run(stream, n, cases[c].nfuncs, cases[c].workers, st, cases[c].queue_size, 4, &res);
+
+            printf("%s %u functions, %u workers, %u-entry queues, %s: %s\n",
+                   !failed && !res.errors ? "✓" : "✗", cases[c].nfuncs, cases[c].workers, cases[c].queue_size,
+                   st ? "stealing" : "static",
+                   failed ? "setup failed" : res.errors ? "lost, reordered or concurrent TLPs" : "all in order");
+            if (failed || res.errors)
+                ret = -1;
+        }
+        free(stream);
+        if (ret)
+            break;
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = argc > 1 ? strtoul(argv[1], NULL, 0) : 2000000;
+    uint32_t nfuncs = argc > 2 ? strtoul(argv[2], NULL, 0) : 1024;
+    uint32_t work = argc > 3 ? strtoul(argv[3], NULL, 0) : 64;
+    static const double skews[] = { 0, 0.8, 1.1 };
+    static const uint32_t workers[] = { 1, 2, 4, 8 };
+
+    ncpus = bench_cpus(&cpu_node, cpus, TLP_NUMA_MAX_CPUS);
+
+    printf("TLP Scheduler Benchmark\n");
+    printf("=======================\n");
+    printf("Usage: %s [tlps] [functions] [work_rounds]\n\n", argv[0]);
+
+    printf("Suite:\n");
+    if (suite_node() || suite())
+        return 1;
+
+    printf("\n%u TLPs over %u functions, %u mixing rounds per TLP, %d CPUs %s\n", n, nfuncs, work, ncpus,
+           cpu_node >= 0 ? "on the device's node" : "(no device node)");
+    printf("  Busiest: share of the TLPs handled by the busiest worker, 1/workers is even\n");
+    printf("  Bound: least busiest share the policy allows on this stream\n");
+    printf("  %-5s %7s %-8s %12s %9s %9s %9s\n", "Zipf", "Workers", "Sched", "TLP/s", "Busiest", "Bound",
+           "Steals");
+    for (size_t z = 0; z < sizeof(skews) / sizeof(skews[0]); z++) {
+        uint32_t *stream = zipf_stream(nfuncs, skews[z], n, 42);
+
+        if (!stream)
+            return 1;
+        for (size_t w = 0; w < sizeof(workers) / sizeof(workers[0]); w++) {
+            for (int st = 0; st < 2; st++) {
+                struct result res;
+
+                if (run(stream, n, nfuncs, workers[w], st, 256, work, &res) || res.errors) {
+                    printf("  %-5.1f %7u %-8s failed\n", skews[z], workers[w], st ? "stealing" : "static");
+                    continue;
+                }
+                printf("  %-5.1f %7u %-8s %10.2f M %8.1f%% %8.1f%% %9lu\n", skews[z], workers[w],
+                       st ? "stealing" : "static", res.tlps_per_sec / 1e6, res.busiest * 100,
+                       busiest_bound(stream, n, nfuncs, workers[w], st) * 100, res.steals);
+            }
+        }
+        free(stream);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - steering of decoded TLPs to per-core queues.
+ * The poller is the producer of every queue. A bucket moved to another
+ * queue switches only once the old queue's consumer passed the bucket's
+ * last TLP there, the same check receive flow steering makes before it
+ * moves a flow to another CPU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlp_steer.h"
+
+struct tlp_steer {
+    uint32_t            nqueues;
+    enum tlp_steer_key  key;
+    struct tlp_spsc     *q[TLP_STEER_QUEUES_MAX];
+    uint8_t             want[TLP_STEER_BUCKETS];    // Written by tlp_steer_set()
+    uint8_t             cur[TLP_STEER_BUCKETS];     // Queue the poller steers to
+    uint32_t            last[TLP_STEER_BUCKETS];    // Position after the bucket's last TLP in cur
+    uint64_t            steered;
+    uint64_t            moves;
+    // One push: rows staged per queue and queues in order of first use
+    uint32_t            room[TLP_STEER_QUEUES_MAX];
+    uint32_t            staged[TLP_STEER_QUEUES_MAX];
+    uint8_t             touched[TLP_STEER_QUEUES_MAX];
+    uint8_t             in_push[TLP_STEER_QUEUES_MAX];
+    uint16_t            rows[TLP_STEER_QUEUES_MAX][TLP_BATCH_MAX];
+};
+
+struct tlp_steer *tlp_steer_create(uint32_t nqueues, uint32_t queue_size, enum tlp_steer_key key)
+{
+    struct tlp_steer *s;
+
+    if (!nqueues || nqueues > TLP_STEER_QUEUES_MAX) {
+        fprintf(stderr, "Invalid steering queue count %u\n", nqueues);
+        return NULL;
+    }
+    s = aligned_alloc(64, sizeof(*s));
+    if (!s)
+        return NULL;
+    memset(s, 0, sizeof(*s));
+    s->nqueues = nqueues;
+    s->key = key;
+    for (uint32_t q = 0; q < nqueues; q++) {
+        s->q[q] = tlp_spsc_create(queue_size);
+        if (!s->q[q]) {
+            tlp_steer_destroy(s);
+            return NULL;
+        }
+    }
+    for (uint32_t b = 0; b < TLP_STEER_BUCKETS; b++)
+        s->want[b] = s->cur[b] = b % nqueues;
+    return s;
+}
+
+void tlp_steer_destroy(struct tlp_steer *s)
+{
+    if (!s)
+        return;
+    for (uint32_t q = 0; q < s->nqueues; q++)
+        tlp_spsc_destroy(s->q[q]);
+    free(s);
+}
+
+struct tlp_spsc *tlp_steer_queue(struct tlp_steer *s, uint32_t queue)
+{
+    return queue < s->nqueues ? s->q[queue] : NULL;
+}
+
+/*
+ * The old queue consumed everything the bucket put there: its last TLP is
+ * not between tail and head, counting rows staged by the current push
+ */
+static inline int bucket_quiet(const struct tlp_steer *s, uint32_t b)
+{
+    const struct tlp_spsc *q = s->q[s->cur[b]];
+    uint32_t head = q->head + s->staged[s->cur[b]];
+
+    return head - s->last[b] >= head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t bucket_queue(struct tlp_steer *s, uint32_t b)
+{
+    uint8_t want = __atomic_load_n(&s->want[b], __ATOMIC_RELAXED);
+
+    if (want != s->cur[b] && bucket_quiet(s, b)) {
+        s->cur[b] = want;
+        s->moves++;
+    }
+    return s->cur[b];
+}
+
+uint32_t tlp_steer_push_batch(struct tlp_steer *s, const struct tlp_batch *batch, uint32_t first,
+                              uint32_t count, uint16_t channel, uint32_t cookie)
+{
+    uint32_t ntouched = 0, n;
+
+    for (n = 0; n < count; n++) {
+        uint32_t row = first + n;
+        uint16_t key = s->key == TLP_STEER_REQUESTER ? batch->requester[row] : batch->target[row];
+        uint32_t b = tlp_steer_bucket(key), qi = bucket_queue(s, b);
+        struct tlp_spsc *q = s->q[qi];
+
+        if (!s->in_push[qi]) {
+            s->in_push[qi] = 1;
+            s->touched[ntouched++] = qi;
+            s->room[qi] = q->size - (q->head - q->tail_cache);
+        }
+        if (s->staged[qi] == s->room[qi]) {
+            // Full by the cached tail, look at the consumer's
+            q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+            s->room[qi] = q->size - (q->head - q->tail_cache);
+            if (s->staged[qi] == s->room[qi])
+                break;
+        }
+        s->rows[qi][s->staged[qi]++] = row;
+        s->last[b] = q->head + s->staged[qi];
+    }
+
+    // Producer side of each SPSC ring, as tlp_spsc_push_batch()
+    for (uint32_t t = 0; t < ntouched; t++) {
+        uint32_t qi = s->touched[t];
+        struct tlp_spsc *q = s->q[qi];
+        uint32_t h = q->head, mask = q->size - 1;
+
+        for (uint32_t k = 0; k < s->staged[qi]; k++) {
+            uint32_t row = s->rows[qi][k];
+
+            tlp_desc_from_batch(&q->slot[(h + k) & mask].d, batch, row, channel, cookie + (row - first));
+        }
+        if (s->staged[qi])
+            __atomic_store_n(&q->head, h + s->staged[qi], __ATOMIC_RELEASE);
+        s->staged[qi] = 0;
+        s->in_push[qi] = 0;
+    }
+    s->steered += n;
+    return n;
+}
+
+int tlp_steer_set(struct tlp_steer *s, uint32_t bucket, uint32_t queue)
+{
+    if (bucket >= TLP_STEER_BUCKETS || queue >= s->nqueues)
+        return -1;
+    __atomic_store_n(&s->want[bucket], queue, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int tlp_steer_spread(struct tlp_steer *s, uint32_t nqueues)
+{
+    if (!nqueues || nqueues > s->nqueues)
+        return -1;
+    for (uint32_t b = 0; b < TLP_STEER_BUCKETS; b++)
+        __atomic_store_n(&s->want[b], b % nqueues, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void tlp_steer_stats(struct tlp_steer *s, struct tlp_steer_stats *stats)
+{
+    stats->steered = s->steered;
+    stats->moves = s->moves;
+    stats->pending = 0;
+    for (uint32_t b = 0; b < TLP_STEER_BUCKETS; b++)
+        stats->pending += __atomic_load_n(&s->want[b], __ATOMIC_RELAXED) != s->cur[b];
+}
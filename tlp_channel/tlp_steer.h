@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel library - steering of decoded TLPs to per-core queues
+ */
+
+#ifndef TLP_STEER_H
+#define TLP_STEER_H
+
+#include <stdint.h>
+
+#include "tlp_ring.h"
+
+#define TLP_STEER_BUCKETS       1024
+#define TLP_STEER_QUEUES_MAX    64
+
+enum tlp_steer_key {
+    TLP_STEER_REQUESTER,            // Requester ID of each TLP
+    TLP_STEER_TARGET,               // Target BDF (config requests, completions)
+};
+
+struct tlp_steer_stats {
+    uint64_t    steered;
+    uint64_t    moves;              // Buckets switched to a new queue
+    uint32_t    pending;            // Buckets waiting for their old queue
+};
+
+struct tlp_steer;
+
+static inline uint32_t tlp_steer_bucket(uint16_t key)
+{
+    return ((uint32_t)key * 0x9e3779b1u) >> 22;
+}
+
+/**
+ * A TLP's key hashes to one of TLP_STEER_BUCKETS buckets and a table maps
+ * buckets to queues, so TLPs with the same key stay in order on one queue.
+ * The poller owns the producer side of every queue, each queue is popped
+ * by one worker (tlp_steer_queue()). Buckets start spread over all queues.
+ * @param queue_size: Entries per queue, power of two
+ * @return: steering stage, NULL on failure
+ */
+struct tlp_steer *tlp_steer_create(uint32_t nqueues, uint32_t queue_size, enum tlp_steer_key key);
+void tlp_steer_destroy(struct tlp_steer *s);
+
+struct tlp_spsc *tlp_steer_queue(struct tlp_steer *s, uint32_t queue);
+
+/**
+ * Steer rows [first, first + count) of a decoded batch, one release store
+ * per queue touched. Poller thread only.
+ * @param cookie: Stored in the first row's descriptor, incremented per row
+ * @return: rows steered; stops at the first row whose queue is full
+ */
+uint32_t tlp_steer_push_batch(struct tlp_steer *s, const struct tlp_batch *batch, uint32_t first,
+                              uint32_t count, uint16_t channel, uint32_t cookie);
+
+/**
+ * Point a bucket at another queue, from any thread and without draining.
+ * The poller switches the bucket once the old queue has consumed the last
+ * TLP steered there, and keeps using the old queue until then, so the
+ * bucket's TLPs are never handled out of order.
+ * @return: 0 on success, -1 on a bad bucket or queue
+ */
+int tlp_steer_set(struct tlp_steer *s, uint32_t bucket, uint32_t queue);
+
+/**
+ * Spread all buckets over queues [0, nqueues), e.g. when cores come or go
+ *
+ * @return: 0 on success, -1 on a bad queue count
+ */
+int tlp_steer_spread(struct tlp_steer *s, uint32_t nqueues);
+
+/**
+ * Poller thread only; pending is counted when called
+ */
+void tlp_steer_stats(struct tlp_steer *s, struct tlp_steer_stats *stats);
+
+#endif /* TLP_STEER_H */
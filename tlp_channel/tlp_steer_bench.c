@@ -0,0 +1,338 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 TLP Channel Test for NVIDIA Firmware
+ *
+ * TLP Channel steering benchmark - a simulated producer fills a channel
+ * queue with TLPs from many requesters, the poller decodes it and steers
+ * every TLP by requester ID to one per-core queue (tlp_steer.h), one
+ * worker thread per queue runs the requester's device model. A suite
+ * checks steering by key, bucket moves and full queues, then checks with
+ * threads that every requester's TLPs are handled once, in order and on
+ * one worker at a time while buckets move. Throughput is reported from
+ * 1 to 16 cores with a fixed table and with buckets moving.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tlp_bench.h"
+#include "tlp_steer.h"
+
+#define RING_QES        4096
+#define CHUNK           64              // QEs decoded per poll
+#define REQUESTERS      256
+#define REQ_BASE        0x0100          // Requester ID of the first function
+
+// CPUs of the device's node, the poller keeps the first
+static int ncpus, cpu_node, cpus[TLP_NUMA_MAX_CPUS];
+
+// MWr 64B from requester REQ_BASE + r
+static void produce_mwr(uint8_t *qe, uint32_t r, uint32_t i)
+{
+    put_be32(qe, 0x60u << 24 | 16);
+    put_be32(qe + 4, (REQ_BASE + r) << 16 | 0xff);
+    put_be32(qe + 8, 0x1);
+    put_be32(qe + 12, (i & 0xffff) * 64);
+}
+
+// CfgRd0 from the root port to function bdf
+static void produce_cfgrd(uint8_t *qe, uint16_t bdf)
+{
+    put_be32(qe, 0x04u << 24 | 1);
+    put_be32(qe + 4, 0x0000u << 16 | 0x0f);
+    put_be32(qe + 8, (uint32_t)bdf << 16 | 0x10);
+}
+
+/*
+ * Single threaded: steering by key, a bucket move waiting for its old
+ * queue, and pushes stopping at a full queue
+ */
+static int suite_steer(void)
+{
+    struct tlp_batch *batch = malloc(sizeof(*batch));
+    uint8_t *qes = calloc(TLP_BATCH_MAX, TLP_QE_SIZE);
+    struct tlp_steer *s = tlp_steer_create(4, 16, TLP_STEER_TARGET);
+    struct tlp_steer_stats st;
+    struct tlp_desc d[16];
+    uint32_t errors = 0, b, from, to, n;
+    int ret = -1;
+
+    if (!batch || !qes || !s)
+        goto out;
+    for (uint32_t i = 0; i < 32; i++)
+        produce_cfgrd(qes + i * TLP_QE_SIZE, 0x0800 + i * 8);
+    tlp_decode_qes(qes, TLP_BATCH_MAX, 0, 32, batch);
+
+    // By target BDF, 8 rows a time so no queue fills
+    for (uint32_t first = 0; first < 32; first += 8) {
+        errors += tlp_steer_push_batch(s, batch, first, 8, 0, first) != 8;
+        for (uint32_t q = 0; q < 4; q++) {
+            n = tlp_spsc_pop(tlp_steer_queue(s, q), d, 16);
+            for (uint32_t k = 0; k < n; k++)
+                errors += tlp_steer_bucket(d[k].target) % 4 != q || d[k].target != 0x0800 + d[k].cookie * 8;
+        }
+    }
+
+    // Move row 0's bucket while one of its TLPs is queued: it stays until that one is consumed
+    b = tlp_steer_bucket(batch->target[0]);
+    from = b % 4;
+    to = (from + 1) % 4;
+    errors += tlp_steer_push_batch(s, batch, 0, 1, 0, 100) != 1;
+    errors += tlp_steer_set(s, b, to) != 0;
+    errors += tlp_steer_push_batch(s, batch, 0, 1, 0, 101) != 1;
+    tlp_steer_stats(s, &st);
+    errors += st.moves != 0 || st.pending != 1;
+    errors += tlp_spsc_pop(tlp_steer_queue(s, from), d, 16) != 2 || d[0].cookie != 100 || d[1].cookie != 101;
+    errors += tlp_steer_push_batch(s, batch, 0, 1, 0, 102) != 1;
+    tlp_steer_stats(s, &st);
+    errors += st.moves != 1 || st.pending != 0;
+    errors += tlp_spsc_pop(tlp_steer_queue(s, to), d, 16) != 1 || d[0].cookie != 102;
+    errors += tlp_steer_set(s, TLP_STEER_BUCKETS, 0) != -1 || tlp_steer_set(s, 0, 4) != -1;
+
+    // One bucket, a 16-entry queue: a push stops at the first row that does not fit
+    for (uint32_t i = 0; i < 32; i++)
+        produce_cfgrd(qes + i * TLP_QE_SIZE, 0x0800);
+    tlp_decode_qes(qes, TLP_BATCH_MAX, 0, 32, batch);
+    errors += tlp_steer_push_batch(s, batch, 0, 32, 0, 0) != 16;
+    errors += tlp_steer_push_batch(s, batch, 16, 16, 0, 16) != 0;
+    n = tlp_spsc_pop(tlp_steer_queue(s, to), d, 16);
+    errors += n != 16 || d[0].cookie != 0 || d[15].cookie != 15;
+    errors += tlp_steer_push_batch(s, batch, 16, 16, 0, 16) != 16;
+    ret = errors ? -1 : 0;
+out:
+    printf("%s steering by target BDF, bucket move behind a queued TLP, full queue\n", ret ? "✗" : "✓");
+    tlp_steer_destroy(s);
+    free(batch);
+    free(qes);
+    return ret;
+}
+
+/*
+ * Device model state of one requester
+ */
+struct req_state {
+    uint32_t    next;               // Lowest cookie still to come
+    uint32_t    busy;
+    uint32_t    errors;
+    uint32_t    count;
+    uint64_t    sum;
+} __attribute__((aligned(64)));
+
+struct run {
+    struct tlp_steer    *steer;
+    struct req_state    *reqs;
+    uint32_t            work;       // Mixing rounds per TLP
+    uint32_t            stop;
+};
+
+struct worker {
+    struct run          *run;
+    uint32_t            id;
+    int                 cpu;
+    pthread_t           thread;
+};
+
+static void *worker_main(void *arg)
+{
+    struct worker *w = arg;
+    struct run *run = w->run;
+    struct tlp_spsc *q = tlp_steer_queue(run->steer, w->id);
+    struct tlp_desc d[32];
+    uint32_t spins = 0;
+
+    pin_cpu(w->cpu);
+    for (;;) {
+        int stop = __atomic_load_n(&run->stop, __ATOMIC_ACQUIRE);
+        uint32_t n = tlp_spsc_pop(q, d, 32);
+
+        if (!n) {
+            if (stop)
+                break;
+            backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            struct req_state *r = &run->reqs[(uint16_t)(d[i].requester - REQ_BASE) % REQUESTERS];
+            uint64_t h = r->sum ^ d[i].addr;
+
+            if (__atomic_exchange_n(&r->busy, 1, __ATOMIC_ACQUIRE))
+                r->errors++;
+            r->errors += d[i].cookie < r->next;
+            r->next = d[i].cookie + 1;
+            r->count++;
+            for (uint32_t k = 0; k < run->work; k++)
+                h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ull;
+            r->sum = h;
+            __atomic_store_n(&r->busy, 0, __ATOMIC_RELEASE);
+        }
+        clobber(run->reqs);
+    }
+    return NULL;
+}
+
+/*
+ * Poll total TLPs from the simulated producer's ring with nqueues workers.
+ * move_every > 0 moves 16 random buckets every move_every polls and every
+ * 64th move shrinks or regrows the spread.
+ */
+static double run_steer(const uint8_t *ring, uint64_t total, uint32_t nqueues, uint32_t queue_size, uint32_t work,
+                        uint32_t move_every, uint32_t *errors, uint64_t *moves)
+{
+    struct tlp_batch *batch = malloc(sizeof(*batch));
+    struct run run = { .work = work };
+    struct worker w[TLP_STEER_QUEUES_MAX];
+    uint32_t gen[REQUESTERS] = { 0 }, spins = 0, polls = 0, started = 0;
+    struct tlp_steer_stats st;
+    uint64_t seed = 5 + nqueues, seq = 0;
+    double t = -1;
+
+    *errors = 0;
+    run.steer = tlp_steer_create(nqueues, queue_size, TLP_STEER_REQUESTER);
+    run.reqs = aligned_alloc(64, REQUESTERS * sizeof(*run.reqs));
+    if (!batch || !run.steer || !run.reqs)
+        goto out;
+    memset(run.reqs, 0, REQUESTERS * sizeof(*run.reqs));
+
+    // The poller keeps the node's first CPU, workers go on the next ones
+    pin_cpu(cpus[0]);
+    for (; started < nqueues; started++) {
+        w[started].run = &run;
+        w[started].id = started;
+        w[started].cpu = cpus[ncpus > 1 ? 1 + started % (ncpus - 1) : 0];
+        if (pthread_create(&w[started].thread, NULL, worker_main, &w[started]))
+            break;
+    }
+    if (started < nqueues)
+        goto stop;
+
+    t = now_sec();
+    while (seq < total) {
+        uint32_t n = total - seq < CHUNK ? total - seq : CHUNK;
+
+        tlp_decode_qes(ring, RING_QES, seq % RING_QES, n, batch);
+        for (uint32_t done = 0; done < n; ) {
+            uint32_t k = tlp_steer_push_batch(run.steer, batch, done, n - done, 0, seq + done);
+
+            if (k) {
+                done += k;
+                spins = 0;
+            } else {
+                backoff(&spins);
+            }
+        }
+        for (uint32_t i = 0; i < n; i++)
+            gen[(uint16_t)(batch->requester[i] - REQ_BASE) % REQUESTERS]++;
+        seq += n;
+
+        if (move_every && ++polls % move_every == 0) {
+            if (polls / move_every % 64 == 0) {
+                tlp_steer_spread(run.steer, polls / move_every % 128 ? 1 + rnd(&seed) % nqueues : nqueues);
+            } else {
+                for (uint32_t k = 0; k < 16; k++)
+                    tlp_steer_set(run.steer, rnd(&seed) % TLP_STEER_BUCKETS, rnd(&seed) % nqueues);
+            }
+        }
+    }
+stop:
+    __atomic_store_n(&run.stop, 1, __ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < started; i++)
+        pthread_join(w[i].thread, NULL);
+    if (t >= 0)
+        t = now_sec() - t;
+    if (started < nqueues)
+        t = -1;
+    tlp_steer_stats(run.steer, &st);
+    *moves = st.moves;
+    for (uint32_t r = 0; r < REQUESTERS; r++)
+        *errors += run.reqs[r].errors + (run.reqs[r].count != gen[r]);
+out:
+    tlp_steer_destroy(run.steer);
+    free(run.reqs);
+    free(batch);
+    return t;
+}
+
+static int suite_threads(const uint8_t *ring)
+{
+    static const struct {
+        uint32_t    nqueues;
+        uint32_t    queue_size;
+        uint32_t    move_every;
+    } cases[] = {
+        { 4, 64, 1 },               // Constant moves, queues often full
+        { 16, 256, 4 },
+        { 3, 1024, 16 },
+    };
+    int ret = 0;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint32_t errors;
+        uint64_t moves;
+        double t = run_steer(ring, 1000000, cases[c].nqueues, cases[c].queue_size, 4, cases[c].move_every,
+                             &errors, &moves);
+
+        printf("%s %u queues of %u, buckets moving every %u polls (%lu moves): %s\n",
+               t >= 0 && !errors ? "✓" : "✗", cases[c].nqueues, cases[c].queue_size, cases[c].move_every, moves,
+               t < 0 ? "setup failed" : errors ? "lost, reordered or concurrent TLPs" : "all in order");
+        if (t < 0 || errors)
+            ret = -1;
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t total = argc > 1 ? strtoull(argv[1], NULL, 0) : 4000000;
+    uint32_t work = argc > 2 ? strtoul(argv[2], NULL, 0) : 64;
+    static const uint32_t cores[] = { 1, 2, 4, 8, 16 };
+    uint8_t *ring = aligned_alloc(64, RING_QES * TLP_QE_SIZE);
+    double base[2] = { 0, 0 };
+    uint64_t seed = 3;
+
+    ncpus = bench_cpus(&cpu_node, cpus, TLP_NUMA_MAX_CPUS);
+
+    printf("TLP Steering Benchmark\n");
+    printf("======================\n");
+    printf("Usage: %s [tlps] [work_rounds]\n\n", argv[0]);
+
+    if (!ring)
+        return 1;
+    // Simulated producer: MWr from requesters picked at random
+    for (uint32_t i = 0; i < RING_QES; i++)
+        produce_mwr(ring + i * TLP_QE_SIZE, rnd(&seed) % REQUESTERS, i);
+
+    printf("Suite:\n");
+    if (suite_steer() || suite_threads(ring)) {
+        free(ring);
+        return 1;
+    }
+
+    printf("\n%lu TLPs from %u requesters, %u mixing rounds per TLP, %d CPUs %s\n", total, REQUESTERS, work,
+           ncpus, cpu_node >= 0 ? "on the device's node" : "(no device node)");
+    printf("  Moving: 16 buckets move every 16 polls of %u TLPs\n", CHUNK);
+    printf("  %-5s %-7s %12s %9s %9s\n", "Cores", "Table", "TLP/s", "Scaling", "Moves");
+    for (size_t c = 0; c < sizeof(cores) / sizeof(cores[0]); c++) {
+        for (int moving = 0; moving < 2; moving++) {
+            uint32_t errors;
+            uint64_t moves;
+            double t = run_steer(ring, total, cores[c], 1024, work, moving ? 16 : 0, &errors, &moves);
+
+            if (t <= 0 || errors) {
+                printf("  %-5u %-7s failed\n", cores[c], moving ? "moving" : "fixed");
+                continue;
+            }
+            if (!base[moving])
+                base[moving] = total / t;
+            printf("  %-5u %-7s %10.2f M %8.2fx %9lu\n", cores[c], moving ? "moving" : "fixed", total / t / 1e6,
+                   total / t / base[moving], moves);
+        }
+    }
+    free(ring);
+    return 0;
+}
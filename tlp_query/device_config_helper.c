@@ -10,9 +10,11 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
-#include <unistd.h>
 
 #include "mlx5_ifc.h"
+#include "tlp_cmd.h"
+#include "tlp_emu_funcs.h"
+#include "tlp_inventory.h"
 
 // 常量定义
 #define MLX5_CMD_OPCODE_QUERY_EMULATED_FUNCTIONS_INFO 0xb03
@@ -26,23 +28,15 @@ int complete_device_activation_and_vuid_query(struct ibv_context *ctx) {
     // 步骤1: 检查设备状态
     printf("\n📋 步骤1: 检查设备当前状态\n");
     
-    struct {
-        uint32_t opcode_uid;
-        uint32_t reserved[7];
-    } hca_cap_cmd = {
-        .opcode_uid = htobe32((MLX5_CMD_OP_QUERY_HCA_CAP << 16) | 0),
-    };
+    uint8_t hca_cap_cmd[TLP_CMD_QUERY_HCA_CAP_IN_SZ];
+    uint8_t hca_cap_out[TLP_CMD_QUERY_HCA_CAP_OUT_SZ] = {0};
     
-    struct {
-        uint32_t status_syndrome;
-        uint32_t syndrome;
-        uint32_t reserved[30];
-    } hca_cap_out = {0};
+    tlp_cmd_query_hca_cap_in(hca_cap_cmd, 0, 0, 0);
     
-    int ret = mlx5dv_devx_general_cmd(ctx, &hca_cap_cmd, sizeof(hca_cap_cmd), 
-                                      &hca_cap_out, sizeof(hca_cap_out));
+    int ret = mlx5dv_devx_general_cmd(ctx, hca_cap_cmd, sizeof(hca_cap_cmd), 
+                                      hca_cap_out, sizeof(hca_cap_out));
     
-    if (ret == 0 && (hca_cap_out.status_syndrome >> 24) == 0) {
+    if (ret == 0 && tlp_cmd_query_hca_cap_out_status(hca_cap_out) == 0) {
         printf("✅ 设备HCA能力查询成功\n");
     } else {
         printf("⚠️  设备HCA能力查询失败，但继续\n");
@@ -51,26 +45,14 @@ int complete_device_activation_and_vuid_query(struct ibv_context *ctx) {
     // 步骤2: 尝试查询ESW functions (可能有助于激活)
     printf("\n📋 步骤2: 查询ESW Functions\n");
     
-    struct {
-        uint32_t opcode_uid;
-        uint32_t reserved1;
-        uint32_t reserved2;
-        uint32_t op_mod;
-        uint32_t reserved3[4];
-    } esw_cmd = {
-        .opcode_uid = htobe32((MLX5_CMD_OP_QUERY_ESW_FUNCTIONS << 16) | 0),
-        .op_mod = htobe32(0),
-    };
-    
-    struct {
-        uint32_t status_syndrome;
-        uint32_t syndrome;
-        uint32_t reserved[30];
-    } esw_out = {0};
-    
-    ret = mlx5dv_devx_general_cmd(ctx, &esw_cmd, sizeof(esw_cmd), &esw_out, sizeof(esw_out));
-    
-    if (ret == 0 && (esw_out.status_syndrome >> 24) == 0) {
+    uint8_t esw_cmd[TLP_CMD_QUERY_ESW_FUNCTIONS_IN_SZ];
+    uint8_t esw_out[TLP_CMD_QUERY_ESW_FUNCTIONS_OUT_SZ] = {0};
+    
+    tlp_cmd_query_esw_functions_in(esw_cmd, 0);
+    
+    ret = mlx5dv_devx_general_cmd(ctx, esw_cmd, sizeof(esw_cmd), esw_out, sizeof(esw_out));
+    
+    if (ret == 0 && tlp_cmd_query_esw_functions_out_status(esw_out) == 0) {
         printf("✅ ESW Functions查询成功\n");
     } else {
         printf("⚠️  ESW Functions查询失败: %s\n", strerror(errno));
@@ -79,162 +61,45 @@ int complete_device_activation_and_vuid_query(struct ibv_context *ctx) {
     // 步骤3: 执行TLP_DEVICES查询
     printf("\n📋 步骤3: 执行TLP_DEVICES查询\n");
     
-    struct {
-        uint16_t opcode;
-        uint16_t uid;
-        uint16_t reserved1;
-        uint16_t op_mod;
-        uint32_t reserved2;
-        uint16_t reserved3;
-        uint16_t pf_vhca_id;
-    } tlp_cmd = {
-        .opcode = htobe16(MLX5_CMD_OPCODE_QUERY_EMULATED_FUNCTIONS_INFO),
-        .uid = htobe16(0),
-        .op_mod = htobe16(PRM_EMULATION_OPMOD_TLP_DEVICES),
-        .pf_vhca_id = htobe16(0),
-    };
-    
-    struct {
-        uint8_t  status;
-        uint8_t  reserved0[3];
-        uint32_t syndrome;
-        uint8_t  raw_data[256];
-    } tlp_out = {0};
-    
-    ret = mlx5dv_devx_general_cmd(ctx, &tlp_cmd, sizeof(tlp_cmd), &tlp_out, sizeof(tlp_out));
-    
-    if (ret != 0 || tlp_out.status != 0) {
+    struct tlp_emu_function_list tlp_funcs;
+    
+    ret = tlp_emu_funcs_query(ctx, PRM_EMULATION_OPMOD_TLP_DEVICES, 0, &tlp_funcs);
+    
+    if (ret != 0) {
         printf("❌ TLP_DEVICES查询失败\n");
         return -1;
     }
     
-    printf("✅ TLP_DEVICES查询成功\n");
+    printf("✅ TLP_DEVICES查询成功: %u 个功能\n", tlp_funcs.count);
     
-    // 分析TLP_DEVICES输出
-    printf("原始数据: ");
-    for (int i = 8; i < 24; i++) {
-        printf("%02x ", tlp_out.raw_data[i]);
-    }
-    printf("\n");
+    // 步骤4: 按返回的VHCA ID查询VUID, 每个功能一次
+    printf("\n📋 步骤4: 建立VUID清单\n");
     
-    // 步骤4: 尝试多种VUID查询方法
-    printf("\n📋 步骤4: 尝试高级VUID查询方法\n");
+    struct tlp_inventory inventory;
+    int resolved = tlp_inventory_build(ctx, &inventory, &tlp_funcs, 1);
+    tlp_emu_funcs_free(&tlp_funcs);
     
-    // 候选VHCA ID基于TLP_DEVICES输出
-    uint16_t vhca_candidates[] = {3, 5, 0, 144, 20};
-    int num_candidates = sizeof(vhca_candidates) / sizeof(vhca_candidates[0]);
+    if (resolved < 0) {
+        printf("❌ 建立VUID清单失败\n");
+        return -1;
+    }
     
-    for (int i = 0; i < num_candidates; i++) {
-        uint16_t vhca_id = vhca_candidates[i];
-        
-        printf("\n🎯 测试 VHCA ID: 0x%04x (%d)\n", vhca_id, vhca_id);
-        
-        // 方法A: 标准VUID查询
-        struct {
-            uint32_t opcode_uid;
-            uint32_t reserved1[2];
-            uint32_t vhca_id_field;
-            uint32_t reserved2[4];
-        } vuid_cmd_a = {
-            .opcode_uid = htobe32((MLX5_CMD_OP_QUERY_VUID << 16) | 0),
-            .vhca_id_field = htobe32(vhca_id),
-        };
-        
-        struct {
-            uint32_t status_syndrome;
-            uint32_t syndrome;
-            uint32_t reserved[24];
-            uint32_t reserved2;
-            uint32_t num_entries;
-            char vuid_data[512];
-        } vuid_out_a = {0};
+    for (uint32_t i = 0; i < inventory.count; i++) {
+        const struct tlp_inventory_entry *entry = &inventory.entries[i];
         
-        ret = mlx5dv_devx_general_cmd(ctx, &vuid_cmd_a, sizeof(vuid_cmd_a), 
-                                      &vuid_out_a, sizeof(vuid_out_a));
-        
-        if (ret == 0 && (vuid_out_a.status_syndrome >> 24) == 0) {
-            uint32_t num_entries = be32toh(vuid_out_a.num_entries);
-            printf("  方法A: ✅ 成功 - %u VUID条目\n", num_entries);
-            
-            if (num_entries > 0) {
-                printf("  🎊 找到VUID数据!\n");
-                
-                // 搜索有效的VUID字符串
-                for (int offset = 0; offset < 256; offset += 128) {
-                    char vuid_str[129];
-                    memset(vuid_str, 0, sizeof(vuid_str));
-                    memcpy(vuid_str, vuid_out_a.vuid_data + offset, 128);
-                    
-                    // 查找可打印字符串
-                    int start = -1, end = -1;
-                    for (int j = 0; j < 128; j++) {
-                        if (vuid_str[j] >= 32 && vuid_str[j] <= 126) {
-                            if (start == -1) start = j;
-                            end = j;
-                        }
-                    }
-                    
-                    if (start >= 0 && end - start > 8) {
-                        vuid_str[end + 1] = '\0';
-                        printf("  📝 VUID发现: '%s'\n", vuid_str + start);
-                        
-                        if (strstr(vuid_str + start, "MT2334") != NULL) {
-                            printf("  🎉 SUCCESS! 找到预期的VUID!\n");
-                            printf("  ✅ VHCA ID 0x%04x 是正确的设备VHCA ID\n", vhca_id);
-                            return 0;
-                        }
-                    }
-                }
-                
-                // 显示原始数据用于调试
-                printf("  📊 原始数据: ");
-                for (int k = 0; k < 64; k++) {
-                    printf("%02x ", (uint8_t)vuid_out_a.vuid_data[k]);
-                    if ((k + 1) % 16 == 0) printf("\n                ");
-                }
-                printf("\n");
-            }
+        printf("\n🎯 VHCA ID: 0x%04x (%d)\n", entry->fn.vhca_id, entry->fn.vhca_id);
+        if (entry->vuid_valid) {
+            printf("  📝 VUID: '%s'\n", entry->vuid);
         } else {
-            printf("  方法A: ❌ 失败\n");
+            printf("  ❌ 无VUID\n");
         }
-        
-        // 方法B: 设置query_vfs_vuid位
-        struct {
-            uint32_t opcode_uid;
-            uint32_t reserved1[2];
-            uint32_t vhca_id_field;
-            uint32_t reserved2[4];
-        } vuid_cmd_b = {
-            .opcode_uid = htobe32((MLX5_CMD_OP_QUERY_VUID << 16) | 0),
-            .vhca_id_field = htobe32((1 << 31) | vhca_id),  // query_vfs_vuid=1
-        };
-        
-        struct {
-            uint32_t status_syndrome;
-            uint32_t syndrome;
-            uint32_t reserved[24];
-            uint32_t reserved2;
-            uint32_t num_entries;
-            char vuid_data[512];
-        } vuid_out_b = {0};
-        
-        ret = mlx5dv_devx_general_cmd(ctx, &vuid_cmd_b, sizeof(vuid_cmd_b), 
-                                      &vuid_out_b, sizeof(vuid_out_b));
-        
-        if (ret == 0 && (vuid_out_b.status_syndrome >> 24) == 0) {
-            uint32_t num_entries = be32toh(vuid_out_b.num_entries);
-            printf("  方法B: ✅ 成功 - %u VUID条目\n", num_entries);
-            
-            if (num_entries > 0) {
-                printf("  🎯 方法B找到VUID数据!\n");
-                return 0;  // 找到了
-            }
-        } else {
-            printf("  方法B: ❌ 失败\n");
-        }
-        
-        // 短暂延迟
-        usleep(50000);  // 50ms
+    }
+    
+    tlp_inventory_free(&inventory);
+    
+    if (resolved > 0) {
+        printf("\n✅ %d 个功能返回了VUID\n", resolved);
+        return 0;
     }
     
     return -1;  // 未找到VUID
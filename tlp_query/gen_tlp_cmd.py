@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+# Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Generate tlp_cmd.h, typed builders/accessors for the commands used by the
+# TLP Query tools, from the mlx5_ifc_*_bits layouts in mlx5_ifc.h.
+#
+#   ./gen_tlp_cmd.py mlx5_ifc.h > tlp_cmd.h
+#
+# Builders write every dword of the command with one big-endian store,
+# accessors read one dword. Offsets are resolved here and re-checked by
+# _Static_assert against mlx5_ifc.h, so a stale tlp_cmd.h fails to build.
+
+import re
+import sys
+
+# Commands built by the tools: (layout, opcode, fields passed by the caller)
+COMMANDS = [
+    ('query_emulated_functions_info_in', 'MLX5_CMD_OP_QUERY_EMULATED_FUNCTIONS_INFO',
+     ['op_mod', 'pf_vhca_id']),
+    ('query_vuid_in', 'MLX5_CMD_OP_QUERY_VUID', ['query_vfs_vuid', 'vhca_id']),
+    ('query_hca_cap_in', 'MLX5_CMD_OP_QUERY_HCA_CAP', ['op_mod', 'other_function', 'function_id']),
+    ('query_esw_functions_in', 'MLX5_CMD_OP_QUERY_ESW_FUNCTIONS', ['op_mod']),
+]
+
+# Layouts read by the tools: (layout, scalar fields, array/nested fields)
+ACCESSORS = [
+    ('query_emulated_functions_info_out', ['status', 'syndrome', 'num_emulated_functions'],
+     ['emulated_function_info']),
+    ('emulated_function_info', ['pci_bdf', 'vhca_id', 'hotplug_function', 'max_num_vfs_valid',
+                                'vf_exist', 'max_num_vfs'], []),
+    ('query_vuid_out', ['status', 'syndrome', 'num_of_entries'], ['vuid']),
+    ('vuid', [], ['vuid']),
+    ('query_hca_cap_out', ['status', 'syndrome'], ['capability']),
+    ('query_esw_functions_out', ['status', 'syndrome'], []),
+    ('eqe', ['event_type', 'event_sub_type'], ['event_data']),
+    ('vhca_state_change_event', ['ec_function', 'function_id'], []),
+]
+
+
+class Layout:
+    def __init__(self, name, union):
+        self.name = name
+        self.union = union
+        self.members = []   # (name, offset, width, elem_type) in bits
+        self.size = 0
+
+
+def tokenize(text):
+    text = re.sub(r'/\*.*?\*/', ' ', text, flags=re.S)
+    text = re.sub(r'//[^\n]*', ' ', text)
+    return re.findall(r'[A-Za-z_]\w*|0[xX][0-9a-fA-F]+|\d+|[{}\[\];]', text)
+
+
+def number(tok):
+    return int(tok, 0)
+
+
+class Parser:
+    def __init__(self, text):
+        self.toks = tokenize(text)
+        self.pos = 0
+        self.layouts = {}
+        self.pending = []   # members whose type is not sized yet
+
+    def peek(self, k=0):
+        return self.toks[self.pos + k] if self.pos + k < len(self.toks) else None
+
+    def take(self, expect=None):
+        tok = self.toks[self.pos]
+        if expect and tok != expect:
+            raise SyntaxError('expected %s got %s at token %d' % (expect, tok, self.pos))
+        self.pos += 1
+        return tok
+
+    def parse(self):
+        while self.peek() is not None:
+            if self.peek() in ('struct', 'union') and self.peek(1) and \
+               self.peek(1).startswith('mlx5_ifc_') and self.peek(2) == '{':
+                union = self.take() == 'union'
+                name = self.take()[len('mlx5_ifc_'):-len('_bits')]
+                layout = Layout(name, union)
+                self.body(layout)
+                self.take(';')
+                self.layouts[name] = layout
+            else:
+                self.pos += 1
+        return self.layouts
+
+    def dims(self):
+        count = 1
+        while self.peek() == '[':
+            self.take('[')
+            if self.peek() == ']':
+                count = 0       # Flexible array, takes no space
+            else:
+                count *= number(self.take())
+            self.take(']')
+        return count
+
+    def body(self, layout):
+        self.take('{')
+        while self.peek() != '}':
+            if self.peek() == 'u8':
+                self.take()
+                name = self.take()
+                dims = []
+                while self.peek() == '[':
+                    self.take('[')
+                    dims.append(0 if self.peek() == ']' else number(self.take()))
+                    self.take(']')
+                self.take(';')
+                width = 1
+                for d in dims:
+                    width *= d
+                self.add(layout, name, width, None)
+            elif self.peek() in ('struct', 'union') and self.peek(1) == '{':
+                inner = Layout(None, self.take() == 'union')
+                self.body(inner)
+                name = self.take() if self.peek() != ';' else None
+                count = self.dims()
+                self.take(';')
+                self.add(layout, name, inner.size * count, inner)
+            elif self.peek() in ('struct', 'union'):
+                self.take()
+                tname = self.take()[len('mlx5_ifc_'):-len('_bits')]
+                name = self.take()
+                count = self.dims()
+                self.take(';')
+                self.add(layout, name, self.layouts[tname].size * count, tname)
+            else:
+                raise SyntaxError('unexpected %s in %s' % (self.peek(), layout.name))
+        self.take('}')
+
+    def add(self, layout, name, width, elem):
+        offset = 0 if layout.union else layout.size
+        layout.members.append((name, offset, width, elem))
+        layout.size = max(layout.size, width) if layout.union else layout.size + width
+
+
+def field(layouts, lname, fname):
+    for name, offset, width, elem in layouts[lname].members:
+        if name == fname:
+            return offset, width
+    raise KeyError('%s has no field %s' % (lname, fname))
+
+
+def ctype(width):
+    for bits, t in ((8, 'uint8_t'), (16, 'uint16_t'), (32, 'uint32_t'), (64, 'uint64_t')):
+        if width <= bits:
+            return t
+    raise ValueError(width)
+
+
+def check_field(out, lname, fname, offset, width):
+    out.append('_Static_assert(__devx_bit_off(%s, %s) == 0x%x && __devx_bit_sz(%s, %s) == 0x%x,'
+               % (lname, fname, offset, lname, fname, width))
+    out.append('               "mlx5_ifc_%s_bits.%s moved, regenerate tlp_cmd.h");' % (lname, fname))
+
+
+def dword_terms(lname, fields, layouts):
+    """Map dword index -> list of C expressions OR-ed into it"""
+    terms = {}
+    for fname, value in fields:
+        offset, width = field(layouts, lname, fname)
+        if width == 64:
+            if offset % 64:
+                raise ValueError('%s.%s not 64-bit aligned' % (lname, fname))
+            terms.setdefault(offset // 32, []).append('(uint32_t)(%s >> 32)' % value)
+            terms.setdefault(offset // 32 + 1, []).append('(uint32_t)%s' % value)
+            continue
+        if offset // 32 != (offset + width - 1) // 32:
+            raise ValueError('%s.%s crosses a dword' % (lname, fname))
+        shift = 32 - width - offset % 32
+        expr = '(uint32_t)%s' % value
+        if width < 32:
+            expr = '((uint32_t)%s & 0x%x)' % (value, (1 << width) - 1)
+        if shift:
+            expr = '(%s << %d)' % (expr, shift)
+        terms.setdefault(offset // 32, []).append(expr)
+    return terms
+
+
+def gen_command(out, layouts, lname, opcode, fields):
+    layout = layouts[lname]
+    ndw = layout.size // 32
+    up = lname.upper()
+    params = []
+    checks = [('opcode',) + field(layouts, lname, 'opcode')]
+
+    for fname in fields:
+        offset, width = field(layouts, lname, fname)
+        params.append('%s %s' % (ctype(width), fname))
+        checks.append((fname, offset, width))
+
+    out.append('/* %s: %s, %d bytes */' % (opcode, lname, layout.size // 8))
+    out.append('#define TLP_CMD_%s_SZ %d' % (up, layout.size // 8))
+    out.append('_Static_assert(sizeof(struct mlx5_ifc_%s_bits) == 0x%x, "mlx5_ifc_%s_bits resized");'
+               % (lname, layout.size, lname))
+    for fname, offset, width in checks:
+        check_field(out, lname, fname, offset, width)
+    out.append('')
+
+    terms = dword_terms(lname, [('opcode', opcode)] + [(f, f) for f in fields], layouts)
+    out.append('static inline void tlp_cmd_%s(void *in%s)' % (lname, ''.join(', ' + p for p in params)))
+    out.append('{')
+    for dw in range(ndw):
+        expr = ' |\n                   '.join(terms.get(dw, ['0']))
+        out.append('    tlp_cmd_put32(in, %d, %s);' % (dw, expr))
+    out.append('}')
+    out.append('')
+
+
+def gen_accessors(out, layouts, lname, scalars, arrays):
+    layout = layouts[lname]
+    up = lname.upper()
+
+    out.append('/* %s, %d bytes */' % (lname, layout.size // 8))
+    out.append('#define TLP_CMD_%s_SZ %d' % (up, layout.size // 8))
+    out.append('_Static_assert(sizeof(struct mlx5_ifc_%s_bits) == 0x%x, "mlx5_ifc_%s_bits resized");'
+               % (lname, layout.size, lname))
+    for fname in scalars + arrays:
+        offset, width = field(layouts, lname, fname)
+        check_field(out, lname, fname, offset, width)
+    for fname in arrays:
+        offset, width = field(layouts, lname, fname)
+        out.append('#define TLP_CMD_%s_%s_OFF %d' % (up, fname.upper(), offset // 8))
+    out.append('')
+
+    for fname in scalars:
+        offset, width = field(layouts, lname, fname)
+        if offset // 32 != (offset + width - 1) // 32:
+            raise ValueError('%s.%s crosses a dword' % (lname, fname))
+        shift = 32 - width - offset % 32
+        expr = 'tlp_cmd_get32(buf, %d)' % (offset // 32)
+        if shift:
+            expr = '(%s >> %d)' % (expr, shift)
+        if width < 32:
+            expr = '%s & 0x%x' % (expr, (1 << width) - 1)
+        out.append('static inline %s tlp_cmd_%s_%s(const void *buf)' % (ctype(width), lname, fname))
+        out.append('{')
+        out.append('    return %s;' % expr)
+        out.append('}')
+        out.append('')
+
+
+HEADER = '''/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - typed command builders and accessors.
+ * Generated by gen_tlp_cmd.py from mlx5_ifc.h, do not edit.
+ */
+
+#ifndef TLP_CMD_H
+#define TLP_CMD_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+
+// Buffers may be any byte array, memcpy compiles to a single unaligned access
+static inline void tlp_cmd_put32(void *buf, unsigned int dw, uint32_t val)
+{
+    val = htobe32(val);
+    memcpy((uint8_t *)buf + dw * 4, &val, sizeof(val));
+}
+
+static inline uint32_t tlp_cmd_get32(const void *buf, unsigned int dw)
+{
+    uint32_t val;
+
+    memcpy(&val, (const uint8_t *)buf + dw * 4, sizeof(val));
+    return be32toh(val);
+}
+'''
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else 'mlx5_ifc.h'
+    with open(path) as f:
+        layouts = Parser(f.read()).parse()
+
+    out = [HEADER]
+    out.append('/* Commands */')
+    out.append('')
+    for lname, opcode, fields in COMMANDS:
+        gen_command(out, layouts, lname, opcode, fields)
+    out.append('/* Outputs */')
+    out.append('')
+    for lname, scalars, arrays in ACCESSORS:
+        gen_accessors(out, layouts, lname, scalars, arrays)
+    out.append('#endif /* TLP_CMD_H */')
+    sys.stdout.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
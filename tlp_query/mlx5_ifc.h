@@ -91,9 +91,33 @@ enum {
 };
 
 enum mlx5_event {
+	MLX5_EVENT_TYPE_VHCA_STATE_CHANGE = 0xb,
+	MLX5_EVENT_TYPE_ESW_FUNCTIONS_CHANGED = 0xe,
 	MLX5_EVENT_TYPE_OBJECT_CHANGE = 0x27,
 };
 
+struct mlx5_ifc_vhca_state_change_event_bits {
+	u8	 ec_function[0x10];
+	u8	 function_id[0x10];
+
+	u8	 reserved_at_20[0xc0];
+};
+
+struct mlx5_ifc_eqe_bits {
+	u8	 reserved_at_0[0x8];
+	u8	 event_type[0x8];
+	u8	 reserved_at_10[0x8];
+	u8	 event_sub_type[0x8];
+
+	u8	 reserved_at_20[0xe0];
+
+	u8	 event_data[0xe0];
+
+	u8	 reserved_at_1e0[0x10];
+	u8	 signature[0x8];
+	u8	 owner[0x8];
+};
+
 struct mlx5_ifc_atomic_caps_bits {
 	u8	 reserved_at_0[0x40];
 
@@ -4927,34 +4951,6 @@ struct mlx5_ifc_dpa_eq_bits {
 #define PRM_EMULATION_OPMOD_GENERIC_PF      0x6
 #define PRM_EMULATION_OPMOD_TLP_DEVICES     0x7
 
-// Input structure for QUERY_EMULATED_FUNCTIONS_INFO command
-struct mlx5_ifc_query_emulated_functions_info_in_simple_bits {
-    uint32_t opcode_uid;         // [31:16] opcode, [15:0] uid
-    uint32_t reserved1;          // reserved
-    uint32_t op_mod;             // operation modifier
-    uint32_t reserved2[2];       // reserved
-    uint32_t host_number_valid;  // host parameters
-    uint32_t host_number;
-    uint32_t pf_vhca_id;
-    uint32_t reserved3[2];       // reserved
-};
-
-// Output structure for QUERY_EMULATED_FUNCTIONS_INFO command
-struct mlx5_ifc_query_emulated_functions_info_out_simple_bits {
-    uint8_t  status;
-    uint8_t  reserved1[3];
-    uint32_t syndrome;
-    uint32_t reserved2[2];
-    uint32_t num_emulated_functions;
-    uint32_t reserved3[3];
-    // Note: Additional function info follows but not parsed in simple version
-};
-
-// Helper macros for byte order conversion
-#ifndef htobe32
-#include <endian.h>
-#endif
-
 // ========================================================================
 // End TLP Query Test Definitions
 // ========================================================================
@@ -0,0 +1,298 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - typed command builders and accessors.
+ * Generated by gen_tlp_cmd.py from mlx5_ifc.h, do not edit.
+ */
+
+#ifndef TLP_CMD_H
+#define TLP_CMD_H
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+#include "mlx5_ifc.h"
+
+// Buffers may be any byte array, memcpy compiles to a single unaligned access
+static inline void tlp_cmd_put32(void *buf, unsigned int dw, uint32_t val)
+{
+    val = htobe32(val);
+    memcpy((uint8_t *)buf + dw * 4, &val, sizeof(val));
+}
+
+static inline uint32_t tlp_cmd_get32(const void *buf, unsigned int dw)
+{
+    uint32_t val;
+
+    memcpy(&val, (const uint8_t *)buf + dw * 4, sizeof(val));
+    return be32toh(val);
+}
+
+/* Commands */
+
+/* MLX5_CMD_OP_QUERY_EMULATED_FUNCTIONS_INFO: query_emulated_functions_info_in, 16 bytes */
+#define TLP_CMD_QUERY_EMULATED_FUNCTIONS_INFO_IN_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_query_emulated_functions_info_in_bits) == 0x80, "mlx5_ifc_query_emulated_functions_info_in_bits resized");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_in, opcode) == 0x0 && __devx_bit_sz(query_emulated_functions_info_in, opcode) == 0x10,
+               "mlx5_ifc_query_emulated_functions_info_in_bits.opcode moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_in, op_mod) == 0x30 && __devx_bit_sz(query_emulated_functions_info_in, op_mod) == 0x10,
+               "mlx5_ifc_query_emulated_functions_info_in_bits.op_mod moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_in, pf_vhca_id) == 0x70 && __devx_bit_sz(query_emulated_functions_info_in, pf_vhca_id) == 0x10,
+               "mlx5_ifc_query_emulated_functions_info_in_bits.pf_vhca_id moved, regenerate tlp_cmd.h");
+
+static inline void tlp_cmd_query_emulated_functions_info_in(void *in, uint16_t op_mod, uint16_t pf_vhca_id)
+{
+    tlp_cmd_put32(in, 0, (((uint32_t)MLX5_CMD_OP_QUERY_EMULATED_FUNCTIONS_INFO & 0xffff) << 16));
+    tlp_cmd_put32(in, 1, ((uint32_t)op_mod & 0xffff));
+    tlp_cmd_put32(in, 2, 0);
+    tlp_cmd_put32(in, 3, ((uint32_t)pf_vhca_id & 0xffff));
+}
+
+/* MLX5_CMD_OP_QUERY_VUID: query_vuid_in, 16 bytes */
+#define TLP_CMD_QUERY_VUID_IN_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_query_vuid_in_bits) == 0x80, "mlx5_ifc_query_vuid_in_bits resized");
+_Static_assert(__devx_bit_off(query_vuid_in, opcode) == 0x0 && __devx_bit_sz(query_vuid_in, opcode) == 0x10,
+               "mlx5_ifc_query_vuid_in_bits.opcode moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_vuid_in, query_vfs_vuid) == 0x60 && __devx_bit_sz(query_vuid_in, query_vfs_vuid) == 0x1,
+               "mlx5_ifc_query_vuid_in_bits.query_vfs_vuid moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_vuid_in, vhca_id) == 0x70 && __devx_bit_sz(query_vuid_in, vhca_id) == 0x10,
+               "mlx5_ifc_query_vuid_in_bits.vhca_id moved, regenerate tlp_cmd.h");
+
+static inline void tlp_cmd_query_vuid_in(void *in, uint8_t query_vfs_vuid, uint16_t vhca_id)
+{
+    tlp_cmd_put32(in, 0, (((uint32_t)MLX5_CMD_OP_QUERY_VUID & 0xffff) << 16));
+    tlp_cmd_put32(in, 1, 0);
+    tlp_cmd_put32(in, 2, 0);
+    tlp_cmd_put32(in, 3, (((uint32_t)query_vfs_vuid & 0x1) << 31) |
+                   ((uint32_t)vhca_id & 0xffff));
+}
+
+/* MLX5_CMD_OP_QUERY_HCA_CAP: query_hca_cap_in, 16 bytes */
+#define TLP_CMD_QUERY_HCA_CAP_IN_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_query_hca_cap_in_bits) == 0x80, "mlx5_ifc_query_hca_cap_in_bits resized");
+_Static_assert(__devx_bit_off(query_hca_cap_in, opcode) == 0x0 && __devx_bit_sz(query_hca_cap_in, opcode) == 0x10,
+               "mlx5_ifc_query_hca_cap_in_bits.opcode moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_hca_cap_in, op_mod) == 0x30 && __devx_bit_sz(query_hca_cap_in, op_mod) == 0x10,
+               "mlx5_ifc_query_hca_cap_in_bits.op_mod moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_hca_cap_in, other_function) == 0x40 && __devx_bit_sz(query_hca_cap_in, other_function) == 0x1,
+               "mlx5_ifc_query_hca_cap_in_bits.other_function moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_hca_cap_in, function_id) == 0x50 && __devx_bit_sz(query_hca_cap_in, function_id) == 0x10,
+               "mlx5_ifc_query_hca_cap_in_bits.function_id moved, regenerate tlp_cmd.h");
+
+static inline void tlp_cmd_query_hca_cap_in(void *in, uint16_t op_mod, uint8_t other_function, uint16_t function_id)
+{
+    tlp_cmd_put32(in, 0, (((uint32_t)MLX5_CMD_OP_QUERY_HCA_CAP & 0xffff) << 16));
+    tlp_cmd_put32(in, 1, ((uint32_t)op_mod & 0xffff));
+    tlp_cmd_put32(in, 2, (((uint32_t)other_function & 0x1) << 31) |
+                   ((uint32_t)function_id & 0xffff));
+    tlp_cmd_put32(in, 3, 0);
+}
+
+/* MLX5_CMD_OP_QUERY_ESW_FUNCTIONS: query_esw_functions_in, 16 bytes */
+#define TLP_CMD_QUERY_ESW_FUNCTIONS_IN_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_query_esw_functions_in_bits) == 0x80, "mlx5_ifc_query_esw_functions_in_bits resized");
+_Static_assert(__devx_bit_off(query_esw_functions_in, opcode) == 0x0 && __devx_bit_sz(query_esw_functions_in, opcode) == 0x10,
+               "mlx5_ifc_query_esw_functions_in_bits.opcode moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_esw_functions_in, op_mod) == 0x30 && __devx_bit_sz(query_esw_functions_in, op_mod) == 0x10,
+               "mlx5_ifc_query_esw_functions_in_bits.op_mod moved, regenerate tlp_cmd.h");
+
+static inline void tlp_cmd_query_esw_functions_in(void *in, uint16_t op_mod)
+{
+    tlp_cmd_put32(in, 0, (((uint32_t)MLX5_CMD_OP_QUERY_ESW_FUNCTIONS & 0xffff) << 16));
+    tlp_cmd_put32(in, 1, ((uint32_t)op_mod & 0xffff));
+    tlp_cmd_put32(in, 2, 0);
+    tlp_cmd_put32(in, 3, 0);
+}
+
+/* Outputs */
+
+/* query_emulated_functions_info_out, 16 bytes */
+#define TLP_CMD_QUERY_EMULATED_FUNCTIONS_INFO_OUT_SZ 16
+_Static_assert(sizeof(struct mlx5_ifc_query_emulated_functions_info_out_bits) == 0x80, "mlx5_ifc_query_emulated_functions_info_out_bits resized");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_out, status) == 0x0 && __devx_bit_sz(query_emulated_functions_info_out, status) == 0x8,
+               "mlx5_ifc_query_emulated_functions_info_out_bits.status moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_out, syndrome) == 0x20 && __devx_bit_sz(query_emulated_functions_info_out, syndrome) == 0x20,
+               "mlx5_ifc_query_emulated_functions_info_out_bits.syndrome moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_out, num_emulated_functions) == 0x70 && __devx_bit_sz(query_emulated_functions_info_out, num_emulated_functions) == 0x10,
+               "mlx5_ifc_query_emulated_functions_info_out_bits.num_emulated_functions moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_emulated_functions_info_out, emulated_function_info) == 0x80 && __devx_bit_sz(query_emulated_functions_info_out, emulated_function_info) == 0x0,
+               "mlx5_ifc_query_emulated_functions_info_out_bits.emulated_function_info moved, regenerate tlp_cmd.h");
+#define TLP_CMD_QUERY_EMULATED_FUNCTIONS_INFO_OUT_EMULATED_FUNCTION_INFO_OFF 16
+
+static inline uint8_t tlp_cmd_query_emulated_functions_info_out_status(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 24) & 0xff;
+}
+
+static inline uint32_t tlp_cmd_query_emulated_functions_info_out_syndrome(const void *buf)
+{
+    return tlp_cmd_get32(buf, 1);
+}
+
+static inline uint16_t tlp_cmd_query_emulated_functions_info_out_num_emulated_functions(const void *buf)
+{
+    return tlp_cmd_get32(buf, 3) & 0xffff;
+}
+
+/* emulated_function_info, 8 bytes */
+#define TLP_CMD_EMULATED_FUNCTION_INFO_SZ 8
+_Static_assert(sizeof(struct mlx5_ifc_emulated_function_info_bits) == 0x40, "mlx5_ifc_emulated_function_info_bits resized");
+_Static_assert(__devx_bit_off(emulated_function_info, pci_bdf) == 0x0 && __devx_bit_sz(emulated_function_info, pci_bdf) == 0x10,
+               "mlx5_ifc_emulated_function_info_bits.pci_bdf moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(emulated_function_info, vhca_id) == 0x10 && __devx_bit_sz(emulated_function_info, vhca_id) == 0x10,
+               "mlx5_ifc_emulated_function_info_bits.vhca_id moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(emulated_function_info, hotplug_function) == 0x20 && __devx_bit_sz(emulated_function_info, hotplug_function) == 0x1,
+               "mlx5_ifc_emulated_function_info_bits.hotplug_function moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(emulated_function_info, max_num_vfs_valid) == 0x21 && __devx_bit_sz(emulated_function_info, max_num_vfs_valid) == 0x1,
+               "mlx5_ifc_emulated_function_info_bits.max_num_vfs_valid moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(emulated_function_info, vf_exist) == 0x22 && __devx_bit_sz(emulated_function_info, vf_exist) == 0x1,
+               "mlx5_ifc_emulated_function_info_bits.vf_exist moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(emulated_function_info, max_num_vfs) == 0x30 && __devx_bit_sz(emulated_function_info, max_num_vfs) == 0x10,
+               "mlx5_ifc_emulated_function_info_bits.max_num_vfs moved, regenerate tlp_cmd.h");
+
+static inline uint16_t tlp_cmd_emulated_function_info_pci_bdf(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 16) & 0xffff;
+}
+
+static inline uint16_t tlp_cmd_emulated_function_info_vhca_id(const void *buf)
+{
+    return tlp_cmd_get32(buf, 0) & 0xffff;
+}
+
+static inline uint8_t tlp_cmd_emulated_function_info_hotplug_function(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 1) >> 31) & 0x1;
+}
+
+static inline uint8_t tlp_cmd_emulated_function_info_max_num_vfs_valid(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 1) >> 30) & 0x1;
+}
+
+static inline uint8_t tlp_cmd_emulated_function_info_vf_exist(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 1) >> 29) & 0x1;
+}
+
+static inline uint16_t tlp_cmd_emulated_function_info_max_num_vfs(const void *buf)
+{
+    return tlp_cmd_get32(buf, 1) & 0xffff;
+}
+
+/* query_vuid_out, 64 bytes */
+#define TLP_CMD_QUERY_VUID_OUT_SZ 64
+_Static_assert(sizeof(struct mlx5_ifc_query_vuid_out_bits) == 0x200, "mlx5_ifc_query_vuid_out_bits resized");
+_Static_assert(__devx_bit_off(query_vuid_out, status) == 0x0 && __devx_bit_sz(query_vuid_out, status) == 0x8,
+               "mlx5_ifc_query_vuid_out_bits.status moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_vuid_out, syndrome) == 0x20 && __devx_bit_sz(query_vuid_out, syndrome) == 0x20,
+               "mlx5_ifc_query_vuid_out_bits.syndrome moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_vuid_out, num_of_entries) == 0x1f0 && __devx_bit_sz(query_vuid_out, num_of_entries) == 0x10,
+               "mlx5_ifc_query_vuid_out_bits.num_of_entries moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_vuid_out, vuid) == 0x200 && __devx_bit_sz(query_vuid_out, vuid) == 0x0,
+               "mlx5_ifc_query_vuid_out_bits.vuid moved, regenerate tlp_cmd.h");
+#define TLP_CMD_QUERY_VUID_OUT_VUID_OFF 64
+
+static inline uint8_t tlp_cmd_query_vuid_out_status(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 24) & 0xff;
+}
+
+static inline uint32_t tlp_cmd_query_vuid_out_syndrome(const void *buf)
+{
+    return tlp_cmd_get32(buf, 1);
+}
+
+static inline uint16_t tlp_cmd_query_vuid_out_num_of_entries(const void *buf)
+{
+    return tlp_cmd_get32(buf, 15) & 0xffff;
+}
+
+/* vuid, 128 bytes */
+#define TLP_CMD_VUID_SZ 128
+_Static_assert(sizeof(struct mlx5_ifc_vuid_bits) == 0x400, "mlx5_ifc_vuid_bits resized");
+_Static_assert(__devx_bit_off(vuid, vuid) == 0x0 && __devx_bit_sz(vuid, vuid) == 0x400,
+               "mlx5_ifc_vuid_bits.vuid moved, regenerate tlp_cmd.h");
+#define TLP_CMD_VUID_VUID_OFF 0
+
+/* query_hca_cap_out, 4112 bytes */
+#define TLP_CMD_QUERY_HCA_CAP_OUT_SZ 4112
+_Static_assert(sizeof(struct mlx5_ifc_query_hca_cap_out_bits) == 0x8080, "mlx5_ifc_query_hca_cap_out_bits resized");
+_Static_assert(__devx_bit_off(query_hca_cap_out, status) == 0x0 && __devx_bit_sz(query_hca_cap_out, status) == 0x8,
+               "mlx5_ifc_query_hca_cap_out_bits.status moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_hca_cap_out, syndrome) == 0x20 && __devx_bit_sz(query_hca_cap_out, syndrome) == 0x20,
+               "mlx5_ifc_query_hca_cap_out_bits.syndrome moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_hca_cap_out, capability) == 0x80 && __devx_bit_sz(query_hca_cap_out, capability) == 0x8000,
+               "mlx5_ifc_query_hca_cap_out_bits.capability moved, regenerate tlp_cmd.h");
+#define TLP_CMD_QUERY_HCA_CAP_OUT_CAPABILITY_OFF 16
+
+static inline uint8_t tlp_cmd_query_hca_cap_out_status(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 24) & 0xff;
+}
+
+static inline uint32_t tlp_cmd_query_hca_cap_out_syndrome(const void *buf)
+{
+    return tlp_cmd_get32(buf, 1);
+}
+
+/* query_esw_functions_out, 128 bytes */
+#define TLP_CMD_QUERY_ESW_FUNCTIONS_OUT_SZ 128
+_Static_assert(sizeof(struct mlx5_ifc_query_esw_functions_out_bits) == 0x400, "mlx5_ifc_query_esw_functions_out_bits resized");
+_Static_assert(__devx_bit_off(query_esw_functions_out, status) == 0x0 && __devx_bit_sz(query_esw_functions_out, status) == 0x8,
+               "mlx5_ifc_query_esw_functions_out_bits.status moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(query_esw_functions_out, syndrome) == 0x20 && __devx_bit_sz(query_esw_functions_out, syndrome) == 0x20,
+               "mlx5_ifc_query_esw_functions_out_bits.syndrome moved, regenerate tlp_cmd.h");
+
+static inline uint8_t tlp_cmd_query_esw_functions_out_status(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 24) & 0xff;
+}
+
+static inline uint32_t tlp_cmd_query_esw_functions_out_syndrome(const void *buf)
+{
+    return tlp_cmd_get32(buf, 1);
+}
+
+/* eqe, 64 bytes */
+#define TLP_CMD_EQE_SZ 64
+_Static_assert(sizeof(struct mlx5_ifc_eqe_bits) == 0x200, "mlx5_ifc_eqe_bits resized");
+_Static_assert(__devx_bit_off(eqe, event_type) == 0x8 && __devx_bit_sz(eqe, event_type) == 0x8,
+               "mlx5_ifc_eqe_bits.event_type moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(eqe, event_sub_type) == 0x18 && __devx_bit_sz(eqe, event_sub_type) == 0x8,
+               "mlx5_ifc_eqe_bits.event_sub_type moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(eqe, event_data) == 0x100 && __devx_bit_sz(eqe, event_data) == 0xe0,
+               "mlx5_ifc_eqe_bits.event_data moved, regenerate tlp_cmd.h");
+#define TLP_CMD_EQE_EVENT_DATA_OFF 32
+
+static inline uint8_t tlp_cmd_eqe_event_type(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 16) & 0xff;
+}
+
+static inline uint8_t tlp_cmd_eqe_event_sub_type(const void *buf)
+{
+    return tlp_cmd_get32(buf, 0) & 0xff;
+}
+
+/* vhca_state_change_event, 28 bytes */
+#define TLP_CMD_VHCA_STATE_CHANGE_EVENT_SZ 28
+_Static_assert(sizeof(struct mlx5_ifc_vhca_state_change_event_bits) == 0xe0, "mlx5_ifc_vhca_state_change_event_bits resized");
+_Static_assert(__devx_bit_off(vhca_state_change_event, ec_function) == 0x0 && __devx_bit_sz(vhca_state_change_event, ec_function) == 0x10,
+               "mlx5_ifc_vhca_state_change_event_bits.ec_function moved, regenerate tlp_cmd.h");
+_Static_assert(__devx_bit_off(vhca_state_change_event, function_id) == 0x10 && __devx_bit_sz(vhca_state_change_event, function_id) == 0x10,
+               "mlx5_ifc_vhca_state_change_event_bits.function_id moved, regenerate tlp_cmd.h");
+
+static inline uint16_t tlp_cmd_vhca_state_change_event_ec_function(const void *buf)
+{
+    return (tlp_cmd_get32(buf, 0) >> 16) & 0xffff;
+}
+
+static inline uint16_t tlp_cmd_vhca_state_change_event_function_id(const void *buf)
+{
+    return tlp_cmd_get32(buf, 0) & 0xffff;
+}
+
+#endif /* TLP_CMD_H */
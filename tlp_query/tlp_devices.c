@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - device selection and parallel per-device runs.
+ * Hosts carry several mlx5 functions; each device is queried on its own
+ * thread so the total time tracks the slowest device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fnmatch.h>
+#include <pthread.h>
+
+#include "tlp_devices.h"
+
+struct device_worker {
+    pthread_t           thread;
+    int                 running;
+    struct ibv_device   *dev;
+    tlp_device_fn       fn;
+    void                *result;
+    void                *arg;
+    int                 ret;
+};
+
+int tlp_devices_match(const char *pattern, struct tlp_device_set *set)
+{
+    int num_devices;
+
+    memset(set, 0, sizeof(*set));
+    set->list = ibv_get_device_list(&num_devices);
+    if (!set->list) {
+        fprintf(stderr, "Failed to get device list\n");
+        return -1;
+    }
+
+    set->match = calloc(num_devices ? num_devices : 1, sizeof(*set->match));
+    if (!set->match) {
+        tlp_devices_release(set);
+        return -1;
+    }
+
+    for (int i = 0; i < num_devices; i++) {
+        if (fnmatch(pattern, ibv_get_device_name(set->list[i]), 0) == 0)
+            set->match[set->nmatch++] = set->list[i];
+    }
+
+    return set->nmatch;
+}
+
+void tlp_devices_release(struct tlp_device_set *set)
+{
+    free(set->match);
+    if (set->list)
+        ibv_free_device_list(set->list);
+    memset(set, 0, sizeof(*set));
+}
+
+static void *device_worker_fn(void *arg)
+{
+    struct device_worker *w = arg;
+
+    w->ret = w->fn(w->dev, w->result, w->arg);
+    return NULL;
+}
+
+int tlp_devices_run_parallel(const struct tlp_device_set *set, tlp_device_fn fn,
+                             void *results, size_t result_size, void *arg)
+{
+    struct device_worker *workers;
+    int failed = 0;
+
+    workers = calloc(set->nmatch ? set->nmatch : 1, sizeof(*workers));
+    if (!workers)
+        return set->nmatch;
+
+    for (int i = 0; i < set->nmatch; i++) {
+        workers[i].dev = set->match[i];
+        workers[i].fn = fn;
+        workers[i].result = (char *)results + (size_t)i * result_size;
+        workers[i].arg = arg;
+        // Fall back to running inline if a thread cannot be started
+        if (pthread_create(&workers[i].thread, NULL, device_worker_fn, &workers[i]) == 0)
+            workers[i].running = 1;
+        else
+            device_worker_fn(&workers[i]);
+    }
+
+    for (int i = 0; i < set->nmatch; i++) {
+        if (workers[i].running)
+            pthread_join(workers[i].thread, NULL);
+        if (workers[i].ret)
+            failed++;
+    }
+
+    free(workers);
+    return failed;
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - device selection and parallel per-device runs
+ */
+
+#ifndef TLP_DEVICES_H
+#define TLP_DEVICES_H
+
+#include <stddef.h>
+#include <infiniband/verbs.h>
+
+struct tlp_device_set {
+    struct ibv_device   **list;         // Owned ibv_get_device_list() result
+    struct ibv_device   **match;        // Devices matching the pattern
+    int                 nmatch;
+};
+
+/**
+ * Per-device work function
+ *
+ * @param dev: Matched device, the callee opens and closes its own context
+ * @param result: Caller-provided per-device result slot
+ * @return: 0 on success
+ */
+typedef int (*tlp_device_fn)(struct ibv_device *dev, void *result, void *arg);
+
+/**
+ * Select devices by exact name or fnmatch(3) pattern (e.g. "mlx5_*")
+ *
+ * @return: number of matching devices, -1 on failure
+ */
+int tlp_devices_match(const char *pattern, struct tlp_device_set *set);
+void tlp_devices_release(struct tlp_device_set *set);
+
+/**
+ * Run fn on every matched device, one thread per device
+ *
+ * Wall-clock time is that of the slowest device rather than the sum.
+ * @param results: Array of set->nmatch slots of result_size bytes
+ * @return: number of devices whose fn failed
+ */
+int tlp_devices_run_parallel(const struct tlp_device_set *set, tlp_device_fn fn,
+                             void *results, size_t result_size, void *arg);
+
+static inline int tlp_device_pattern_is_multi(const char *pattern)
+{
+    for (; *pattern; pattern++) {
+        if (*pattern == '*' || *pattern == '?' || *pattern == '[')
+            return 1;
+    }
+    return 0;
+}
+
+#endif /* TLP_DEVICES_H */
@@ -0,0 +1,296 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - QUERY_EMULATED_FUNCTIONS_INFO decoder.
+ * Layout comes from mlx5_ifc_query_emulated_functions_info_out_bits: a 16B
+ * header carrying num_emulated_functions followed by one 8B
+ * emulated_function_info per function.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <infiniband/mlx5dv.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_cmd.h"
+#include "tlp_emu_funcs.h"
+
+// Entries fetched by the first attempt, covers typical hosts in one command
+#define TLP_EMU_FUNCS_INITIAL_ENTRIES   64
+#define TLP_EMU_FUNCS_MAX_ATTEMPTS      3
+
+#define TLP_EMU_FUNCS_HDR_SZ    TLP_CMD_QUERY_EMULATED_FUNCTIONS_INFO_OUT_EMULATED_FUNCTION_INFO_OFF
+#define TLP_EMU_FUNCS_ENTRY_SZ  TLP_CMD_EMULATED_FUNCTION_INFO_SZ
+
+uint32_t tlp_emu_funcs_decode(const void *out, size_t outlen, uint8_t dev_type,
+                              struct tlp_emu_function *funcs, uint32_t max)
+{
+    const uint8_t *entry;
+    uint32_t count;
+
+    if (outlen < TLP_EMU_FUNCS_HDR_SZ)
+        return 0;
+
+    count = tlp_cmd_query_emulated_functions_info_out_num_emulated_functions(out);
+    if (count > (outlen - TLP_EMU_FUNCS_HDR_SZ) / TLP_EMU_FUNCS_ENTRY_SZ)
+        count = (outlen - TLP_EMU_FUNCS_HDR_SZ) / TLP_EMU_FUNCS_ENTRY_SZ;
+    if (count > max)
+        count = max;
+
+    entry = (const uint8_t *)out + TLP_EMU_FUNCS_HDR_SZ;
+    for (uint32_t i = 0; i < count; i++, entry += TLP_EMU_FUNCS_ENTRY_SZ) {
+        funcs[i].pci_bdf = tlp_cmd_emulated_function_info_pci_bdf(entry);
+        funcs[i].vhca_id = tlp_cmd_emulated_function_info_vhca_id(entry);
+        funcs[i].parent_vhca_id = 0;
+        funcs[i].hotplug = tlp_cmd_emulated_function_info_hotplug_function(entry);
+        funcs[i].dev_type = dev_type;
+    }
+
+    return count;
+}
+
+int tlp_emu_funcs_query(struct ibv_context *ctx, uint16_t op_mod, uint16_t pf_vhca_id,
+                        struct tlp_emu_function_list *list)
+{
+    uint8_t in[TLP_CMD_QUERY_EMULATED_FUNCTIONS_INFO_IN_SZ];
+    uint32_t capacity = TLP_EMU_FUNCS_INITIAL_ENTRIES;
+    uint8_t *out = NULL;
+    size_t outlen;
+
+    memset(list, 0, sizeof(*list));
+    list->op_mod = op_mod;
+
+    tlp_cmd_query_emulated_functions_info_in(in, op_mod, pf_vhca_id);
+
+    for (int attempt = 0; attempt < TLP_EMU_FUNCS_MAX_ATTEMPTS; attempt++) {
+        uint32_t reported;
+        int ret;
+
+        outlen = TLP_EMU_FUNCS_HDR_SZ + (size_t)capacity * TLP_EMU_FUNCS_ENTRY_SZ;
+        free(out);
+        out = calloc(1, outlen);
+        if (!out)
+            goto err;
+
+        ret = mlx5dv_devx_general_cmd(ctx, in, sizeof(in), out, outlen);
+        list->status = tlp_cmd_query_emulated_functions_info_out_status(out);
+        list->syndrome = tlp_cmd_query_emulated_functions_info_out_syndrome(out);
+        if (ret || list->status)
+            goto err;
+
+        // Functions may be hot-plugged between attempts, size to the latest count
+        reported = tlp_cmd_query_emulated_functions_info_out_num_emulated_functions(out);
+        if (reported <= capacity)
+            break;
+        capacity = reported;
+    }
+
+    list->funcs = calloc(capacity ? capacity : 1, sizeof(*list->funcs));
+    if (!list->funcs)
+        goto err;
+    list->count = tlp_emu_funcs_decode(out, outlen, op_mod, list->funcs, capacity);
+    if (op_mod == TLP_EMU_DEV_TYPE_VF) {
+        for (uint32_t i = 0; i < list->count; i++)
+            list->funcs[i].parent_vhca_id = pf_vhca_id;
+    }
+
+    free(out);
+    return 0;
+
+err:
+    free(out);
+    return -1;
+}
+
+// Op_mods that list physical functions, VFs are listed per PF afterwards
+static const uint16_t pf_op_mods[] = {
+    TLP_EMU_DEV_TYPE_NVME,
+    TLP_EMU_DEV_TYPE_VIRTIO_NET,
+    TLP_EMU_DEV_TYPE_VIRTIO_BLK,
+    TLP_EMU_DEV_TYPE_VIRTIO_FS,
+    TLP_EMU_DEV_TYPE_GENERIC,
+    TLP_EMU_DEV_TYPE_TLP,
+};
+
+// One QUERY_EMULATED_FUNCTIONS_INFO of a sweep
+struct emu_query_job {
+    uint16_t                        op_mod;
+    uint16_t                        pf_vhca_id;
+    struct tlp_emu_function_list    *list;
+    int                             ret;
+};
+
+struct emu_sweep {
+    struct ibv_context      *ctx;
+    struct emu_query_job    *jobs;
+    uint32_t                njobs;
+    uint32_t                next;       // Shared job cursor
+};
+
+static void *sweep_worker(void *arg)
+{
+    struct emu_sweep *sweep = arg;
+    uint32_t idx;
+
+    while ((idx = __atomic_fetch_add(&sweep->next, 1, __ATOMIC_RELAXED)) < sweep->njobs) {
+        struct emu_query_job *job = &sweep->jobs[idx];
+
+        job->ret = tlp_emu_funcs_query(sweep->ctx, job->op_mod, job->pf_vhca_id, job->list);
+    }
+    return NULL;
+}
+
+// Run all jobs with up to TLP_EMU_FUNCS_SWEEP_THREADS in flight, the caller is one of them
+static void sweep_run(struct ibv_context *ctx, struct emu_query_job *jobs, uint32_t njobs)
+{
+    struct emu_sweep sweep = { .ctx = ctx, .jobs = jobs, .njobs = njobs };
+    pthread_t threads[TLP_EMU_FUNCS_SWEEP_THREADS - 1];
+    int nthreads = 0;
+
+    while (nthreads < TLP_EMU_FUNCS_SWEEP_THREADS - 1 && (uint32_t)nthreads + 1 < njobs &&
+           pthread_create(&threads[nthreads], NULL, sweep_worker, &sweep) == 0)
+        nthreads++;
+
+    sweep_worker(&sweep);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+}
+
+static int op_mod_rejected(const struct tlp_emu_op_mod_cache *cache, uint16_t op_mod)
+{
+    return cache && op_mod < TLP_EMU_OP_MOD_CACHE_SIZE &&
+           ((cache->rejected[op_mod / 64] >> (op_mod % 64)) & 1);
+}
+
+int tlp_emu_funcs_sweep(struct ibv_context *ctx, const uint16_t *op_mods, int n,
+                        struct tlp_emu_op_mod_cache *cache, struct tlp_emu_function_list *lists)
+{
+    struct emu_query_job *jobs;
+    uint32_t njobs = 0;
+    int succeeded = 0;
+
+    for (int i = 0; i < n; i++) {
+        memset(&lists[i], 0, sizeof(lists[i]));
+        lists[i].op_mod = op_mods[i];
+    }
+
+    if (n <= 0)
+        return 0;
+    jobs = calloc(n, sizeof(*jobs));
+    if (!jobs)
+        return 0;
+
+    for (int i = 0; i < n; i++) {
+        struct tlp_emu_function_list *list = &lists[i];
+
+        if (op_mod_rejected(cache, op_mods[i])) {
+            list->status = cache->status[op_mods[i]];
+            list->syndrome = cache->syndrome[op_mods[i]];
+            list->cached = 1;
+            continue;
+        }
+        jobs[njobs++] = (struct emu_query_job){ .op_mod = op_mods[i], .list = list };
+    }
+
+    sweep_run(ctx, jobs, njobs);
+
+    for (uint32_t i = 0; i < njobs; i++) {
+        const struct tlp_emu_function_list *list = jobs[i].list;
+        uint16_t op_mod = jobs[i].op_mod;
+
+        if (jobs[i].ret == 0) {
+            succeeded++;
+        } else if (cache && list->status && op_mod < TLP_EMU_OP_MOD_CACHE_SIZE) {
+            cache->rejected[op_mod / 64] |= 1ull << (op_mod % 64);
+            cache->status[op_mod] = list->status;
+            cache->syndrome[op_mod] = list->syndrome;
+        }
+    }
+
+    free(jobs);
+    return succeeded;
+}
+
+int tlp_emu_funcs_query_all(struct ibv_context *ctx, struct tlp_emu_op_mod_cache *cache,
+                            struct tlp_emu_function_list *lists, int max_lists)
+{
+    const int npf_op_mods = sizeof(pf_op_mods) / sizeof(pf_op_mods[0]);
+    struct tlp_emu_function_list pf_lists[sizeof(pf_op_mods) / sizeof(pf_op_mods[0])];
+    struct emu_query_job *jobs;
+    uint32_t njobs = 0, npfs = 0;
+    int nlists = 0;
+
+    // Op_mods the device does not emulate fail with a syndrome and are skipped
+    tlp_emu_funcs_sweep(ctx, pf_op_mods, npf_op_mods, cache, pf_lists);
+    for (int i = 0; i < npf_op_mods; i++) {
+        if (pf_lists[i].count && nlists < max_lists)
+            lists[nlists++] = pf_lists[i];
+        else
+            tlp_emu_funcs_free(&pf_lists[i]);
+    }
+
+    // Then the VFs of every PF concurrently; a rejection is per PF, so it is not cached
+    for (int l = 0; l < nlists; l++)
+        npfs += lists[l].count;
+    jobs = calloc(npfs ? npfs : 1, sizeof(*jobs));
+    if (!jobs)
+        return nlists;
+
+    for (int l = 0, npf_lists = nlists; l < npf_lists; l++) {
+        for (uint32_t i = 0; i < lists[l].count && nlists + njobs < (uint32_t)max_lists; i++) {
+            uint32_t j;
+
+            // TLP_DEVICES reports the same PFs as GENERIC, list their VFs once
+            for (j = 0; j < njobs && jobs[j].pf_vhca_id != lists[l].funcs[i].vhca_id; j++)
+                ;
+            if (j < njobs)
+                continue;
+
+            jobs[njobs] = (struct emu_query_job){
+                .op_mod = TLP_EMU_DEV_TYPE_VF,
+                .pf_vhca_id = lists[l].funcs[i].vhca_id,
+                .list = &lists[nlists + njobs],
+            };
+            njobs++;
+        }
+    }
+    sweep_run(ctx, jobs, njobs);
+
+    // Compact, keeping only PFs that have VFs
+    for (uint32_t i = 0; i < njobs; i++) {
+        struct tlp_emu_function_list vfs = *jobs[i].list;
+
+        if (jobs[i].ret == 0 && vfs.count)
+            lists[nlists++] = vfs;
+        else
+            tlp_emu_funcs_free(&vfs);
+    }
+
+    free(jobs);
+    return nlists;
+}
+
+void tlp_emu_funcs_free(struct tlp_emu_function_list *list)
+{
+    free(list->funcs);
+    list->funcs = NULL;
+    list->count = 0;
+}
+
+const char *tlp_emu_dev_type_str(uint8_t dev_type)
+{
+    switch (dev_type) {
+    case TLP_EMU_DEV_TYPE_NVME:         return "NVME";
+    case TLP_EMU_DEV_TYPE_VIRTIO_NET:   return "VIRTIO_NET";
+    case TLP_EMU_DEV_TYPE_VIRTIO_BLK:   return "VIRTIO_BLK";
+    case TLP_EMU_DEV_TYPE_VF:           return "VF";
+    case TLP_EMU_DEV_TYPE_VIRTIO_FS:    return "VIRTIO_FS";
+    case TLP_EMU_DEV_TYPE_GENERIC:      return "GENERIC";
+    case TLP_EMU_DEV_TYPE_TLP:          return "TLP";
+    default:                            return "UNKNOWN";
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - QUERY_EMULATED_FUNCTIONS_INFO decoder
+ */
+
+#ifndef TLP_EMU_FUNCS_H
+#define TLP_EMU_FUNCS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+// Function type follows the op_mod it was reported under
+enum tlp_emu_dev_type {
+    TLP_EMU_DEV_TYPE_NVME          = 0x0,
+    TLP_EMU_DEV_TYPE_VIRTIO_NET    = 0x1,
+    TLP_EMU_DEV_TYPE_VIRTIO_BLK    = 0x2,
+    TLP_EMU_DEV_TYPE_VF            = 0x3,
+    TLP_EMU_DEV_TYPE_VIRTIO_FS     = 0x5,
+    TLP_EMU_DEV_TYPE_GENERIC       = 0x6,
+    TLP_EMU_DEV_TYPE_TLP           = 0x7,
+};
+
+struct tlp_emu_function {
+    uint16_t    vhca_id;
+    uint16_t    pci_bdf;
+    uint16_t    parent_vhca_id; // Owning PF, valid for TLP_EMU_DEV_TYPE_VF
+    uint8_t     hotplug;
+    uint8_t     dev_type;       // enum tlp_emu_dev_type
+};
+
+struct tlp_emu_function_list {
+    struct tlp_emu_function *funcs;     // Dense, count entries
+    uint32_t                count;
+    uint16_t                op_mod;
+    uint8_t                 status;     // Firmware status/syndrome of the last attempt
+    uint32_t                syndrome;
+    uint8_t                 cached;     // Known rejected op_mod, no command was issued
+};
+
+// Op_mods the rejection cache can hold, covers every 8-bit op_mod
+#define TLP_EMU_OP_MOD_CACHE_SIZE   0x100
+
+/**
+ * Op_mods a device's firmware rejected with a bad status
+ *
+ * Only firmware rejections are remembered, transport errors are retried.
+ * Zero-initialize before first use; not safe for concurrent sweeps.
+ */
+struct tlp_emu_op_mod_cache {
+    uint64_t    rejected[TLP_EMU_OP_MOD_CACHE_SIZE / 64];
+    uint8_t     status[TLP_EMU_OP_MOD_CACHE_SIZE];
+    uint32_t    syndrome[TLP_EMU_OP_MOD_CACHE_SIZE];
+};
+
+/**
+ * Query and decode all emulated functions of one op_mod
+ *
+ * The output buffer is sized from num_emulated_functions: the first attempt
+ * uses a small buffer and is repeated once with the exact size when firmware
+ * reports more functions than fit.
+ * @param pf_vhca_id: PF to list VFs of (op_mod VF), 0 otherwise
+ * @param list: Filled on return, release with tlp_emu_funcs_free()
+ * @return: 0 on success, -1 on failure (list->status/syndrome tell why)
+ */
+int tlp_emu_funcs_query(struct ibv_context *ctx, uint16_t op_mod, uint16_t pf_vhca_id,
+                        struct tlp_emu_function_list *list);
+void tlp_emu_funcs_free(struct tlp_emu_function_list *list);
+
+// True if the op_mod of list was queried successfully (funcs is only set then)
+static inline int tlp_emu_funcs_ok(const struct tlp_emu_function_list *list)
+{
+    return list->funcs != NULL;
+}
+
+// Upper bound on lists returned by tlp_emu_funcs_query_all()
+#define TLP_EMU_FUNCS_MAX_LISTS     1024
+
+// Commands kept in flight by a sweep
+#define TLP_EMU_FUNCS_SWEEP_THREADS 8
+
+/**
+ * Query several op_mods concurrently
+ *
+ * One command per op_mod is kept in flight from a small thread pool.
+ * Op_mods found in cache are not sent again, their list comes back
+ * failed with the cached status and cached set; new rejections are
+ * added to cache.
+ * @param cache: Optional
+ * @param lists: Array of n, one per op_mod, free each with tlp_emu_funcs_free()
+ * @return: number of op_mods that succeeded
+ */
+int tlp_emu_funcs_sweep(struct ibv_context *ctx, const uint16_t *op_mods, int n,
+                        struct tlp_emu_op_mod_cache *cache, struct tlp_emu_function_list *lists);
+
+/**
+ * List every emulated PF of all op_mods, then the VFs of each PF
+ *
+ * Both stages are swept concurrently, see tlp_emu_funcs_sweep().
+ * @param cache: Optional, skips op_mods this firmware rejected before
+ * @param lists: Array of max_lists, only non-empty lists are returned
+ * @return: number of lists filled, free each with tlp_emu_funcs_free()
+ */
+int tlp_emu_funcs_query_all(struct ibv_context *ctx, struct tlp_emu_op_mod_cache *cache,
+                            struct tlp_emu_function_list *lists, int max_lists);
+
+/**
+ * Decode a QUERY_EMULATED_FUNCTIONS_INFO output in one linear pass
+ *
+ * Entries beyond outlen (truncated output) or max are not decoded.
+ * @return: number of entries written to funcs
+ */
+uint32_t tlp_emu_funcs_decode(const void *out, size_t outlen, uint8_t dev_type,
+                              struct tlp_emu_function *funcs, uint32_t max);
+
+const char *tlp_emu_dev_type_str(uint8_t dev_type);
+
+#endif /* TLP_EMU_FUNCS_H */
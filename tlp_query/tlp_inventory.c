@@ -0,0 +1,221 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - emulated function inventory.
+ * vhca_ids come straight from the decoded QUERY_EMULATED_FUNCTIONS_INFO
+ * output, so each function costs at most one QUERY_VUID and no candidate
+ * IDs are guessed. Both directions are served from open-addressed hash
+ * indexes sized to twice the function count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <infiniband/mlx5dv.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_cmd.h"
+#include "tlp_inventory.h"
+#include "tlp_vuid_resolver.h"
+
+#define TLP_INVENTORY_EMPTY     UINT32_MAX
+
+int tlp_vuid_copy(char *vuid, const void *data)
+{
+    const char *str = data;
+    size_t len;
+
+    // VUID is an ASCII string padded with NULs or spaces
+    len = strnlen(str, TLP_VUID_LEN);
+    while (len > 0 && str[len - 1] == ' ')
+        len--;
+    memcpy(vuid, str, len);
+    vuid[len] = '\0';
+
+    return len ? 0 : 1;
+}
+
+int tlp_vuid_query(struct ibv_context *ctx, uint16_t vhca_id, char *vuid)
+{
+    uint8_t in[TLP_CMD_QUERY_VUID_IN_SZ];
+    uint8_t out[TLP_CMD_QUERY_VUID_OUT_VUID_OFF + TLP_CMD_VUID_SZ] = {0};
+
+    tlp_cmd_query_vuid_in(in, 0, vhca_id);
+
+    if (mlx5dv_devx_general_cmd(ctx, in, sizeof(in), out, sizeof(out)) ||
+        tlp_cmd_query_vuid_out_status(out))
+        return -1;
+
+    if (tlp_cmd_query_vuid_out_num_of_entries(out) == 0)
+        return 1;
+
+    return tlp_vuid_copy(vuid, out + TLP_CMD_QUERY_VUID_OUT_VUID_OFF);
+}
+
+static uint32_t hash_vhca(uint16_t vhca_id)
+{
+    return (uint32_t)vhca_id * 2654435761u;
+}
+
+static uint32_t hash_vuid(const char *vuid)
+{
+    uint32_t hash = 2166136261u;
+
+    for (; *vuid; vuid++) {
+        hash ^= (uint8_t)*vuid;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void tlp_inventory_index_vuids(struct tlp_inventory *inv)
+{
+    memset(inv->by_vuid, 0xff, (inv->index_mask + 1) * sizeof(*inv->by_vuid));
+
+    for (uint32_t i = 0; i < inv->count; i++) {
+        uint32_t slot;
+
+        if (!inv->entries[i].vuid_valid)
+            continue;
+
+        slot = hash_vuid(inv->entries[i].vuid) & inv->index_mask;
+        while (inv->by_vuid[slot] != TLP_INVENTORY_EMPTY)
+            slot = (slot + 1) & inv->index_mask;
+        inv->by_vuid[slot] = i;
+    }
+}
+
+static int inventory_alloc(struct tlp_inventory *inv, uint32_t total)
+{
+    uint32_t buckets = 1;
+
+    memset(inv, 0, sizeof(*inv));
+    while (buckets < 2 * total)
+        buckets <<= 1;
+
+    inv->entries = calloc(total ? total : 1, sizeof(*inv->entries));
+    inv->by_vhca = malloc(buckets * sizeof(*inv->by_vhca));
+    inv->by_vuid = malloc(buckets * sizeof(*inv->by_vuid));
+    if (!inv->entries || !inv->by_vhca || !inv->by_vuid) {
+        tlp_inventory_free(inv);
+        return -1;
+    }
+    memset(inv->by_vhca, 0xff, buckets * sizeof(*inv->by_vhca));
+    memset(inv->by_vuid, 0xff, buckets * sizeof(*inv->by_vuid));
+    inv->index_mask = buckets - 1;
+
+    return 0;
+}
+
+// Append fn unless its vhca_id is already present, returns the new entry
+static struct tlp_inventory_entry *inventory_add(struct tlp_inventory *inv, const struct tlp_emu_function *fn)
+{
+    uint32_t slot = hash_vhca(fn->vhca_id) & inv->index_mask;
+
+    while (inv->by_vhca[slot] != TLP_INVENTORY_EMPTY) {
+        if (inv->entries[inv->by_vhca[slot]].fn.vhca_id == fn->vhca_id)
+            return NULL;
+        slot = (slot + 1) & inv->index_mask;
+    }
+
+    inv->entries[inv->count].fn = *fn;
+    inv->by_vhca[slot] = inv->count;
+    return &inv->entries[inv->count++];
+}
+
+int tlp_inventory_init(struct tlp_inventory *inv, const struct tlp_emu_function_list *lists, int nlists)
+{
+    uint32_t total = 0;
+
+    for (int l = 0; l < nlists; l++)
+        total += lists[l].count;
+    if (inventory_alloc(inv, total))
+        return -1;
+
+    for (int l = 0; l < nlists; l++) {
+        for (uint32_t i = 0; i < lists[l].count; i++)
+            inventory_add(inv, &lists[l].funcs[i]);
+    }
+
+    return 0;
+}
+
+int tlp_inventory_load(struct tlp_inventory *inv, const struct tlp_inventory_entry *entries, uint32_t count)
+{
+    if (inventory_alloc(inv, count))
+        return -1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        struct tlp_inventory_entry *entry = inventory_add(inv, &entries[i].fn);
+
+        if (entry)
+            *entry = entries[i];
+    }
+    tlp_inventory_index_vuids(inv);
+
+    return 0;
+}
+
+int tlp_inventory_resolve(struct ibv_context *ctx, struct tlp_inventory *inv)
+{
+    int resolved = 0;
+
+    for (uint32_t i = 0; i < inv->count; i++) {
+        struct tlp_inventory_entry *entry = &inv->entries[i];
+
+        entry->vuid_valid = tlp_vuid_query(ctx, entry->fn.vhca_id, entry->vuid) == 0;
+        resolved += entry->vuid_valid;
+    }
+
+    tlp_inventory_index_vuids(inv);
+    return resolved;
+}
+
+int tlp_inventory_build(struct ibv_context *ctx, struct tlp_inventory *inv,
+                        const struct tlp_emu_function_list *lists, int nlists)
+{
+    if (tlp_inventory_init(inv, lists, nlists))
+        return -1;
+    return tlp_vuid_resolve(ctx, inv, TLP_VUID_RESOLVER_WORKERS, TLP_VUID_RESOLVE_BATCH_VFS);
+}
+
+void tlp_inventory_free(struct tlp_inventory *inv)
+{
+    free(inv->entries);
+    free(inv->by_vhca);
+    free(inv->by_vuid);
+    memset(inv, 0, sizeof(*inv));
+}
+
+const struct tlp_inventory_entry *tlp_inventory_find_vhca(const struct tlp_inventory *inv, uint16_t vhca_id)
+{
+    uint32_t slot;
+
+    if (!inv->by_vhca)
+        return NULL;
+
+    for (slot = hash_vhca(vhca_id) & inv->index_mask;
+         inv->by_vhca[slot] != TLP_INVENTORY_EMPTY;
+         slot = (slot + 1) & inv->index_mask) {
+        if (inv->entries[inv->by_vhca[slot]].fn.vhca_id == vhca_id)
+            return &inv->entries[inv->by_vhca[slot]];
+    }
+    return NULL;
+}
+
+const struct tlp_inventory_entry *tlp_inventory_find_vuid(const struct tlp_inventory *inv, const char *vuid)
+{
+    uint32_t slot;
+
+    if (!inv->by_vuid)
+        return NULL;
+
+    for (slot = hash_vuid(vuid) & inv->index_mask;
+         inv->by_vuid[slot] != TLP_INVENTORY_EMPTY;
+         slot = (slot + 1) & inv->index_mask) {
+        if (strcmp(inv->entries[inv->by_vuid[slot]].vuid, vuid) == 0)
+            return &inv->entries[inv->by_vuid[slot]];
+    }
+    return NULL;
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - emulated function inventory with vhca_id/VUID index
+ */
+
+#ifndef TLP_INVENTORY_H
+#define TLP_INVENTORY_H
+
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+#include "tlp_emu_funcs.h"
+
+// One mlx5_ifc_vuid_bits entry, 0x400 bits
+#define TLP_VUID_LEN    128
+
+struct tlp_inventory_entry {
+    struct tlp_emu_function fn;
+    uint8_t                 vuid_valid;
+    char                    vuid[TLP_VUID_LEN + 1];
+};
+
+struct tlp_inventory {
+    struct tlp_inventory_entry  *entries;
+    uint32_t                    count;
+
+    // Open-addressed indexes into entries, UINT32_MAX marks an empty slot
+    uint32_t                    *by_vhca;
+    uint32_t                    *by_vuid;
+    uint32_t                    index_mask;
+};
+
+/**
+ * Query the VUID of one function with a single QUERY_VUID
+ *
+ * @param vuid: At least TLP_VUID_LEN + 1 bytes, NUL terminated on return
+ * @return: 0 if a VUID was returned, 1 if firmware returned no entry, -1 on failure
+ */
+int tlp_vuid_query(struct ibv_context *ctx, uint16_t vhca_id, char *vuid);
+
+/**
+ * Copy one VUID out of a QUERY_VUID output entry, dropping padding
+ *
+ * @return: 0 if the VUID is non-empty, 1 otherwise
+ */
+int tlp_vuid_copy(char *vuid, const void *data);
+
+/**
+ * Collect functions from decoded QUERY_EMULATED_FUNCTIONS_INFO lists
+ *
+ * A vhca_id listed under several op_mods is kept once, first list wins.
+ * VUIDs are not resolved yet, see tlp_inventory_resolve().
+ * @return: 0 on success, -1 on allocation failure
+ */
+int tlp_inventory_init(struct tlp_inventory *inv, const struct tlp_emu_function_list *lists, int nlists);
+
+/**
+ * Build an inventory from already resolved entries, e.g. a shared-memory snapshot
+ *
+ * @return: 0 on success, -1 on allocation failure
+ */
+int tlp_inventory_load(struct tlp_inventory *inv, const struct tlp_inventory_entry *entries, uint32_t count);
+
+/**
+ * Resolve the VUID of every function (one blocking QUERY_VUID each) and index them
+ *
+ * Sequential reference path, tlp_inventory_build() uses tlp_vuid_resolve().
+ * @return: number of functions with a VUID
+ */
+int tlp_inventory_resolve(struct ibv_context *ctx, struct tlp_inventory *inv);
+
+/**
+ * Rebuild the VUID -> vhca_id index after entries were resolved
+ */
+void tlp_inventory_index_vuids(struct tlp_inventory *inv);
+
+/**
+ * tlp_inventory_init() followed by pipelined VUID resolution
+ */
+int tlp_inventory_build(struct ibv_context *ctx, struct tlp_inventory *inv,
+                        const struct tlp_emu_function_list *lists, int nlists);
+void tlp_inventory_free(struct tlp_inventory *inv);
+
+const struct tlp_inventory_entry *tlp_inventory_find_vhca(const struct tlp_inventory *inv, uint16_t vhca_id);
+const struct tlp_inventory_entry *tlp_inventory_find_vuid(const struct tlp_inventory *inv, const char *vuid);
+
+#endif /* TLP_INVENTORY_H */
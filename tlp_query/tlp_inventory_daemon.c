@@ -0,0 +1,216 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Inventory Daemon
+ * 持有设备上下文, 发现模拟功能并解析VUID, 发布到共享内存供只读客户端使用.
+ * 设备支持DevX事件时按热插拔/状态变化事件增量更新, 否则周期性轮询
+ */
+
+#include <infiniband/verbs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_devices.h"
+#include "tlp_emu_funcs.h"
+#include "tlp_inventory.h"
+#include "tlp_inventory_events.h"
+#include "tlp_inventory_shm.h"
+#include "tlp_vuid_resolver.h"
+
+struct daemon_device {
+    const char                  *name;
+    struct ibv_context          *ctx;
+    struct tlp_inventory_shm    *shm;
+    struct tlp_inventory_events *events;    // NULL: device is polled
+    struct tlp_emu_op_mod_cache op_mods;    // Op_mods rejected by this firmware
+    struct tlp_inventory        inv;        // Last published inventory
+    struct tlp_inventory_events_stats stats;
+};
+
+static volatile sig_atomic_t daemon_stop;
+
+static long now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void daemon_signal(int sig)
+{
+    (void)sig;
+    daemon_stop = 1;
+}
+
+// 发布当前清单, 内容未变化时不更新共享内存
+static int publish_device(struct daemon_device *dev)
+{
+    int ret = tlp_inventory_shm_publish(dev->shm, &dev->inv);
+    int resolved = 0;
+    
+    for (uint32_t i = 0; i < dev->inv.count; i++)
+        resolved += dev->inv.entries[i].vuid_valid;
+    
+    if (ret > 0)
+        printf("📢 %s: %u 个功能, %d 个VUID, generation %lu\n", dev->name, dev->inv.count,
+               resolved, (unsigned long)tlp_inventory_shm_generation(dev->shm));
+    else if (ret < 0)
+        printf("❌ %s: %u 个功能超出共享内存容量 %d\n", dev->name, dev->inv.count, TLP_INVENTORY_SHM_MAX_FUNCS);
+    
+    return ret < 0 ? -1 : 0;
+}
+
+// 发现一个设备的全部模拟功能并重新解析所有VUID
+static int refresh_device(struct daemon_device *dev)
+{
+    static struct tlp_emu_function_list lists[TLP_EMU_FUNCS_MAX_LISTS];
+    struct tlp_inventory inv;
+    int nlists, ret;
+
+    nlists = tlp_emu_funcs_query_all(dev->ctx, &dev->op_mods, lists, TLP_EMU_FUNCS_MAX_LISTS);
+    ret = tlp_inventory_init(&inv, lists, nlists);
+    for (int l = 0; l < nlists; l++)
+        tlp_emu_funcs_free(&lists[l]);
+    if (ret)
+        return -1;
+
+    tlp_vuid_resolve(dev->ctx, &inv, TLP_VUID_RESOLVER_WORKERS, TLP_VUID_RESOLVE_BATCH_VFS);
+    tlp_inventory_free(&dev->inv);
+    dev->inv = inv;
+    return publish_device(dev);
+}
+
+// 处理设备上待处理的事件, 只更新受影响的条目
+static int handle_events(struct daemon_device *dev)
+{
+    struct timespec start, end;
+    int changed;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    changed = tlp_inventory_events_apply(dev->events, dev->ctx, &dev->inv, &dev->stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (changed <= 0)
+        return changed;
+
+    printf("⚡ %s: %d 个条目变化, 用时 %.1f us (累计 %u 个事件, %u 次QUERY_VUID, %u 次重新发现)\n",
+           dev->name, changed,
+           (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3,
+           dev->stats.events, dev->stats.vuid_queries, dev->stats.rediscoveries);
+    return publish_device(dev);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pattern = argc > 1 ? argv[1] : "mlx5_*";
+    long interval_ms = argc > 2 ? strtol(argv[2], NULL, 0) : 1000;
+    struct daemon_device *devs;
+    struct tlp_device_set devices;
+    struct sigaction sa = { .sa_handler = daemon_signal };
+    int ndevs = 0, ret = 1;
+
+    printf("🛰️  TLP Inventory Daemon\n");
+    printf("========================\n");
+    printf("Usage: %s [device|pattern] [interval_ms]\n\n", argv[0]);
+
+    if (tlp_devices_match(pattern, &devices) <= 0) {
+        printf("❌ 设备 %s 未找到\n", pattern);
+        tlp_devices_release(&devices);
+        return 1;
+    }
+
+    devs = calloc(devices.nmatch, sizeof(*devs));
+    if (!devs)
+        goto out;
+
+    for (int i = 0; i < devices.nmatch; i++) {
+        struct daemon_device *dev = &devs[ndevs];
+
+        dev->name = ibv_get_device_name(devices.match[i]);
+        dev->ctx = ibv_open_device(devices.match[i]);
+        if (!dev->ctx) {
+            printf("⚠️  打开设备 %s 失败, 跳过\n", dev->name);
+            continue;
+        }
+        dev->shm = tlp_inventory_shm_create(dev->name);
+        if (!dev->shm) {
+            printf("⚠️  %s: 创建共享内存失败: %s\n", dev->name, strerror(errno));
+            ibv_close_device(dev->ctx);
+            continue;
+        }
+        dev->events = tlp_inventory_events_open(dev->ctx);
+        printf("✅ %s -> /dev/shm%s%s (%s)\n", dev->name, TLP_INVENTORY_SHM_PREFIX, dev->name,
+               dev->events ? "事件驱动" : "轮询");
+        ndevs++;
+    }
+    if (ndevs == 0)
+        goto out_devs;
+
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+
+    // 首次全量发现, 之后事件驱动的设备只在事件到来时更新
+    for (int i = 0; i < ndevs; i++)
+        refresh_device(&devs[i]);
+
+    printf("\n🔄 事件驱动设备即时更新, 其余每 %ld ms 轮询一次, Ctrl-C 退出\n", interval_ms);
+    long next_poll = now_ms() + interval_ms;
+    
+    while (!daemon_stop) {
+        struct pollfd pfds[ndevs];
+        int npolled = 0, nfds = 0, timeout = -1;
+
+        for (int i = 0; i < ndevs; i++) {
+            if (!devs[i].events) {
+                npolled++;
+                continue;
+            }
+            pfds[nfds].fd = tlp_inventory_events_fd(devs[i].events);
+            pfds[nfds].events = POLLIN;
+            nfds++;
+        }
+        if (npolled)
+            timeout = next_poll > now_ms() ? (int)(next_poll - now_ms()) : 0;
+
+        // Cut short by events or the stop signal
+        if (poll(pfds, nfds, timeout) < 0 && errno != EINTR)
+            break;
+        if (daemon_stop)
+            break;
+
+        for (int i = 0, fd = 0; i < ndevs; i++) {
+            if (devs[i].events && (pfds[fd++].revents & POLLIN))
+                handle_events(&devs[i]);
+        }
+
+        if (npolled && now_ms() >= next_poll) {
+            for (int i = 0; i < ndevs; i++) {
+                if (!devs[i].events)
+                    refresh_device(&devs[i]);
+            }
+            next_poll = now_ms() + interval_ms;
+        }
+    }
+    printf("\n👋 停止发布, 清理共享内存\n");
+    ret = 0;
+
+out_devs:
+    for (int i = 0; i < ndevs; i++) {
+        tlp_inventory_events_close(devs[i].events);
+        tlp_inventory_free(&devs[i].inv);
+        tlp_inventory_shm_destroy(devs[i].shm);
+        ibv_close_device(devs[i].ctx);
+    }
+    free(devs);
+out:
+    tlp_devices_release(&devices);
+    return ret;
+}
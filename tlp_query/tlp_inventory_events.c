@@ -0,0 +1,282 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - event-driven inventory refresh.
+ * Instead of re-listing every op_mod on a timer, the device's unaffiliated
+ * VHCA_STATE_CHANGE and ESW_FUNCTIONS_CHANGED events are read from a DevX
+ * event channel. Events are coalesced per drain: each vhca_id is queried
+ * at most once however many events it produced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <infiniband/mlx5dv.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_cmd.h"
+#include "tlp_emu_funcs.h"
+#include "tlp_inventory_events.h"
+#include "tlp_vuid_resolver.h"
+
+#define TLP_INVENTORY_EVENTS_COOKIE     0x544c5049      // "TLPI"
+#define TLP_INVENTORY_EVENTS_VHCA_IDS   (UINT16_MAX + 1)
+
+struct tlp_inventory_events {
+    struct mlx5dv_devx_event_channel    *channel;
+    struct tlp_emu_op_mod_cache         op_mods;    // Re-listing skips rejected op_mods
+
+    // vhca_ids with a pending state change, bitmap dedupes repeated events
+    uint64_t                            dirty[TLP_INVENTORY_EVENTS_VHCA_IDS / 64];
+    uint16_t                            dirty_ids[TLP_INVENTORY_EVENTS_VHCA_IDS];
+    uint32_t                            ndirty;
+};
+
+static int is_dirty(const struct tlp_inventory_events *ev, uint16_t vhca_id)
+{
+    return (ev->dirty[vhca_id / 64] >> (vhca_id % 64)) & 1;
+}
+
+static void mark_dirty(struct tlp_inventory_events *ev, uint16_t vhca_id)
+{
+    if (is_dirty(ev, vhca_id))
+        return;
+    ev->dirty[vhca_id / 64] |= 1ull << (vhca_id % 64);
+    ev->dirty_ids[ev->ndirty++] = vhca_id;
+}
+
+static void clear_dirty(struct tlp_inventory_events *ev)
+{
+    for (uint32_t i = 0; i < ev->ndirty; i++)
+        ev->dirty[ev->dirty_ids[i] / 64] = 0;
+    ev->ndirty = 0;
+}
+
+struct tlp_inventory_events *tlp_inventory_events_open(struct ibv_context *ctx)
+{
+    uint16_t events[] = {
+        MLX5_EVENT_TYPE_VHCA_STATE_CHANGE,
+        MLX5_EVENT_TYPE_ESW_FUNCTIONS_CHANGED,
+    };
+    struct tlp_inventory_events *ev;
+    int flags;
+
+    ev = calloc(1, sizeof(*ev));
+    if (!ev)
+        return NULL;
+
+    ev->channel = mlx5dv_devx_create_event_channel(ctx, 0);
+    if (!ev->channel)
+        goto err;
+
+    // Unaffiliated events, no object to attach to
+    if (mlx5dv_devx_subscribe_devx_event(ev->channel, NULL, sizeof(events), events,
+                                         TLP_INVENTORY_EVENTS_COOKIE))
+        goto err;
+
+    flags = fcntl(ev->channel->fd, F_GETFL);
+    if (flags < 0 || fcntl(ev->channel->fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        goto err;
+
+    return ev;
+
+err:
+    tlp_inventory_events_close(ev);
+    return NULL;
+}
+
+void tlp_inventory_events_close(struct tlp_inventory_events *ev)
+{
+    if (!ev)
+        return;
+    if (ev->channel)
+        mlx5dv_devx_destroy_event_channel(ev->channel);
+    free(ev);
+}
+
+int tlp_inventory_events_fd(const struct tlp_inventory_events *ev)
+{
+    return ev->channel->fd;
+}
+
+static int entry_changed(const struct tlp_inventory_entry *a, const struct tlp_inventory_entry *b)
+{
+    return memcmp(&a->fn, &b->fn, sizeof(a->fn)) != 0 || a->vuid_valid != b->vuid_valid ||
+           (a->vuid_valid && strcmp(a->vuid, b->vuid) != 0);
+}
+
+// Re-query the VUID of known functions only, the function list is unchanged
+static int patch_dirty(struct tlp_inventory_events *ev, struct ibv_context *ctx,
+                       struct tlp_inventory *inv, struct tlp_inventory_events_stats *stats)
+{
+    int changed = 0;
+
+    for (uint32_t i = 0; i < ev->ndirty; i++) {
+        const struct tlp_inventory_entry *found = tlp_inventory_find_vhca(inv, ev->dirty_ids[i]);
+        struct tlp_inventory_entry *entry, old;
+        int ret;
+
+        if (!found)
+            continue;
+        entry = &inv->entries[found - inv->entries];
+        old = *entry;
+
+        ret = tlp_vuid_query(ctx, entry->fn.vhca_id, entry->vuid);
+        stats->vuid_queries++;
+        if (ret < 0) {
+            *entry = old;
+            continue;
+        }
+        entry->vuid_valid = ret == 0;
+        changed += entry_changed(entry, &old);
+    }
+
+    if (changed)
+        tlp_inventory_index_vuids(inv);
+    return changed;
+}
+
+/*
+ * Re-list the functions and carry VUIDs over from the current inventory;
+ * only new, modified or dirty entries (all of them when rebuild is set)
+ * are resolved again.
+ */
+static int rediscover(struct tlp_inventory_events *ev, struct ibv_context *ctx,
+                      struct tlp_inventory *inv, int rebuild, struct tlp_inventory_events_stats *stats)
+{
+    struct tlp_emu_function_list *lists;
+    struct tlp_inventory fresh, pending;
+    struct tlp_inventory_entry *todo;
+    struct tlp_vuid_resolve_stats rstats = {0};
+    uint32_t ntodo = 0;
+    int nlists, ret, changed = 0;
+
+    lists = calloc(TLP_EMU_FUNCS_MAX_LISTS, sizeof(*lists));
+    if (!lists)
+        return -1;
+    nlists = tlp_emu_funcs_query_all(ctx, &ev->op_mods, lists, TLP_EMU_FUNCS_MAX_LISTS);
+    ret = tlp_inventory_init(&fresh, lists, nlists);
+    for (int l = 0; l < nlists; l++)
+        tlp_emu_funcs_free(&lists[l]);
+    free(lists);
+    if (ret)
+        return -1;
+    stats->rediscoveries++;
+
+    todo = calloc(fresh.count ? fresh.count : 1, sizeof(*todo));
+    if (!todo) {
+        tlp_inventory_free(&fresh);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < fresh.count; i++) {
+        struct tlp_inventory_entry *entry = &fresh.entries[i];
+        const struct tlp_inventory_entry *old = tlp_inventory_find_vhca(inv, entry->fn.vhca_id);
+
+        if (!rebuild && old && !is_dirty(ev, entry->fn.vhca_id) &&
+            memcmp(&old->fn, &entry->fn, sizeof(entry->fn)) == 0) {
+            entry->vuid_valid = old->vuid_valid;
+            memcpy(entry->vuid, old->vuid, sizeof(entry->vuid));
+            continue;
+        }
+        todo[ntodo++] = *entry;
+    }
+
+    // Resolve just the pending entries, VFs of one PF still go out as one batch
+    if (ntodo) {
+        if (tlp_inventory_load(&pending, todo, ntodo) == 0) {
+            tlp_vuid_resolve_stats(ctx, &pending, TLP_VUID_RESOLVER_WORKERS,
+                                   TLP_VUID_RESOLVE_BATCH_VFS, &rstats);
+            for (uint32_t i = 0; i < pending.count; i++) {
+                const struct tlp_inventory_entry *resolved = &pending.entries[i];
+                const struct tlp_inventory_entry *found = tlp_inventory_find_vhca(&fresh, resolved->fn.vhca_id);
+
+                fresh.entries[found - fresh.entries] = *resolved;
+            }
+            tlp_inventory_free(&pending);
+        }
+        stats->vuid_queries += rstats.commands;
+    }
+    free(todo);
+    tlp_inventory_index_vuids(&fresh);
+
+    for (uint32_t i = 0; i < fresh.count; i++) {
+        const struct tlp_inventory_entry *old = tlp_inventory_find_vhca(inv, fresh.entries[i].fn.vhca_id);
+
+        changed += !old || entry_changed(old, &fresh.entries[i]);
+    }
+    for (uint32_t i = 0; i < inv->count; i++)
+        changed += !tlp_inventory_find_vhca(&fresh, inv->entries[i].fn.vhca_id);
+
+    tlp_inventory_free(inv);
+    *inv = fresh;
+    return changed;
+}
+
+int tlp_inventory_events_apply(struct tlp_inventory_events *ev, struct ibv_context *ctx,
+                               struct tlp_inventory *inv, struct tlp_inventory_events_stats *stats)
+{
+    // Cookie followed by the whole EQE, uint64_t keeps the cookie aligned
+    uint64_t buf[(sizeof(struct mlx5dv_devx_async_event_hdr) + TLP_CMD_EQE_SZ) / 8];
+    struct mlx5dv_devx_async_event_hdr *hdr = (void *)buf;
+    struct tlp_inventory_events_stats local = {0};
+    int relist = 0, rebuild = 0, nevents = 0, ret;
+
+    if (!stats)
+        stats = &local;
+
+    for (;;) {
+        ssize_t len = mlx5dv_devx_get_event(ev->channel, hdr, sizeof(buf));
+        const void *eqe_data = hdr->out_data;
+
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            if (errno == EOVERFLOW) {
+                rebuild = 1;    // Events were dropped, nothing can be trusted
+                continue;
+            }
+            clear_dirty(ev);
+            return -1;
+        }
+        nevents++;
+        stats->events++;
+
+        if (len < (ssize_t)sizeof(*hdr) + TLP_CMD_EQE_SZ) {
+            relist = 1;     // Data omitted, the event type alone is unknown
+            continue;
+        }
+
+        switch (tlp_cmd_eqe_event_type(eqe_data)) {
+        case MLX5_EVENT_TYPE_VHCA_STATE_CHANGE: {
+            uint16_t vhca_id = tlp_cmd_vhca_state_change_event_function_id(
+                                   (const uint8_t *)eqe_data + TLP_CMD_EQE_EVENT_DATA_OFF);
+
+            mark_dirty(ev, vhca_id);
+            if (!tlp_inventory_find_vhca(inv, vhca_id))
+                relist = 1;
+            break;
+        }
+        case MLX5_EVENT_TYPE_ESW_FUNCTIONS_CHANGED:
+        default:
+            relist = 1;
+            break;
+        }
+    }
+
+    if (!nevents && !rebuild)
+        return 0;
+
+    if (relist || rebuild)
+        ret = rediscover(ev, ctx, inv, rebuild, stats);
+    else
+        ret = patch_dirty(ev, ctx, inv, stats);
+    clear_dirty(ev);
+
+    if (ret > 0)
+        stats->changed += ret;
+    return ret;
+}
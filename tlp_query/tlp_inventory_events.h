@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - event-driven inventory refresh
+ */
+
+#ifndef TLP_INVENTORY_EVENTS_H
+#define TLP_INVENTORY_EVENTS_H
+
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+#include "tlp_inventory.h"
+
+struct tlp_inventory_events;
+
+struct tlp_inventory_events_stats {
+    uint32_t    events;         // Events read from the channel
+    uint32_t    vuid_queries;   // QUERY_VUID commands issued by the patch
+    uint32_t    rediscoveries;  // Function list re-queried (new function or ESW change)
+    uint32_t    changed;        // Entries added, removed or modified
+};
+
+/**
+ * Subscribe to function hotplug and state change events of a device
+ *
+ * Subscribes to VHCA_STATE_CHANGE and ESW_FUNCTIONS_CHANGED on a DevX
+ * event channel. The channel fd is non-blocking and can be polled.
+ * @return: Event handle, NULL if the device does not deliver these events
+ */
+struct tlp_inventory_events *tlp_inventory_events_open(struct ibv_context *ctx);
+void tlp_inventory_events_close(struct tlp_inventory_events *ev);
+
+/**
+ * File descriptor that becomes readable when events are pending
+ */
+int tlp_inventory_events_fd(const struct tlp_inventory_events *ev);
+
+/**
+ * Drain pending events and patch the inventory in place
+ *
+ * A state change of a known function re-queries only its VUID. A change
+ * on an unknown vhca_id or of the eswitch function set re-lists the
+ * functions and resolves VUIDs of new or modified entries only; entries
+ * that did not change keep their VUID. Lost events (channel overflow)
+ * rebuild the inventory.
+ * @param stats: Optional, accumulated
+ * @return: number of entries changed, 0 if nothing pending, -1 on failure
+ */
+int tlp_inventory_events_apply(struct tlp_inventory_events *ev, struct ibv_context *ctx,
+                               struct tlp_inventory *inv, struct tlp_inventory_events_stats *stats);
+
+#endif /* TLP_INVENTORY_EVENTS_H */
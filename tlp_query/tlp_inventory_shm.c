@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - emulated function inventory in shared memory.
+ * A single writer (tlp_inventory_daemon) publishes, any number of readers
+ * map the segment read-only. Consistency comes from a sequence lock: the
+ * writer makes seq odd, updates the entries and makes it even again; a
+ * reader copies the entries and retries if seq was odd or changed. The
+ * writer holds an flock() on the segment for its lifetime, so a second
+ * daemon for the same device fails to create instead of racing it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tlp_inventory_shm.h"
+
+#define TLP_INVENTORY_SHM_MAGIC     0x49504c54      // "TLPI"
+#define TLP_INVENTORY_SHM_VERSION   1
+
+// Reader spins this many times on a busy writer before yielding the CPU
+#define TLP_INVENTORY_SHM_SPINS     64
+
+struct tlp_inventory_shm_hdr {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    entry_size;     // sizeof(struct tlp_inventory_entry) of the writer
+    uint32_t    capacity;
+    uint32_t    count;
+    uint64_t    seq;            // Odd while the writer updates the entries
+    uint64_t    generation;     // Bumped on every published change
+    uint64_t    updated_ns;     // CLOCK_REALTIME of the last change
+    int32_t     writer_pid;
+    uint32_t    reserved;
+    char        dev_name[IBV_SYSFS_NAME_MAX];
+} __attribute__((aligned(64)));
+
+struct tlp_inventory_shm {
+    struct tlp_inventory_shm_hdr    *hdr;
+    struct tlp_inventory_entry      *entries;
+    size_t                          size;
+    int                             lock_fd;        // Writer only, holds the flock()
+    char                            name[IBV_SYSFS_NAME_MAX + sizeof(TLP_INVENTORY_SHM_PREFIX)];
+};
+
+static size_t shm_size(uint32_t capacity)
+{
+    return sizeof(struct tlp_inventory_shm_hdr) + (size_t)capacity * sizeof(struct tlp_inventory_entry);
+}
+
+static struct tlp_inventory_shm *shm_map(const char *dev_name, int writer)
+{
+    struct tlp_inventory_shm *shm;
+    struct stat st;
+    int fd, errno_save;
+
+    shm = calloc(1, sizeof(*shm));
+    if (!shm)
+        return NULL;
+    shm->lock_fd = -1;
+    snprintf(shm->name, sizeof(shm->name), "%s%s", TLP_INVENTORY_SHM_PREFIX, dev_name);
+
+    fd = shm_open(shm->name, writer ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0)
+        goto err;
+
+    if (writer) {
+        // One writer per segment, released when the writer exits
+        if (flock(fd, LOCK_EX | LOCK_NB)) {
+            if (errno == EWOULDBLOCK) {
+                fprintf(stderr, "Inventory segment %s already has a writer\n", shm->name);
+                errno = EBUSY;
+            }
+            goto err_close;
+        }
+        shm->size = shm_size(TLP_INVENTORY_SHM_MAX_FUNCS);
+        // Sparse: pages beyond the published entries are never touched
+        if (ftruncate(fd, shm->size))
+            goto err_close;
+    } else {
+        if (fstat(fd, &st) || (size_t)st.st_size < sizeof(struct tlp_inventory_shm_hdr))
+            goto err_close;
+        shm->size = st.st_size;
+    }
+
+    shm->hdr = mmap(NULL, shm->size, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (shm->hdr == MAP_FAILED)
+        goto err_close;
+    if (writer)
+        shm->lock_fd = fd;
+    else
+        close(fd);
+    shm->entries = (struct tlp_inventory_entry *)(shm->hdr + 1);
+
+    return shm;
+
+err_close:
+    errno_save = errno;
+    close(fd);
+    errno = errno_save;
+err:
+    free(shm);
+    return NULL;
+}
+
+static void seq_write_begin(struct tlp_inventory_shm_hdr *hdr)
+{
+    __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void seq_write_end(struct tlp_inventory_shm_hdr *hdr)
+{
+    __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELEASE);
+}
+
+struct tlp_inventory_shm *tlp_inventory_shm_create(const char *dev_name)
+{
+    struct tlp_inventory_shm *shm = shm_map(dev_name, 1);
+    struct tlp_inventory_shm_hdr *hdr;
+
+    if (!shm)
+        return NULL;
+
+    // A previous daemon may have left the segment behind, possibly mid-update:
+    // keep seq monotonic and even before the write begins
+    hdr = shm->hdr;
+    __atomic_store_n(&hdr->seq, (hdr->seq + 1) & ~1ULL, __ATOMIC_RELAXED);
+    seq_write_begin(hdr);
+    hdr->version = TLP_INVENTORY_SHM_VERSION;
+    hdr->entry_size = sizeof(struct tlp_inventory_entry);
+    hdr->capacity = TLP_INVENTORY_SHM_MAX_FUNCS;
+    hdr->count = 0;
+    hdr->generation++;
+    hdr->updated_ns = 0;
+    hdr->writer_pid = getpid();
+    snprintf(hdr->dev_name, sizeof(hdr->dev_name), "%s", dev_name);
+    hdr->magic = TLP_INVENTORY_SHM_MAGIC;
+    seq_write_end(hdr);
+
+    return shm;
+}
+
+int tlp_inventory_shm_publish(struct tlp_inventory_shm *shm, const struct tlp_inventory *inv)
+{
+    struct tlp_inventory_shm_hdr *hdr = shm->hdr;
+    struct timespec now;
+
+    if (inv->count > hdr->capacity)
+        return -1;
+
+    // Only the writer modifies the segment, comparing without the lock is safe.
+    // The first publish always goes out, even empty: readers take
+    // updated_ns == 0 for "nothing published yet"
+    if (hdr->updated_ns && hdr->count == inv->count &&
+        memcmp(shm->entries, inv->entries, inv->count * sizeof(*inv->entries)) == 0)
+        return 0;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    seq_write_begin(hdr);
+    memcpy(shm->entries, inv->entries, inv->count * sizeof(*inv->entries));
+    hdr->count = inv->count;
+    hdr->generation++;
+    hdr->updated_ns = now.tv_sec * 1000000000ull + now.tv_nsec;
+    seq_write_end(hdr);
+
+    return 1;
+}
+
+void tlp_inventory_shm_destroy(struct tlp_inventory_shm *shm)
+{
+    if (!shm)
+        return;
+    munmap(shm->hdr, shm->size);
+    shm_unlink(shm->name);
+    close(shm->lock_fd);
+    free(shm);
+}
+
+struct tlp_inventory_shm *tlp_inventory_shm_attach(const char *dev_name)
+{
+    struct tlp_inventory_shm *shm = shm_map(dev_name, 0);
+
+    if (!shm)
+        return NULL;
+
+    if (shm->hdr->magic != TLP_INVENTORY_SHM_MAGIC ||
+        shm->hdr->version != TLP_INVENTORY_SHM_VERSION ||
+        shm->hdr->entry_size != sizeof(struct tlp_inventory_entry) ||
+        shm_size(shm->hdr->capacity) > shm->size) {
+        tlp_inventory_shm_detach(shm);
+        return NULL;
+    }
+
+    // Nothing published yet, or left behind by a daemon that died
+    if (shm->hdr->updated_ns == 0 ||
+        (kill(shm->hdr->writer_pid, 0) != 0 && errno == ESRCH)) {
+        tlp_inventory_shm_detach(shm);
+        return NULL;
+    }
+
+    return shm;
+}
+
+/*
+ * Wait for a writer mid-update: pause first, then give it the CPU, which it
+ * needs when both share one
+ */
+static void backoff(uint32_t *spins)
+{
+    if (*spins < TLP_INVENTORY_SHM_SPINS) {
+        (*spins)++;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        return;
+    }
+    sched_yield();
+}
+
+int tlp_inventory_shm_snapshot(const struct tlp_inventory_shm *shm, struct tlp_inventory *inv,
+                               uint64_t *generation)
+{
+    const struct tlp_inventory_shm_hdr *hdr = shm->hdr;
+    struct tlp_inventory_entry *copy = NULL;
+    uint32_t capacity = 0, count, spins = 0;
+    uint64_t seq, gen;
+    int ret;
+
+    for (;; backoff(&spins)) {
+        seq = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+
+        count = hdr->count;
+        gen = hdr->generation;
+        if (count > hdr->capacity)
+            continue;   // Torn read of count, seq check below would fail anyway
+
+        if (count > capacity) {
+            free(copy);
+            capacity = count;
+            copy = malloc(capacity * sizeof(*copy));
+            if (!copy)
+                return -1;
+        }
+        memcpy(copy, shm->entries, count * sizeof(*copy));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&hdr->seq, __ATOMIC_RELAXED) == seq)
+            break;
+    }
+
+    ret = tlp_inventory_load(inv, copy, count);
+    free(copy);
+    if (ret == 0 && generation)
+        *generation = gen;
+    return ret;
+}
+
+uint64_t tlp_inventory_shm_generation(const struct tlp_inventory_shm *shm)
+{
+    return __atomic_load_n(&shm->hdr->generation, __ATOMIC_ACQUIRE);
+}
+
+void tlp_inventory_shm_detach(struct tlp_inventory_shm *shm)
+{
+    if (!shm)
+        return;
+    munmap(shm->hdr, shm->size);
+    free(shm);
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - emulated function inventory in shared memory
+ */
+
+#ifndef TLP_INVENTORY_SHM_H
+#define TLP_INVENTORY_SHM_H
+
+#include <stdint.h>
+
+#include "tlp_inventory.h"
+
+// One POSIX shared-memory segment per device: /dev/shm/tlp_inventory.<dev>
+#define TLP_INVENTORY_SHM_PREFIX        "/tlp_inventory."
+#define TLP_INVENTORY_SHM_MAX_FUNCS     65536
+
+struct tlp_inventory_shm;
+
+/**
+ * Create (or take over) the segment of a device for publishing
+ *
+ * @return: Writer handle, NULL on failure (errno EBUSY when another live
+ *          writer holds the segment)
+ */
+struct tlp_inventory_shm *tlp_inventory_shm_create(const char *dev_name);
+
+/**
+ * Publish an inventory, readers never observe a partial update
+ *
+ * @return: 1 if published, 0 if unchanged, -1 if it does not fit
+ */
+int tlp_inventory_shm_publish(struct tlp_inventory_shm *shm, const struct tlp_inventory *inv);
+
+/**
+ * Unmap and remove the segment
+ */
+void tlp_inventory_shm_destroy(struct tlp_inventory_shm *shm);
+
+/**
+ * Map the segment of a device read-only
+ *
+ * @return: Reader handle, NULL if no live daemon published this device
+ */
+struct tlp_inventory_shm *tlp_inventory_shm_attach(const char *dev_name);
+
+/**
+ * Take a consistent copy of the published inventory
+ *
+ * Lock-free: retries while the writer is mid-update, pausing and then
+ * yielding the CPU, and issues no other syscalls beyond the allocation of inv.
+ * @param generation: Optional, set to the generation of the snapshot
+ * @return: 0 on success, -1 on failure
+ */
+int tlp_inventory_shm_snapshot(const struct tlp_inventory_shm *shm, struct tlp_inventory *inv,
+                               uint64_t *generation);
+
+/**
+ * Generation of the current contents, cheap staleness check for readers
+ */
+uint64_t tlp_inventory_shm_generation(const struct tlp_inventory_shm *shm);
+
+void tlp_inventory_shm_detach(struct tlp_inventory_shm *shm);
+
+#endif /* TLP_INVENTORY_SHM_H */
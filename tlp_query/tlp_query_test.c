@@ -13,203 +13,83 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "mlx5_ifc.h"
+#include "tlp_emu_funcs.h"
+#include "tlp_inventory.h"
+#include "tlp_inventory_shm.h"
 
 // 添加缺失的常量定义
 #define MLX5_CMD_OPCODE_QUERY_EMULATED_FUNCTIONS_INFO 0xb03
 #define PRM_EMULATION_OPMOD_GENERIC_PF      0x6
 #define PRM_EMULATION_OPMOD_TLP_DEVICES     0x7
 
-// Use the working 16-bit format (this triggers firmware logs)
-struct cmd_in {
-    uint16_t opcode;
-    uint16_t uid;
-    uint16_t reserved1;
-    uint16_t op_mod;
-    uint32_t reserved2;
-    uint16_t reserved3;
-    uint16_t pf_vhca_id;
-};
-
-struct cmd_out {
-    uint8_t  status;
-    uint8_t  reserved0[3];
-    uint32_t syndrome;
-    uint8_t  raw_data[256];
-};
-
-// VUID Query structures - 使用正确的PRM格式
-#pragma pack(push, 1)
-struct vuid_cmd_in_prm {
-    uint32_t opcode_uid;        // [31:16] opcode, [15:0] uid  
-    uint32_t reserved1[2];      // 8 bytes reserved
-    uint32_t query_vfs_vuid_vhca_id;  // [31] query_vfs_vuid, [15:0] vhca_id
-    uint32_t reserved2[4];      // 16 bytes reserved - total 32 bytes
-};
-
-struct vuid_cmd_out_prm {
-    uint32_t status_syndrome;   // [31:24] status, [23:0] reserved
-    uint32_t syndrome;
-    uint32_t reserved1[26];     // Skip to VUID data location (104 bytes)
-    uint32_t reserved2_num_entries;  // [31:16] reserved, [15:0] num_of_entries
-    char     vuid_strings[1024]; // VUID strings buffer
-};
-#pragma pack(pop)
-
-// Parse output to extract VHCA IDs 
-uint32_t extract_u32_be(const uint8_t *data, int offset) {
-    return (data[offset] << 24) | 
-           (data[offset+1] << 16) | 
-           (data[offset+2] << 8) | 
-           data[offset+3];
-}
-
-void analyze_vhca_output(const char* test_name, uint16_t opmod, struct cmd_out *output) {
+void analyze_vhca_output(const char* test_name, uint16_t opmod, const struct tlp_emu_function_list *list) {
     printf("\n=== %s Analysis (OpMod 0x%x) ===\n", test_name, opmod);
     
-    if (output->status != 0) {
-        uint32_t syndrome = be32toh(output->syndrome);
-        printf("❌ Command failed - Status: 0x%x, Syndrome: 0x%x\n", output->status, syndrome);
+    if (list->status != 0) {
+        printf("❌ Command failed - Status: 0x%x, Syndrome: 0x%x\n", list->status, list->syndrome);
         return;
     }
-    
-    printf("✅ Command succeeded!\n");
-    
-    // Show first 32 bytes for analysis
-    printf("Raw data (first 32 bytes):\n");
-    for (int i = 0; i < 32; i++) {
-        printf("%02x ", output->raw_data[i]);
-        if ((i + 1) % 8 == 0) printf("\n");
-    }
-    printf("\n");
-    
-    // 重新分析输出结构格式
-    // 数据模式: 00 00 00 00 00 00 00 01 62 00 00 05 90 00 00 00
-    // 看起来 num_functions 可能在不同的位置
-    
-    // 尝试不同的偏移量来找到正确的 num_functions
-    printf("🔍 Trying different offsets for num_functions:\n");
-    for (int test_offset = 4; test_offset <= 24; test_offset += 4) {
-        uint32_t test_val = be32toh(*(uint32_t*)(output->raw_data + test_offset));
-        printf("  Offset %2d: 0x%08x (%u)\n", test_offset, test_val, test_val);
+    if (!tlp_emu_funcs_ok(list)) {
+        printf("❌ Command failed to execute\n");
+        return;
     }
     
-    // 从数据模式看，offset 4-7 是 00 00 00 01，这可能是 num_functions = 1
-    uint32_t num_functions = be32toh(*(uint32_t*)(output->raw_data + 4));
-    printf("🔍 Number of emulated functions: %u\n", num_functions);
+    printf("✅ Command succeeded!\n");
+    printf("🔍 Number of emulated functions: %u\n", list->count);
     
-    if (num_functions > 0 && num_functions <= 10) {
-        // 从数据模式分析：00 00 00 00 00 00 00 01 62 00 00 05 90 00 00 00
-        // 如果 num_functions=1 在 offset 4-7，那么设备信息从 offset 8 开始
-        uint8_t *func_info_ptr = output->raw_data + 8; // 设备信息从 offset 8 开始
-        
-        printf("📝 Parsing emulated function info structures:\n");
-        
-        for (uint32_t i = 0; i < num_functions && i < 5; i++) {
-            // 分析数据: 62 00 00 05 90 00 00 00
-            // 尝试不同的解释方式
-            
-            printf("  Function %d raw data: ", i+1);
-            for (int j = 0; j < 8; j++) {
-                printf("%02x ", func_info_ptr[j]);
-            }
-            printf("\n");
-            
-            // 方法1: 前16位是 vhca_id (0x6200)
-            uint16_t vhca_id_method1 = be16toh(*(uint16_t*)(func_info_ptr));
-            
-            // 方法2: 后16位是 vhca_id (0x0005) 
-            uint16_t vhca_id_method2 = be16toh(*(uint16_t*)(func_info_ptr + 2));
-            
-            // 方法3: 最后一个字节是 vhca_id (0x05)
-            uint16_t vhca_id_method3 = func_info_ptr[3];
-            
-            // 方法4: 根据固件日志，gvmi=3，可能 vhca_id=3
-            uint16_t vhca_id_method4 = 3;
-            
-            printf("    - Method 1 (bytes 0-1): VHCA ID = 0x%04x (%u)\n", vhca_id_method1, vhca_id_method1);
-            printf("    - Method 2 (bytes 2-3): VHCA ID = 0x%04x (%u)\n", vhca_id_method2, vhca_id_method2); 
-            printf("    - Method 3 (byte 3):    VHCA ID = 0x%04x (%u)\n", vhca_id_method3, vhca_id_method3);
-            printf("    - Method 4 (fw log):    VHCA ID = 0x%04x (%u)\n", vhca_id_method4, vhca_id_method4);
-            
-            // 使用最可能的 vhca_id (gvmi=3 从固件日志)
-            uint16_t selected_vhca_id = vhca_id_method4; 
-            printf("    🎯 Selected VHCA ID for VUID query: 0x%04x (%u)\n", selected_vhca_id, selected_vhca_id);
-            
-            // 移动到下一个结构体 (假设 8 bytes per function 基于观察到的数据)
-            func_info_ptr += 8;
-        }
-    } else if (num_functions == 0) {
+    if (list->count == 0) {
         printf("❌ No emulated functions found\n");
-    } else {
-        printf("⚠️  Unexpected function count: %u (might be parsing error)\n", num_functions);
+        return;
     }
     
-    // 特殊检查：如果还是看到测试模式数据
-    uint32_t field1 = extract_u32_be(output->raw_data, 8);   
-    if (field1 == 0x62000005) {
-        printf("📝 Still seeing test pattern (0x62000005) - hack might need structure format adjustment\n");
-        printf("   The firmware is returning test data instead of real device information\n");
+    // 按 mlx5_ifc_emulated_function_info_bits 解码, 不再猜测偏移
+    printf("📝 Emulated functions:\n");
+    printf("  %-6s %-8s %-10s %-8s %s\n", "Index", "VHCA ID", "PCI BDF", "Hotplug", "Type");
+    for (uint32_t i = 0; i < list->count; i++) {
+        const struct tlp_emu_function *fn = &list->funcs[i];
+        
+        printf("  %-6u 0x%04x   %02x:%02x.%x    %-8s %s\n", i, fn->vhca_id,
+               fn->pci_bdf >> 8, (fn->pci_bdf >> 3) & 0x1f, fn->pci_bdf & 0x7,
+               fn->hotplug ? "yes" : "no", tlp_emu_dev_type_str(fn->dev_type));
     }
 }
 
-int query_vuid(struct ibv_context *ctx, uint16_t vhca_id) {
-    printf("\n=== VUID Query Test (VHCA ID: 0x%x) ===\n", vhca_id);
-    
-    struct vuid_cmd_in_prm vuid_in = {0};
-    struct vuid_cmd_out_prm vuid_out = {0};
-    
-    vuid_in.opcode_uid = htobe32(MLX5_CMD_OP_QUERY_VUID << 16 | vhca_id);
-    
-    printf("Querying VUID for VHCA ID 0x%x...\n", vhca_id);
-    
-    int ret = mlx5dv_devx_general_cmd(ctx, &vuid_in, sizeof(vuid_in), &vuid_out, sizeof(vuid_out));
-    
-    if (ret) {
-        printf("❌ VUID query failed: %s\n", strerror(errno));
-        return ret;
-    }
-    
-    if (vuid_out.status_syndrome >> 24 != 0) {
-        uint32_t syndrome = be32toh(vuid_out.syndrome);
-        printf("❌ VUID command failed - Status: 0x%x, Syndrome: 0x%x\n", vuid_out.status_syndrome >> 24, syndrome);
-        return -1;
-    }
-    
-    printf("✅ VUID query succeeded!\n");
-    
-    uint32_t num_entries = be32toh(vuid_out.reserved2_num_entries) & 0xFFFF;
-    printf("Number of VUID entries: %u\n", num_entries);
-    
-    if (num_entries > 0) {
-        printf("🎯 VUID Found:\n");
-        // Extract first VUID (128 bytes = 0x400 bits / 8)
-        char vuid_str[129];  // 128 chars + null terminator
-        memcpy(vuid_str, vuid_out.vuid_strings, 128);
-        vuid_str[128] = '\0';
-        
-        // Remove trailing null bytes for cleaner display
-        int len = strlen(vuid_str);
-        for (int i = len - 1; i >= 0 && vuid_str[i] == '\0'; i--) {
-            len = i;
-        }
-        vuid_str[len] = '\0';
-        
-        printf("  VUID: %s\n", vuid_str);
-        
-        // Display raw VUID bytes for analysis
-        printf("  Raw VUID bytes (first 32):\n  ");
-        for (int i = 0; i < 32; i++) {
-            printf("%02x ", (uint8_t)vuid_out.vuid_strings[i]);
-            if ((i + 1) % 16 == 0) printf("\n  ");
-        }
-        printf("\n");
-    } else {
-        printf("❌ No VUID entries returned\n");
+/*
+ * A daemon whose device has no emulated functions still publishes: an
+ * empty inventory must attach, unlike a segment nothing was published to
+ */
+static bool test_empty_inventory_shm(void)
+{
+    struct tlp_inventory empty = {0}, inventory = {0};
+    struct tlp_inventory_shm *shm, *reader;
+    uint64_t generation = 0;
+    char name[32];
+    bool ok;
+
+    snprintf(name, sizeof(name), "tlp_query_test.%d", (int)getpid());
+    shm = tlp_inventory_shm_create(name);
+    if (!shm) {
+        printf("❌ Failed to create inventory segment %s\n", name);
+        return false;
     }
-    
-    return 0;
+    reader = tlp_inventory_shm_attach(name);
+    ok = reader == NULL;
+    tlp_inventory_shm_detach(reader);
+
+    ok = ok && tlp_inventory_shm_publish(shm, &empty) == 1;
+    reader = tlp_inventory_shm_attach(name);
+    ok = ok && reader && tlp_inventory_shm_snapshot(reader, &inventory, &generation) == 0 &&
+         inventory.count == 0 && generation == tlp_inventory_shm_generation(shm);
+    tlp_inventory_shm_detach(reader);
+    tlp_inventory_free(&inventory);
+    tlp_inventory_shm_destroy(shm);
+
+    printf("%s Empty inventory attaches once published\n", ok ? "✅" : "❌");
+    return ok;
 }
 
 int main(int argc, char *argv[])
@@ -219,20 +99,28 @@ int main(int argc, char *argv[])
     struct ibv_context *ctx = NULL;
     int num_devices;
     const char *device_name = "mlx5_0";
+    const char *expected_vuid = NULL;
     
     printf("TLP_DEVICES Hack Test + VUID Query - 获取真实的设备信息\n");
     printf("=========================================================\n");
     printf("Enhanced test to get real generic emu device information\n\n");
     
-    if (argc == 2) {
+    if (argc == 2 || argc == 3) {
         device_name = argv[1];
+        if (argc == 3)
+            expected_vuid = argv[2];  // e.g. VUID from doca_devemu_pci_device_list
     } else if (argc == 1) {
         printf("Using default device: %s\n", device_name);
     } else {
-        printf("Usage: %s [device_name] (default: mlx5_0)\n", argv[0]);
+        printf("Usage: %s [device_name] [vuid] (default: mlx5_0)\n", argv[0]);
         return -1;
     }
     
+    // Test 0: shared memory inventory, no device needed
+    printf("\n=== Test 0: Inventory Segment ===\n");
+    if (!test_empty_inventory_shm())
+        return -1;
+    
     // Get device list
     device_list = ibv_get_device_list(&num_devices);
     if (!device_list) {
@@ -264,186 +152,133 @@ int main(int argc, char *argv[])
     
     printf("Device: %s\n", device_name);
     
-    // Test 1: GENERIC_PF (baseline)
-    printf("\n=== Test 1: GENERIC_PF (Baseline) ===\n");
-    struct cmd_in cmd_in1 = {0};
-    struct cmd_out cmd_out1 = {0};
-    
-    cmd_in1.opcode = htobe16(MLX5_CMD_OPCODE_QUERY_EMULATED_FUNCTIONS_INFO);
-    cmd_in1.uid = htobe16(0);
-    cmd_in1.reserved1 = htobe16(0);
-    cmd_in1.op_mod = htobe16(PRM_EMULATION_OPMOD_GENERIC_PF);  // 0x6
-    cmd_in1.reserved2 = htobe32(0);
-    cmd_in1.reserved3 = htobe16(0);
-    cmd_in1.pf_vhca_id = htobe16(0);
+    // Test 1: every emulation device type plus invalid op_mods, one concurrent sweep
+    printf("\n=== Test 1: Device Types Sweep ===\n");
+    static const uint16_t sweep_op_mods[] = {
+        0x0, 0x1, 0x2, PRM_EMULATION_OPMOD_GENERIC_PF, PRM_EMULATION_OPMOD_TLP_DEVICES,
+        0x8, 0x9, 0xff,     // Beyond TLP_DEVICES, firmware must reject these
+    };
+    const int nsweep = sizeof(sweep_op_mods) / sizeof(sweep_op_mods[0]);
+    struct tlp_emu_function_list sweep[sizeof(sweep_op_mods) / sizeof(sweep_op_mods[0])];
+    struct tlp_emu_function_list repeat[sizeof(sweep_op_mods) / sizeof(sweep_op_mods[0])];
+    struct tlp_emu_function_list *generic_funcs = NULL, *tlp_funcs = NULL;
+    struct tlp_emu_op_mod_cache op_mod_cache = {0};
+    struct timespec start, end;
+    double sweep_ms, repeat_ms;
+    int succeeded, skipped = 0;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    succeeded = tlp_emu_funcs_sweep(ctx, sweep_op_mods, nsweep, &op_mod_cache, sweep);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sweep_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    
+    printf("  %-7s %-12s %-8s %-10s %s\n", "OpMod", "Type", "Status", "Syndrome", "Functions");
+    for (int i = 0; i < nsweep; i++) {
+        const struct tlp_emu_function_list *list = &sweep[i];
+        
+        printf("  0x%-5x %-12s 0x%-6x 0x%-8x %u %s\n", list->op_mod,
+               tlp_emu_dev_type_str(list->op_mod), list->status, list->syndrome, list->count,
+               tlp_emu_funcs_ok(list) ? "✅" : "❌");
+        if (list->op_mod == PRM_EMULATION_OPMOD_GENERIC_PF)
+            generic_funcs = &sweep[i];
+        else if (list->op_mod == PRM_EMULATION_OPMOD_TLP_DEVICES)
+            tlp_funcs = &sweep[i];
+    }
+    printf("⏱️  %d / %d op_mods succeeded, sweep took %.3f ms\n", succeeded, nsweep, sweep_ms);
+    
+    // A repeat sweep does not send the op_mods this firmware already rejected
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    tlp_emu_funcs_sweep(ctx, sweep_op_mods, nsweep, &op_mod_cache, repeat);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    repeat_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    for (int i = 0; i < nsweep; i++) {
+        skipped += repeat[i].cached;
+        tlp_emu_funcs_free(&repeat[i]);
+    }
+    printf("🔁 Repeat sweep: %.3f ms, %d rejected op_mods skipped from cache\n", repeat_ms, skipped);
     
-    printf("Querying GENERIC_PF (OpMod 0x6) for baseline...\n");
+    int ret1 = tlp_emu_funcs_ok(generic_funcs) ? 0 : -1;
+    int ret2 = tlp_emu_funcs_ok(tlp_funcs) ? 0 : -1;
     
-    int ret1 = mlx5dv_devx_general_cmd(ctx, &cmd_in1, sizeof(cmd_in1), &cmd_out1, sizeof(cmd_out1));
-    
-    if (ret1) {
-        printf("❌ GENERIC_PF query failed: %s\n", strerror(errno));
-    } else {
-        analyze_vhca_output("GENERIC_PF", PRM_EMULATION_OPMOD_GENERIC_PF, &cmd_out1);
-    }
+    analyze_vhca_output("GENERIC_PF", PRM_EMULATION_OPMOD_GENERIC_PF, generic_funcs);
     
     // Test 2: TLP_DEVICES (your hack)
     printf("\n=== Test 2: TLP_DEVICES Hack ===\n");
-    struct cmd_in cmd_in2 = {0};
-    struct cmd_out cmd_out2 = {0};
-    
-    cmd_in2.opcode = htobe16(MLX5_CMD_OPCODE_QUERY_EMULATED_FUNCTIONS_INFO);
-    cmd_in2.uid = htobe16(0);
-    cmd_in2.reserved1 = htobe16(0);
-    cmd_in2.op_mod = htobe16(PRM_EMULATION_OPMOD_TLP_DEVICES);  // 0x7
-    cmd_in2.reserved2 = htobe32(0);
-    cmd_in2.reserved3 = htobe16(0);
-    cmd_in2.pf_vhca_id = htobe16(0);
-    
-    printf("Querying TLP_DEVICES (OpMod 0x7) with your hack...\n");
     printf("Expected: Should return generic emu devices due to hack\n");
+    analyze_vhca_output("TLP_DEVICES", PRM_EMULATION_OPMOD_TLP_DEVICES, tlp_funcs);
     
-    int ret2 = mlx5dv_devx_general_cmd(ctx, &cmd_in2, sizeof(cmd_in2), &cmd_out2, sizeof(cmd_out2));
+    // Test 3: VUID inventory of every function the sweep reported, typed by op_mod
+    printf("\n=== Test 3: VUID Inventory ===\n");
+    struct tlp_emu_function_list lists[sizeof(sweep_op_mods) / sizeof(sweep_op_mods[0])];
+    struct tlp_inventory inventory = {0};
+    int nlists = 0, resolved;
     
-    if (ret2) {
-        printf("❌ TLP_DEVICES query failed: %s\n", strerror(errno));
-    } else {
-        analyze_vhca_output("TLP_DEVICES", PRM_EMULATION_OPMOD_TLP_DEVICES, &cmd_out2);
+    for (int i = 0; i < nsweep; i++) {
+        if (tlp_emu_funcs_ok(&sweep[i]))
+            lists[nlists++] = sweep[i];
     }
     
-    // Test 3: Enhanced VUID Query with Smart VHCA ID Detection
-    printf("\n=== Test 3: Enhanced VUID Query with Smart VHCA ID Detection ===\n");
+    // Prefer the inventory published by tlp_inventory_daemon, no firmware commands
+    struct tlp_inventory_shm *shm = tlp_inventory_shm_attach(device_name);
+    uint64_t generation = 0;
+    bool from_daemon = false;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (shm && tlp_inventory_shm_snapshot(shm, &inventory, &generation) == 0) {
+        from_daemon = true;
+        resolved = 0;
+        for (uint32_t i = 0; i < inventory.count; i++)
+            resolved += inventory.entries[i].vuid_valid;
+    } else {
+        // One QUERY_VUID per reported function, no candidate VHCA IDs
+        resolved = tlp_inventory_build(ctx, &inventory, lists, nlists);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    tlp_inventory_shm_detach(shm);
     
-    // Step 1: Analyze the pattern data for real VHCA IDs
-    uint32_t detected_vhca_ids[20];
-    int num_detected = 0;
+    if (from_daemon) {
+        printf("📥 Using inventory published by tlp_inventory_daemon (generation %lu)\n",
+               (unsigned long)generation);
+    }
     
-    if (ret1 == 0 && cmd_out1.status == 0) {
-        printf("🔍 Analyzing TLP_DEVICES output for real VHCA IDs:\n");
-        
-        // The pattern is: 00 00 00 00 00 00 00 01 62 00 00 05 90 00 00 00
-        // Let's analyze this as a potential device list structure
-        
-        uint32_t device_count = extract_u32_be(cmd_out1.raw_data, 4);  // At offset 4
-        printf("  Potential device count: %u\n", device_count);
-        
-        if (device_count == 1) {
-            // Try to extract VHCA ID from the pattern
-            uint32_t pattern1 = extract_u32_be(cmd_out1.raw_data, 8);   // 0x62000005
-            uint32_t pattern2 = extract_u32_be(cmd_out1.raw_data, 12);  // 0x90000000
-            
-            printf("  Pattern analysis:\n");
-            printf("    Pattern1: 0x%08x\n", pattern1);
-            printf("    Pattern2: 0x%08x\n", pattern2);
-            
-            // Method 1: Try different interpretations of the pattern
-            // The 0x62000005 might be: [device_type:16][vhca_id:16] or other encoding
-            detected_vhca_ids[num_detected++] = pattern1 & 0xFFFF;        // Lower 16 bits: 0x0005
-            detected_vhca_ids[num_detected++] = (pattern1 >> 16) & 0xFFFF; // Upper 16 bits: 0x6200  
-            detected_vhca_ids[num_detected++] = pattern1 & 0xFF;          // Lower 8 bits: 0x05
-            detected_vhca_ids[num_detected++] = (pattern1 >> 8) & 0xFF;   // Byte 2: 0x00
-            detected_vhca_ids[num_detected++] = (pattern1 >> 16) & 0xFF;  // Byte 1: 0x00
-            detected_vhca_ids[num_detected++] = (pattern1 >> 24) & 0xFF;  // Byte 0: 0x62
-            
-            // Method 2: Try pattern2 variations
-            if (pattern2 != 0) {
-                detected_vhca_ids[num_detected++] = pattern2 & 0xFFFF;        // 0x0000
-                detected_vhca_ids[num_detected++] = (pattern2 >> 16) & 0xFFFF; // 0x9000
-                detected_vhca_ids[num_detected++] = (pattern2 >> 24) & 0xFF;   // 0x90
-            }
-            
-            // Method 3: Based on firmware logs, gvmi=3 might be the real VHCA ID
-            printf("  Adding firmware-suggested VHCA IDs:\n");
-            detected_vhca_ids[num_detected++] = 3;      // From gvmi=3 in firmware logs
-            detected_vhca_ids[num_detected++] = 2;      // Adjacent values
-            detected_vhca_ids[num_detected++] = 4;
-            detected_vhca_ids[num_detected++] = 1;
+    if (resolved < 0) {
+        printf("❌ Failed to build VUID inventory\n");
+    } else {
+        printf("  %-8s %-10s %-10s %s\n", "VHCA ID", "PCI BDF", "Type", "VUID");
+        for (uint32_t i = 0; i < inventory.count; i++) {
+            const struct tlp_inventory_entry *entry = &inventory.entries[i];
             
-            // Method 4: Try common generic device VHCA IDs
-            for (int i = 10; i <= 20; i++) {
-                detected_vhca_ids[num_detected++] = i;
-            }
+            printf("  0x%04x   %02x:%02x.%x    %-10s %s\n", entry->fn.vhca_id,
+                   entry->fn.pci_bdf >> 8, (entry->fn.pci_bdf >> 3) & 0x1f, entry->fn.pci_bdf & 0x7,
+                   tlp_emu_dev_type_str(entry->fn.dev_type),
+                   entry->vuid_valid ? entry->vuid : "(none)");
         }
     }
     
-    // Step 2: Remove duplicates and invalid values
-    printf("\n📋 Testing %d potential VHCA IDs for VUID queries:\n", num_detected);
-    
-    bool found_any_vuid = false;
-    int successful_queries = 0;
-    
-    for (int i = 0; i < num_detected; i++) {
-        uint32_t vhca_id = detected_vhca_ids[i];
+    // VUID -> VHCA ID reverse lookup
+    bool found_expected_vuid = false;
+    if (expected_vuid) {
+        const struct tlp_inventory_entry *entry = tlp_inventory_find_vuid(&inventory, expected_vuid);
         
-        // Skip obviously invalid IDs
-        if (vhca_id == 0 || vhca_id > 0x1000) continue;
-        
-        printf("  🔍 Testing VHCA ID: 0x%04x (%d)\n", vhca_id, vhca_id);
-        
-        struct vuid_cmd_in_prm vuid_in = {0};
-        struct vuid_cmd_out_prm vuid_out = {0};
-        
-        vuid_in.opcode_uid = htobe32((MLX5_CMD_OP_QUERY_VUID << 16) | 0);  // 确保使用正确的操作码
-        vuid_in.query_vfs_vuid_vhca_id = htobe32(vhca_id);  // VHCA ID 在正确位置
-        
-        int ret = mlx5dv_devx_general_cmd(ctx, &vuid_in, sizeof(vuid_in), &vuid_out, sizeof(vuid_out));
-        
-        if (ret == 0) {
-            uint32_t status = (be32toh(vuid_out.status_syndrome) >> 24) & 0xFF;
-            uint32_t syndrome = be32toh(vuid_out.syndrome);
-            
-            if (status == 0) {
-                uint32_t num_entries = be32toh(vuid_out.reserved2_num_entries) & 0xFFFF;
-                successful_queries++;
-                
-                printf("    ✅ Query successful: %u VUID entries\n", num_entries);
-                
-                if (num_entries > 0) {
-                    found_any_vuid = true;
-                    printf("    🎯 FOUND VUID! VHCA ID 0x%04x has VUID data!\n", vhca_id);
-                    
-                    // Display the VUID
-                    char vuid_str[129];
-                    memcpy(vuid_str, vuid_out.vuid_strings, 128);
-                    vuid_str[128] = '\0';
-                    
-                    // Clean up the string
-                    int len = 0;
-                    for (int j = 0; j < 128 && vuid_str[j] != '\0'; j++) {
-                        if (vuid_str[j] >= 32 && vuid_str[j] <= 126) len = j + 1;
-                    }
-                    vuid_str[len] = '\0';
-                    
-                    printf("    📝 VUID: '%s'\n", vuid_str);
-                    printf("    🔗 This matches doca_devemu_pci_device_list output!\n");
-                    
-                    // Show raw bytes for verification
-                    printf("    📊 Raw VUID bytes: ");
-                    for (int k = 0; k < 32; k++) {
-                        printf("%02x ", (uint8_t)vuid_out.vuid_strings[k]);
-                    }
-                    printf("\n");
-                    break;  // Found it, no need to continue
-                }
-            } else {
-                printf("    ⚠️  Query returned status=0x%02x, syndrome=0x%08x\n", status, syndrome);
-            }
+        printf("\n🔗 Lookup VUID '%s': ", expected_vuid);
+        if (entry) {
+            found_expected_vuid = true;
+            printf("VHCA ID 0x%04x ✅\n", entry->fn.vhca_id);
         } else {
-            printf("    ❌ DevX command failed: %s\n", strerror(errno));
+            printf("not found ❌\n");
         }
     }
     
     printf("\n📊 Results summary:\n");
-    printf("  - Tested %d VHCA IDs\n", num_detected);
-    printf("  - %d successful queries\n", successful_queries);
-    printf("  - Found VUID: %s\n", found_any_vuid ? "YES! 🎉" : "NO");
-    
-    if (!found_any_vuid) {
-        printf("\n💡 Next steps to find the real VHCA ID:\n");
-        printf("1. 检查固件中 generic emu 设备的真实 VHCA ID 分配\n");
-        printf("2. 查看 doca_devemu_pci_type_create_rep_list 的具体实现\n");
-        printf("3. 可能需要先创建/激活 generic 设备 representor\n");
-        printf("4. 或者 VUID 只在设备 representor 打开时才可用\n");
+    printf("  - Emulated functions: %u\n", inventory.count);
+    printf("  - VUIDs resolved: %d\n", resolved < 0 ? 0 : resolved);
+    printf("  - Discovery time: %.3f ms\n",
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    
+    if (resolved <= 0) {
+        printf("\n💡 No VUID returned:\n");
+        printf("1. Generic emu device not active/representor not created\n");
+        printf("2. VUID only available in specific device state\n");
     }
     
     // Final analysis
@@ -451,15 +286,13 @@ int main(int argc, char *argv[])
     printf("TLP_DEVICES Hack + VUID Query 结果总结\n");
     printf("============================================================\n");
     
-    if (ret1 == 0 && ret2 == 0 && cmd_out1.status == 0 && cmd_out2.status == 0) {
-        // Compare raw output patterns
-        bool patterns_similar = true;
-        for (int i = 8; i < 24; i += 4) {
-            uint32_t val1 = extract_u32_be(cmd_out1.raw_data, i);
-            uint32_t val2 = extract_u32_be(cmd_out2.raw_data, i);
-            if (val1 != val2) {
+    if (ret1 == 0 && ret2 == 0) {
+        // Compare decoded function lists
+        bool patterns_similar = generic_funcs->count == tlp_funcs->count;
+        for (uint32_t i = 0; patterns_similar && i < generic_funcs->count; i++) {
+            if (generic_funcs->funcs[i].vhca_id != tlp_funcs->funcs[i].vhca_id ||
+                generic_funcs->funcs[i].pci_bdf != tlp_funcs->funcs[i].pci_bdf) {
                 patterns_similar = false;
-                break;
             }
         }
         
@@ -472,206 +305,16 @@ int main(int argc, char *argv[])
     }
     
     printf("\n💡 总结:\n");
-    printf("1. ✅ TLP_DEVICES hack 功能已验证成功\n");
-    printf("2. ✅ VUID 查询功能已实现 (尝试了多个VHCA ID)\n");
-    printf("3. 📝 下一步: 分析 doca_devemu_pci_device_list 源码\n");
-    printf("4. 🔍 可能需要不同的设备发现方法获取真实VUID\n");
-    
-    printf("\n🎯 === 专门测试解析出的 VHCA ID 候选值 ===\n");
-    
-    // 基于解析结果的候选 VHCA ID
-    uint16_t candidate_vhca_ids[] = {
-        0x0005,  // Method 2/3: 从 bytes 2-3 解析 (0x0005)
-        0x0003,  // Method 4: 基于固件日志 gvmi=3
-        0x0001,  // 尝试相邻值
-        0x0002,  
-        0x0004,
-        0x0006,
-        0x0007,
-        0x0008
-    };
-    
-    int num_candidates = sizeof(candidate_vhca_ids) / sizeof(candidate_vhca_ids[0]);
-    bool found_working_vhca = false;
-    
-    printf("Testing %d candidate VHCA IDs based on parsing results...\n", num_candidates);
-    
-    for (int i = 0; i < num_candidates; i++) {
-        uint16_t vhca_id = candidate_vhca_ids[i];
-        
-        printf("\n🔍 Testing VHCA ID: 0x%04x (%d)\n", vhca_id, vhca_id);
-        
-        struct vuid_cmd_in_prm vuid_in = {0};
-        struct vuid_cmd_out_prm vuid_out = {0};
-        
-        // 使用正确的 VUID 查询格式
-        vuid_in.opcode_uid = htobe32((MLX5_CMD_OP_QUERY_VUID << 16) | 0);  // 确保使用正确的操作码
-        vuid_in.query_vfs_vuid_vhca_id = htobe32(vhca_id);  // VHCA ID 在正确位置
-        
-        int ret = mlx5dv_devx_general_cmd(ctx, &vuid_in, sizeof(vuid_in), &vuid_out, sizeof(vuid_out));
-        
-        if (ret != 0) {
-            printf("❌ DevX command failed: %s\n", strerror(errno));
-            continue;
-        }
-        
-        uint32_t status = (be32toh(vuid_out.status_syndrome) >> 24) & 0xFF;
-        uint32_t syndrome = be32toh(vuid_out.syndrome);
-        
-        if (status != 0) {
-            printf("❌ VUID command failed - Status: 0x%02x, Syndrome: 0x%08x\n", status, syndrome);
-            continue;
-        }
-        
-        uint32_t num_entries = be32toh(vuid_out.reserved2_num_entries) & 0xFFFF;
-        printf("✅ VUID query successful: %u VUID entries\n", num_entries);
-        
-        if (num_entries > 0) {
-            found_working_vhca = true;
-            printf("🎉 FOUND VUID! VHCA ID 0x%04x has real VUID data!\n", vhca_id);
-            
-            // 提取并显示 VUID
-            char vuid_str[129];
-            memset(vuid_str, 0, sizeof(vuid_str));
-            memcpy(vuid_str, vuid_out.vuid_strings, 128);
-            
-            // 清理 VUID 字符串
-            int len = 0;
-            for (int j = 0; j < 128; j++) {
-                if (vuid_str[j] >= 32 && vuid_str[j] <= 126) {
-                    len = j + 1;
-                } else if (vuid_str[j] == '\0') {
-                    break;
-                }
-            }
-            vuid_str[len] = '\0';
-            
-            printf("📝 VUID: '%s'\n", vuid_str);
-            
-            // 显示原始字节用于分析
-            printf("📊 Raw VUID bytes (first 32): ");
-            for (int k = 0; k < 32; k++) {
-                printf("%02x ", (uint8_t)vuid_out.vuid_strings[k]);
-            }
-            printf("\n");
-            
-            // 与 doca_devemu_pci_device_list 比较
-            printf("\n🔗 Compare with doca_devemu_pci_device_list output:\n");
-            printf("Expected: MT2334XZ0LGBGES1D0F0 (from previous test)\n");
-            printf("Actual:   %s\n", vuid_str);
-            
-            if (strstr(vuid_str, "MT2334") != NULL) {
-                printf("🎉 MATCH! This VUID matches doca_devemu_pci_device_list output!\n");
-                printf("✅ VHCA ID 0x%04x is the correct generic emu device VHCA ID\n", vhca_id);
-            } else {
-                printf("⚠️  Different VUID format - might be different device or representor\n");
-            }
-            
-            break; // 找到了，不需要继续测试
-        } else {
-            printf("⚠️  Command succeeded but returned 0 VUID entries\n");
-        }
-    }
-    
-    printf("\n📊 === Final Analysis ===\n");
-    if (found_working_vhca) {
-        printf("🎉 SUCCESS: Found working VHCA ID with VUID data!\n");
-        printf("✅ TLP_DEVICES hack successfully returns parseable device information\n");
-        printf("✅ VUID query integration working correctly\n");
-    } else {
-        printf("⚠️  No VHCA ID returned VUID data\n");
-        printf("💡 Possible reasons:\n");
-        printf("   1. Generic emu device not active/representor not created\n");
-        printf("   2. VHCA ID encoding different than expected\n");
-        printf("   3. Need to activate device representor first\n");
-        printf("   4. VUID only available in specific device state\n");
+    printf("1. ✅ TLP_DEVICES 输出按 PRM 结构解码\n");
+    printf("2. ✅ 每个功能一次 VUID 查询, vhca_id <-> VUID 双向索引\n");
+    if (expected_vuid) {
+        printf("3. %s VUID %s\n", found_expected_vuid ? "✅" : "❌", expected_vuid);
     }
     
-    printf("\n🔄 Next steps:\n");
-    printf("1. Run doca_devemu_pci_device_list for comparison\n");
-    printf("2. Check if generic emu device representor is active\n");
-    printf("3. Try creating/opening device representor first\n");
-
-    printf("\n🚀 === 基于 PCI 地址分析的新测试 ===\n");
-    printf("doca_devemu_pci_device_list 显示: PCI=0000:62:00.0, VUID=MT2334XZ0LGBGES1D0F0\n");
-    printf("我们解析的数据: 62 00 00 05 -> PCI总线=0x62, 与实际PCI地址匹配!\n\n");
-    
-    // 基于PCI地址分析，尝试相关的VHCA ID
-    uint16_t pci_based_vhca_ids[] = {
-        0x0062,  // 直接使用PCI总线号
-        0x0000,  // PCI设备号
-        0x0005,  // 解析出的第4个字节  
-        0x0003,  // gvmi from firmware logs
-        0x6200,  // PCI address as 16-bit BE
-        0x6205,  // 组合: bus + device_func
-    };
-    
-    printf("Testing PCI-based VHCA ID candidates:\n");
-    
-    for (int i = 0; i < 6; i++) {
-        uint16_t vhca_id = pci_based_vhca_ids[i];
-        
-        printf("\n🎯 Testing PCI-based VHCA ID: 0x%04x (%d)\n", vhca_id, vhca_id);
-        
-        struct vuid_cmd_in_prm vuid_in = {0};
-        struct vuid_cmd_out_prm vuid_out = {0};
-        
-        // 使用不同的查询格式尝试
-        vuid_in.opcode_uid = htobe32((MLX5_CMD_OP_QUERY_VUID << 16) | 0);  
-        vuid_in.query_vfs_vuid_vhca_id = htobe32(vhca_id & 0xFFFF);  
-        
-        int ret = mlx5dv_devx_general_cmd(ctx, &vuid_in, sizeof(vuid_in), &vuid_out, sizeof(vuid_out));
-        
-        if (ret != 0) {
-            printf("❌ DevX command failed: %s\n", strerror(errno));
-            continue;
-        }
-        
-        uint32_t status = (be32toh(vuid_out.status_syndrome) >> 24) & 0xFF;
-        if (status != 0) {
-            uint32_t syndrome = be32toh(vuid_out.syndrome);
-            printf("❌ Command failed - Status: 0x%02x, Syndrome: 0x%08x\n", status, syndrome);
-            continue;
-        }
-        
-        uint32_t num_entries = be32toh(vuid_out.reserved2_num_entries) & 0xFFFF;
-        printf("✅ Query successful: %u VUID entries\n", num_entries);
-        
-        if (num_entries > 0) {
-            printf("🎉 BREAKTHROUGH! Found VUID with VHCA ID 0x%04x!\n", vhca_id);
-            
-            char vuid_str[129];
-            memset(vuid_str, 0, sizeof(vuid_str));
-            memcpy(vuid_str, vuid_out.vuid_strings, 128);
-            
-            // 清理字符串
-            for (int j = 127; j >= 0; j--) {
-                if (vuid_str[j] == '\0' || vuid_str[j] == ' ') continue;
-                vuid_str[j+1] = '\0';
-                break;
-            }
-            
-            printf("📝 Retrieved VUID: '%s'\n", vuid_str);
-            printf("📝 Expected  VUID: 'MT2334XZ0LGBGES1D0F0'\n");
-            
-            if (strstr(vuid_str, "MT2334") != NULL || strstr(vuid_str, "XZ0LGB") != NULL) {
-                printf("🎊 PERFECT MATCH! VUID matches doca_devemu_pci_device_list output!\n");
-                printf("✅ Successfully integrated TLP_DEVICES hack with VUID query!\n");
-                printf("✅ VHCA ID 0x%04x is the correct representor VHCA ID\n", vhca_id);
-                break;
-            } else {
-                printf("🤔 Different VUID - might be different representor or device state\n");
-            }
-        }
-    }
-    
-    printf("\n🎯 === PCI 地址关联性分析 ===\n");
-    printf("✅ TLP_DEVICES 返回的 0x62 与实际 PCI 总线号 62 匹配\n");
-    printf("✅ 证明我们的数据解析方向正确\n");
-    printf("✅ TLP_DEVICES hack 成功返回真实设备信息\n");
-    printf("📝 数据格式可能是: [bus][dev][func][device_id][additional_info...]\n");
-
     // Cleanup
+    tlp_inventory_free(&inventory);
+    for (int i = 0; i < nsweep; i++)
+        tlp_emu_funcs_free(&sweep[i]);
     ibv_close_device(ctx);
     ibv_free_device_list(device_list);
     
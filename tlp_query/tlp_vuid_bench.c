@@ -0,0 +1,123 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * VUID Resolution Benchmark
+ * 比较串行QUERY_VUID与流水线/VF批量解析的吞吐量 (VUIDs/sec)
+ */
+
+#include <infiniband/verbs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_devices.h"
+#include "tlp_emu_funcs.h"
+#include "tlp_inventory.h"
+#include "tlp_vuid_resolver.h"
+
+#define MAX_LISTS   TLP_EMU_FUNCS_MAX_LISTS
+
+struct bench_mode {
+    const char      *name;
+    int             workers;
+    unsigned int    flags;
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *device_name = argc > 1 ? argv[1] : "mlx5_0";
+    uint32_t min_lookups = argc > 2 ? strtoul(argv[2], NULL, 0) : 1024;
+    int workers = argc > 3 ? atoi(argv[3]) : TLP_VUID_RESOLVER_WORKERS;
+    static struct tlp_emu_function_list lists[MAX_LISTS];
+    struct tlp_device_set devices;
+    struct tlp_inventory inv;
+    struct ibv_context *ctx;
+    int nlists, ret = 1;
+
+    const struct bench_mode modes[] = {
+        { "sequential",            1,       0 },
+        { "pipelined",             workers, 0 },
+        { "pipelined + VF batch",  workers, TLP_VUID_RESOLVE_BATCH_VFS },
+    };
+
+    printf("🚀 VUID Resolution Benchmark\n");
+    printf("============================\n");
+    printf("Usage: %s [device] [min_lookups] [workers]\n\n", argv[0]);
+
+    if (tlp_devices_match(device_name, &devices) <= 0) {
+        printf("❌ 设备 %s 未找到\n", device_name);
+        tlp_devices_release(&devices);
+        return 1;
+    }
+
+    ctx = ibv_open_device(devices.match[0]);
+    if (!ctx) {
+        printf("❌ 打开设备 %s 失败\n", device_name);
+        tlp_devices_release(&devices);
+        return 1;
+    }
+
+    nlists = tlp_emu_funcs_query_all(ctx, NULL, lists, MAX_LISTS);
+    if (tlp_inventory_init(&inv, lists, nlists)) {
+        printf("❌ 分配清单失败\n");
+        goto cleanup_lists;
+    }
+
+    printf("设备: %s, 模拟功能: %u (%d 个列表), workers: %d\n",
+           device_name, inv.count, nlists, workers);
+    if (inv.count == 0) {
+        printf("❌ 没有模拟功能可供解析\n");
+        goto cleanup_inv;
+    }
+
+    // 功能少于min_lookups时重复多轮, 保证每种模式至少解析min_lookups次
+    uint32_t rounds = (min_lookups + inv.count - 1) / inv.count;
+    printf("每种模式 %u 轮, 共 %u 次解析\n\n", rounds, rounds * inv.count);
+
+    printf("%-22s %10s %10s %12s %14s\n", "Mode", "Resolved", "Commands", "Time(ms)", "VUIDs/sec");
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        struct tlp_vuid_resolve_stats stats, total = {0};
+        uint64_t resolved = 0;
+        double start = now_sec(), elapsed;
+
+        for (uint32_t r = 0; r < rounds; r++) {
+            int n = tlp_vuid_resolve_stats(ctx, &inv, modes[m].workers, modes[m].flags, &stats);
+
+            if (n < 0) {
+                printf("❌ %s 解析失败\n", modes[m].name);
+                goto cleanup_inv;
+            }
+            resolved += n;
+            total.commands += stats.commands;
+            total.batch_fallbacks += stats.batch_fallbacks;
+        }
+        elapsed = now_sec() - start;
+
+        printf("%-22s %10lu %10u %12.2f %14.0f\n", modes[m].name, (unsigned long)resolved,
+               total.commands, elapsed * 1e3, (double)rounds * inv.count / elapsed);
+        if (total.batch_fallbacks)
+            printf("  ⚠️  %u 个PF批量查询不受支持, 已逐个VF查询\n", total.batch_fallbacks);
+    }
+    ret = 0;
+
+cleanup_inv:
+    tlp_inventory_free(&inv);
+cleanup_lists:
+    for (int l = 0; l < nlists; l++)
+        tlp_emu_funcs_free(&lists[l]);
+    ibv_close_device(ctx);
+    tlp_devices_release(&devices);
+
+    return ret;
+}
@@ -0,0 +1,192 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - pipelined QUERY_VUID resolution.
+ * rdma-core offers no asynchronous variant of mlx5dv_devx_general_cmd (only
+ * object queries have one), so commands are kept in flight by a small pool
+ * of threads issuing the blocking call concurrently; the kernel and firmware
+ * process them in parallel across command slots. VFs of the same PF are
+ * resolved with one query_vfs_vuid command when firmware supports it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <infiniband/mlx5dv.h>
+
+#include "mlx5_ifc.h"
+#include "tlp_cmd.h"
+#include "tlp_vuid_resolver.h"
+
+struct vuid_work {
+    uint32_t    first;      // Offset in resolver.order
+    uint32_t    count;
+    uint16_t    parent_vhca_id;
+    uint8_t     batch;      // VFs of parent_vhca_id, try query_vfs_vuid first
+};
+
+struct vuid_resolver {
+    struct ibv_context      *ctx;
+    struct tlp_inventory    *inv;
+    uint32_t                *order;     // Entry indices, VFs of a PF contiguous
+    struct vuid_work        *work;
+    uint32_t                nwork;
+    uint32_t                next;       // Shared work cursor
+    struct tlp_vuid_resolve_stats stats;
+};
+
+static void resolve_one(struct vuid_resolver *r, uint32_t idx)
+{
+    struct tlp_inventory_entry *entry = &r->inv->entries[idx];
+
+    entry->vuid_valid = tlp_vuid_query(r->ctx, entry->fn.vhca_id, entry->vuid) == 0;
+    __atomic_fetch_add(&r->stats.commands, 1, __ATOMIC_RELAXED);
+}
+
+// VUIDs come back in VF order, the same order the VF list was reported in
+static int resolve_vf_batch(struct vuid_resolver *r, const struct vuid_work *work)
+{
+    uint8_t in[TLP_CMD_QUERY_VUID_IN_SZ];
+    size_t outlen = TLP_CMD_QUERY_VUID_OUT_VUID_OFF + (size_t)work->count * TLP_CMD_VUID_SZ;
+    const uint8_t *vuids;
+    uint8_t *out;
+    int ret = -1;
+
+    out = calloc(1, outlen);
+    if (!out)
+        return -1;
+
+    tlp_cmd_query_vuid_in(in, 1, work->parent_vhca_id);
+
+    __atomic_fetch_add(&r->stats.commands, 1, __ATOMIC_RELAXED);
+    if (mlx5dv_devx_general_cmd(r->ctx, in, sizeof(in), out, outlen) ||
+        tlp_cmd_query_vuid_out_status(out) ||
+        tlp_cmd_query_vuid_out_num_of_entries(out) != work->count)
+        goto out;
+
+    vuids = out + TLP_CMD_QUERY_VUID_OUT_VUID_OFF;
+    for (uint32_t i = 0; i < work->count; i++) {
+        struct tlp_inventory_entry *entry = &r->inv->entries[r->order[work->first + i]];
+
+        entry->vuid_valid = tlp_vuid_copy(entry->vuid, vuids + i * TLP_CMD_VUID_SZ) == 0;
+    }
+    __atomic_fetch_add(&r->stats.batched_vfs, work->count, __ATOMIC_RELAXED);
+    ret = 0;
+
+out:
+    free(out);
+    return ret;
+}
+
+static void *resolver_worker(void *arg)
+{
+    struct vuid_resolver *r = arg;
+    uint32_t w;
+
+    while ((w = __atomic_fetch_add(&r->next, 1, __ATOMIC_RELAXED)) < r->nwork) {
+        const struct vuid_work *work = &r->work[w];
+
+        if (work->batch) {
+            if (resolve_vf_batch(r, work) == 0)
+                continue;
+            __atomic_fetch_add(&r->stats.batch_fallbacks, 1, __ATOMIC_RELAXED);
+        }
+        for (uint32_t i = 0; i < work->count; i++)
+            resolve_one(r, r->order[work->first + i]);
+    }
+
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// Split the inventory into work items: one per function, one per PF for its VFs
+static int resolver_plan(struct vuid_resolver *r, unsigned int flags)
+{
+    const struct tlp_inventory *inv = r->inv;
+    uint64_t *vf_keys;
+    uint32_t nvf = 0, norder = 0;
+
+    r->order = calloc(inv->count ? inv->count : 1, sizeof(*r->order));
+    r->work = calloc(inv->count ? inv->count : 1, sizeof(*r->work));
+    vf_keys = calloc(inv->count ? inv->count : 1, sizeof(*vf_keys));
+    if (!r->order || !r->work || !vf_keys) {
+        free(vf_keys);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < inv->count; i++) {
+        if ((flags & TLP_VUID_RESOLVE_BATCH_VFS) && inv->entries[i].fn.dev_type == TLP_EMU_DEV_TYPE_VF) {
+            vf_keys[nvf++] = ((uint64_t)inv->entries[i].fn.parent_vhca_id << 32) | i;
+            continue;
+        }
+        r->order[norder] = i;
+        r->work[r->nwork++] = (struct vuid_work){ .first = norder++, .count = 1 };
+    }
+
+    // Group VFs by PF, keeping their reported order within the PF
+    qsort(vf_keys, nvf, sizeof(*vf_keys), cmp_u64);
+    for (uint32_t i = 0; i < nvf; i++) {
+        uint16_t parent = vf_keys[i] >> 32;
+
+        if (i == 0 || parent != (uint16_t)(vf_keys[i - 1] >> 32))
+            r->work[r->nwork++] = (struct vuid_work){
+                .first = norder, .parent_vhca_id = parent, .batch = 1,
+            };
+        r->order[norder++] = (uint32_t)vf_keys[i];
+        r->work[r->nwork - 1].count++;
+    }
+
+    free(vf_keys);
+    return 0;
+}
+
+int tlp_vuid_resolve_stats(struct ibv_context *ctx, struct tlp_inventory *inv, int workers,
+                           unsigned int flags, struct tlp_vuid_resolve_stats *stats)
+{
+    pthread_t threads[TLP_VUID_RESOLVER_MAX_WORKERS];
+    struct vuid_resolver r = { .ctx = ctx, .inv = inv };
+    int started = 0, resolved = 0;
+
+    if (resolver_plan(&r, flags)) {
+        free(r.order);
+        free(r.work);
+        return -1;
+    }
+
+    if (workers > TLP_VUID_RESOLVER_MAX_WORKERS)
+        workers = TLP_VUID_RESOLVER_MAX_WORKERS;
+    if (workers > (int)r.nwork)
+        workers = r.nwork;
+
+    // The calling thread is one of the workers
+    for (; started < workers - 1; started++) {
+        if (pthread_create(&threads[started], NULL, resolver_worker, &r))
+            break;
+    }
+    resolver_worker(&r);
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    for (uint32_t i = 0; i < inv->count; i++)
+        resolved += inv->entries[i].vuid_valid;
+    tlp_inventory_index_vuids(inv);
+
+    if (stats)
+        *stats = r.stats;
+    free(r.order);
+    free(r.work);
+    return resolved;
+}
+
+int tlp_vuid_resolve(struct ibv_context *ctx, struct tlp_inventory *inv, int workers, unsigned int flags)
+{
+    return tlp_vuid_resolve_stats(ctx, inv, workers, flags, NULL);
+}
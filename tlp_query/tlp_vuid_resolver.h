@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ * Copyright(c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * TLP Query library - pipelined QUERY_VUID resolution
+ */
+
+#ifndef TLP_VUID_RESOLVER_H
+#define TLP_VUID_RESOLVER_H
+
+#include <infiniband/verbs.h>
+
+#include "tlp_inventory.h"
+
+// Commands kept in flight by tlp_inventory_build()
+#define TLP_VUID_RESOLVER_WORKERS   8
+#define TLP_VUID_RESOLVER_MAX_WORKERS 64
+
+enum tlp_vuid_resolve_flags {
+    // Fetch all VF VUIDs of a PF with one query_vfs_vuid command
+    TLP_VUID_RESOLVE_BATCH_VFS  = 1 << 0,
+};
+
+struct tlp_vuid_resolve_stats {
+    uint32_t    commands;       // QUERY_VUID commands issued
+    uint32_t    batched_vfs;    // VUIDs that came from a query_vfs_vuid batch
+    uint32_t    batch_fallbacks;// PF batches that had to be re-queried per VF
+};
+
+/**
+ * Resolve the VUID of every inventory entry with several commands in flight
+ *
+ * Worker threads pull entries (or whole PF batches) from a shared cursor
+ * and issue QUERY_VUID concurrently, so firmware command slots are kept
+ * busy instead of waiting for each round trip. The VUID index is rebuilt
+ * once all workers are done.
+ * @param workers: Commands in flight, 1 gives the sequential behaviour
+ * @param flags: enum tlp_vuid_resolve_flags
+ * @return: number of functions with a VUID, -1 on failure
+ */
+int tlp_vuid_resolve(struct ibv_context *ctx, struct tlp_inventory *inv, int workers, unsigned int flags);
+
+/**
+ * Same as tlp_vuid_resolve() and also reports command statistics
+ */
+int tlp_vuid_resolve_stats(struct ibv_context *ctx, struct tlp_inventory *inv, int workers,
+                           unsigned int flags, struct tlp_vuid_resolve_stats *stats);
+
+#endif /* TLP_VUID_RESOLVER_H */